@@ -3,8 +3,13 @@
 #include <string>
 #include <vector>
 #include <iomanip>
+#include <thread>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
 #include <grpcpp/grpcpp.h>
 #include "file.grpc.pb.h"
+#include "common/DownloadRange.h"
 #include <openssl/md5.h>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
@@ -202,7 +207,117 @@ public:
         }
     }
 
+    // 并发区间下载：按文件大小切段，每段一条流写到各自的偏移，
+    // 逐段校验区间 MD5，最后校验整个文件的 MD5
+    bool downloadParallel(const std::string& fileName,
+                          const std::string& outputPath,
+                          int streams) {
+        DownloadStatus downloadStatus;
+        if (!queryDownloadStatus(fileName, generateUUID(), downloadStatus)) {
+            return false;
+        }
+        int64 fileSize = downloadStatus.file_size();
+        auto ranges = DownloadRange::Split(fileSize, streams, kRangeAlign);
+        if (ranges.size() <= 1) {
+            return downloadFile(fileName, outputPath);
+        }
+
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "[*] Downloading: " << fileName << std::endl;
+        std::cout << "[*] Output: " << outputPath << std::endl;
+        std::cout << "[*] Size: " << formatBytes(fileSize) << " in "
+                  << ranges.size() << " ranges" << std::endl;
+        std::cout << "========================================" << std::endl;
+
+        int fd = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ::ftruncate(fd, fileSize) != 0) {
+            std::cerr << "[-] Failed to open output file" << std::endl;
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+
+        std::vector<char> results(ranges.size(), 0);
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            workers.emplace_back([&, i]() {
+                results[i] = downloadRange(fileName, fd, ranges[i].first,
+                                           ranges[i].second);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        ::close(fd);
+
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (!results[i]) {
+                std::cerr << "[FAIL] Range [" << ranges[i].first << ", "
+                          << ranges[i].second << ") failed" << std::endl;
+                return false;
+            }
+        }
+
+        std::string downloadedMd5 = calculateFileMD5(outputPath);
+        std::cout << "[i] MD5: " << downloadedMd5 << std::endl;
+        if (downloadedMd5 != downloadStatus.file_md5()) {
+            std::cerr << "[FAIL] MD5 mismatch, expected "
+                      << downloadStatus.file_md5() << std::endl;
+            return false;
+        }
+        std::cout << "[OK] Download completed!" << std::endl;
+        return true;
+    }
+
 private:
+    // 下载 [begin, end) 写到 fd 的对应偏移，并与服务端发来的区间 MD5 比对
+    bool downloadRange(const std::string& fileName, int fd,
+                       int64 begin, int64 end) {
+        ClientContext context;
+        DownloadRequest request;
+        request.set_file_name(fileName);
+        request.set_start_offset(begin);
+        request.set_end_offset(end);
+        request.set_range_md5(true);
+
+        std::unique_ptr<ClientReader<DownloadResponse>> reader(
+            stub_->DownloadFile(&context, request));
+
+        MD5_CTX md5Context;
+        MD5_Init(&md5Context);
+        DownloadResponse response;
+        int64 offset = begin;
+        std::string serverMd5;
+
+        while (reader->Read(&response)) {
+            if (response.has_chunk()) {
+                const std::string& chunk = response.chunk();
+                if (::pwrite(fd, chunk.data(), chunk.size(), offset)
+                    != static_cast<ssize_t>(chunk.size())) {
+                    context.TryCancel();
+                    break;
+                }
+                MD5_Update(&md5Context, chunk.data(), chunk.size());
+                offset += chunk.size();
+            } else if (response.has_range()) {
+                serverMd5 = response.range().md5();
+            }
+        }
+
+        Status status = reader->Finish();
+        if (!status.ok() || offset != end) {
+            return false;
+        }
+
+        unsigned char digest[MD5_DIGEST_LENGTH];
+        MD5_Final(digest, &md5Context);
+        char hexDigest[MD5_DIGEST_LENGTH * 2 + 1];
+        for (int i = 0; i < MD5_DIGEST_LENGTH; i++) {
+            sprintf(&hexDigest[i * 2], "%02x", (unsigned int)digest[i]);
+        }
+        return serverMd5 == hexDigest;
+    }
+
+    // 与服务端发送块大小一致，区间边界落在块边界上
+    static constexpr int64 kRangeAlign = 2 * 1024 * 1024;
+
     std::unique_ptr<FileTransport::Stub> stub_;
 };
 
@@ -212,12 +327,13 @@ private:
 
 int main(int argc, char** argv) {
     if (argc < 3) {
-        std::cout << "Usage: " << argv[0] << " <filename> <output_path> [server_address] [session_id]\n"
+        std::cout << "Usage: " << argv[0] << " <filename> <output_path> [server_address] [session_id] [streams]\n"
                   << "\nArguments:"
                   << "\n  filename       Name of the file to download from server"
                   << "\n  output_path    Where to save the downloaded file"
                   << "\n  server_address Server address (default: 0.0.0.0:50051)"
                   << "\n  session_id     Optional session ID for resuming download"
+                  << "\n  streams        Parallel range streams (default: 1)"
                   << std::endl;
         return 1;
     }
@@ -226,6 +342,7 @@ int main(int argc, char** argv) {
     std::string outputPath = argv[2];
     std::string serverAddress = argc > 3 ? argv[3] : "0.0.0.0:50051";
     std::string sessionId = argc > 4 ? argv[4] : "";
+    int streams = argc > 5 ? std::atoi(argv[5]) : 1;
 
     auto channel = grpc::CreateChannel(serverAddress, grpc::InsecureChannelCredentials());
     DownloadClient client(channel);
@@ -233,7 +350,9 @@ int main(int argc, char** argv) {
     std::cout << "[*] Server: " << serverAddress << std::endl;
     std::cout << "========================================" << std::endl;
 
-    bool success = client.downloadFile(fileName, outputPath, sessionId);
+    bool success = streams > 1
+        ? client.downloadParallel(fileName, outputPath, streams)
+        : client.downloadFile(fileName, outputPath, sessionId);
 
     return success ? 0 : 1;
 }
@@ -0,0 +1,152 @@
+// 单个 io_context 线程上的查询吞吐：阻塞 DAO 调用 vs Async* 接口
+// 同时用 1ms 定时器衡量 io 线程被阻塞的程度（定时器最大延迟）
+// 需要本地 MySQL（config.ini [MySQL]），只读 user 表
+// 用法: Bench_async_dao [uid] [requests]
+#include "dao/UserDAO.h"
+#include "infra/MySqlPoolManager.h"
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 每 1ms 触发一次，记录实际触发时间相对预期的最大延迟
+class LoopProbe {
+public:
+    explicit LoopProbe(boost::asio::io_context& ioc) : _timer(ioc) {}
+
+    void Start() {
+        _stopped  = false;
+        _expected = Clock::now() + TICK;
+        arm();
+    }
+    void Stop() {
+        // 尚未触发的那次定时同样计入（io 线程一直被占用时定时器没有机会触发）
+        record();
+        _stopped = true;
+        _timer.cancel();
+    }
+    double MaxLagMs() const { return _max_lag.count() / 1000.0; }
+
+private:
+    static constexpr std::chrono::milliseconds TICK{1};
+
+    void record() {
+        auto lag = std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - _expected);
+        if (lag > _max_lag) _max_lag = lag;
+    }
+
+    void arm() {
+        _timer.expires_at(_expected);
+        _timer.async_wait([this](const boost::system::error_code& ec) {
+            if (ec || _stopped) return;
+            record();
+            _expected = Clock::now() + TICK;
+            arm();
+        });
+    }
+
+    boost::asio::steady_timer _timer;
+    Clock::time_point         _expected;
+    std::chrono::microseconds _max_lag{0};
+    bool                      _stopped = false;
+};
+
+struct RunStats {
+    double seconds    = 0;
+    int    failed     = 0;
+    double max_lag_ms = 0;
+};
+
+void PrintStats(const char* label, int requests, const RunStats& stats) {
+    std::printf(
+        "%-10s %8.0f queries/s  failed %d  io loop max stall %.1f ms\n",
+        label,
+        requests / stats.seconds,
+        stats.failed,
+        stats.max_lag_ms);
+}
+
+// 旧方式：查询直接在 io 线程上逐个执行
+RunStats RunBlocking(int uid, int requests) {
+    boost::asio::io_context ioc;
+    LoopProbe               probe(ioc);
+    RunStats                stats;
+    Clock::time_point       start;
+
+    boost::asio::post(ioc, [&]() {
+        probe.Start();
+        start = Clock::now();
+        for (int i = 0; i < requests; ++i) {
+            if (!UserDAO::getInstance()->FindUserByUid(uid).IsOK()) {
+                ++stats.failed;
+            }
+        }
+        stats.seconds
+            = std::chrono::duration<double>(Clock::now() - start).count();
+        probe.Stop();
+    });
+    ioc.run();
+    stats.max_lag_ms = probe.MaxLagMs();
+    return stats;
+}
+
+// 新方式：io 线程只发起查询，完成回调回到同一个 io_context
+RunStats RunAsync(int uid, int requests) {
+    boost::asio::io_context ioc;
+    LoopProbe               probe(ioc);
+    RunStats                stats;
+    Clock::time_point       start;
+    int                     done = 0;
+
+    boost::asio::post(ioc, [&]() {
+        probe.Start();
+        start = Clock::now();
+        for (int i = 0; i < requests; ++i) {
+            UserDAO::getInstance()->AsyncFindUserByUid(
+                uid,
+                boost::asio::bind_executor(ioc, [&](Result<UserInfo> res) {
+                    if (!res.IsOK()) ++stats.failed;
+                    if (++done == requests) {
+                        stats.seconds = std::chrono::duration<double>(
+                                            Clock::now() - start)
+                                            .count();
+                        probe.Stop();
+                    }
+                }));
+        }
+    });
+    ioc.run();
+    stats.max_lag_ms = probe.MaxLagMs();
+    return stats;
+}
+
+}   // namespace
+
+int main(int argc, char* argv[]) {
+    int uid      = argc > 1 ? std::atoi(argv[1]) : 1;
+    int requests = argc > 2 ? std::atoi(argv[2]) : 2000;
+    if (requests <= 0) requests = 2000;
+
+    std::printf(
+        "FindUserByUid(%d) x %d on one io_context thread\n", uid, requests);
+
+    // 预热：建好连接、缓存好预编译语句
+    UserDAO::getInstance()->FindUserByUid(uid);
+
+    PrintStats("blocking", requests, RunBlocking(uid, requests));
+    PrintStats("async", requests, RunAsync(uid, requests));
+
+    MySqlPoolManager::getInstance()->LogStats();
+    MySqlPoolManager::getInstance()->Close();
+    return 0;
+}
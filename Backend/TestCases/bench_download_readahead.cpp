@@ -0,0 +1,233 @@
+// 对比下载的两种读盘方式：CQ 线程上逐块同步读后发送（原实现），
+// 与 DownloadReadAhead 在 IO 线程池上预读后续块、读盘与发送重叠
+// 两种方式跑同一组文件，结果按 DownloadPerformanceMetrics 的字段汇总：
+// 总吞吐、读盘耗时、发送方等待读盘的时间（Read Stall）与预读命中
+// 网络发送按 link_mb_s 限速模拟（按块累计的发送截止时间），
+// 冷读前用 POSIX_FADV_DONTNEED 把文件逐出页缓存
+//
+// 用法: Bench_download_readahead [dir] [large_mb] [link_mb_s] [depth]
+//       在 dir（默认 /tmp）下生成 32MB 与 large_mb（默认 512）两个文件，
+//       结束后删除；link_mb_s 默认 1000，depth 默认取 download_read_ahead
+//       需在 config.ini 所在目录运行（IO 线程数等读取 [FileServer]）
+#include "DownloadIoPool.h"
+#include "DownloadReadAhead.h"
+#include "const.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 与 DownloadCallData 一致
+constexpr std::size_t CHUNK_SIZE = 2 * 1024 * 1024;
+
+double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+// 按链路速率发送：每块在上一块发完后占用 size / link 的时间
+class PacedLink {
+public:
+    explicit PacedLink(double mb_per_s) : _mb_per_s(mb_per_s) {}
+
+    void Send(const std::string& chunk, std::size_t size) {
+        if (_deadline < Clock::now()) _deadline = Clock::now();
+        _deadline += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(
+                size / (_mb_per_s * 1024 * 1024)));
+        digest = digest * 31 + static_cast<unsigned char>(chunk[size - 1]);
+        std::this_thread::sleep_until(_deadline);
+    }
+
+    uint64_t digest = 0;
+
+private:
+    double            _mb_per_s;
+    Clock::time_point _deadline = Clock::now();
+};
+
+void CreateFile(const std::string& path, std::size_t size) {
+    std::ofstream     out(path, std::ios::binary);
+    std::vector<char> block(CHUNK_SIZE);
+    for (std::size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<char>((i * 131) ^ (i >> 9));
+    }
+    for (std::size_t done = 0; done < size;) {
+        std::size_t n = std::min(block.size(), size - done);
+        out.write(block.data(), static_cast<std::streamsize>(n));
+        done += n;
+    }
+}
+
+void DropCache(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+// 原实现：读一块、发一块，读盘期间不发送
+DownloadPerformanceMetrics
+SendSync(const std::string& path, double link_mb_s, uint64_t& digest) {
+    DownloadPerformanceMetrics metrics;
+    metrics.source = "sync";
+    auto start     = Clock::now();
+
+    std::ifstream in(path, std::ios::binary);
+    std::string   chunk(CHUNK_SIZE, '\0');
+    PacedLink     link(link_mb_s);
+    while (true) {
+        auto read_start = Clock::now();
+        in.read(&chunk[0], CHUNK_SIZE);
+        auto n = static_cast<std::size_t>(in.gcount());
+        // 同步读时发送方等待的就是整个读盘时间
+        double read_ms = ElapsedMs(read_start);
+        metrics.file_read_duration_ms += read_ms;
+        metrics.read_stall_duration_ms += read_ms;
+        if (n == 0) break;
+
+        auto write_start = Clock::now();
+        link.Send(chunk, n);
+        metrics.network_write_duration_ms += ElapsedMs(write_start);
+        metrics.bytes_sent += static_cast<int64>(n);
+        metrics.chunk_count++;
+    }
+    metrics.total_duration_ms = ElapsedMs(start);
+    digest                    = link.digest;
+    return metrics;
+}
+
+// 预读：发送当前块时 IO 线程已在读后续 depth 块
+DownloadPerformanceMetrics SendReadAhead(
+    const std::string& path, std::size_t size, double link_mb_s,
+    std::size_t depth, uint64_t& digest) {
+    DownloadPerformanceMetrics metrics;
+    metrics.source = "read-ahead";
+    auto start     = Clock::now();
+
+    auto reader = DownloadReadAhead::Open(
+        path, 0, static_cast<int64>(size), CHUNK_SIZE, depth);
+    assert(reader);
+    PacedLink link(link_mb_s);
+
+    std::mutex              mutex;
+    std::condition_variable ready_cv;
+    bool                    ready = false;
+    while (!reader->Exhausted()) {
+        DownloadReadAhead::Chunk chunk;
+        if (reader->Take(chunk, {})) {
+            metrics.prefetch_hits++;
+        } else {
+            // 服务端在这里挂起，由读完的 IO 线程通过 Alarm 唤醒 CQ
+            auto stall_start = Clock::now();
+            while (!reader->Take(chunk, [&]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready = true;
+                ready_cv.notify_one();
+            })) {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready_cv.wait(lock, [&]() { return ready; });
+                ready = false;
+            }
+            metrics.read_stall_duration_ms += ElapsedMs(stall_start);
+        }
+        assert(chunk.ok);
+        metrics.file_read_duration_ms += chunk.read_ms;
+
+        auto write_start = Clock::now();
+        link.Send(*chunk.data, chunk.data->size());
+        metrics.network_write_duration_ms += ElapsedMs(write_start);
+        metrics.bytes_sent += static_cast<int64>(chunk.data->size());
+        metrics.chunk_count++;
+        DownloadIoPool::getInstance()->ReleaseBuffer(std::move(chunk.data));
+    }
+    metrics.total_duration_ms = ElapsedMs(start);
+    digest                    = link.digest;
+    return metrics;
+}
+
+double Throughput(const DownloadPerformanceMetrics& metrics) {
+    return metrics.bytes_sent / (1024.0 * 1024.0)
+           / (metrics.total_duration_ms / 1000.0);
+}
+
+void Print(
+    const std::string& label, bool cold,
+    const DownloadPerformanceMetrics& metrics) {
+    std::printf(
+        "%-6s %-4s %-10s  total %8.1f ms  %7.1f MB/s   read %7.1f ms   "
+        "stall %7.1f ms   hits %3d/%d\n",
+        label.c_str(),
+        cold ? "cold" : "warm",
+        metrics.source.c_str(),
+        metrics.total_duration_ms,
+        Throughput(metrics),
+        metrics.file_read_duration_ms,
+        metrics.read_stall_duration_ms,
+        metrics.prefetch_hits,
+        metrics.chunk_count);
+}
+
+}   // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dir       = argc > 1 ? argv[1] : "/tmp";
+    std::size_t large_mb  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 512;
+    double      link_mb_s = argc > 3 ? std::atof(argv[3]) : 1000.0;
+    std::size_t depth     = DownloadIoPool::getInstance()->ReadAheadDepth();
+    if (argc > 4) depth = std::strtoul(argv[4], nullptr, 10);
+
+    std::printf(
+        "link %.0f MB/s, read-ahead depth %zu, chunk %zu KB\n",
+        link_mb_s,
+        depth,
+        CHUNK_SIZE / 1024);
+
+    struct Case {
+        std::string label;
+        std::size_t size;
+    };
+    std::vector<Case> cases = {
+        {"32MB", 32 * 1024 * 1024},
+        {std::to_string(large_mb) + "MB", large_mb * 1024 * 1024},
+    };
+    for (const auto& c : cases) {
+        std::string path = dir + "/bench_readahead_" + c.label + ".bin";
+        CreateFile(path, c.size);
+        for (bool cold : {true, false}) {
+            uint64_t sync_digest = 0;
+            uint64_t ra_digest   = 0;
+            if (cold) DropCache(path);
+            auto sync = SendSync(path, link_mb_s, sync_digest);
+            if (cold) DropCache(path);
+            auto ahead
+                = SendReadAhead(path, c.size, link_mb_s, depth, ra_digest);
+            assert(sync_digest == ra_digest);
+
+            Print(c.label, cold, sync);
+            Print(c.label, cold, ahead);
+            std::printf(
+                "%-6s %-4s speedup %.2fx\n",
+                c.label.c_str(),
+                cold ? "cold" : "warm",
+                Throughput(ahead) / Throughput(sync));
+        }
+        std::remove(path.c_str());
+    }
+    DownloadIoPool::getInstance()->Stop();
+    return 0;
+}
@@ -0,0 +1,124 @@
+// 消息持久化吞吐：逐条自动提交 INSERT（旧实现）vs 事务内 multi-VALUES 批量 INSERT
+// 需要本地 MySQL（config.ini [MySQL]），只读写临时表 chat_messages_bench，结束后删除
+#include "dao/MsgDAO.h"
+#include "infra/ConfigManager.h"
+#include "infra/MySqlPoolManager.h"
+#include "repository/MessagePersistenceRepository.h"
+#include <chrono>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/statement.h>
+#include <cstdio>
+#include <json/json.h>
+#include <memory>
+#include <mysql_driver.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int         ROUNDS     = 20;
+constexpr int         BATCH_SIZE = 200;   // 与 MessagePersistenceService::BATCH_SIZE 一致
+const std::string     TABLE      = "chat_messages_bench";
+
+std::string MakeMessage(int round, int seq) {
+    Json::Value root;
+    root["fromuid"] = 1001;
+    root["touid"]   = 1002;
+    Json::Value text;
+    text["msgid"]   = "bench_" + std::to_string(round) + "_" + std::to_string(seq);
+    text["content"] = "benchmark message body " + std::to_string(seq);
+    root["text_array"].append(text);
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+std::unique_ptr<sql::Connection> Connect() {
+    auto        config = ConfigManager::getInstance();
+    std::string url
+        = "tcp://" + (*config)["MySQL"]["host"] + ":" + (*config)["MySQL"]["port"];
+    std::unique_ptr<sql::Connection> conn(
+        sql::mysql::get_mysql_driver_instance()->connect(
+            url, (*config)["MySQL"]["user"], (*config)["MySQL"]["passwd"]));
+    conn->setSchema((*config)["MySQL"]["schema"]);
+    return conn;
+}
+
+// 旧实现：每行单独 prepare + 自动提交
+void InsertLegacy(sql::Connection* conn, const std::vector<std::string>& messages) {
+    for (const auto& msg : messages) {
+        Json::Reader reader;
+        Json::Value  root;
+        reader.parse(msg, root);
+        std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
+            "INSERT INTO " + TABLE
+            + " (msgid, from_uid, to_uid, content) VALUES (?, ?, ?, ?)"));
+        stmt->setString(1, root["text_array"][0]["msgid"].asString());
+        stmt->setInt(2, root["fromuid"].asInt());
+        stmt->setInt(3, root["touid"].asInt());
+        stmt->setString(4, msg);
+        stmt->executeUpdate();
+    }
+}
+
+template <typename Fn>
+double RowsPerSecond(Fn insert) {
+    double total_sec = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+        std::vector<std::string> messages;
+        messages.reserve(BATCH_SIZE);
+        for (int i = 0; i < BATCH_SIZE; ++i) messages.push_back(MakeMessage(round, i));
+
+        auto start = std::chrono::steady_clock::now();
+        insert(messages);
+        auto end = std::chrono::steady_clock::now();
+        total_sec += std::chrono::duration<double>(end - start).count();
+    }
+    return ROUNDS * BATCH_SIZE / total_sec;
+}
+
+}   // namespace
+
+int main() {
+    auto conn = Connect();
+    std::unique_ptr<sql::Statement> ddl(conn->createStatement());
+    ddl->execute("DROP TABLE IF EXISTS " + TABLE);
+    ddl->execute(
+        "CREATE TABLE " + TABLE
+        + " (id BIGINT AUTO_INCREMENT PRIMARY KEY, msgid VARCHAR(64) NOT NULL, "
+          "from_uid INT NOT NULL, to_uid INT NOT NULL, "
+          "peer_key BIGINT NOT NULL DEFAULT 0, seq BIGINT NOT NULL DEFAULT 0, "
+          "msg_type TINYINT NOT NULL DEFAULT 0, content MEDIUMTEXT, "
+          "payload MEDIUMTEXT NULL, msg_ts BIGINT NOT NULL DEFAULT 0, "
+          "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP)");
+
+    double legacy = RowsPerSecond([&](const std::vector<std::string>& messages) {
+        InsertLegacy(conn.get(), messages);
+    });
+    double batched = RowsPerSecond([&](const std::vector<std::string>& messages) {
+        MessagePersistenceRepository::BatchInsertToMySQL(TABLE, messages);
+    });
+
+    std::printf("rows per round: %d, rounds: %d\n", BATCH_SIZE, ROUNDS);
+    std::printf("%-36s %10.0f rows/s\n", "per-row INSERT, autocommit", legacy);
+    std::printf("%-36s %10.0f rows/s\n", "multi-VALUES INSERT, one transaction", batched);
+    std::printf("speedup: %.1fx\n", batched / legacy);
+
+    auto stmt_stats = MsgDAO::getInstance()->GetStatementCacheStats();
+    std::printf(
+        "statement cache: hits=%llu misses=%llu hit_ratio=%.2f\n",
+        static_cast<unsigned long long>(stmt_stats.hits),
+        static_cast<unsigned long long>(stmt_stats.misses),
+        stmt_stats.hit_ratio());
+
+    for (const auto& client : MySqlPoolManager::getInstance()->Primary().GetStats().clients) {
+        std::printf(
+            "pool %s: wait p99=%lluus, query p50/p99=%llu/%lluus\n",
+            client.name.c_str(),
+            static_cast<unsigned long long>(client.wait.percentile_us(0.99)),
+            static_cast<unsigned long long>(client.query.percentile_us(0.50)),
+            static_cast<unsigned long long>(client.query.percentile_us(0.99)));
+    }
+
+    ddl->execute("DROP TABLE IF EXISTS " + TABLE);
+    return 0;
+}
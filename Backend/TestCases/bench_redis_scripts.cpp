@@ -0,0 +1,144 @@
+// 对比多命令 读-改-写 序列与 EVALSHA 单次往返的延迟
+// 需要本地 Redis（config.ini [Redis]），只读写 bench:* 前缀的临时 key
+#include "infra/RedisManager.h"
+#include "infra/RedisScripts.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int ITERATIONS = 2000;
+
+struct BenchResult {
+    double avg_us = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+};
+
+BenchResult RunBench(const std::function<void()>& setup, const std::function<void()>& op) {
+    std::vector<double> samples;
+    samples.reserve(ITERATIONS);
+    for (int i = 0; i < ITERATIONS; ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        op();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    BenchResult result;
+    for (double s : samples) result.avg_us += s;
+    result.avg_us /= samples.size();
+    result.p50_us = samples[samples.size() / 2];
+    result.p99_us = samples[samples.size() * 99 / 100];
+    return result;
+}
+
+void Report(const char* name, int round_trips, const BenchResult& r) {
+    std::printf(
+        "%-34s round_trips=%d  avg=%8.1fus  p50=%8.1fus  p99=%8.1fus\n",
+        name,
+        round_trips,
+        r.avg_us,
+        r.p50_us,
+        r.p99_us);
+}
+
+}   // namespace
+
+int main() {
+    auto redis = RedisManager::getInstance();
+
+    const std::string msg_key  = "bench:chat:msg";
+    const std::string meta_key = "bench:chat:meta";
+    const std::string list_key = "bench:offline";
+    const std::string hash_key = "bench:upload_progress";
+
+    auto fill_queue = [&]() {
+        redis->Del(msg_key);
+        for (int i = 0; i < 10; ++i) {
+            redis->LPush(msg_key, "{\"msg\":" + std::to_string(i) + "}");
+        }
+    };
+
+    // 1. RemovePersistedMessages: LRANGE + LTRIM + HSET vs. 脚本
+    Report(
+        "trim persisted (legacy)",
+        3,
+        RunBench(fill_queue, [&]() {
+            std::vector<std::string> all;
+            redis->LRange(msg_key, 0, -1, all);
+            redis->LTrim(msg_key, 0, static_cast<int>(all.size()) - 6);
+            redis->HSet(meta_key, "count", std::to_string(all.size() - 5));
+        }));
+    Report(
+        "trim persisted (evalsha)",
+        1,
+        RunBench(fill_queue, [&]() {
+            long long remaining = 0;
+            redis->EvalScript(
+                RedisScripts::TRIM_PERSISTED_MSGS,
+                {msg_key, meta_key},
+                {"5"},
+                remaining);
+        }));
+
+    // 2. GetOfflineMessages: LRANGE + DEL vs. 脚本
+    auto fill_offline = [&]() {
+        redis->RPush(list_key, "offline-1");
+        redis->RPush(list_key, "offline-2");
+    };
+    Report(
+        "drain offline (legacy)",
+        2,
+        RunBench(fill_offline, [&]() {
+            std::vector<std::string> values;
+            redis->LRange(list_key, 0, -1, values);
+            redis->Del(list_key);
+        }));
+    Report(
+        "drain offline (evalsha)",
+        1,
+        RunBench(fill_offline, [&]() {
+            std::vector<std::string> values;
+            redis->EvalScript(RedisScripts::LIST_DRAIN, {list_key}, {}, values);
+        }));
+
+    // 3. SaveUploadProgress: 5 x HSET + EXPIRE vs. 脚本
+    Report(
+        "save upload progress (legacy)",
+        6,
+        RunBench([]() {}, [&]() {
+            redis->HSet(hash_key, "file_name", "bench.bin");
+            redis->HSet(hash_key, "total_size", "104857600");
+            redis->HSet(hash_key, "uploaded_bytes", "20971520");
+            redis->HSet(hash_key, "status", "uploading");
+            redis->HSet(hash_key, "updated_at", "1700000000");
+            redis->Expire(hash_key, 86400);
+        }));
+    Report(
+        "save upload progress (evalsha)",
+        1,
+        RunBench([]() {}, [&]() {
+            long long ok = 0;
+            redis->EvalScript(
+                RedisScripts::HASH_SET_EXPIRE,
+                {hash_key},
+                {"86400",
+                 "file_name", "bench.bin",
+                 "total_size", "104857600",
+                 "uploaded_bytes", "20971520",
+                 "status", "uploading",
+                 "updated_at", "1700000000"},
+                ok);
+        }));
+
+    redis->Del(std::vector<std::string>{msg_key, meta_key, list_key, hash_key});
+    return 0;
+}
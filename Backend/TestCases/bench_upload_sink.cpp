@@ -0,0 +1,195 @@
+// 对比上传写盘的几种方式：原实现（ofstream + 256KB 缓冲区，每块先拷进缓冲区）
+// 与 FileSink（pwrite 定位写入 + fallocate 预留），以及 FileSink 的三种同步策略
+// 写调用次数和写放大取自 /proc/self/io：syscw 为写系统调用数，
+// write_bytes 为实际提交到块设备的字节数（tmpfs 等不经块设备的目录恒为 0）
+//
+// 用法: Bench_upload_sink [dir] [size_mb] [chunk_kb]
+//       在 dir（默认 /tmp）下写 size_mb（默认 512）MB，每块 chunk_kb（默认 2048，
+//       与客户端一致）KB，每 20MB 一个断点，结束后删除
+#include "infra/FileSink.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 与 FileWorker 一致
+constexpr std::size_t BUFFER_THRESHOLD  = 256 * 1024;
+constexpr int64_t     RESUME_CHUNK_SIZE = 20 * 1024 * 1024;
+
+struct IoCounters {
+    int64_t syscw       = 0;
+    int64_t write_bytes = 0;
+};
+
+IoCounters ReadIoCounters() {
+    std::ifstream                  in("/proc/self/io");
+    std::map<std::string, int64_t> values;
+    std::string                    key;
+    int64_t                        value;
+    while (in >> key >> value) values[key] = value;
+    return {values["syscw:"], values["write_bytes:"]};
+}
+
+struct Result {
+    double  ms          = 0;
+    int64_t syscalls    = 0;
+    int64_t disk_bytes  = 0;
+    int     sync_count  = 0;
+    double  avg_sync_ms = 0;
+    double  max_sync_ms = 0;
+};
+
+// 原实现：每块追加到缓冲区，满 256KB 写一次，断点处 ofstream::flush
+void WriteByOfstream(
+    const std::string& path, const std::vector<char>& chunk, int64_t size,
+    Result&) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::string   buffer;
+    for (int64_t written = 0; written < size;) {
+        auto n = static_cast<std::size_t>(
+            std::min<int64_t>(chunk.size(), size - written));
+        buffer.append(chunk.data(), n);
+        if (buffer.size() >= BUFFER_THRESHOLD) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+        written += n;
+        if (written % RESUME_CHUNK_SIZE == 0) out.flush();
+    }
+    out.write(buffer.data(), buffer.size());
+    out.close();
+}
+
+// FileWorker 新路径：大块直接 pwrite，小块攒够阈值再写
+void WriteBySink(
+    const std::string& path, const std::vector<char>& chunk, int64_t size,
+    const FileSink::Options& options, Result& result) {
+    auto sink = FileSink::Open(path, 0, size, options);
+    assert(sink);
+    std::string buffer;
+    int64_t     block_filled = 0;
+    for (int64_t written = 0; written < size;) {
+        auto n = static_cast<std::size_t>(
+            std::min<int64_t>(chunk.size(), size - written));
+        if (buffer.empty() && n >= BUFFER_THRESHOLD) {
+            sink->Write(chunk.data(), n);
+        } else {
+            buffer.append(chunk.data(), n);
+            if (buffer.size() >= BUFFER_THRESHOLD) {
+                sink->Write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        written += n;
+        block_filled += n;
+        if (block_filled >= RESUME_CHUNK_SIZE) {
+            block_filled -= RESUME_CHUNK_SIZE;
+            if (!buffer.empty()) {
+                sink->Write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+            sink->Checkpoint();
+        }
+    }
+    if (!buffer.empty()) sink->Write(buffer.data(), buffer.size());
+    bool closed = sink->Close();
+    assert(closed);
+    (void) closed;
+
+    const auto& stats  = sink->GetStats();
+    result.sync_count  = stats.sync_count;
+    result.avg_sync_ms = stats.AvgSyncMs();
+    result.max_sync_ms = stats.max_sync_ms;
+}
+
+template <typename Fn>
+Result Measure(const std::string& path, Fn fn) {
+    Result result;
+    auto   before = ReadIoCounters();
+    auto   start  = std::chrono::steady_clock::now();
+    fn(result);
+    // 统一在计时外把脏页刷到磁盘，write_bytes 才反映完整的落盘量
+    result.ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    ::fsync(fd);
+    ::close(fd);
+    auto after        = ReadIoCounters();
+    result.syscalls   = after.syscw - before.syscw;
+    result.disk_bytes = after.write_bytes - before.write_bytes;
+    std::remove(path.c_str());
+    return result;
+}
+
+void Print(const char* label, const Result& r, int64_t size) {
+    double mb = static_cast<double>(size) / (1024 * 1024);
+    std::printf(
+        "%-18s %9.1f ms %8.1f MB/s  %7.2f syscalls/MB  amplification %5.2f  "
+        "fdatasync %3d (avg %7.2f ms, max %7.2f ms)\n",
+        label,
+        r.ms,
+        mb / (r.ms / 1000),
+        r.syscalls / mb,
+        static_cast<double>(r.disk_bytes) / size,
+        r.sync_count,
+        r.avg_sync_ms,
+        r.max_sync_ms);
+}
+
+}   // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dir      = argc > 1 ? argv[1] : "/tmp";
+    int64_t     size_mb  = argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 512;
+    int64_t     chunk_kb = argc > 3 ? std::strtoll(argv[3], nullptr, 10) : 2048;
+    int64_t     size     = size_mb * 1024 * 1024;
+    std::string path     = dir + "/bench_upload_sink.bin";
+
+    std::vector<char> chunk(static_cast<std::size_t>(chunk_kb * 1024));
+    for (std::size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<char>((i * 131) ^ (i >> 9));
+    }
+
+    std::printf(
+        "%lld MB in %lld KB chunks, checkpoint every 20 MB\n",
+        static_cast<long long>(size_mb),
+        static_cast<long long>(chunk_kb));
+
+    Print(
+        "ofstream",
+        Measure(
+            path, [&](Result& r) { WriteByOfstream(path, chunk, size, r); }),
+        size);
+
+    struct Case {
+        const char*          label;
+        FileSink::SyncPolicy sync;
+    };
+    for (const auto& c : {
+             Case{"pwrite/none", FileSink::SyncPolicy::NONE},
+             Case{"pwrite/close", FileSink::SyncPolicy::CLOSE},
+             Case{"pwrite/checkpoint", FileSink::SyncPolicy::CHECKPOINT},
+         }) {
+        FileSink::Options options;
+        options.sync = c.sync;
+        Print(
+            c.label,
+            Measure(
+                path,
+                [&](Result& r) {
+                    WriteBySink(path, chunk, size, options, r);
+                }),
+            size);
+    }
+    return 0;
+}
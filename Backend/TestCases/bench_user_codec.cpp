@@ -0,0 +1,114 @@
+// 对比缓存记录的 JSON 与二进制编码：每用户 Redis 值大小、解码耗时
+// 纯本地计算，不需要 Redis
+#include "common/UserCodec.h"
+#include "common/UserMessage.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <json/json.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int ITERATIONS   = 20000;
+constexpr int FRIEND_COUNT = 50;
+
+UserInfo MakeUser(int uid) {
+    UserInfo info;
+    info.uid   = uid;
+    info.sex   = uid % 2;
+    info.name  = "user_" + std::to_string(uid);
+    info.nick  = "昵称" + std::to_string(uid);
+    info.email = "user" + std::to_string(uid) + "@example.com";
+    info.desc  = "hello, this is my signature";
+    info.back  = "";
+    info.icon  = "/static/head_" + std::to_string(uid % 8) + ".png";
+    return info;
+}
+
+std::string ToJson(const std::vector<UserInfo>& list) {
+    Json::Value root(Json::arrayValue);
+    for (const auto& item : list) root.append(UserJsonMapper::ToJson(item));
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+// 旧实现：Json::Reader 解析 + 每条 make_shared
+std::vector<std::shared_ptr<UserInfo>> DecodeJsonLegacy(const std::string& data) {
+    std::vector<std::shared_ptr<UserInfo>> list;
+    Json::Reader                           reader;
+    Json::Value                            root;
+    if (reader.parse(data, root) && root.isArray()) {
+        for (const auto& item : root) {
+            list.push_back(std::make_shared<UserInfo>(UserJsonMapper::FromJson(item)));
+        }
+    }
+    return list;
+}
+
+template <typename Fn>
+double MeasureNs(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+}   // namespace
+
+int main() {
+    // 正确性：编解码往返
+    auto     user = MakeUser(12345);
+    UserInfo decoded;
+    assert(UserCodec::Decode(UserCodec::Encode(user), decoded));
+    assert(decoded.uid == user.uid && decoded.sex == user.sex);
+    assert(decoded.nick == user.nick && decoded.icon == user.icon);
+
+    std::vector<UserInfo> friends;
+    for (int i = 0; i < FRIEND_COUNT; ++i) friends.push_back(MakeUser(1000 + i));
+    std::vector<UserInfo> decoded_list;
+    auto                  binary_list = UserCodec::Encode(friends);
+    assert(UserCodec::Decode(binary_list, decoded_list));
+    assert(decoded_list.size() == friends.size());
+    assert(decoded_list.back().email == friends.back().email);
+
+    std::vector<ApplyInfo> applies{ApplyInfo(7, "a", "", "", "n", 1, 0)};
+    std::vector<ApplyInfo> decoded_applies;
+    assert(UserCodec::Decode(UserCodec::Encode(applies), decoded_applies));
+    assert(decoded_applies.size() == 1 && decoded_applies[0]._nick == "n");
+
+    // 截断 / 类型不符的数据必须解码失败
+    assert(!UserCodec::Decode(binary_list.substr(0, binary_list.size() - 1), decoded_list));
+    assert(!UserCodec::Decode(binary_list, decoded));
+    assert(!UserCodec::IsBinary(ToJson(friends)));
+
+    // 大小
+    Json::FastWriter writer;
+    auto             json_user   = writer.write(UserJsonMapper::ToJson(user));
+    auto             binary_user = UserCodec::Encode(user);
+    auto             json_list   = ToJson(friends);
+    std::printf("user:base value      json=%5zu B  binary=%5zu B  (%.0f%%)\n",
+        json_user.size(), binary_user.size(),
+        100.0 * binary_user.size() / json_user.size());
+    std::printf("friend:list (%d)     json=%5zu B  binary=%5zu B  (%.0f%%)\n",
+        FRIEND_COUNT, json_list.size(), binary_list.size(),
+        100.0 * binary_list.size() / json_list.size());
+    std::printf("per user (base + friend list) json=%zu B  binary=%zu B\n",
+        json_user.size() + json_list.size(), binary_user.size() + binary_list.size());
+
+    // 解码耗时
+    double json_ns = MeasureNs([&]() {
+        auto list = DecodeJsonLegacy(json_list);
+        assert(list.size() == FRIEND_COUNT);
+    });
+    double binary_ns = MeasureNs([&]() {
+        std::vector<UserInfo> list;
+        UserCodec::Decode(binary_list, list);
+        assert(list.size() == FRIEND_COUNT);
+    });
+    std::printf("decode friend:list   json=%8.0f ns  binary=%8.0f ns  (x%.1f)\n",
+        json_ns, binary_ns, json_ns / binary_ns);
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "common/ArchiveSegment.h"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace {
+
+ArchiveRow Row(int64_t id, int from, int to, int64_t ts) {
+    ArchiveRow row;
+    row.id              = id;
+    row.record.msgid    = "msg_" + std::to_string(id);
+    row.record.from_uid = from;
+    row.record.to_uid   = to;
+    row.record.peer_key = MessageCodec::PeerKey(from, to);
+    row.record.seq      = id;
+    row.record.msg_ts   = ts;
+    row.record.msg_type = (from == BOT_UID || to == BOT_UID)
+                              ? MessageType::BOT
+                              : MessageType::TEXT;
+    row.record.payload  = "{\"content\":\"第 " + std::to_string(id) + " 条\"}";
+    return row;
+}
+
+bool Load(
+    const std::string& file, ArchiveFooter& footer,
+    std::vector<ArchiveBlockRef>& index) {
+    if (!ArchiveSegment::ParseFooter(
+            file.substr(0, ArchiveSegment::HEADER_SIZE),
+            file.substr(file.size() - ArchiveSegment::FOOTER_SIZE),
+            footer)) {
+        return false;
+    }
+    return ArchiveSegment::ParseIndex(
+        file.substr(
+            footer.index_offset,
+            footer.index_count * ArchiveSegment::INDEX_ENTRY_SIZE),
+        footer,
+        index);
+}
+
+}   // namespace
+
+int main() {
+    // 两个会话交错写入，另有一条与 BOT 的消息（uid 为负）
+    std::vector<ArchiveRow> rows;
+    for (int64_t i = 10; i >= 1; --i) {
+        rows.push_back(Row(i, i % 2 ? 1 : 2, i % 2 ? 2 : 1, 1000 + i));
+        rows.push_back(Row(100 + i, 3, 4, 2000 + i));
+    }
+    rows.push_back(Row(500, 1, BOT_UID, 1500));
+
+    std::string file = ArchiveSegment::Encode(rows, 4);
+    assert(!file.empty());
+    assert(ArchiveSegment::Encode({}).empty());
+
+    ArchiveFooter                footer;
+    std::vector<ArchiveBlockRef> index;
+    assert(Load(file, footer, index));
+    assert(footer.min_ts == 1001 && footer.max_ts == 2010);
+    // 每个会话 10 条、每块 4 条 -> 3 块，BOT 会话 1 块
+    assert(index.size() == 7);
+    for (std::size_t i = 1; i < index.size(); ++i) {
+        assert(
+            index[i - 1].peer_key < index[i].peer_key
+            || (index[i - 1].peer_key == index[i].peer_key
+                && index[i - 1].max_ts <= index[i].min_ts));
+    }
+
+    // 每块解码后按 (msg_ts, id) 升序，与 index 中的范围一致
+    std::size_t total = 0;
+    for (const auto& ref : index) {
+        std::vector<ArchiveRow> block;
+        assert(ArchiveSegment::DecodeBlock(
+            file.substr(ref.offset, ref.size), ref, block));
+        assert(block.size() == ref.count);
+        assert(block.front().record.msg_ts == ref.min_ts);
+        assert(block.front().id == ref.min_id);
+        assert(block.back().record.msg_ts == ref.max_ts);
+        assert(block.back().id == ref.max_id);
+        for (const auto& row : block) {
+            assert(row.record.peer_key == ref.peer_key);
+            assert(row.record.msgid == "msg_" + std::to_string(row.id));
+            assert(row.record.seq == row.id);
+            assert(
+                row.record.payload
+                == "{\"content\":\"第 " + std::to_string(row.id) + " 条\"}");
+        }
+        total += block.size();
+    }
+    assert(total == rows.size());
+
+    // BOT 会话：负 uid 与消息类型原样还原
+    auto bot_key = MessageCodec::PeerKey(1, BOT_UID);
+    for (const auto& ref : index) {
+        if (ref.peer_key != bot_key) continue;
+        std::vector<ArchiveRow> block;
+        assert(ArchiveSegment::DecodeBlock(
+            file.substr(ref.offset, ref.size), ref, block));
+        assert(block.size() == 1);
+        assert(block[0].record.to_uid == BOT_UID);
+        assert(block[0].record.msg_type == MessageType::BOT);
+    }
+
+    // 损坏的块与 index 都会被拒绝
+    {
+        const auto& ref    = index.front();
+        std::string packed = file.substr(ref.offset, ref.size);
+        packed[packed.size() / 2] ^= 0x5A;
+        std::vector<ArchiveBlockRef> ignored;
+        std::vector<ArchiveRow>      block;
+        assert(!ArchiveSegment::DecodeBlock(packed, ref, block));
+
+        std::string broken = file;
+        broken[footer.index_offset + 3] ^= 0x01;
+        assert(!Load(broken, footer, ignored));
+    }
+    // 文件头或 footer 的魔数不对
+    {
+        ArchiveFooter ignored;
+        std::string   header = file.substr(0, ArchiveSegment::HEADER_SIZE);
+        std::string   tail
+            = file.substr(file.size() - ArchiveSegment::FOOTER_SIZE);
+        assert(ArchiveSegment::ParseFooter(header, tail, ignored));
+        header[0] = 'X';
+        assert(!ArchiveSegment::ParseFooter(header, tail, ignored));
+        header = file.substr(0, ArchiveSegment::HEADER_SIZE);
+        tail.back() = 'X';
+        assert(!ArchiveSegment::ParseFooter(header, tail, ignored));
+        assert(!ArchiveSegment::ParseFooter(header, "", ignored));
+    }
+
+    // (msg_ts, id) 游标比较
+    assert(ArchiveSegment::Before(1, 9, 2, 1));
+    assert(ArchiveSegment::Before(2, 1, 2, 2));
+    assert(!ArchiveSegment::Before(2, 2, 2, 2));
+
+    // 月份目录按 UTC
+    assert(ArchiveSegment::MonthOf(0) == "197001");
+    assert(ArchiveSegment::MonthOf(1700000000) == "202311");
+    assert(ArchiveSegment::MonthOf(1704067199) == "202312");
+    assert(ArchiveSegment::MonthOf(1704067200) == "202401");
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "common/BlockBitmap.h"
+
+#include <cassert>
+#include <string>
+
+int main() {
+    constexpr int32_t MB = 1024 * 1024;
+
+    // 块大小：0 取默认值，越界截到上下限
+    assert(
+        BlockBitmap::NormalizeBlockSize(0) == BlockBitmap::DEFAULT_BLOCK_SIZE);
+    assert(BlockBitmap::NormalizeBlockSize(1) == BlockBitmap::MIN_BLOCK_SIZE);
+    assert(
+        BlockBitmap::NormalizeBlockSize(64 * MB)
+        == BlockBitmap::MAX_BLOCK_SIZE);
+    assert(BlockBitmap::NormalizeBlockSize(8 * MB) == 8 * MB);
+
+    // 块划分：只有最后一块可以不足 block_size
+    const int64_t total = 10 * MB + 1;
+    assert(BlockBitmap::BlockCount(total, 4 * MB) == 3);
+    assert(BlockBitmap::BlockCount(8 * MB, 4 * MB) == 2);
+    assert(BlockBitmap::BlockLength(total, 4 * MB, 0) == 4 * MB);
+    assert(BlockBitmap::BlockLength(total, 4 * MB, 2) == 2 * MB + 1);
+    assert(BlockBitmap::BlockLength(total, 4 * MB, 3) == 0);
+    assert(BlockBitmap::BlockLength(total, 4 * MB, -1) == 0);
+    assert(BlockBitmap::BlockOffset(2, 4 * MB) == 8 * MB);
+    // 超过 2GB 的偏移不溢出
+    assert(BlockBitmap::BlockOffset(1000, 16 * MB) == 16000LL * MB);
+
+    // 位序与 Redis SETBIT 一致：块 0 是第 0 字节的最高位
+    std::string bitmap;
+    BlockBitmap::Set(bitmap, 0);
+    BlockBitmap::Set(bitmap, 9);
+    assert(bitmap.size() == 2);
+    assert(static_cast<uint8_t>(bitmap[0]) == 0x80);
+    assert(static_cast<uint8_t>(bitmap[1]) == 0x40);
+    assert(BlockBitmap::IsSet(bitmap, 0) && BlockBitmap::IsSet(bitmap, 9));
+    assert(!BlockBitmap::IsSet(bitmap, 1) && !BlockBitmap::IsSet(bitmap, 64));
+    assert(BlockBitmap::CountSet(bitmap, 10) == 2);
+    assert(BlockBitmap::CountSet(bitmap, 9) == 1);
+    assert(BlockBitmap::CountSet(std::string(), 3) == 0);
+    return 0;
+}
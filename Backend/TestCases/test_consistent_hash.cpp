@@ -0,0 +1,46 @@
+#include "infra/ConsistentHash.h"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+int main() {
+    std::vector<std::string> nodes = {
+        "127.0.0.1:6379", "127.0.0.1:6380", "127.0.0.1:6381"};
+    ConsistentHashRing ring(nodes);
+
+    // hash tag：只对 {} 内的部分哈希
+    assert(ConsistentHashRing::HashTag("{chatserver}:login:") == "chatserver");
+    assert(ConsistentHashRing::HashTag("user:base:1") == "user:base:1");
+    assert(ConsistentHashRing::HashTag("a{}b") == "a{}b");
+    assert(
+        ring.NodeOf("{chatserver}:login:") == ring.NodeOf("{chatserver}:activate:"));
+
+    // 每个节点都能分到 key，且分布不至于严重倾斜
+    const int        total = 30000;
+    std::vector<int> counts(nodes.size(), 0);
+    for (int i = 0; i < total; ++i) {
+        counts[ring.NodeOf("user:base:" + std::to_string(i))]++;
+    }
+    for (int count : counts) {
+        assert(count > total / 6);
+    }
+
+    // 增加一个节点时，原有 key 只会迁往新节点，不会在旧节点之间移动
+    auto               grown_nodes = nodes;
+    grown_nodes.push_back("127.0.0.1:6382");
+    ConsistentHashRing grown(grown_nodes);
+    int                moved = 0;
+    for (int i = 0; i < total; ++i) {
+        auto key  = "user:base:" + std::to_string(i);
+        auto from = ring.NodeOf(key);
+        auto to   = grown.NodeOf(key);
+        if (from != to) {
+            assert(to == nodes.size());
+            moved++;
+        }
+    }
+    assert(moved < total / 2);
+
+    return 0;
+}
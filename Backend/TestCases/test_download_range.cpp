@@ -0,0 +1,58 @@
+#include "common/DownloadRange.h"
+
+#include <cassert>
+#include <limits>
+
+int main() {
+    constexpr int64_t MB   = 1024 * 1024;
+    const int64_t     size = 10 * MB + 1;
+    DownloadRange::Range range;
+
+    // 未指定终点：读到文件末尾（原有的 start_offset 续传语义不变）
+    assert(DownloadRange::Resolve(0, 0, 0, size, &range));
+    assert(range.first == 0 && range.second == size);
+    assert(DownloadRange::Resolve(size, 0, 0, size, &range));
+    assert(range.first == size && range.second == size);
+    assert(!DownloadRange::IsPartial(0, 0));
+
+    // end_offset 与 length 二选一，超出文件末尾截断
+    assert(DownloadRange::Resolve(MB, 3 * MB, 0, size, &range));
+    assert(range.first == MB && range.second == 3 * MB);
+    assert(DownloadRange::Resolve(MB, 0, 2 * MB, size, &range));
+    assert(range.first == MB && range.second == 3 * MB);
+    assert(DownloadRange::Resolve(MB, 3 * MB, 2 * MB, size, &range));
+    assert(DownloadRange::Resolve(9 * MB, 0, 4 * MB, size, &range));
+    assert(range.second == size);
+    // 极大的 length 不溢出，按文件末尾截断
+    const int64_t huge = std::numeric_limits<int64_t>::max();
+    assert(DownloadRange::Resolve(MB, 0, huge, size, &range));
+    assert(range.first == MB && range.second == size);
+    assert(DownloadRange::Resolve(0, 0, huge, size, &range));
+    assert(range.second == size);
+    assert(!DownloadRange::Resolve(MB, 3 * MB, huge, size, &range));
+    assert(DownloadRange::IsPartial(3 * MB, 0));
+    assert(DownloadRange::IsPartial(0, 2 * MB));
+
+    // 非法区间
+    assert(!DownloadRange::Resolve(-1, 0, 0, size, &range));
+    assert(!DownloadRange::Resolve(size + 1, 0, 0, size, &range));
+    assert(!DownloadRange::Resolve(2 * MB, MB, 0, size, &range));
+    assert(!DownloadRange::Resolve(0, -1, 0, size, &range));
+    assert(!DownloadRange::Resolve(0, 0, -1, size, &range));
+    assert(!DownloadRange::Resolve(MB, 3 * MB, MB, size, &range));
+
+    // 切段：首尾相接覆盖整个文件，段边界按 align 对齐
+    auto ranges = DownloadRange::Split(size, 4, 2 * MB);
+    assert(ranges.size() == 3);
+    assert(ranges.front().first == 0 && ranges.back().second == size);
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+        if (i > 0) assert(ranges[i].first == ranges[i - 1].second);
+        if (i + 1 < ranges.size()) assert(ranges[i].second % (2 * MB) == 0);
+    }
+    // 文件小于一个对齐单位时只有一段，空文件不切段
+    assert(DownloadRange::Split(MB, 8, 2 * MB).size() == 1);
+    assert(DownloadRange::Split(0, 8, 2 * MB).empty());
+    assert(DownloadRange::Split(64 * MB, 8, 2 * MB).size() == 8);
+    assert(DownloadRange::Split(64 * MB, 0, 2 * MB).size() == 1);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "common/MessageRecord.h"
+
+#include <cassert>
+#include <json/json.h>
+#include <string>
+
+int main() {
+    // 与 LogicHandler 写入的格式一致：toStyledString 的缩进 JSON
+    Json::Value frame;
+    frame["error"]     = 0;
+    frame["timestamp"] = static_cast<Json::Int64>(1700000000);
+    frame["fromuid"]   = 1002;
+    frame["touid"]     = 1019;
+    Json::Value text;
+    text["msgid"]     = "msg_1700000000_1";
+    text["content"]   = "你好, \"world\"";
+    text["timestamp"] = static_cast<Json::Int64>(1700000000);
+    frame["text_array"].append(text);
+    std::string styled = frame.toStyledString();
+
+    MessageRecord record;
+    assert(MessageCodec::Parse(styled, record));
+    assert(record.msgid == "msg_1700000000_1");
+    assert(record.from_uid == 1002 && record.to_uid == 1019);
+    assert(record.msg_ts == 1700000000);
+    assert(record.msg_type == MessageType::TEXT);
+    assert(record.seq == 0);
+    assert(record.payload.find("fromuid") == std::string::npos);
+    assert(record.payload.size() < styled.size());
+
+    // 会话键与方向无关，不同会话不冲突
+    assert(MessageCodec::PeerKey(1002, 1019) == MessageCodec::PeerKey(1019, 1002));
+    assert(MessageCodec::PeerKey(1002, 1019) != MessageCodec::PeerKey(1002, 1020));
+    assert(MessageCodec::PeerKey(BOT_UID, 1002) == MessageCodec::PeerKey(1002, BOT_UID));
+
+    // 由列值 + payload 拼回的帧与原帧等价
+    std::string rebuilt = MessageCodec::BuildFrame(
+        record.from_uid, record.to_uid, record.msg_ts, record.payload);
+    Json::Value  parsed;
+    Json::Reader reader;
+    assert(reader.parse(rebuilt, parsed));
+    assert(parsed == frame);
+
+    // 只有列字段的帧
+    assert(MessageCodec::BuildFrame(1, 2, 3, "{}") == "{\"fromuid\":1,\"touid\":2,\"timestamp\":3}");
+
+    // 机器人会话
+    Json::Value bot;
+    bot["fromuid"] = BOT_UID;
+    bot["touid"]   = 1002;
+    assert(MessageCodec::Parse(bot.toStyledString(), record));
+    assert(record.msg_type == MessageType::BOT);
+    assert(record.msgid.rfind("msg_", 0) == 0);
+
+    assert(!MessageCodec::Parse("not json", record));
+
+    // 持久化按帧内的消息时间选月份表，而不是落库时间
+    assert(MessageCodec::FrameTimestamp(rebuilt) == 1700000000);
+    assert(MessageCodec::FrameTimestamp(MessageCodec::BuildFrame(1, 2, 3, "{}")) == 3);
+    assert(MessageCodec::FrameTimestamp("not json") > 0);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "common/MessageSearch.h"
+
+#include <cassert>
+#include <json/json.h>
+#include <string>
+
+namespace {
+
+std::string Frame(int fromuid, int touid, const std::string& content) {
+    Json::Value frame;
+    frame["error"]     = 0;
+    frame["timestamp"] = static_cast<Json::Int64>(1700000000);
+    frame["fromuid"]   = fromuid;
+    frame["touid"]     = touid;
+    Json::Value text;
+    text["msgid"]     = "msg_1700000000_1";
+    text["content"]   = content;
+    text["timestamp"] = static_cast<Json::Int64>(1700000000);
+    frame["text_array"].append(text);
+    return frame.toStyledString();
+}
+
+}   // namespace
+
+int main() {
+    // 多字词按短语、单字词按前缀，每个词都必须命中
+    assert(MessageSearch::BooleanQuery("明天 开会") == "+\"明天\" +\"开会\"");
+    assert(MessageSearch::BooleanQuery("会") == "+会*");
+    assert(MessageSearch::BooleanQuery("hello") == "+\"hello\"");
+    // 全角空格同样分词，连续空白不产生空词
+    assert(
+        MessageSearch::BooleanQuery("明天\xE3\x80\x80  开会")
+        == "+\"明天\" +\"开会\"");
+    // 用户输入中的布尔运算符被去掉，不能改变查询语义
+    assert(MessageSearch::BooleanQuery("-\"a\"b* @3 (x)") == "+\"ab\" +3* +x*");
+    assert(MessageSearch::BooleanQuery("  +-* ").empty());
+    assert(MessageSearch::BooleanQuery("").empty());
+    // 超过 MAX_TERMS 的词被丢弃
+    std::string many;
+    for (int i = 0; i < 20; ++i) many += "ab ";
+    std::string query = MessageSearch::BooleanQuery(many);
+    std::size_t terms = 0;
+    for (char ch : query) terms += ch == '+';
+    assert(terms == MessageSearch::MAX_TERMS);
+
+    // 收发双方各一份文档
+    auto docs = MessageSearch::Documents(Frame(1002, 1019, "明天开会"));
+    assert(docs.size() == 2);
+    assert(docs[0].owner_uid == 1002 && docs[0].peer_uid == 1019);
+    assert(docs[1].owner_uid == 1019 && docs[1].peer_uid == 1002);
+    assert(docs[0].msgid == "msg_1700000000_1");
+    assert(docs[0].msg_ts == 1700000000);
+    assert(docs[0].body == "明天开会");
+
+    // BOT 一方不建文档
+    docs = MessageSearch::Documents(Frame(BOT_UID, 1002, "hi"));
+    assert(docs.size() == 1 && docs[0].owner_uid == 1002);
+    // 没有文本、无法解析的帧不建文档
+    assert(MessageSearch::Documents(Frame(1002, 1019, "")).empty());
+    assert(MessageSearch::Documents("not json").empty());
+    Json::Value no_msgid;
+    no_msgid["fromuid"] = 1002;
+    no_msgid["touid"]   = 1019;
+    Json::Value text;
+    text["content"] = "hi";
+    no_msgid["text_array"].append(text);
+    assert(MessageSearch::Documents(no_msgid.toStyledString()).empty());
+
+    // 截断不切断多字节字符
+    assert(MessageSearch::TruncateUtf8("abc", 8) == "abc");
+    assert(MessageSearch::TruncateUtf8("你好", 4) == "你");
+    assert(MessageSearch::TruncateUtf8("你好", 6) == "你好");
+    assert(MessageSearch::TruncateUtf8("a你", 2) == "a");
+
+    assert(MessageSearch::TableFor("chat_message_search", 16, 1019)
+           == "chat_message_search_11");
+    assert(MessageSearch::TableFor("chat_message_search", 16, -1)
+           == "chat_message_search_15");
+    assert(MessageSearch::TableFor("chat_message_search", 0, 7)
+           == "chat_message_search_0");
+    return 0;
+}
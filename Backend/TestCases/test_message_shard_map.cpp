@@ -0,0 +1,50 @@
+#include "infra/MessageShardMap.h"
+
+#include <cassert>
+#include <ctime>
+#include <string>
+
+int main() {
+    // 默认布局与最初的 16 张固定分表一致
+    MessageShardLayout legacy;
+    assert(legacy.TableFor(1002, 1019, 0) == "chat_messages_" + std::to_string((1002 + 1019) % 16));
+    assert(legacy.TableFor(1019, 1002, 0) == legacy.TableFor(1002, 1019, 0));
+    assert(legacy.ShardOf(-1, 0) == 15);   // 负 uid 取非负余数
+    assert(legacy.TablesInRange(0, std::time(nullptr)).size() == 16);
+
+    assert(legacy.Owns("chat_messages_0"));
+    assert(legacy.Owns("chat_messages_15"));
+    assert(!legacy.Owns("chat_messages_16"));
+    assert(!legacy.Owns("chat_messages_template"));
+    assert(!legacy.Owns("chat_messages_3_202610"));
+    assert(!legacy.Owns("chat_messages_bench"));
+
+    // 按月分区：以 UTC 年月选表，时间窗跨年时按月展开
+    MessageShardLayout monthly;
+    monthly.prefix  = "chat_messages_v2";
+    monthly.shards  = 4;
+    monthly.monthly = true;
+    std::time_t oct_2026 = 1791504000;   // 2026-10-09 UTC
+    std::time_t jan_2027 = 1801180800;   // 2027-01-29 UTC
+    assert(monthly.TableFor(1, 2, oct_2026) == "chat_messages_v2_3_202610");
+    assert(monthly.TableShard("chat_messages_v2_3_202610") == 3);
+    assert(monthly.TableShard("chat_messages_v2_3") == -1);
+    assert(monthly.TableShard("chat_messages_v2_4_202610") == -1);
+    assert(!legacy.Owns("chat_messages_v2_3_202610"));
+
+    auto tables = monthly.TablesInRange(oct_2026, jan_2027);
+    assert(tables.size() == 4 * 4);   // 10, 11, 12, 01
+    assert(tables[3] == "chat_messages_v2_0_202701");
+
+    // 单个会话只展开自己的分表，从新到旧
+    auto conv = monthly.ConversationTables(2, 1, oct_2026, jan_2027);
+    assert(conv.size() == 4);
+    assert(conv.front() == "chat_messages_v2_3_202701");
+    assert(conv.back() == "chat_messages_v2_3_202610");
+    assert(legacy.ConversationTables(1002, 1019, 0, jan_2027).size() == 1);
+
+    assert(MessageShardMap::ParsePhase(MessageShardMap::PhaseName(ReshardPhase::CUTOVER))
+           == ReshardPhase::CUTOVER);
+    assert(MessageShardMap::ParsePhase("bogus") == ReshardPhase::NONE);
+    return 0;
+}
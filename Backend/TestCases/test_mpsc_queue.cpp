@@ -0,0 +1,48 @@
+#include "infra/MpscQueue.h"
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+int main() {
+    MpscQueue<int> queue;
+    int            value = 0;
+    assert(queue.Empty() && !queue.Pop(value));
+
+    queue.Push(1);
+    queue.Push(2);
+    assert(!queue.Empty());
+    assert(queue.Pop(value) && value == 1);
+    assert(queue.Pop(value) && value == 2);
+    assert(queue.Empty() && !queue.Pop(value));
+
+    // 多个生产者并发写入，消费者看到的每个生产者的元素保持各自的提交顺序
+    const int                producers  = 4;
+    const int                per_thread = 100000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < per_thread; ++i) {
+                queue.Push(p * per_thread + i);
+            }
+        });
+    }
+
+    std::vector<int> last(producers, -1);
+    int              received = 0;
+    while (received < producers * per_thread) {
+        if (!queue.Pop(value)) continue;
+        int p = value / per_thread;
+        assert(value % per_thread == last[p] + 1);
+        last[p] = value % per_thread;
+        ++received;
+    }
+    for (auto& t : threads) t.join();
+    assert(queue.Empty());
+
+    // 析构时释放未消费的元素
+    MpscQueue<std::vector<int>> pending;
+    pending.Push(std::vector<int>(1024));
+    pending.Push(std::vector<int>(1024));
+    return 0;
+}
@@ -0,0 +1,65 @@
+// 下载小文件缓存：命中、失效、单文件上限、按容量淘汰与统计
+// 在 Backend 目录（config.ini 所在目录）下运行，按默认配置断言：
+// 总容量 64MB，单文件上限 256KB
+#include "SmallFileCache.h"
+#include <cassert>
+#include <string>
+
+namespace {
+
+constexpr std::size_t KB = 1024;
+
+grpc::Slice Content(std::size_t size, char fill) {
+    return grpc::Slice(std::string(size, fill));
+}
+
+}   // namespace
+
+int main() {
+    auto cache = SmallFileCache::getInstance();
+    assert(cache->Enabled());
+    assert(cache->MaxFileSize() == 256 * KB);
+
+    // 命中时返回同一份内容，发送只增加引用
+    SmallFileCache::Entry entry;
+    assert(!cache->Get("avatar_1.png", entry));
+    cache->RecordMiss();
+    cache->Put("avatar_1.png", "md5-a", Content(4 * KB, 'a'));
+    assert(cache->Get("avatar_1.png", entry));
+    assert(entry.file_md5 == "md5-a" && entry.data.size() == 4 * KB);
+    assert(entry.data.begin()[0] == 'a');
+    cache->RecordServed(entry.data.size());
+
+    // 重新放入同名文件替换旧内容，字节数不重复计算
+    cache->Put("avatar_1.png", "md5-b", Content(8 * KB, 'b'));
+    assert(cache->Get("avatar_1.png", entry) && entry.file_md5 == "md5-b");
+    assert(cache->GetStats().bytes == 8 * KB);
+
+    // 文件名改指向其他内容后失效
+    cache->Invalidate("avatar_1.png");
+    assert(!cache->Get("avatar_1.png", entry));
+
+    // 超过单文件上限的不缓存
+    cache->Put("large.bin", "md5-l", Content(256 * KB + 1, 'l'));
+    assert(!cache->Get("large.bin", entry));
+
+    // 总容量用满后淘汰最久未访问的文件
+    const std::size_t count = 64 * 1024 / 256 + 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        cache->Put("thumb_" + std::to_string(i), "md5", Content(256 * KB, 't'));
+        if (i == 0) assert(cache->Get("thumb_0", entry));
+    }
+    assert(!cache->Get("thumb_0", entry));
+    assert(cache->Get("thumb_" + std::to_string(count - 1), entry));
+
+    auto stats = cache->GetStats();
+    assert(stats.evictions == 1);
+    assert(stats.entries == count - 1);
+    assert(stats.bytes <= 64 * 1024 * KB);
+    assert(stats.misses == 1);
+    assert(stats.hits == 4);
+    assert(stats.bytes_served == 4 * KB);
+    assert(stats.hit_ratio() == 0.8);
+    cache->LogStats();
+    return 0;
+}
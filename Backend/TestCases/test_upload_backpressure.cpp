@@ -0,0 +1,71 @@
+// 上传背压额度：单流额度、全局上限与按登记顺序唤醒
+// 在 Backend 目录（config.ini 所在目录）下运行，按默认额度断言：
+// 全局 1024MB，每个上传 64MB
+#include "BackPressureManager.h"
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t MB = 1024 * 1024;
+
+}   // namespace
+
+int main() {
+    auto manager = BackPressureManager::getInstance();
+    std::vector<std::string> woken;
+    auto on_credit = [&woken](const std::string& stream) {
+        return [&woken, stream]() { woken.push_back(stream); };
+    };
+
+    // 单个上传用满自己的额度后暂停，不影响其他上传
+    manager->charge("a", 64 * MB);
+    assert(!manager->request_credit("a", on_credit("a")));
+    assert(manager->request_credit("b", on_credit("b")));
+
+    // 归还一部分后被唤醒，且只唤醒一次
+    manager->notify_data_flushed("a", 2 * MB);
+    assert(woken.size() == 1 && woken[0] == "a");
+    manager->notify_data_flushed("a", 2 * MB);
+    assert(woken.size() == 1);
+    manager->notify_data_flushed("a", 60 * MB);
+
+    // 全局用满后所有上传都暂停，按登记顺序唤醒
+    woken.clear();
+    for (int i = 0; i < 16; ++i) {
+        manager->charge("s" + std::to_string(i), 64 * MB);
+    }
+    assert(manager->in_flight_bytes() == 1024 * MB);
+    assert(!manager->request_credit("x", on_credit("x")));
+    assert(!manager->request_credit("y", on_credit("y")));
+    assert(manager->waiting_streams() == 2);
+    manager->notify_data_flushed("s0", 4 * MB);
+    assert(woken.size() == 2 && woken[0] == "x" && woken[1] == "y");
+
+    // 结束的上传撤销等待，剩余在途字节归还后不再回调
+    woken.clear();
+    assert(!manager->request_credit("s1", on_credit("s1")));
+    manager->close_stream("s1");
+    assert(manager->waiting_streams() == 0);
+    for (int i = 0; i < 16; ++i) {
+        manager->notify_data_flushed("s" + std::to_string(i), 64 * MB);
+    }
+    assert(woken.empty());
+    assert(manager->in_flight_bytes() == 0);
+
+    // 同一内容的两个并发上传各有自己的额度，结束一个不影响另一个的等待
+    auto first  = manager->new_stream("md5");
+    auto second = manager->new_stream("md5");
+    assert(first != second);
+    manager->charge(first, 64 * MB);
+    manager->charge(second, 64 * MB);
+    assert(!manager->request_credit(first, on_credit(first)));
+    assert(!manager->request_credit(second, on_credit(second)));
+    manager->close_stream(second);
+    manager->notify_data_flushed(first, 64 * MB);
+    assert(woken.size() == 1 && woken[0] == first);
+    manager->notify_data_flushed(second, 64 * MB);
+    assert(manager->in_flight_bytes() == 0);
+    return 0;
+}
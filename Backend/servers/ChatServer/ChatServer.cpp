@@ -81,6 +81,16 @@ void ChatServer::Register() {
         MsgId::ID_PULL_HISTORY_MSG_REQ, [this](auto session, const auto& msg) {
             LogicHandler::HandlePullHistory(session, msg);
         });
+    // 聊天记录检索
+    _dispatcher->Register(
+        MsgId::ID_SEARCH_MSG_REQ, [](auto session, const auto& msg) {
+            LogicHandler::HandleSearchMessages(session, msg);
+        });
+    // 会话历史翻页（消息表 + 冷存储）
+    _dispatcher->Register(
+        MsgId::ID_PULL_CONV_HISTORY_REQ, [](auto session, const auto& msg) {
+            LogicHandler::HandlePullConversation(session, msg);
+        });
 }
 
 void ChatServer::DoAccept() {
@@ -126,13 +126,13 @@ void LogicHandler::HandleLogin(
     if (!apply_list.empty()) {
         for (auto &apply : apply_list) {
             Json::Value obj;
-            obj["name"]   = apply->_name;
-            obj["uid"]    = apply->_uid;
-            obj["icon"]   = apply->_icon;
-            obj["nick"]   = apply->_nick;
-            obj["sex"]    = apply->_sex;
-            obj["desc"]   = apply->_desc;
-            obj["status"] = apply->_status;
+            obj["name"]   = apply._name;
+            obj["uid"]    = apply._uid;
+            obj["icon"]   = apply._icon;
+            obj["nick"]   = apply._nick;
+            obj["sex"]    = apply._sex;
+            obj["desc"]   = apply._desc;
+            obj["status"] = apply._status;
             root["apply_list"].append(obj);
         }
     }
@@ -143,13 +143,13 @@ void LogicHandler::HandleLogin(
         LOG_DEBUG("friendList is not empty");
         for (auto &friend_info : friendList) {
             Json::Value obj;
-            obj["name"] = friend_info->name;
-            obj["uid"]  = friend_info->uid;
-            obj["icon"] = friend_info->icon;
-            obj["nick"] = friend_info->nick;
-            obj["sex"]  = friend_info->sex;
-            obj["desc"] = friend_info->desc;
-            obj["back"] = friend_info->back;
+            obj["name"] = friend_info.name;
+            obj["uid"]  = friend_info.uid;
+            obj["icon"] = friend_info.icon;
+            obj["nick"] = friend_info.nick;
+            obj["sex"]  = friend_info.sex;
+            obj["desc"] = friend_info.desc;
+            obj["back"] = friend_info.back;
             root["friend_list"].append(obj);
         }
     }
@@ -237,31 +237,171 @@ void LogicHandler::HandlePullHistory(
         return;
     }
 
-    auto recent_msgs_res
-        = MessagePersistenceRepository::GetRecentMessagesWithCache(
-            uid, days, limit);
-    if (!recent_msgs_res.IsOK()) {
-        root["error"] = static_cast<int>(recent_msgs_res.Error());
+    // 缓存未命中时的分表查询在 MySQL 工作线程上完成，不占用会话所在的 io 线程；
+    // Send 内部投递到会话 strand，可以在任意线程调用
+    MessagePersistenceRepository::AsyncGetRecentMessagesWithCache(
+        uid,
+        days,
+        limit,
+        [session, uid](Result<std::vector<FriendMessages>> recent_msgs_res) {
+            Json::Value root;
+            root["uid"] = uid;
+            if (!recent_msgs_res.IsOK()) {
+                root["error"] = static_cast<int>(recent_msgs_res.Error());
+                session->Send(
+                    MsgId::ID_PULL_HISTORY_MSG_RSP, root.toStyledString());
+                return;
+            }
+
+            root["error"] = static_cast<int>(ErrorCodes::SUCCESS);
+
+            Json::Reader reader;
+            for (const auto &fm : recent_msgs_res.Value()) {
+                for (const auto &msg_json : fm.messages) {
+                    Json::Value msg_obj;
+                    if (!reader.parse(msg_json, msg_obj)
+                        || !msg_obj.isObject()) {
+                        continue;
+                    }
+                    root["messages"].append(msg_obj);
+                }
+            }
+
+            session->Send(
+                MsgId::ID_PULL_HISTORY_MSG_RSP, root.toStyledString());
+        });
+}
+
+void LogicHandler::HandleSearchMessages(
+    std::shared_ptr<Session> session, const Message &msg) {
+    Json::Value src, root;
+    if (!ParseJson(msg.body, src)) {
+        root["error"] = static_cast<int>(ErrorCodes::ERROR_JSON);
+        session->Send(MsgId::ID_SEARCH_MSG_RSP, root.toStyledString());
+        return;
+    }
+
+    const int         uid       = src["uid"].asInt();
+    const std::string keyword   = src["keyword"].asString();
+    const int64_t     before_ts = src["before_ts"].asInt64();
+    const int64_t     before_id = src["before_id"].asInt64();
+    int               limit = src.isMember("limit") ? src["limit"].asInt() : 20;
+    if (limit <= 0 || limit > 100) {
+        limit = 20;
+    }
+
+    // 只能检索自己的聊天记录
+    auto bound_session = UserManager::getInstance()->GetSession(uid);
+    if (!bound_session || bound_session->Id() != session->Id()) {
+        root["error"] = static_cast<int>(ErrorCodes::UID_INVALID);
         root["uid"]   = uid;
-        session->Send(MsgId::ID_PULL_HISTORY_MSG_RSP, root.toStyledString());
+        session->Send(MsgId::ID_SEARCH_MSG_RSP, root.toStyledString());
         return;
     }
 
-    root["error"] = static_cast<int>(ErrorCodes::SUCCESS);
-    root["uid"]   = uid;
+    MessagePersistenceRepository::AsyncSearchMessages(
+        uid,
+        keyword,
+        before_ts,
+        before_id,
+        limit,
+        [session, uid, keyword](Result<SearchPage> page_res) {
+            Json::Value root;
+            root["uid"]     = uid;
+            root["keyword"] = keyword;
+            if (!page_res.IsOK()) {
+                root["error"] = static_cast<int>(page_res.Error());
+                session->Send(MsgId::ID_SEARCH_MSG_RSP, root.toStyledString());
+                return;
+            }
 
-    Json::Reader reader;
-    for (const auto &fm : recent_msgs_res.Value()) {
-        for (const auto &msg_json : fm.messages) {
-            Json::Value msg_obj;
-            if (!reader.parse(msg_json, msg_obj) || !msg_obj.isObject()) {
-                continue;
+            const auto &page = page_res.Value();
+            root["error"]    = static_cast<int>(ErrorCodes::SUCCESS);
+            root["results"]  = Json::Value(Json::arrayValue);
+            for (const auto &hit : page.hits) {
+                Json::Value obj;
+                obj["msgid"]     = hit.msgid;
+                obj["fromuid"]   = hit.from_uid;
+                obj["touid"]     = hit.to_uid;
+                obj["peeruid"]   = hit.peer_uid;
+                obj["timestamp"] = static_cast<Json::Int64>(hit.msg_ts);
+                obj["content"]   = hit.body;
+                root["results"].append(obj);
             }
-            root["messages"].append(msg_obj);
-        }
+            // 下一页游标：本页最后一条
+            root["has_more"] = page.has_more;
+            if (page.has_more && !page.hits.empty()) {
+                root["before_ts"]
+                    = static_cast<Json::Int64>(page.hits.back().msg_ts);
+                root["before_id"]
+                    = static_cast<Json::Int64>(page.hits.back().id);
+            }
+            session->Send(MsgId::ID_SEARCH_MSG_RSP, root.toStyledString());
+        });
+}
+
+void LogicHandler::HandlePullConversation(
+    std::shared_ptr<Session> session, const Message &msg) {
+    Json::Value src, root;
+    if (!ParseJson(msg.body, src)) {
+        root["error"] = static_cast<int>(ErrorCodes::ERROR_JSON);
+        session->Send(MsgId::ID_PULL_CONV_HISTORY_RSP, root.toStyledString());
+        return;
+    }
+
+    const int     uid       = src["uid"].asInt();
+    const int     peer_uid  = src["peeruid"].asInt();
+    const int64_t before_ts = src["before_ts"].asInt64();
+    const int64_t before_id = src["before_id"].asInt64();
+    int           limit = src.isMember("limit") ? src["limit"].asInt() : 50;
+    if (limit <= 0 || limit > 200) {
+        limit = 50;
     }
 
-    session->Send(MsgId::ID_PULL_HISTORY_MSG_RSP, root.toStyledString());
+    auto bound_session = UserManager::getInstance()->GetSession(uid);
+    if (!bound_session || bound_session->Id() != session->Id()) {
+        root["error"] = static_cast<int>(ErrorCodes::UID_INVALID);
+        root["uid"]   = uid;
+        session->Send(MsgId::ID_PULL_CONV_HISTORY_RSP, root.toStyledString());
+        return;
+    }
+
+    MessagePersistenceRepository::AsyncGetConversationHistory(
+        uid,
+        peer_uid,
+        before_ts,
+        before_id,
+        limit,
+        [session, uid, peer_uid](Result<ConversationPage> page_res) {
+            Json::Value root;
+            root["uid"]     = uid;
+            root["peeruid"] = peer_uid;
+            if (!page_res.IsOK()) {
+                root["error"] = static_cast<int>(page_res.Error());
+                session->Send(
+                    MsgId::ID_PULL_CONV_HISTORY_RSP, root.toStyledString());
+                return;
+            }
+
+            const auto &page = page_res.Value();
+            root["error"]    = static_cast<int>(ErrorCodes::SUCCESS);
+            root["messages"] = Json::Value(Json::arrayValue);
+            Json::Reader reader;
+            for (const auto &msg_json : page.messages) {
+                Json::Value msg_obj;
+                if (reader.parse(msg_json, msg_obj) && msg_obj.isObject()) {
+                    root["messages"].append(msg_obj);
+                }
+            }
+            // 下一页游标：本页最后一条
+            root["has_more"] = page.has_more;
+            if (page.has_more) {
+                root["before_ts"] = static_cast<Json::Int64>(page.next_ts);
+                root["before_id"] = static_cast<Json::Int64>(page.next_id);
+            }
+            session->Send(
+                MsgId::ID_PULL_CONV_HISTORY_RSP, root.toStyledString());
+        });
 }
 
 void LogicHandler::AddFriendApply(
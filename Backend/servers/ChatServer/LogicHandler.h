@@ -25,6 +25,10 @@ public:
         const ChatServerInfo& server_info, std::shared_ptr<Session> session,
         const Message& msg);
     static void HandlePullHistory(std::shared_ptr<Session> session, const Message& msg);
+    static void HandleSearchMessages(
+        std::shared_ptr<Session> session, const Message& msg);
+    static void HandlePullConversation(
+        std::shared_ptr<Session> session, const Message& msg);
     static void HandleHeartBeat(std::shared_ptr<Session> session, const Message& msg);
 
 private:
@@ -1,6 +1,7 @@
 #include "MessagePersistenceService.h"
 #include "infra/DistLock.h"
 #include "infra/LogManager.h"
+#include "infra/MessageShardMap.h"
 #include "repository/MessagePersistenceRepository.h"
 #include <chrono>
 #include <thread>
@@ -75,7 +76,9 @@ void MessagePersistenceService::PersistMessages() {
 
 void MessagePersistenceService::DoPersistMessages() {
     // 使用分布式锁防止多实例重复处理
-    DistLock lock("lock:msg:persistence", 10, 5);
+    // 其他实例正在处理时直接跳过本轮，不等待；批量持久化耗时不定，持有期间自动续期
+    DistLock lock(LockService::getInstance()->TryAcquire(
+        "lock:msg:persistence", std::chrono::seconds(10), true));
 
     if (!lock.isLocked()) {
         LOG_DEBUG(
@@ -85,6 +88,9 @@ void MessagePersistenceService::DoPersistMessages() {
 
     LOG_DEBUG("[MessagePersistence] Acquired lock, starting persistence");
 
+    // 刷新重分片阶段，本轮写入都按该阶段选表（迁移工具持锁切换阶段）
+    MessageShardMap::getInstance()->AcknowledgePhase();
+
     // 获取所有待处理的对话队列
     auto queues_res = MessagePersistenceRepository::GetAllChatQueues();
     if (!queues_res.IsOK()) {
@@ -100,6 +106,7 @@ void MessagePersistenceService::DoPersistMessages() {
 
     int total_persisted = 0;
     int total_failed    = 0;
+    int total_unindexed = 0;
 
     // 对每个对话队列进行处理
     for (const auto& [from_uid, to_uid] : queues) {
@@ -121,30 +128,79 @@ void MessagePersistenceService::DoPersistMessages() {
             continue;
         }
 
-        // 2. 确定目标表
-        std::string table_name
-            = MessagePersistenceRepository::GetChatMessageTableName(
-                from_uid, to_uid);
+        // 2. 按消息时间确定目标表：按月分区时跨月的批次拆成多段，
+        //    重分片双写窗口内每段有主表 + 影子表
+        auto runs = MessagePersistenceRepository::GetChatMessageTables(
+            from_uid, to_uid, messages);
+
+        // 3. 预留会话序号后逐段批量插入到 MySQL，主表结果决定该段成败；
+        //    某段失败时停止，已写入的前缀从 Redis 删除，其余等下次重试
+        int64_t first_seq = MessagePersistenceRepository::AllocateMessageSeq(
+            from_uid, to_uid, static_cast<int>(messages.size()));
+
+        std::size_t persisted = 0;   // 已写入主表的前缀条数
+        for (const auto& run : runs) {
+            const std::string&       table_name = run.tables.front();
+            std::vector<std::string> part(
+                messages.begin() + run.begin, messages.begin() + run.end);
+
+            int64_t seq = first_seq > 0 ? first_seq + run.begin : 0;
+
+            auto insert_res = MessagePersistenceRepository::BatchInsertToMySQL(
+                table_name, part, seq);
+            if (!insert_res.IsOK()) {
+                // 插入失败，消息保留在 Redis 中等待下次重试
+                total_failed++;
+                LOG_ERROR(
+                    "[MessagePersistence] Failed to insert messages to {}: {} "
+                    "-> {}",
+                    table_name,
+                    from_uid,
+                    to_uid);
+                break;
+            }
 
-        // 3. 批量插入到 MySQL
-        auto insert_res = MessagePersistenceRepository::BatchInsertToMySQL(
-            table_name, messages);
+            // 全文索引随批次增量维护；索引写入失败不影响消息落库，
+            // 文档以 (owner_uid, msgid) 去重，重建时重放即可
+            auto index_res
+                = MessagePersistenceRepository::IndexMessagesForSearch(part);
+            if (!index_res.IsOK()) {
+                total_unindexed += part.size();
+            }
+
+            // 影子表写入失败不阻塞主流程，记下会话交给迁移工具重新复制
+            for (std::size_t i = 1; i < run.tables.size(); ++i) {
+                auto shadow_res
+                    = MessagePersistenceRepository::BatchInsertToMySQL(
+                        run.tables[i], part, seq);
+                if (!shadow_res.IsOK()) {
+                    LOG_WARN(
+                        "[MessagePersistence] Dual write to {} failed: {} -> "
+                        "{}",
+                        run.tables[i],
+                        from_uid,
+                        to_uid);
+                    MessageShardMap::getInstance()->MarkDirty(from_uid, to_uid);
+                }
+            }
 
-        if (insert_res.IsOK()) {
-            // 4. 插入成功，从 Redis 删除已处理的消息
+            persisted = run.end;
+            LOG_DEBUG(
+                "[MessagePersistence] Persisted {} messages: {} -> {} to {}",
+                part.size(),
+                from_uid,
+                to_uid,
+                table_name);
+        }
+
+        if (persisted > 0) {
+            // 4. 从 Redis 删除已写入的消息
             auto remove_res
                 = MessagePersistenceRepository::RemovePersistedMessages(
-                    from_uid, to_uid, messages.size());
+                    from_uid, to_uid, static_cast<int>(persisted));
 
             if (remove_res.IsOK()) {
-                total_persisted += messages.size();
-                LOG_DEBUG(
-                    "[MessagePersistence] Persisted {} messages: {} -> {} to "
-                    "{}",
-                    messages.size(),
-                    from_uid,
-                    to_uid,
-                    table_name);
+                total_persisted += persisted;
             } else {
                 LOG_WARN(
                     "[MessagePersistence] Failed to remove cached messages: {} "
@@ -152,15 +208,6 @@ void MessagePersistenceService::DoPersistMessages() {
                     from_uid,
                     to_uid);
             }
-        } else {
-            // 插入失败，消息保留在 Redis 中等待下次重试
-            total_failed++;
-            LOG_ERROR(
-                "[MessagePersistence] Failed to insert messages to {}: {} -> "
-                "{}",
-                table_name,
-                from_uid,
-                to_uid);
         }
     }
 
@@ -171,4 +218,10 @@ void MessagePersistenceService::DoPersistMessages() {
             total_persisted,
             total_failed);
     }
+    if (total_unindexed > 0) {
+        LOG_WARN(
+            "[MessagePersistence] {} persisted messages missing from search "
+            "index",
+            total_unindexed);
+    }
 }
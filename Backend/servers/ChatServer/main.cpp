@@ -4,6 +4,8 @@
 #include "infra/AsioIOServicePool.h"
 #include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
+#include "infra/MySqlPoolManager.h"
+#include "infra/NearCache.h"
 #include "infra/RedisManager.h"
 #include "repository/ChatServerRepository.h"
 #include <boost/asio/io_context.hpp>
@@ -79,6 +81,9 @@ int main(int argc, char* argv[]) {
             ioc.stop();
             ChatServerRepository::RestConnection(ServerName);
             AsioIOServicePool::getInstance()->Stop();
+            NearCache::getInstance()->LogStats();
+            MySqlPoolManager::getInstance()->LogStats();
+            NearCache::getInstance()->Stop();
         });
 
         LOG_INFO("[ChatServer] running...");
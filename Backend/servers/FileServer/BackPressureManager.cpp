@@ -1,30 +1,119 @@
 #include "BackPressureManager.h"
+#include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
+#include <algorithm>
+#include <cstdlib>
 #include <mutex>
+#include <vector>
 
+namespace {
 
-void BackPressureManager::wait_if_needed(size_t chunk_size) {
-    std::unique_lock<std::mutex> lock(_mutex);
-    LOG_WARN(
-        "[Backpressure] In-flight bytes ({}) > threshold. Waiting...",
-        _in_flight_bytes.load() + chunk_size);
-    _cv.wait(lock, [&]() {
-        return _in_flight_bytes + chunk_size <= MAX_IN_FLIGHT_BYTES;
-    });
-    LOG_INFO("[Backpressure] Resuming...");
-    _in_flight_bytes += chunk_size;
+size_t ConfigMegabytes(const std::string& key, size_t fallback) {
+    auto value = (*ConfigManager::getInstance())["FileServer"][key];
+    int  n     = value.empty() ? 0 : std::atoi(value.c_str());
+    return (n > 0 ? static_cast<size_t>(n) : fallback) * 1024 * 1024;
 }
 
+}   // namespace
 
-void BackPressureManager::notify_data_flushed(size_t flushed_size) {
+BackPressureManager::BackPressureManager()
+    : _global_limit(ConfigMegabytes("upload_inflight_mb", 1024))
+    , _stream_limit(ConfigMegabytes("upload_stream_inflight_mb", 64)) {
+    LOG_INFO(
+        "[Backpressure] in-flight limit {} MB, per upload {} MB",
+        _global_limit / (1024 * 1024),
+        _stream_limit / (1024 * 1024));
+}
+
+std::string BackPressureManager::new_stream(const std::string& file_md5) {
+    return file_md5 + "#" + std::to_string(_stream_seq.fetch_add(1));
+}
+
+bool BackPressureManager::has_credit(const StreamState& state) const {
+    return state.in_flight < _stream_limit && _in_flight_bytes < _global_limit;
+}
+
+void BackPressureManager::charge(const std::string& stream, size_t bytes) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& state = _streams[stream];
+    state.closed = false;
+    state.in_flight += bytes;
+    _in_flight_bytes += bytes;
+}
+
+bool BackPressureManager::request_credit(
+    const std::string& stream, std::function<void()> on_credit) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& state = _streams[stream];
+    if (has_credit(state)) return true;
+
+    LOG_DEBUG(
+        "[Backpressure] Pausing {}: stream {} bytes, total {} bytes",
+        stream,
+        state.in_flight,
+        _in_flight_bytes);
+    state.on_credit = std::move(on_credit);
+    _waiting.push_back(stream);
+    return false;
+}
+
+void BackPressureManager::notify_data_flushed(
+    const std::string& stream, size_t flushed_size) {
     if (flushed_size == 0) {
         return;
     }
 
-    _in_flight_bytes -= flushed_size;
-    _cv.notify_one();
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _streams.find(stream);
+        if (it != _streams.end()) {
+            auto& state = it->second;
+            state.in_flight -= std::min(state.in_flight, flushed_size);
+            if (state.closed && state.in_flight == 0) {
+                _streams.erase(it);
+            }
+        }
+        _in_flight_bytes -= std::min(_in_flight_bytes, flushed_size);
+
+        // 按登记顺序唤醒；自身额度仍满的流留在队列里，不挡后面的流
+        for (auto w = _waiting.begin();
+             w != _waiting.end() && _in_flight_bytes < _global_limit;) {
+            auto state = _streams.find(*w);
+            if (state == _streams.end() || !state->second.on_credit) {
+                w = _waiting.erase(w);
+            } else if (has_credit(state->second)) {
+                ready.push_back(std::move(state->second.on_credit));
+                state->second.on_credit = nullptr;
+                w = _waiting.erase(w);
+            } else {
+                ++w;
+            }
+        }
+    }
+    for (auto& on_credit : ready) on_credit();
+}
+
+void BackPressureManager::close_stream(const std::string& stream) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _waiting.erase(
+        std::remove(_waiting.begin(), _waiting.end(), stream), _waiting.end());
+    auto it = _streams.find(stream);
+    if (it == _streams.end()) return;
+    it->second.on_credit = nullptr;
+    if (it->second.in_flight == 0) {
+        _streams.erase(it);
+    } else {
+        it->second.closed = true;
+    }
+}
+
+size_t BackPressureManager::in_flight_bytes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _in_flight_bytes;
 }
 
-void BackPressureManager::notify_all() {
-    _cv.notify_all();
+size_t BackPressureManager::waiting_streams() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _waiting.size();
 }
@@ -3,21 +3,62 @@
 
 #include "common/singleton.h"
 #include <atomic>
-#include <condition_variable>
-#include <type_traits>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 上传背压：按额度决定是否发起下一次 Read，CQ 线程从不阻塞
+// 每个上传调用（以 new_stream 分配的标识区分）有自己的在途额度，
+// 所有流再共享一个全局上限；
+// 收到的块计入在途，worker 写盘后归还。额度不足的流登记回调后暂停读取，
+// 归还时按登记顺序唤醒，单个快速上传最多占满自己的额度，饿不死其他上传
 class BackPressureManager : public SingleTon<BackPressureManager> {
     friend class SingleTon<BackPressureManager>;
 
 public:
-        void wait_if_needed(size_t chunk_size);
-        void notify_data_flushed(size_t flushed_size);
-        void notify_all();
+    // @brief: 为一次上传调用分配标识（file_md5#序号），同一内容的并发上传
+    //         各有自己的额度与等待回调，互不覆盖
+    std::string new_stream(const std::string& file_md5);
+
+    // @brief: 已收到的块计入该流和全局的在途字节
+    void charge(const std::string& stream, size_t bytes);
+
+    // @brief: 还有额度继续读取时返回 true；否则登记 on_credit 并返回 false，
+    //         额度归还后在调用 notify_data_flushed 的线程上回调一次
+    bool request_credit(
+        const std::string& stream, std::function<void()> on_credit);
+
+    // @brief: worker 写盘（或丢弃）后归还额度，并唤醒满足条件的等待者
+    void notify_data_flushed(const std::string& stream, size_t flushed_size);
+
+    // @brief: 上传结束，撤销等待；尚在途的字节仍由 worker 归还
+    void close_stream(const std::string& stream);
+
+    size_t in_flight_bytes();
+    size_t waiting_streams();
+
 private:
-    BackPressureManager() = default;
-    std::atomic<size_t>     _in_flight_bytes{0};
-    std::mutex              _mutex;
-    std::condition_variable _cv;
-    static const size_t MAX_IN_FLIGHT_BYTES = 1024 * 1024 * 1024 ;   // 1GB
+    BackPressureManager();
+
+    struct StreamState {
+        size_t                in_flight = 0;
+        bool                  closed    = false;
+        std::function<void()> on_credit;
+    };
+
+    // @brief: 在锁内调用
+    bool has_credit(const StreamState& state) const;
+
+    std::mutex                                   _mutex;
+    std::unordered_map<std::string, StreamState> _streams;
+    std::deque<std::string>                      _waiting;   // 按登记顺序唤醒
+    size_t                                       _in_flight_bytes = 0;
+    size_t                                       _global_limit;
+    size_t                                       _stream_limit;
+    std::atomic<uint64_t>                        _stream_seq{0};
 };
 
 
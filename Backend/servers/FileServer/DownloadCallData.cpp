@@ -1,14 +1,19 @@
 #include "DownloadCallData.h"
+#include "DownloadIoPool.h"
 #include "FileIndexManager.h"
+#include "SmallFileCache.h"
+#include "common/DownloadFrame.h"
+#include "common/DownloadRange.h"
 #include "const.h"
 #include "file.pb.h"
 #include "infra/LogManager.h"
 #include "repository/FileRepository.h"
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <grpcpp/completion_queue.h>
+#include <grpc/support/time.h>
 #include <grpcpp/support/status.h>
-#include <ios>
 #include <ratio>
 
 namespace fs = std::filesystem;
@@ -20,12 +25,12 @@ std::string DownloadCallData::GenerateSessionID() {
 }
 
 DownloadCallData::DownloadCallData(
-    FileTransport::AsyncService* service, ServerCompletionQueue* cq)
+    FileTransportService* service, ServerCompletionQueue* cq)
     : _service(service)
     , _cq(cq)
     , _writer(&_context)
-    , _state(CallState::CREATE)
-    , _buffer(2 * 1024 * 1024) {
+    , _state(CallState::CREATE) {
+    _ready_tag.owner = this;
     Proceed(true);
 }
 
@@ -59,7 +64,7 @@ void DownloadCallData::Proceed(bool ok) {
 void DownloadCallData::handleCreateState() {
     _state = CallState::PROCESS;
     _service->RequestDownloadFile(
-        &_context, &_request, &_writer, _cq, _cq, this);
+        &_context, &_request_buffer, &_writer, _cq, _cq, this);
 }
 
 void DownloadCallData::handleProcessState(bool ok) {
@@ -70,21 +75,36 @@ void DownloadCallData::handleProcessState(bool ok) {
 
     createNextHandler();
 
+    if (!DownloadFrame::ParseRequest(&_request_buffer, &_request)) {
+        finishWithError(
+            grpc::StatusCode::INVALID_ARGUMENT, "Malformed download request");
+        return;
+    }
+
     std::string request_filename = _request.file_name();
     _start_offset                = _request.start_offset();   // 获取起始偏移量
 
     LOG_INFO(
-        "[DownloadCallData] Download request: file={}, offset={}",
+        "[DownloadCallData] Download request: file={}, offset={}, end={}, "
+        "length={}",
         request_filename,
-        _start_offset);
+        _start_offset,
+        _request.end_offset(),
+        _request.length());
 
-    auto validation = validateDownloadRequest(request_filename, _start_offset);
+    // 热点小文件直接从内存发送，不查索引、不打开文件
+    if (serveFromCache(request_filename)) {
+        return;
+    }
+
+    auto validation = validateDownloadRequest(_request);
     if (!validation.is_valid) {
         if (validation.error_code == grpc::StatusCode::NOT_FOUND) {
             handleFileNotFoundError(request_filename);
         } else if (
             validation.error_code == grpc::StatusCode::INVALID_ARGUMENT) {
-            handleInvalidOffsetError(_start_offset, validation.file_size);
+            handleInvalidRangeError(
+                validation.error_message, validation.file_size);
         } else {
             finishWithError(validation.error_code, validation.error_message);
         }
@@ -100,19 +120,75 @@ void DownloadCallData::handleProcessState(bool ok) {
             grpc::StatusCode::INTERNAL, "Failed to initialize session");
         return;
     }
+    _end_offset = validation.range_end;
+    // blob 按内容寻址，文件名即整个文件的 MD5
+    _file_md5 = fs::path(validation.file_path).filename().string();
+
+    auto cache = SmallFileCache::getInstance();
+    if (cache->Enabled()
+        && validation.file_size <= static_cast<int64>(cache->MaxFileSize())) {
+        cache->RecordMiss();
+        // 整个文件一块发完，发送的同时放入缓存
+        _cache_fill = _start_offset == 0 && _end_offset == _file_size
+                      && _file_size > 0;
+    }
 
     if (!openFileStream(validation.file_path, _start_offset)) {
         handleFileOpenError();
         return;
     }
 
+    beginTransfer(request_filename);
+}
+
+bool DownloadCallData::serveFromCache(const std::string& file_name) {
+    SmallFileCache::Entry entry;
+    if (!SmallFileCache::getInstance()->Get(file_name, entry)) {
+        return false;
+    }
+
+    // 区间不合法时交给常规路径报错
+    auto                 file_size = static_cast<int64>(entry.data.size());
+    DownloadRange::Range range;
+    if (!DownloadRange::Resolve(
+            _request.start_offset(),
+            _request.end_offset(),
+            _request.length(),
+            file_size,
+            &range)) {
+        return false;
+    }
+
+    initializeDownloadSession(file_name, "", range.first, file_size);
+    _end_offset     = range.second;
+    _file_md5       = entry.file_md5;
+    _cached         = std::move(entry.data);
+    _from_cache     = true;
+    _metrics.source = "cache";
+
+    beginTransfer(file_name);
+    return true;
+}
+
+void DownloadCallData::beginTransfer(const std::string& file_name) {
+    // 区间下载由客户端按区间记录进度，写进按文件名记录的断点
+    // 会被整文件续传误用；一块就能发完的下载断点没有意义，省掉几次 Redis 写
+    _save_breakpoint
+        = !DownloadRange::IsPartial(_request.end_offset(), _request.length())
+          && _end_offset - _start_offset > static_cast<int64>(CHUNK_SIZE);
+    if (_request.range_md5()) {
+        _range_hash = std::make_unique<Md5Stream>();
+    }
+
     // 保存初始断点
-    FileRepository::SaveDownloadProgress(
-        request_filename, _session_id, _current_offset);
+    if (_save_breakpoint) {
+        FileRepository::SaveDownloadProgress(
+            file_name, _session_id, _current_offset);
+    }
 
     _last_saved_offset = _current_offset;
 
-    sendFileMetadata(request_filename, validation.file_size);
+    sendFileMetadata(file_name, _file_size, _file_md5);
 
     // perforamnce metrics
     _start_time = std::chrono::high_resolution_clock::now();
@@ -124,17 +200,26 @@ void DownloadCallData::handleStreamState(bool ok) {
         return;
     }
 
-    // 读取并发送数据块
-    readAndSendChunk();
+    // 上一次写已完成（元数据或数据块）
+    if (_write_start.time_since_epoch().count() != 0) {
+        _metrics.network_write_duration_ms
+            += std::chrono::duration<double, std::milli>(
+                   std::chrono::high_resolution_clock::now() - _write_start)
+                   .count();
+    }
+
+    sendNextChunk();
 }
 
 void DownloadCallData::handleFinishState() {
-    if (_file_stream.is_open()) {
-        _file_stream.close();
+    if (_read_ahead) {
+        _read_ahead->Cancel();
+        _read_ahead.reset();
     }
+    _mapping.reset();
 
     // 只有完整下载成功时才删除断点
-    if (_download_completed && !_session_id.empty()
+    if (_download_completed && _save_breakpoint && !_session_id.empty()
         && !_request.file_name().empty()) {
         FileRepository::DeleteDownloadProgress(
             _request.file_name(), _session_id);
@@ -144,11 +229,13 @@ void DownloadCallData::handleFinishState() {
 }
 
 DownloadValidationResult DownloadCallData::validateDownloadRequest(
-    const std::string& file_name, int64 start_offset) {
+    const FileService::DownloadRequest& request) {
 
     DownloadValidationResult result;
     result.is_valid = false;
 
+    const std::string& file_name = request.file_name();
+
     // 查找文件路径
     std::string file_path
         = FileIndexManager::getInstance()->find_path(file_name);
@@ -169,15 +256,25 @@ DownloadValidationResult DownloadCallData::validateDownloadRequest(
         return result;
     }
 
-    // 验证偏移量
-    if (start_offset < 0 || start_offset > result.file_size) {
-        result.error_code = grpc::StatusCode::INVALID_ARGUMENT;
+    // 验证偏移量与区间
+    DownloadRange::Range range;
+    if (!DownloadRange::Resolve(
+            request.start_offset(),
+            request.end_offset(),
+            request.length(),
+            result.file_size,
+            &range)) {
+        result.error_code    = grpc::StatusCode::INVALID_ARGUMENT;
         result.error_message
-            = "Invalid start_offset: " + std::to_string(start_offset);
+            = "Invalid range: start_offset="
+              + std::to_string(request.start_offset())
+              + ", end_offset=" + std::to_string(request.end_offset())
+              + ", length=" + std::to_string(request.length());
         return result;
     }
 
-    result.is_valid = true;
+    result.range_end = range.second;
+    result.is_valid  = true;
     return result;
 }
 
@@ -187,93 +284,220 @@ bool DownloadCallData::openFileStream(
     const std::string& file_path, int64 start_offset) {
 
     auto open_start = std::chrono::high_resolution_clock::now();
-
-    _file_stream.open(file_path, std::ios::binary);
-
-    if (!_file_stream.is_open()) {
-        return false;
+    auto pool       = DownloadIoPool::getInstance();
+
+    // 空区间无需映射（也无法映射空文件），交给预读直接结束
+    if (pool->UseMmap() && start_offset < _end_offset) {
+        _mapping = MappedFile::Open(file_path);
+        if (_mapping && _mapping->Size() == _file_size) {
+            _metrics.source = "mmap";
+            _mapping->WillNeed(start_offset, CHUNK_SIZE);
+        } else {
+            // 映射失败或文件在校验后变化，退回预读
+            LOG_WARN("[DownloadCallData] mmap unavailable for {}", file_path);
+            _mapping.reset();
+        }
     }
 
-    auto open_end = std::chrono::high_resolution_clock::now();
-
-    auto seek_start = std::chrono::high_resolution_clock::now();
-
-    if (start_offset > 0) {
-        _file_stream.seekg(start_offset);
-        LOG_INFO("[DownloadCallData] Seeking to offset: {}", start_offset);
+    if (!_mapping) {
+        // 打开即开始预读首批数据块，与元数据的发送重叠
+        _read_ahead = DownloadReadAhead::Open(
+            file_path,
+            start_offset,
+            _end_offset,
+            CHUNK_SIZE,
+            pool->ReadAheadDepth());
+        if (!_read_ahead) {
+            return false;
+        }
     }
 
-    auto seek_end = std::chrono::high_resolution_clock::now();
-    _metrics.file_seek_duration_ms
-        = std::chrono::duration<double, std::milli>(seek_end - seek_start)
-              .count();
+    auto open_end = std::chrono::high_resolution_clock::now();
     _metrics.file_open_duration_ms
         = std::chrono::duration<double, std::milli>(open_end - open_start)
               .count();
 
+    if (start_offset > 0) {
+        LOG_INFO("[DownloadCallData] Resuming from offset: {}", start_offset);
+    }
     return true;
 }
 
 void DownloadCallData::sendFileMetadata(
-    const std::string& file_name, int64 file_size) {
+    const std::string& file_name, int64 file_size,
+    const std::string& file_md5) {
 
     DownloadResponse meta_response;
     FileMeta*        meta = meta_response.mutable_meta();
     meta->set_file_name(file_name);
     meta->set_total_size(file_size);
+    meta->set_file_md5(file_md5);
+    meta->set_resume_offset(_start_offset);
 
-    _state = CallState::STREAM;
-    _writer.Write(meta_response, this);
+    _state       = CallState::STREAM;
+    _write_start = std::chrono::high_resolution_clock::now();
+    _writer.Write(DownloadFrame::Message(meta_response), this);
 }
 
 // stream handle
-void DownloadCallData::readAndSendChunk() {
-    DownloadResponse chunk_response;
-    std::string*     chunk_data = chunk_response.mutable_chunk();
-    chunk_data->resize(CHUNK_SIZE);
+void DownloadCallData::sendNextChunk() {
+    if (_from_cache) {
+        sendCachedChunk();
+        return;
+    }
+    if (_mapping) {
+        sendMappedChunk();
+        return;
+    }
+    if (_read_ahead->Exhausted()) {
+        finishTransfer();
+        return;
+    }
 
-    // read time
-    auto read_start = std::chrono::high_resolution_clock::now();
+    DownloadReadAhead::Chunk chunk;
+    bool                     ready = _read_ahead->Take(chunk, [this]() {
+        // IO 线程上：经 Alarm 回到 CQ 线程继续发送
+        _ready_alarm.Set(_cq, gpr_now(GPR_CLOCK_MONOTONIC), &_ready_tag);
+    });
+    if (!ready) {
+        // 磁盘跟不上网络，等待预读完成
+        _stall_start = std::chrono::high_resolution_clock::now();
+        return;
+    }
 
-    _file_stream.read(chunk_data->data(), CHUNK_SIZE);
-    std::streamsize bytes_read = _file_stream.gcount();
+    _metrics.prefetch_hits++;
+    writeChunk(std::move(chunk));
+}
 
-    auto   read_end = std::chrono::high_resolution_clock::now();
-    double read_duration
-        = std::chrono::duration<double, std::milli>(read_end - read_start)
-              .count();
+void DownloadCallData::sendCachedChunk() {
+    if (_current_offset >= _end_offset) {
+        finishTransfer();
+        return;
+    }
+
+    // 缓存的文件不超过一块，剩余区间一次发完
+    grpc::Slice slice = _cached.sub(_current_offset, _end_offset);
+    if (_range_hash) {
+        _range_hash->Update(
+            reinterpret_cast<const char*>(slice.begin()), slice.size());
+    }
+    SmallFileCache::getInstance()->RecordServed(slice.size());
+    auto len = static_cast<int64>(slice.size());
+    writeFrame(DownloadFrame::Chunk(std::move(slice)), len);
+}
 
-    _metrics.file_read_duration_ms += read_duration;
+void DownloadCallData::sendMappedChunk() {
+    if (_current_offset >= _end_offset) {
+        finishTransfer();
+        return;
+    }
 
-    if (bytes_read > 0) {
-        chunk_data->resize(bytes_read);
-        _current_offset += bytes_read;
+    auto len = static_cast<std::size_t>(
+        std::min<int64>(CHUNK_SIZE, _end_offset - _current_offset));
+    // 发送本块时让内核预读下一块，gRPC 发送映射内存时少缺页
+    if (_current_offset + static_cast<int64>(len) < _end_offset) {
+        _mapping->WillNeed(_current_offset + len, CHUNK_SIZE);
+    }
+    grpc::Slice slice = _mapping->SliceAt(_current_offset, len);
+    if (_range_hash) {
+        _range_hash->Update(
+            reinterpret_cast<const char*>(slice.begin()), slice.size());
+    }
+    if (_cache_fill && static_cast<int64>(len) == _file_size) {
+        // 缓存持有一份拷贝，不让缓存项拖住整个映射
+        slice = grpc::Slice(slice.begin(), slice.size());
+        SmallFileCache::getInstance()->Put(
+            _request.file_name(), _file_md5, slice);
+    }
+    writeFrame(DownloadFrame::Chunk(std::move(slice)), static_cast<int64>(len));
+}
+
+void DownloadCallData::handleChunkReady(bool ok) {
+    _metrics.read_stall_duration_ms
+        += std::chrono::duration<double, std::milli>(
+               std::chrono::high_resolution_clock::now() - _stall_start)
+               .count();
+
+    if (!ok) {
+        handleDownloadCancelled();
+        return;
+    }
 
-        auto write_start = std::chrono::high_resolution_clock::now();
-        _writer.Write(chunk_response, this);
-        auto write_end = std::chrono::high_resolution_clock::now();
+    DownloadReadAhead::Chunk chunk;
+    if (!_read_ahead->Take(chunk, nullptr)) {
+        finishWithError(grpc::StatusCode::INTERNAL, "Read-ahead out of order");
+        return;
+    }
+    writeChunk(std::move(chunk));
+}
 
-        double write_duration
-            = std::chrono::duration<double, std::milli>(write_end - write_start)
-                  .count();
-        _metrics.network_write_duration_ms += write_duration;
+void DownloadCallData::writeChunk(DownloadReadAhead::Chunk chunk) {
+    _metrics.file_read_duration_ms += chunk.read_ms;
+    if (!chunk.ok) {
+        DownloadIoPool::getInstance()->ReleaseBuffer(std::move(chunk.data));
+        finishWithError(grpc::StatusCode::INTERNAL, "Failed to read file");
+        return;
+    }
 
-        // update metrics
-        _metrics.bytes_sent += bytes_read;
-        _metrics.chunk_count++;
-    } else {
-        LOG_INFO(
-            "[DownloadCallData] Transfer complete: offset={}", _current_offset);
-        handleDownloadComplete();
+    int64 bytes_read = static_cast<int64>(chunk.data->size());
+    if (_range_hash) {
+        _range_hash->Update(chunk.data->data(), chunk.data->size());
     }
+    if (_cache_fill && bytes_read == _file_size) {
+        // 块缓冲要回到缓冲池，缓存和本次发送共用一份拷贝
+        grpc::Slice copy(*chunk.data);
+        DownloadIoPool::getInstance()->ReleaseBuffer(std::move(chunk.data));
+        SmallFileCache::getInstance()->Put(
+            _request.file_name(), _file_md5, copy);
+        writeFrame(DownloadFrame::Chunk(std::move(copy)), bytes_read);
+        return;
+    }
+    // 块缓冲直接作为 Slice 交给 gRPC，发送完成后自动归还缓冲池
+    writeFrame(
+        DownloadFrame::Chunk(
+            DownloadIoPool::getInstance()->ToSlice(std::move(chunk.data))),
+        bytes_read);
+}
+
+void DownloadCallData::writeFrame(grpc::ByteBuffer frame, int64 bytes) {
+    _current_offset += bytes;
+
+    _write_start = std::chrono::high_resolution_clock::now();
+    _writer.Write(frame, this);
 
+    // update metrics
+    _metrics.bytes_sent += bytes;
+    _metrics.chunk_count++;
 
     if (shouldSaveBreakPoint()) {
         saveDownloadBreakPoint();
     }
 }
 
+void DownloadCallData::finishTransfer() {
+    if (_range_hash && !_digest_sent) {
+        sendRangeDigest();
+        return;
+    }
+    LOG_INFO(
+        "[DownloadCallData] Transfer complete: offset={}", _current_offset);
+    handleDownloadComplete();
+}
+
+void DownloadCallData::sendRangeDigest() {
+    DownloadResponse response;
+    RangeDigest*     range = response.mutable_range();
+    range->set_offset(_start_offset);
+    range->set_length(_current_offset - _start_offset);
+    range->set_md5(_range_hash->HexDigest());
+
+    _digest_sent = true;
+    _write_start = std::chrono::high_resolution_clock::now();
+    _writer.Write(DownloadFrame::Message(response), this);
+}
+
 bool DownloadCallData::shouldSaveBreakPoint() const {
+    if (!_save_breakpoint) return false;
     return (_current_offset - _last_saved_offset) >= SAVE_BREAKPOINT_INTERVAL;
 }
 
@@ -310,7 +534,8 @@ void DownloadCallData::handleDownloadCancelled() {
         = std::chrono::duration<double, std::milli>(end_time - _start_time)
               .count();
 
-    if (!_session_id.empty() && !_request.file_name().empty()) {
+    if (_save_breakpoint && !_session_id.empty()
+        && !_request.file_name().empty()) {
         FileRepository::UpdateDownloadProgress(
             _request.file_name(), _session_id, _current_offset);
         _last_saved_offset = _current_offset;
@@ -346,14 +571,10 @@ void DownloadCallData::handleFileSizeError() {
     finishWithError(grpc::StatusCode::INTERNAL, "Failed to get file size");
 }
 
-void DownloadCallData::handleInvalidOffsetError(int64 offset, int64 file_size) {
-    LOG_WARN(
-        "[DownloadCallData] Invalid offset: {}, file size: {}",
-        offset,
-        file_size);
-    finishWithError(
-        grpc::StatusCode::INVALID_ARGUMENT,
-        "Invalid start_offset: " + std::to_string(offset));
+void DownloadCallData::handleInvalidRangeError(
+    const std::string& message, int64 file_size) {
+    LOG_WARN("[DownloadCallData] {}, file size: {}", message, file_size);
+    finishWithError(grpc::StatusCode::INVALID_ARGUMENT, message);
 }
 
 void DownloadCallData::handleFileOpenError() {
@@ -377,6 +598,7 @@ bool DownloadCallData::initializeDownloadSession(
     _session_id         = GenerateSessionID();
     _start_offset       = start_offset;
     _current_offset     = start_offset;
+    _end_offset         = file_size;
     _file_size          = file_size;
     _last_saved_offset  = start_offset;
     _download_completed = false;
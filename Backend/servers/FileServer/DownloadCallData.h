@@ -2,22 +2,25 @@
 #define DOWNLOADCALLDATA_H_
 
 #include "CallData.h"
+#include "DownloadReadAhead.h"
+#include "Md5Stream.h"
 #include "const.h"
 #include "file.grpc.pb.h"
+#include "infra/MappedFile.h"
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <chrono>
 #include <cstdint>
-#include <fstream>
+#include <grpcpp/alarm.h>
+#include <grpcpp/support/byte_buffer.h>
 #include <grpcpp/support/status.h>
-#include <vector>
+#include <memory>
 
 class DownloadCallData : public CallData {
 public:
     DownloadCallData(
-        FileService::FileTransport::AsyncService* service,
-        grpc::ServerCompletionQueue*              cq);
+        FileTransportService* service, grpc::ServerCompletionQueue* cq);
     void Proceed(bool ok) override;
 
 private:
@@ -29,16 +32,30 @@ private:
     void handleProcessState(bool ok);
     void handleStreamState(bool ok);
     void handleFinishState();
+    // @brief: 命中小文件缓存时直接开始发送，未命中返回 false
+    bool serveFromCache(const std::string& file_name);
+    // @brief: 区间与数据源就绪后保存初始断点并发送元数据
+    void beginTransfer(const std::string& file_name);
 
-    DownloadValidationResult validateDownloadRequest(
-        const std::string& file_name, int64 start_offset);
+    DownloadValidationResult
+    validateDownloadRequest(const FileService::DownloadRequest& request);
 
     // file operation
     bool openFileStream(const std::string& file_path, int64 start_offset);
-    void sendFileMetadata(const std::string& file_name, int64 file_size);
+    void sendFileMetadata(
+        const std::string& file_name, int64 file_size,
+        const std::string& file_md5);
 
     // stream handle
-    void readAndSendChunk();
+    void sendNextChunk();
+    void sendMappedChunk();
+    void sendCachedChunk();
+    void writeChunk(DownloadReadAhead::Chunk chunk);
+    void writeFrame(grpc::ByteBuffer frame, int64 bytes);
+    // @brief: 数据发送完毕，按需先发送区间的 MD5，再结束调用
+    void finishTransfer();
+    void sendRangeDigest();
+    void handleChunkReady(bool ok);
     bool shouldSaveBreakPoint() const;
     void saveDownloadBreakPoint();
     void handleDownloadComplete();
@@ -48,7 +65,7 @@ private:
     void finishWithError(grpc::StatusCode code, const std::string& message);
     void handleFileNotFoundError(const std::string& file_name);
     void handleFileSizeError();
-    void handleInvalidOffsetError(int64 offset, int64 file_size);
+    void handleInvalidRangeError(const std::string& message, int64 file_size);
     void handleFileOpenError();
 
 
@@ -57,26 +74,46 @@ private:
     void        createNextHandler();
     void        cleanup();
 
+    // 预读完成时经 Alarm 投递到 CQ 的事件，与写完成事件区分
+    struct ChunkReadyTag : public CallData {
+        DownloadCallData* owner = nullptr;
+        void Proceed(bool ok) override { owner->handleChunkReady(ok); }
+    };
+
 private:
-    FileService::FileTransport::AsyncService*              _service;
-    grpc::ServerCompletionQueue*                           _cq;
-    grpc::ServerContext                                    _context;
-    FileService::DownloadRequest                           _request;
-    grpc::ServerAsyncWriter<FileService::DownloadResponse> _writer;
-    CallState                                              _state;
-    std::ifstream                                          _file_stream;
-    std::vector<char>                                      _buffer;
+    FileTransportService*                     _service;
+    grpc::ServerCompletionQueue*              _cq;
+    grpc::ServerContext                       _context;
+    grpc::ByteBuffer                          _request_buffer;
+    FileService::DownloadRequest              _request;
+    grpc::ServerAsyncWriter<grpc::ByteBuffer> _writer;
+    CallState                                 _state;
+    std::shared_ptr<DownloadReadAhead>        _read_ahead;   // read 模式
+    std::shared_ptr<MappedFile>               _mapping;      // mmap 模式
+    grpc::Slice                               _cached;       // 命中小文件缓存
+    grpc::Alarm                               _ready_alarm;
+    ChunkReadyTag                             _ready_tag;
 
     std::string _session_id;               // 下载会话ID
     int64_t     _current_offset     = 0;   // 当前发送位置
     int64_t     _start_offset       = 0;   // 起始偏移量
+    int64_t     _end_offset         = 0;   // 区间终点（不含），默认为文件大小
     int64_t     _file_size          = 0;   // 文件总大小
     int64_t     _last_saved_offset  = 0;
     bool        _download_completed = false;
+    bool        _save_breakpoint    = false;   // 区间下载和小文件不记录断点
+    bool        _digest_sent        = false;
+    bool        _from_cache         = false;
+    bool        _cache_fill         = false;   // 发送时放入小文件缓存
+    std::string _file_md5;
+
+    std::unique_ptr<Md5Stream> _range_hash;   // 仅在请求 range_md5 时计算
 
 
     DownloadPerformanceMetrics                     _metrics;
     std::chrono::high_resolution_clock::time_point _start_time;
+    std::chrono::high_resolution_clock::time_point _write_start;   // 当前块发出
+    std::chrono::high_resolution_clock::time_point _stall_start;   // 开始等盘
 
     static constexpr int64_t SAVE_BREAKPOINT_INTERVAL
         = 20 * 1024 * 1024;   // 20MB
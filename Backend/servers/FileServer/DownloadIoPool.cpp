@@ -0,0 +1,100 @@
+#include "DownloadIoPool.h"
+#include "infra/ConfigManager.h"
+#include "infra/LogManager.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+std::string ConfigValue(const std::string& key) {
+    return (*ConfigManager::getInstance())["FileServer"][key];
+}
+
+std::size_t ConfigSize(const std::string& key, std::size_t fallback) {
+    auto value = ConfigValue(key);
+    int  n     = value.empty() ? 0 : std::atoi(value.c_str());
+    return n > 0 ? static_cast<std::size_t>(n) : fallback;
+}
+
+// Slice 的释放回调：user_data 是交给 gRPC 的块缓冲
+void ReturnBuffer(void* user_data) {
+    DownloadIoPool::getInstance()->ReleaseBuffer(
+        std::unique_ptr<std::string>(static_cast<std::string*>(user_data)));
+}
+
+}   // namespace
+
+DownloadIoPool::DownloadIoPool() {
+    auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    auto threads  = ConfigSize(
+        "download_io_threads", std::min<std::size_t>(4, hardware));
+    // 双缓冲或三缓冲即可让读盘与发送重叠，更深只会多占内存
+    _read_ahead  = std::min<std::size_t>(
+        ConfigSize("download_read_ahead", _read_ahead), 4);
+    _max_buffers = ConfigSize("download_buffer_pool", _max_buffers);
+    _mmap        = ConfigValue("download_mode") == "mmap";
+
+    for (std::size_t i = 0; i < threads; ++i) {
+        _threads.emplace_back(&DownloadIoPool::run, this);
+    }
+    LOG_INFO(
+        "[DownloadIoPool] {} io threads, read-ahead {} chunks, pool {} buffers",
+        threads,
+        _read_ahead,
+        _max_buffers);
+    if (_mmap) {
+        LOG_INFO("[DownloadIoPool] Downloads are served from mmap");
+    }
+}
+
+DownloadIoPool::~DownloadIoPool() {
+    Stop();
+}
+
+void DownloadIoPool::Stop() {
+    _queue.stop();
+    for (auto& t : _threads) {
+        if (t.joinable()) t.join();
+    }
+    _threads.clear();
+}
+
+void DownloadIoPool::Submit(std::function<void()> task) {
+    _queue.push(std::move(task));
+}
+
+void DownloadIoPool::run() {
+    std::function<void()> task;
+    while (_queue.pop(task)) {
+        task();
+        task = nullptr;
+    }
+}
+
+std::unique_ptr<std::string> DownloadIoPool::AcquireBuffer(std::size_t size) {
+    std::unique_ptr<std::string> buffer;
+    {
+        std::lock_guard<std::mutex> lock(_buffer_mutex);
+        if (!_buffers.empty()) {
+            buffer = std::move(_buffers.back());
+            _buffers.pop_back();
+        }
+    }
+    if (!buffer) buffer = std::make_unique<std::string>();
+    // 复用的缓冲长度通常已等于块大小，resize 不会重新分配或清零
+    buffer->resize(size);
+    return buffer;
+}
+
+void DownloadIoPool::ReleaseBuffer(std::unique_ptr<std::string> buffer) {
+    if (!buffer) return;
+    std::lock_guard<std::mutex> lock(_buffer_mutex);
+    if (_buffers.size() < _max_buffers) {
+        _buffers.push_back(std::move(buffer));
+    }
+}
+
+grpc::Slice DownloadIoPool::ToSlice(std::unique_ptr<std::string> buffer) {
+    std::string* raw = buffer.release();
+    return grpc::Slice(&(*raw)[0], raw->size(), &ReturnBuffer, raw);
+}
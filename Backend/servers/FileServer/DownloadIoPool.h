@@ -0,0 +1,52 @@
+#ifndef DOWNLOADIOPOOL_H_
+#define DOWNLOADIOPOOL_H_
+
+#include "TaskQueue.h"
+#include "common/singleton.h"
+#include <functional>
+#include <grpcpp/support/slice.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 下载预读用的 IO 线程池与块缓冲池
+// CQ 线程只负责发送，磁盘读在这里的线程上完成；
+// 块缓冲在各下载会话之间复用，避免每块重新分配 2MB
+class DownloadIoPool : public SingleTon<DownloadIoPool> {
+    friend class SingleTon<DownloadIoPool>;
+
+public:
+    ~DownloadIoPool();
+    void Stop();
+    void Submit(std::function<void()> task);
+
+    // @brief: 取一块缓冲，池中没有时新分配
+    std::unique_ptr<std::string> AcquireBuffer(std::size_t size);
+    // @brief: 归还缓冲，池满时直接释放
+    void ReleaseBuffer(std::unique_ptr<std::string> buffer);
+    // @brief: 把缓冲交给 gRPC 发送，发送完成释放 Slice 时自动归还
+    grpc::Slice ToSlice(std::unique_ptr<std::string> buffer);
+
+    // @brief: 每个下载会话预读的块数（不含正在发送的块）
+    std::size_t ReadAheadDepth() const { return _read_ahead; }
+    // @brief: 是否以 mmap 零拷贝发送（download_mode = mmap）
+    bool UseMmap() const { return _mmap; }
+
+private:
+    DownloadIoPool();
+    void run();
+
+private:
+    std::vector<std::thread>                  _threads;
+    TaskQueue<std::function<void()>>          _queue;
+    std::mutex                                _buffer_mutex;
+    std::vector<std::unique_ptr<std::string>> _buffers;
+    std::size_t                               _max_buffers = 16;
+    std::size_t                               _read_ahead  = 2;
+    bool                                      _mmap        = false;
+};
+
+
+#endif   // DOWNLOADIOPOOL_H_
@@ -0,0 +1,134 @@
+#include "DownloadReadAhead.h"
+#include "DownloadIoPool.h"
+#include "infra/LogManager.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+std::shared_ptr<DownloadReadAhead> DownloadReadAhead::Open(
+    const std::string& path, int64 offset, int64 end, std::size_t chunk_size,
+    std::size_t depth) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR(
+            "[DownloadReadAhead] Failed to open {}: {}",
+            path,
+            std::strerror(errno));
+        return nullptr;
+    }
+    // 提示内核按顺序读，加大内核自身的预读窗口
+    ::posix_fadvise(fd, offset, end - offset, POSIX_FADV_SEQUENTIAL);
+
+    std::shared_ptr<DownloadReadAhead> reader(new DownloadReadAhead(
+        fd, offset, end, chunk_size, std::max<std::size_t>(1, depth)));
+    std::lock_guard<std::mutex> lock(reader->_mutex);
+    reader->fill();
+    return reader;
+}
+
+DownloadReadAhead::DownloadReadAhead(
+    int fd, int64 offset, int64 end, std::size_t chunk_size, std::size_t depth)
+    : _fd(fd)
+    , _next_offset(offset)
+    , _end(end)
+    , _chunk_size(chunk_size)
+    , _depth(depth) {}
+
+DownloadReadAhead::~DownloadReadAhead() {
+    auto pool = DownloadIoPool::getInstance();
+    for (auto& slot : _slots) {
+        pool->ReleaseBuffer(std::move(slot.chunk.data));
+    }
+    ::close(_fd);
+}
+
+bool DownloadReadAhead::Take(Chunk& chunk, std::function<void()> on_ready) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_slots.empty() || !_slots.front().ready) {
+        _on_ready = std::move(on_ready);
+        return false;
+    }
+    chunk = std::move(_slots.front().chunk);
+    _slots.pop_front();
+    fill();
+    return true;
+}
+
+bool DownloadReadAhead::Exhausted() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _slots.empty() && _next_offset >= _end;
+}
+
+void DownloadReadAhead::Cancel() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cancelled = true;
+    _on_ready  = nullptr;
+}
+
+void DownloadReadAhead::fill() {
+    if (_cancelled) return;
+    while (_slots.size() < _depth && _next_offset < _end) {
+        Slot slot;
+        slot.offset = _next_offset;
+        slot.size   = static_cast<std::size_t>(
+            std::min<int64>(_chunk_size, _end - _next_offset));
+        _next_offset += static_cast<int64>(slot.size);
+        _slots.push_back(std::move(slot));
+
+        Slot* target = &_slots.back();
+        DownloadIoPool::getInstance()->Submit(
+            [self = shared_from_this(), target]() { self->read(target); });
+    }
+}
+
+void DownloadReadAhead::read(Slot* slot) {
+    bool cancelled;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        cancelled = _cancelled;
+    }
+
+    Chunk chunk;
+    if (!cancelled) {
+        auto start = std::chrono::steady_clock::now();
+        chunk.data = DownloadIoPool::getInstance()->AcquireBuffer(slot->size);
+        std::size_t done = 0;
+        while (done < slot->size) {
+            ssize_t n = ::pread(
+                _fd,
+                &(*chunk.data)[done],
+                slot->size - done,
+                slot->offset + static_cast<int64>(done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;   // 出错，或文件在下载过程中被截断
+            done += static_cast<std::size_t>(n);
+        }
+        chunk.ok      = done == slot->size;
+        chunk.read_ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+        if (!chunk.ok) {
+            LOG_ERROR(
+                "[DownloadReadAhead] Short read at offset {}: {} of {} bytes",
+                slot->offset,
+                done,
+                slot->size);
+        }
+    }
+
+    std::function<void()> notify;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        slot->chunk = std::move(chunk);
+        slot->ready = true;
+        // 块可能乱序读完，只有队首就绪时发送方才能继续
+        if (!_slots.empty() && &_slots.front() == slot && _on_ready) {
+            notify = std::move(_on_ready);
+            _on_ready = nullptr;
+        }
+    }
+    if (notify) notify();
+}
@@ -0,0 +1,66 @@
+#ifndef DOWNLOADREADAHEAD_H_
+#define DOWNLOADREADAHEAD_H_
+
+#include "const.h"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// 单个下载流的顺序预读
+// 在 DownloadIoPool 上用 pread 按偏移并发读后续 depth 块，
+// CQ 线程按顺序取出已读好的块发送，磁盘读与上一块的网络发送重叠
+// IO 任务持有 shared_ptr，下载会话提前结束时文件在最后一个读任务完成后关闭
+class DownloadReadAhead
+    : public std::enable_shared_from_this<DownloadReadAhead> {
+public:
+    struct Chunk {
+        std::unique_ptr<std::string> data;
+        double                       read_ms = 0;       // 在 IO 线程上读盘耗时
+        bool                         ok      = false;   // false 表示读失败
+    };
+
+    // @brief: 打开文件并开始预读 [offset, end)，打开失败返回 nullptr
+    static std::shared_ptr<DownloadReadAhead> Open(
+        const std::string& path, int64 offset, int64 end,
+        std::size_t chunk_size, std::size_t depth);
+    ~DownloadReadAhead();
+
+    // @brief: 取出下一块并补足预读窗口；尚未读好时返回 false，
+    //         并在读好后于 IO 线程上调用一次 on_ready
+    bool Take(Chunk& chunk, std::function<void()> on_ready);
+    // @brief: 所有块都已取出
+    bool Exhausted();
+    // @brief: 停止预读，丢弃未取出的块，不再回调 on_ready
+    void Cancel();
+
+private:
+    DownloadReadAhead(
+        int fd, int64 offset, int64 end, std::size_t chunk_size,
+        std::size_t depth);
+
+    struct Slot {
+        int64       offset = 0;
+        std::size_t size   = 0;
+        bool        ready  = false;
+        Chunk       chunk;
+    };
+
+    // @brief: 在锁内调用，补足 depth 个在读或已读好的块
+    void fill();
+    void read(Slot* slot);
+
+    int                   _fd;
+    int64                 _next_offset;
+    int64                 _end;
+    std::size_t           _chunk_size;
+    std::size_t           _depth;
+    std::mutex            _mutex;
+    std::deque<Slot>      _slots;   // 按偏移递增，首尾增删不影响其余元素的地址
+    std::function<void()> _on_ready;
+    bool                  _cancelled = false;
+};
+
+
+#endif   // DOWNLOADREADAHEAD_H_
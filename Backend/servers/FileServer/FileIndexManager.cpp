@@ -1,37 +1,142 @@
 #include "FileIndexManager.h"
+#include "SmallFileCache.h"
 #include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
 #include "infra/RedisManager.h"
+#include "infra/RedisScripts.h"
+#include "repository/FileRepository.h"
+#include <algorithm>
+#include <cctype>
 #include <filesystem>
 #include <fstream>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+bool IsMd5(const std::string& value) {
+    return value.size() == 32
+           && std::all_of(value.begin(), value.end(), [](unsigned char c) {
+                  return std::isxdigit(c);
+              });
+}
+
+}   // namespace
+
 FileIndexManager::FileIndexManager() {
-    _redis_key_prefix = "file:path:";
+    _names_key = "file:{file_index}:names";
+    _refs_key  = "file:{file_index}:refs";
+    _blob_dir  = "./uploads/blobs/";
 }
 
-std::string FileIndexManager::format_key(const std::string& original_name) {
-    return _redis_key_prefix + original_name;
+std::string FileIndexManager::blob_path(const std::string& file_md5) const {
+    return _blob_dir + file_md5;
 }
 
-void FileIndexManager::add_file(
-    const std::string& original_name, const std::string& full_path_disk) {
-    auto        redisManager = RedisManager::getInstance();
-    std::string key          = format_key(original_name);
-    if (!redisManager->Set(key, full_path_disk)) {
-        LOG_ERROR("[FileIndex] Failed to set key: {}", key);
+std::string FileIndexManager::partial_path(const std::string& file_md5) const {
+    return _blob_dir + file_md5 + ".part";
+}
+
+std::string FileIndexManager::block_partial_path(
+    const std::string& file_md5) const {
+    return _blob_dir + file_md5 + ".blocks.part";
+}
+
+bool FileIndexManager::link(
+    const std::string& original_name, const std::string& file_md5) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return link_locked(original_name, file_md5);
+}
+
+bool FileIndexManager::link_locked(
+    const std::string& original_name, const std::string& file_md5) {
+    std::vector<std::string> result;
+    if (!RedisManager::getInstance()->EvalScript(
+            RedisScripts::LINK_FILE_BLOB,
+            {_names_key, _refs_key},
+            {original_name, file_md5},
+            result)
+        || result.size() != 2) {
+        LOG_ERROR(
+            "[FileIndex] Failed to link {} -> {}", original_name, file_md5);
+        return false;
+    }
+    LOG_INFO(
+        "[FileIndex] Linked {} -> {} (refs={})",
+        original_name,
+        file_md5,
+        result[0]);
+    // 名字可能改指向了新内容，内存里的旧内容不能再发出去
+    SmallFileCache::getInstance()->Invalidate(original_name);
+
+    // 名字改指向新内容后旧 blob 已无人引用
+    const std::string& orphan = result[1];
+    if (!orphan.empty()) {
+        std::error_code ec;
+        fs::remove(blob_path(orphan), ec);
+        LOG_INFO(
+            "[FileIndex] Removed unreferenced blob {}{}",
+            orphan,
+            ec ? ": " + ec.message() : "");
     }
+    return true;
 }
 
 std::string FileIndexManager::find_path(const std::string& original_name) {
-    auto        redisManager = RedisManager::getInstance();
-    std::string key          = format_key(original_name);
-    std::string value        = "";
-    redisManager->Get(key, value);
-    return value;
+    auto file_md5
+        = RedisManager::getInstance()->HGet(_names_key, original_name);
+    return file_md5.empty() ? std::string() : blob_path(file_md5);
+}
+
+bool FileIndexManager::has_blob(
+    const std::string& file_md5, int64_t expected_size) {
+    if (!IsMd5(file_md5)) return false;
+    std::error_code ec;
+    auto            size = fs::file_size(blob_path(file_md5), ec);
+    if (ec) return false;
+    return expected_size <= 0 || static_cast<int64_t>(size) == expected_size;
 }
 
+bool FileIndexManager::link_existing(
+    const std::string& original_name, const std::string& file_md5,
+    int64_t expected_size) {
+    // 在锁内检查，保证链接时 blob 不会被同时作为孤立 blob 删除
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!has_blob(file_md5, expected_size)) return false;
+    return link_locked(original_name, file_md5);
+}
+
+void FileIndexManager::migrate_legacy_file(
+    const std::string& path, const std::string& file_md5,
+    const std::string& original_name) {
+    std::error_code ec;
+
+    // 上传未完成的文件留作续传
+    auto progress = FileRepository::GetUploadProgress(file_md5);
+    if (progress.IsOK() && progress.Value().status != "completed") {
+        if (!fs::exists(partial_path(file_md5), ec)) {
+            fs::rename(path, partial_path(file_md5), ec);
+        }
+        return;
+    }
+
+    if (!fs::exists(blob_path(file_md5), ec)) {
+        fs::rename(path, blob_path(file_md5), ec);
+    } else if (has_blob(file_md5, static_cast<int64_t>(fs::file_size(path)))) {
+        fs::remove(path, ec);   // 同一内容的重复副本
+    } else {
+        LOG_WARN(
+            "[FileIndex] {} does not match existing blob {}, left in place",
+            path,
+            file_md5);
+        return;
+    }
+    if (ec) {
+        LOG_ERROR("[FileIndex] Failed to migrate {}: {}", path, ec.message());
+        return;
+    }
+    link(original_name, file_md5);
+}
 
 void FileIndexManager::build_index_from_disk(
     const std::string& directory_path) {
@@ -40,14 +145,17 @@ void FileIndexManager::build_index_from_disk(
         directory_path);
     int count = 0;
     try {
+        fs::create_directories(_blob_dir);
         for (const auto& entry : fs::directory_iterator(directory_path)) {
             if (entry.is_regular_file()) {
                 std::string disk_filename = entry.path().filename().string();
                 size_t      pos           = disk_filename.find("_");
-                if (pos != std::string::npos && pos > 0) {
-                    std::string original_name = disk_filename.substr(pos + 1);
-                    std::string path = directory_path + entry.path().filename().string();
-                    add_file(original_name, path);
+                if (pos != std::string::npos
+                    && IsMd5(disk_filename.substr(0, pos))) {
+                    migrate_legacy_file(
+                        entry.path().string(),
+                        disk_filename.substr(0, pos),
+                        disk_filename.substr(pos + 1));
                     ++count;
                 }
             }
@@ -58,5 +166,6 @@ void FileIndexManager::build_index_from_disk(
             directory_path,
             e.what());
     }
-    LOG_INFO("[FileIndex] Index build complete. Indexed {} files.", count);
+    LOG_INFO(
+        "[FileIndex] Index build complete. Migrated {} legacy files.", count);
 }
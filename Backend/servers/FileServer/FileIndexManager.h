@@ -3,31 +3,61 @@
 
 #include "common/singleton.h"
 #include "infra/RedisManager.h"
-
+#include <cstdint>
+#include <mutex>
+
+// 按内容寻址的文件存储
+// 文件内容只按 md5 存一份：./uploads/blobs/<md5>，上传中为 <md5>.part
+// Redis 里维护 文件名 -> md5 的索引和每个 md5 的引用计数，
+// 同一内容换个名字或由其他用户再次上传时只增加一条引用，不再写盘
+// 两个 hash 共用 {file_index} hash tag，链接脚本在同一分片上原子执行
 class FileIndexManager : public SingleTon<FileIndexManager> {
     friend class SingleTon<FileIndexManager>;
 
 public:
-    // @brief 将文件索引添加到 Redis
+    // @brief 把文件名指向 md5 对应的 blob，名字原先指向的 blob 引用减一，
+    //        减到 0 时删除该 blob
     // @original_name: "gdb-1.md"
-    // @full_path_on_disk: "./uploads/aecfb..._gdb-1.md"
-    void add_file(
-        const std::string& original_name, const std::string& full_path_on_disk);
+    // @file_md5: "aecfb..."
+    bool link(const std::string& original_name, const std::string& file_md5);
 
     // @brief 从redis中查找文件的完整路径
     // @return 如果找到，返回完整路径，没有返回空字符串
     std::string find_path(const std::string& original_name);
 
+    // @brief blob 已完整落盘且大小一致（expected_size <= 0 时不校验大小）
+    bool has_blob(const std::string& file_md5, int64_t expected_size = 0);
+
+    // @brief 已上传完成的内容直接链接到新名字（秒传），blob 不存在时返回 false
+    bool link_existing(
+        const std::string& original_name, const std::string& file_md5,
+        int64_t expected_size);
+
+    std::string blob_path(const std::string& file_md5) const;
+    // @brief 上传中的临时文件，完成后 rename 为 blob_path
+    std::string partial_path(const std::string& file_md5) const;
+    // @brief 分块上传会话的临时文件，与整文件上传的 .part 分开，
+    //        两条路径同时上传同一内容时不会截断或覆盖对方已写入的数据
+    std::string block_partial_path(const std::string& file_md5) const;
 
     // 在服务器启动时，从磁盘扫描并构建/恢复索引
+    // 旧版 <md5>_<name> 文件迁移为 blob，未完成的上传迁移为 .part 以便续传
     void build_index_from_disk(const std::string& directory_path);
 
 private:
     FileIndexManager();
-    std::string format_key(const std::string& original_name);
+    bool link_locked(
+        const std::string& original_name, const std::string& file_md5);
+    void migrate_legacy_file(
+        const std::string& path, const std::string& file_md5,
+        const std::string& original_name);
 
 private:
-    std::string _redis_key_prefix;
+    std::string _names_key;   // hash: 文件名 -> md5
+    std::string _refs_key;    // hash: md5 -> 引用计数
+    std::string _blob_dir;
+    // 链接与删除孤立 blob 在本进程内串行，避免秒传链接到正在删除的 blob
+    std::mutex  _mutex;
 };
 
 #endif   // FILEINDEXMANAGER_H_
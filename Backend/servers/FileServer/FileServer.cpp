@@ -1,15 +1,18 @@
 #include "FileServer.h"
 #include "CallData.h"
 #include "DownloadCallData.h"
+#include "OpenUploadSessionCallData.h"
 #include "QueryDownloadCallData.h"   // 新增
 #include "QueryUploadCallData.h"     // 新增
+#include "SmallFileCache.h"
+#include "UploadBlocksCallData.h"
 #include "UploadCallData.h"
 #include "file.grpc.pb.h"
 #include "infra/LogManager.h"
 #include <grpcpp/security/server_credentials.h>
 
 FileServer::FileServer()
-    : _service(std::make_unique<FileService::FileTransport::AsyncService>()) {}
+    : _service(std::make_unique<FileTransportService>()) {}
 
 FileServer::~FileServer() {
     Stop();
@@ -50,6 +53,10 @@ void FileServer::Run(const std::string& host, const std::string& port) {
         // 新增的断点查询RPC
         new QueryUploadCallData(_service.get(), _cqs[i].get());
         new QueryDownloadCallData(_service.get(), _cqs[i].get());
+
+        // 并行分块上传
+        new OpenUploadSessionCallData(_service.get(), _cqs[i].get());
+        new UploadBlocksCallData(_service.get(), _cqs[i].get());
     }
 
     for (auto& t : _threads) {
@@ -83,4 +90,5 @@ void FileServer::Stop() {
     }
     _cqs.clear();
     _server.reset();
+    SmallFileCache::getInstance()->LogStats();
 }
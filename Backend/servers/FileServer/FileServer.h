@@ -32,7 +32,7 @@ private:
     std::unique_ptr<Server> _server;
     std::vector<std::unique_ptr<ServerCompletionQueue>> _cqs;
     std::vector<std::thread>                            _threads;
-    std::unique_ptr<FileTransport::AsyncService>        _service;
+    std::unique_ptr<FileTransportService>               _service;
     int _cq_num = 4;
 };
 
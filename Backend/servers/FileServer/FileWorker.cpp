@@ -1,224 +1,590 @@
 #include "FileWorker.h"
 #include "BackPressureManager.h"
 #include "FileIndexManager.h"
+#include "FileWorkerPool.h"
 #include "TaskQueue.h"
 #include "infra/LogManager.h"
 #include "repository/FileRepository.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <openssl/md5.h>
-#include <unordered_map>
+#include <vector>
 
-FileWorker::FileWorker(int id) : _id(id), _running(true) {
-    _worker_thread = std::thread(&FileWorker::run, this);
+namespace {
+
+bool Md5Equals(const std::string& a, const std::string& b) {
+    return a.size() == b.size()
+           && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                  return std::tolower(static_cast<unsigned char>(x))
+                         == std::tolower(static_cast<unsigned char>(y));
+              });
 }
 
+}   // namespace
+
+FileWorker::FileWorker(
+    int id, FileWorkerPool* pool, const FileSink::Options& sink_options)
+    : _id(id), _pool(pool), _running(true), _sink_options(sink_options) {}
+
 FileWorker::~FileWorker() {
-    _running = false;
-    _queue.stop();
+    stop();
+    join();
+}
+
+void FileWorker::start() {
+    _worker_thread = std::thread(&FileWorker::run, this);
+}
+
+void FileWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _cond.notify_all();
+}
+
+void FileWorker::join() {
     if (_worker_thread.joinable()) {
         _worker_thread.join();
     }
 }
 
-void FileWorker::submit(const FsTask& task) {
-    _queue.push(task);
+void FileWorker::push(std::shared_ptr<FileStream> stream) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.push_back(std::move(stream));
+    }
+    _cond.notify_one();
+}
+
+std::shared_ptr<FileStream> FileWorker::steal() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_ready.empty()) return nullptr;
+    auto stream = std::move(_ready.back());
+    _ready.pop_back();
+    return stream;
+}
+
+void FileWorker::wake() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _signaled = true;
+    }
+    _cond.notify_one();
+}
+
+std::size_t FileWorker::queue_depth() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::size_t depth = _current ? _current->PendingCount() : 0;
+    for (const auto& stream : _ready) depth += stream->PendingCount();
+    return depth;
+}
+
+bool FileWorker::commitBlob(
+    const std::string& file_md5, const std::string& file_name,
+    const std::string& partial) {
+    auto            index = FileIndexManager::getInstance();
+    std::error_code ec;
+    if (index->has_blob(file_md5)) {
+        // 同一内容在本次上传期间已由其他会话提交，丢弃重复副本
+        std::filesystem::remove(partial, ec);
+    } else {
+        std::filesystem::rename(partial, index->blob_path(file_md5), ec);
+        if (ec) {
+            LOG_ERROR(
+                "[FileWorker] id: {} Failed to commit blob {}: {}",
+                _id,
+                file_md5,
+                ec.message());
+            return false;
+        }
+    }
+    return index->link(file_name, file_md5);
+}
+
+bool FileWorker::restoreDigest(
+    FileBuffer& file_buf, const std::string& filepath, int64 resume_offset) {
+    // 断点之后可能还有未确认的数据，由 FileSink 打开时截掉
+    std::error_code ec;
+    auto            size = std::filesystem::file_size(filepath, ec);
+    if (ec || static_cast<int64>(size) < resume_offset) {
+        LOG_ERROR(
+            "[FileWorker] id: {} Partial file {} is shorter than resume "
+            "offset {}",
+            _id,
+            filepath,
+            resume_offset);
+        return false;
+    }
+    file_buf.block_index    = resume_offset / RESUME_CHUNK_SIZE;
+    const int64 block_start = file_buf.block_index * RESUME_CHUNK_SIZE;
+    file_buf.block_filled   = resume_offset - block_start;
+    file_buf.total_written  = resume_offset;
+
+    std::ifstream     in(filepath, std::ios::binary);
+    std::vector<char> buffer(1024 * 1024);
+    int64             offset = 0;
+    while (offset < resume_offset) {
+        auto n = std::min<int64>(buffer.size(), resume_offset - offset);
+        if (!in.read(buffer.data(), n)) return false;
+        file_buf.file_hash.Update(buffer.data(), n);
+        // 续传点通常在块边界上，这里也兼容落在块中间的情况
+        if (offset + n > block_start) {
+            auto skip = std::max<int64>(0, block_start - offset);
+            file_buf.block_hash.Update(buffer.data() + skip, n - skip);
+        }
+        offset += n;
+    }
+    return true;
+}
+
+void FileWorker::hashData(FileBuffer& file_buf, const std::string& data) {
+    file_buf.file_hash.Update(data.data(), data.size());
+
+    // chunk 大小与块大小无关，一个 chunk 可能跨越块边界
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        auto n = std::min<std::size_t>(
+            data.size() - pos, RESUME_CHUNK_SIZE - file_buf.block_filled);
+        file_buf.block_hash.Update(data.data() + pos, n);
+        file_buf.block_filled += static_cast<int64>(n);
+        pos += n;
+        if (file_buf.block_filled == RESUME_CHUNK_SIZE) {
+            saveCheckpoint(file_buf);
+        }
+    }
+}
+
+bool FileWorker::writeBlock(const FsTask& task) {
+    // 会话结束后迟到或重传的块：内容已提交则直接确认，不再写盘，
+    // 否则会留下孤立的临时文件和一个新的位图
+    if (FileIndexManager::getInstance()->has_blob(
+            task.file_md5, task.total_size)) {
+        LOG_DEBUG(
+            "[FileWorker] id: {} Late block acked: md5={}, block={}",
+            _id,
+            task.file_md5,
+            task.block_index);
+        return true;
+    }
+    if (!FileRepository::GetUploadSession(task.file_md5).IsOK()) {
+        LOG_WARN(
+            "[FileWorker] id: {} Block without upload session: md5={}, "
+            "block={}",
+            _id,
+            task.file_md5,
+            task.block_index);
+        return false;
+    }
+
+    const auto& data = *task.data;
+    if (!task.block_md5.empty()) {
+        Md5Stream hash;
+        hash.Update(data.data(), data.size());
+        if (!Md5Equals(hash.HexDigest(), task.block_md5)) {
+            LOG_WARN(
+                "[FileWorker] id: {} Block md5 mismatch: md5={}, block={}",
+                _id,
+                task.file_md5,
+                task.block_index);
+            return false;
+        }
+    }
+
+    // 每块单独打开关闭：不在 worker 上保留句柄，会话中断也不会泄漏；
+    // 同一文件的块由文件流串行处理，不会交错写入
+    auto sink = FileSink::OpenForBlocks(
+        FileIndexManager::getInstance()->block_partial_path(task.file_md5),
+        task.total_size,
+        _sink_options);
+    if (!sink || !sink->WriteAt(task.resume_offset, data.data(), data.size())
+        || !sink->Close()) {
+        return false;
+    }
+
+    // 位图只记录已按同步策略落盘的块
+    auto marked = FileRepository::MarkBlockReceived(
+        task.file_md5, task.block_index, task.block_count);
+    if (!marked.IsOK()) return false;
+    if (marked.Value()) {
+        finalizeBlocks(task.file_md5, task.file_name, task.total_size);
+    }
+    return true;
+}
+
+bool FileWorker::finalizeBlocks(
+    const std::string& file_md5, const std::string& file_name,
+    int64 total_size) {
+    auto            index    = FileIndexManager::getInstance();
+    std::string     filepath = index->block_partial_path(file_md5);
+    std::error_code ec;
+    auto            size = std::filesystem::file_size(filepath, ec);
+
+    Md5Stream hash;
+    if (!ec && static_cast<int64>(size) == total_size) {
+        std::ifstream     in(filepath, std::ios::binary);
+        std::vector<char> buffer(1024 * 1024);
+        while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+            hash.Update(buffer.data(), in.gcount());
+        }
+    }
+    const std::string digest = hash.HexDigest();
+
+    // 无论成败会话都结束：校验失败时无法确定哪一块出错，需要重新上传
+    FileRepository::DeleteUploadSession(file_md5);
+    if (ec || static_cast<int64>(size) != total_size
+        || !Md5Equals(digest, file_md5)) {
+        LOG_ERROR(
+            "[FileWorker] id: {} Block upload verification failed: md5={}, "
+            "actual={}, bytes={}",
+            _id,
+            file_md5,
+            digest,
+            ec ? 0 : size);
+        std::filesystem::remove(filepath, ec);
+        return false;
+    }
+
+    bool committed = commitBlob(file_md5, file_name, filepath);
+    LOG_INFO(
+        "[FileWorker] id: {} Block upload completed: md5={}, bytes={}, "
+        "committed={}",
+        _id,
+        file_md5,
+        total_size,
+        committed);
+    return committed;
+}
+
+void FileWorker::discardUpload(const std::string& file_md5) {
+    FileRepository::DeleteUploadProgress(file_md5);
+    FileRepository::DeleteBlockCheckpoints(file_md5);
+    std::error_code ec;
+    std::filesystem::remove(
+        FileIndexManager::getInstance()->partial_path(file_md5), ec);
 }
 
-// 新增：MD5计算函数
-std::string FileWorker::CalculateMD5(const std::string& data) {
-    unsigned char digest[MD5_DIGEST_LENGTH];
-    MD5((unsigned char*) data.data(), data.size(), digest);
+void FileWorker::flushBuffer(FileBuffer& file_buf) {
+    if (file_buf.buffer.empty()) return;
+    size_t flushed_size = file_buf.buffer.size();
+    if (!file_buf.sink->Write(file_buf.buffer.data(), flushed_size)) {
+        file_buf.write_failed = true;
+    }
+    file_buf.buffer.clear();
+    for (const auto& [key, size] : file_buf.buffered_credit) {
+        if (key.empty()) continue;
+        BackPressureManager::getInstance()->notify_data_flushed(key, size);
+    }
+    file_buf.buffered_credit.clear();
+}
 
-    char md5_string[33];
-    for (int i = 0; i < 16; i++) {
-        sprintf(&md5_string[i * 2], "%02x", (unsigned int) digest[i]);
+void FileWorker::releaseCredit(const FsTask& task) {
+    if (task.credit_key.empty() || !task.data) return;
+    BackPressureManager::getInstance()->notify_data_flushed(
+        task.credit_key, task.data->size());
+}
+
+void FileWorker::logSinkStats(const FileBuffer& file_buf) {
+    const auto& stats = file_buf.sink->GetStats();
+    LOG_INFO(
+        "[FileWorker] id: {} md5={} wrote {} bytes in {} pwrite calls "
+        "({:.2f}/MB), fdatasync {} times (avg {:.2f} ms, max {:.2f} ms)",
+        _id,
+        file_buf.file_md5,
+        stats.bytes,
+        stats.write_calls,
+        stats.WriteCallsPerMB(),
+        stats.sync_count,
+        stats.AvgSyncMs(),
+        stats.max_sync_ms);
+}
+
+void FileWorker::saveCheckpoint(FileBuffer& file_buf) {
+    // 断点记录的字节必须已经写出，按同步策略落盘
+    flushBuffer(file_buf);
+    if (!file_buf.write_failed && !file_buf.sink->Checkpoint()) {
+        // fdatasync 失败，这一段不能当作已落盘
+        file_buf.write_failed = true;
+        LOG_ERROR(
+            "[FileWorker] id: {} Checkpoint sync failed: md5={}, chunk={}, "
+            "error={}",
+            _id,
+            file_buf.file_md5,
+            file_buf.block_index,
+            std::strerror(file_buf.sink->LastError()));
+    }
+    if (file_buf.write_failed) {
+        // 摘要来自内存中的数据，磁盘上已有缺失，不能再作为续传点
+        ++file_buf.block_index;
+        file_buf.block_filled = 0;
+        return;
     }
 
-    return std::string(md5_string, 32);
+    const int64 offset = (file_buf.block_index + 1) * RESUME_CHUNK_SIZE;
+    auto        result = FileRepository::SaveBlockCheckpoint(
+        file_buf.file_md5,
+        static_cast<int>(file_buf.block_index),
+        file_buf.block_hash.HexDigest());
+    if (result.IsOK()) {
+        LOG_INFO(
+            "[FileWorker] id: {} Saved chunk checkpoint: md5={}, chunk={}, "
+            "offset={}",
+            _id,
+            file_buf.file_md5,
+            file_buf.block_index,
+            offset);
+    }
+
+    // 更新上传进度
+    FileRepository::UpdateUploadProgress(file_buf.file_md5, offset);
+
+    ++file_buf.block_index;
+    file_buf.block_filled = 0;
 }
 
 void FileWorker::run() {
     LOG_INFO("[FileWorker] id: {} started", _id);
     while (_running) {
-        FsTask task;
-        if (!_queue.pop(task)) {
-            if (!_running) break;
-            continue;
+        auto stream = next();
+        if (!stream) continue;
+        _busy = true;
+        process(stream);
+        _busy = false;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _current.reset();
+    }
+}
+
+std::shared_ptr<FileStream> FileWorker::next() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // 先清除唤醒标记再去窃取，窃取期间的唤醒不会丢
+        _signaled = false;
+        if (!_ready.empty()) {
+            _current = std::move(_ready.front());
+            _ready.pop_front();
+            return _current;
         }
+    }
+    if (auto stream = _pool->Steal(_id)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _current = stream;
+        return stream;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [this]() {
+        return !_ready.empty() || _signaled || !_running;
+    });
+    return nullptr;
+}
 
-        switch (task.type) {
-        case TaskType::META: {
-            // create file
-            std::string filepath
-                = "./uploads/" + task.file_md5 + "_" + task.file_name;
+void FileWorker::process(const std::shared_ptr<FileStream>& stream) {
+    FsTask task;
+    int    handled = 0;
+    while (handled < TASK_BUDGET && stream->tasks.Pop(task)) {
+        --stream->pending;
+        handle(*stream, task);
+        ++handled;
+    }
+    if (handled == TASK_BUDGET && !stream->tasks.Empty()) {
+        // 预算用完，排到队尾让出给其他文件，空闲 worker 可以接手
+        _pool->Schedule(stream, _id);
+        return;
+    }
 
-            std::ios::openmode mode = std::ios::binary;
-            if (task.resume_offset > 0) {
-                mode |= std::ios::app;   // 追加模式
-                LOG_INFO(
-                    "[FileWorker] id: {} Opening file for resume: {} at offset "
-                    "{}",
-                    _id,
-                    filepath,
-                    task.resume_offset);
-            } else {
-                mode |= std::ios::trunc;   // 覆盖模式
-                LOG_INFO(
-                    "[FileWorker] id: {} Creating new file: {}", _id, filepath);
-            }
+    // 先清标记再检查计数，与 Submit 的"先计数入队再置标记"配对，不会漏调度；
+    // 清标记后流可能已被其他 worker 接手，只能读原子计数，不能再碰队列
+    stream->scheduled = false;
+    if (stream->PendingCount() > 0) {
+        if (!stream->scheduled.exchange(true)) _pool->Schedule(stream, _id);
+        return;
+    }
+    _pool->Retire(stream);
+}
 
-            FileBuffer file_buf;
-            file_buf.file     = std::make_unique<std::ofstream>(filepath, mode);
-            file_buf.file_md5 = task.file_md5;
-            file_buf.file_name = task.file_name;
-
-            if (file_buf.file->is_open()) {
-                // 验证文件大小
-                if (task.resume_offset > 0) {
-                    file_buf.file->seekp(0, std::ios::end);
-                    auto current_size
-                        = static_cast<int64>(file_buf.file->tellp());
-                    if (current_size != task.resume_offset) {
-                        LOG_WARN(
-                            "[FileWorker] id: {} File size mismatch: "
-                            "expected={}, actual={}",
-                            _id,
-                            task.resume_offset,
-                            current_size);
-                    } else {
-                        file_buf.total_written = task.resume_offset;
-                    }
-                }
+void FileWorker::handle(FileStream& stream, FsTask& task) {
+    switch (task.type) {
+    case TaskType::META: {
+        // create file
+        // 先写临时文件，完整收到后再以 md5 为名提交到 blob 存储
+        std::string filepath
+            = FileIndexManager::getInstance()->partial_path(task.file_md5);
 
-                _file_buffers[task.file_md5]        = std::move(file_buf);
-                _md5_to_filename_map[task.file_md5] = task.file_name;
-                LOG_INFO("[FileWorker] id: {} File opened {}", _id, filepath);
-            } else {
-                LOG_ERROR(
-                    "[FileWorker] id: {} Failed to open file {}",
-                    _id,
-                    filepath);
+        auto file_buf       = std::make_unique<FileBuffer>();
+        file_buf->file_md5  = task.file_md5;
+        file_buf->file_name = task.file_name;
+
+        if (task.resume_offset > 0) {
+            LOG_INFO(
+                "[FileWorker] id: {} Opening file for resume: {} at offset "
+                "{}",
+                _id,
+                filepath,
+                task.resume_offset);
+            if (!restoreDigest(*file_buf, filepath, task.resume_offset)) {
+                break;
             }
-            break;
+        } else {
+            LOG_INFO(
+                "[FileWorker] id: {} Creating new file: {}", _id, filepath);
         }
 
-        case TaskType::DATA: {
-            auto it = _file_buffers.find(task.file_md5);
-            if (it != _file_buffers.end() && task.data) {
-                auto& file_buf = it->second;
-                file_buf.buffer.append(*(task.data));
-                file_buf.checkpoint_buffer.append(*(task.data));
+        file_buf->sink = FileSink::Open(
+            filepath, task.resume_offset, task.total_size, _sink_options);
 
-                // 超过阈值就刷新缓冲区
-                if (file_buf.buffer.size() >= BUFFER_THRESHOLD) {
-                    size_t flushed_size = file_buf.buffer.size();
-                    file_buf.flush();
-                    BackPressureManager::getInstance()->notify_data_flushed(
-                        flushed_size);
-                }
+        if (file_buf->sink) {
+            stream.file = std::move(file_buf);
+            LOG_INFO("[FileWorker] id: {} File opened {}", _id, filepath);
+        } else {
+            LOG_ERROR(
+                "[FileWorker] id: {} Failed to open file {}",
+                _id,
+                filepath);
+        }
+        break;
+    }
 
-                // 更新总写入字节数
-                file_buf.total_written += task.data->size();
-
-                // 每20MB保存断点和校验和
-                if (file_buf.total_written % RESUME_CHUNK_SIZE == 0) {
-                    int64 chunk_index
-                        = file_buf.total_written / RESUME_CHUNK_SIZE - 1;
-
-                    // 计算分块MD5
-                    std::string chunk_md5
-                        = CalculateMD5(file_buf.checkpoint_buffer);
-
-                    // 保存分块校验和
-                    auto result = FileRepository::SaveBlockCheckpoint(
-                        file_buf.file_md5, chunk_index, chunk_md5);
-
-                    if (result.IsOK()) {
-                        LOG_INFO(
-                            "[FileWorker] id: {} Saved chunk checkpoint: "
-                            "md5={}, chunk={}, offset={}",
-                            _id,
-                            file_buf.file_md5,
-                            chunk_index,
-                            file_buf.total_written);
-                    }
-
-                    // 更新上传进度
-                    FileRepository::UpdateUploadProgress(
-                        file_buf.file_md5, file_buf.total_written);
-
-                    // 清空校验缓冲区，继续累计下一块
-                    file_buf.checkpoint_buffer.clear();
+    case TaskType::DATA: {
+        if (stream.file && task.data) {
+            auto& file_buf = *stream.file;
+            if (file_buf.buffer.empty()
+                && task.data->size() >= BUFFER_THRESHOLD) {
+                // 大块直接定位写入，不再经缓冲区拷贝
+                if (!file_buf.sink->Write(
+                        task.data->data(), task.data->size())) {
+                    file_buf.write_failed = true;
                 }
+                releaseCredit(task);
             } else {
-                LOG_ERROR(
-                    "[FileWorker] id: {} Error: Received data for unknown file "
-                    "MD5: {}",
-                    _id,
-                    task.file_md5);
+                // 小块攒够阈值再写，减少写调用
+                file_buf.buffer.append(*(task.data));
+                auto& credit = file_buf.buffered_credit;
+                if (credit.empty() || credit.back().first != task.credit_key) {
+                    credit.emplace_back(task.credit_key, 0);
+                }
+                credit.back().second += task.data->size();
+                if (file_buf.buffer.size() >= BUFFER_THRESHOLD) {
+                    flushBuffer(file_buf);
+                }
             }
-            break;
-        }
 
-        case TaskType::END: {
-            auto it = _file_buffers.find(task.file_md5);
-            if (it == _file_buffers.end()) {
-                LOG_WARN(
-                    "[FileWorker] id: {} END for unknown md5: {}",
-                    _id,
-                    task.file_md5);
-                break;
-            }
+            // 更新总写入字节数
+            file_buf.total_written += task.data->size();
 
-            size_t remaining_size = it->second.buffer.size();
-            it->second.flush();
-            BackPressureManager::getInstance()->notify_data_flushed(
-                remaining_size);
-            it->second.file->close();
+            // 增量计算文件与块摘要，每满 20MB 保存断点和校验和
+            hashData(file_buf, *(task.data));
+        } else {
+            LOG_ERROR(
+                "[FileWorker] id: {} Error: Received data for unknown file "
+                "MD5: {}",
+                _id,
+                task.file_md5);
+            // 丢弃的数据同样归还背压额度
+            releaseCredit(task);
+        }
+        break;
+    }
 
-            const int64 written_bytes
-                = static_cast<int64>(it->second.total_written);
+    case TaskType::END: {
+        if (!stream.file) {
+            LOG_WARN(
+                "[FileWorker] id: {} END for unknown md5: {}",
+                _id,
+                task.file_md5);
+            if (task.on_done) task.on_done(false);
+            break;
+        }
 
-            if (task.complete) {
-                FileRepository::MarkUploadComplete(task.file_md5);
-                FileRepository::DeleteUploadProgress(task.file_md5);
-                FileRepository::DeleteBlockCheckpoints(task.file_md5);
+        auto& file_buf = *stream.file;
+        flushBuffer(file_buf);
+        bool closed = file_buf.sink->Close();
+        logSinkStats(file_buf);
 
-                auto map_it = _md5_to_filename_map.find(task.file_md5);
-                if (map_it != _md5_to_filename_map.end()) {
-                    const std::string original_name = map_it->second;
-                    const std::string full_path
-                        = "./uploads/" + task.file_md5 + "_" + original_name;
-                    FileIndexManager::getInstance()->add_file(
-                        original_name, full_path);
-                    _md5_to_filename_map.erase(map_it);
-                }
+        const int64 written_bytes = static_cast<int64>(file_buf.total_written);
 
-                LOG_INFO(
-                    "[FileWorker] id: {} upload completed: md5={}, bytes={}",
+        bool committed = false;
+        if (task.complete) {
+            // 整个文件的摘要必须与 FileMeta.file_md5 一致才提交
+            const std::string digest = file_buf.file_hash.HexDigest();
+            if (file_buf.write_failed) {
+                // 摘要按内存数据计算，磁盘上的文件有缺失，按摘要不符处理
+                LOG_ERROR(
+                    "[FileWorker] id: {} Write failed, discarding md5={}",
+                    _id,
+                    task.file_md5);
+                discardUpload(task.file_md5);
+            } else if (!closed) {
+                LOG_ERROR(
+                    "[FileWorker] id: {} Failed to persist md5={}",
+                    _id,
+                    task.file_md5);
+            } else if (!Md5Equals(digest, task.file_md5)) {
+                LOG_ERROR(
+                    "[FileWorker] id: {} md5 mismatch: expected={}, "
+                    "actual={}, bytes={}",
                     _id,
                     task.file_md5,
+                    digest,
                     written_bytes);
+                // 无法确定哪一块出错，丢弃整个文件
+                discardUpload(task.file_md5);
             } else {
-                FileRepository::UpdateUploadProgress(
-                    task.file_md5, written_bytes);
-                FileRepository::MarkUploadCancelled(task.file_md5);
+                FileRepository::MarkUploadComplete(task.file_md5);
+                FileRepository::DeleteUploadProgress(task.file_md5);
+                FileRepository::DeleteBlockCheckpoints(task.file_md5);
 
-                auto map_it = _md5_to_filename_map.find(task.file_md5);
-                if (map_it != _md5_to_filename_map.end()) {
-                    _md5_to_filename_map.erase(map_it);
-                }
+                committed = commitBlob(
+                    task.file_md5,
+                    file_buf.file_name,
+                    FileIndexManager::getInstance()->partial_path(
+                        task.file_md5));
 
-                LOG_WARN(
-                    "[FileWorker] id: {} upload cancelled: md5={}, bytes={}",
+                LOG_INFO(
+                    "[FileWorker] id: {} upload completed: md5={}, "
+                    "bytes={}",
                     _id,
                     task.file_md5,
                     written_bytes);
             }
+        } else if (file_buf.write_failed) {
+            // 已写入的部分有缺失，不能留作续传
+            LOG_WARN(
+                "[FileWorker] id: {} upload cancelled after write failure: "
+                "md5={}",
+                _id,
+                task.file_md5);
+            discardUpload(task.file_md5);
+        } else {
+            FileRepository::UpdateUploadProgress(
+                task.file_md5, written_bytes);
+            FileRepository::MarkUploadCancelled(task.file_md5);
 
-            _file_buffers.erase(it);
-            break;
+            LOG_WARN(
+                "[FileWorker] id: {} upload cancelled: md5={}, bytes={}",
+                _id,
+                task.file_md5,
+                written_bytes);
         }
+
+        stream.file.reset();
+        if (task.on_done) task.on_done(committed);
+        break;
+    }
+
+    case TaskType::BLOCK: {
+        bool written = task.data && writeBlock(task);
+        if (task.on_done) task.on_done(written);
+        break;
+    }
+
+    case TaskType::BARRIER: {
+        if (task.on_done) {
+            auto index = FileIndexManager::getInstance();
+            task.on_done(index->has_blob(task.file_md5));
         }
+        break;
+    }
     }
 }
@@ -1,45 +1,134 @@
 #ifndef FILEWORKER_H_
 #define FILEWORKER_H_
+#include "Md5Stream.h"
 #include "TaskQueue.h"
 #include "const.h"
-#include <unordered_map>
+#include "infra/FileSink.h"
+#include "infra/MpscQueue.h"
+#include <cstdint>
+#include <deque>
+
+class FileWorkerPool;
+
+// 正在上传的文件的写盘状态，随文件流在 worker 之间迁移
+struct FileBuffer {
+    std::unique_ptr<FileSink> sink;
+    std::string               buffer;   // 只攒小于阈值的块
+    std::size_t               total_written = 0;
+    std::string               file_md5;      // 新增：文件MD5
+    std::string               file_name;     // 新增：文件名
+    Md5Stream                 file_hash;     // 整个文件的增量摘要
+    Md5Stream                 block_hash;    // 当前断点块的增量摘要
+    int64                     block_index  = 0;
+    int64                     block_filled = 0;       // 当前块已计入字节数
+    bool                      write_failed = false;   // 有数据未能写盘
+    // 缓冲区中的字节按所属上传流记账，写出后分别归还背压额度
+    std::vector<std::pair<std::string, std::size_t>> buffered_credit;
+};
+
+// 同一文件（file_md5）的任务流
+// 任务按提交顺序进入无锁队列；scheduled 保证同一时刻只有一个 worker 处理它，
+// 文件内的顺序因此得以保持，而整条流可以被空闲 worker 窃取
+// 提交方只在查表时持有池的锁，计数、入队和调度都在锁外完成；
+// 空闲的流由 Retire 把 pending 从 0 CAS 为 RETIRED 后移出表，
+// 之后拿着旧指针的提交方 AddPending 失败，重新查表取新流
+struct FileStream {
+    static constexpr std::size_t RETIRED = SIZE_MAX;
+
+    explicit FileStream(const std::string& md5)
+        : file_md5(md5) {}
+
+    // @brief: 计入一个待处理任务，流已退役时返回 false
+    bool AddPending() {
+        auto n = pending.load();
+        do {
+            if (n == RETIRED) return false;
+        } while (!pending.compare_exchange_weak(n, n + 1));
+        return true;
+    }
+    std::size_t PendingCount() const {
+        auto n = pending.load();
+        return n == RETIRED ? 0 : n;
+    }
+
+    const std::string           file_md5;
+    MpscQueue<FsTask>           tasks;
+    std::atomic<std::size_t>    pending{0};          // 尚未处理的任务数
+    std::atomic<bool>           scheduled{false};    // 已在就绪队列或正被处理
+    std::unique_ptr<FileBuffer> file;                // 仅由持有流的 worker 访问
+};
 
 class FileWorker {
 public:
-    FileWorker(int id);
+    FileWorker(
+        int id, FileWorkerPool* pool, const FileSink::Options& sink_options);
     ~FileWorker();
-    void submit(const FsTask& task);
+
+    void start();
+    void stop();
+    void join();
+
+    // @brief: 文件流进入就绪队列尾部
+    void push(std::shared_ptr<FileStream> stream);
+    // @brief: 从就绪队列尾部取走一条流，供空闲 worker 窃取
+    std::shared_ptr<FileStream> steal();
+    // @brief: 唤醒空闲的 worker 去窃取
+    void wake();
+
+    bool busy() const { return _busy; }
+    // @brief: 就绪队列中（含正在处理的流）尚未处理的任务数
+    std::size_t queue_depth();
 
 private:
     void run();
-    std::string CalculateMD5(const std::string& data);  // 新增：MD5计算
+    // @brief: 先取自己的就绪队列，再去其他 worker 窃取，都没有则等待
+    std::shared_ptr<FileStream> next();
+    // @brief: 处理一条流，最多 TASK_BUDGET 个任务后让出给其他文件
+    void process(const std::shared_ptr<FileStream>& stream);
+    void handle(FileStream& stream, FsTask& task);
+
+    // @brief: 把完整收到的临时文件提交为 blob，并把文件名链接过去
+    bool commitBlob(
+        const std::string& file_md5, const std::string& file_name,
+        const std::string& partial);
+    // @brief: 续传时截掉断点之后的数据，并从磁盘重算已写入部分的摘要
+    bool restoreDigest(
+        FileBuffer& file_buf, const std::string& filepath, int64 resume_offset);
+    // @brief: 数据计入文件摘要和当前块摘要，跨块边界时按边界切分
+    void hashData(FileBuffer& file_buf, const std::string& data);
+    // @brief: 当前块写满，保存块校验和与上传进度
+    void saveCheckpoint(FileBuffer& file_buf);
+    // @brief: 分块上传：校验并定位写入一块，落盘后记入位图，到齐时提交
+    bool writeBlock(const FsTask& task);
+    // @brief: 全部块到齐后从磁盘重算整个文件的摘要，一致则提交为 blob
+    bool finalizeBlocks(
+        const std::string& file_md5, const std::string& file_name,
+        int64 total_size);
+    // @brief: 丢弃无法提交的上传：删除临时文件、进度与断点校验和
+    void discardUpload(const std::string& file_md5);
+    // @brief: 写出攒下的小块并归还背压额度
+    void flushBuffer(FileBuffer& file_buf);
+    // @brief: 把一个 DATA 任务的字节还给它所属的上传流
+    static void releaseCredit(const FsTask& task);
+    void logSinkStats(const FileBuffer& file_buf);
 
 private:
-    struct FileBuffer {
-        std::unique_ptr<std::ofstream> file;
-        std::string                    buffer;
-        std::string                    checkpoint_buffer;
-        std::size_t                    total_written = 0;
-        std::string                    file_md5;      // 新增：文件MD5
-        std::string                    file_name;     // 新增：文件名
-
-        void                           flush() {
-            if (!buffer.empty() && file->is_open()) {
-                file->write(buffer.data(), buffer.size());
-                buffer.clear();
-            }
-        }
-    };
-
-    int                                         _id;
-    std::atomic<bool>                           _running;
-    std::thread                                 _worker_thread;
-    TaskQueue<FsTask>                           _queue;
-    std::unordered_map<std::string, FileBuffer> _file_buffers;
-    std::unordered_map<std::string, std::string> _md5_to_filename_map;
+    int                                     _id;
+    FileWorkerPool*                         _pool;
+    std::atomic<bool>                       _running;
+    std::atomic<bool>                       _busy{false};
+    std::thread                             _worker_thread;
+    std::mutex                              _mutex;
+    std::condition_variable                 _cond;
+    bool                                    _signaled = false;
+    std::deque<std::shared_ptr<FileStream>> _ready;
+    std::shared_ptr<FileStream>             _current;   // 正在处理的流
+    FileSink::Options                       _sink_options;
 
     static constexpr size_t                     BUFFER_THRESHOLD = 256 * 1024;
     static constexpr int64                      RESUME_CHUNK_SIZE = 20 * 1024 * 1024; // 20MB
+    // 每次处理一条流的任务上限（约 16MB），大文件不会独占 worker
+    static constexpr int                        TASK_BUDGET = 8;
 };
 
 
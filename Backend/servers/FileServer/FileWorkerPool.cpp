@@ -1,16 +1,54 @@
 #include "FileWorkerPool.h"
 #include "FileWorker.h"
+#include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
+#include <algorithm>
+#include <cstdlib>
 
-FileWorkerPool::FileWorkerPool(int count) {
+namespace {
+
+// 写盘受磁盘限制，线程数超过核数或 8 个收益不大
+std::size_t ConfigWorkers(const std::string& value) {
+    int n = value.empty() ? 0 : std::atoi(value.c_str());
+    if (n > 0) return static_cast<std::size_t>(n);
+    auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    return std::clamp<std::size_t>(hardware, 2, 8);
+}
+
+}   // namespace
+
+FileWorkerPool::FileWorkerPool() {
+    auto& config = *ConfigManager::getInstance();
+
+    FileSink::Options sink_options;
+    sink_options.sync
+        = FileSink::ParseSyncPolicy(config["FileServer"]["upload_sync"]);
+    sink_options.preallocate
+        = config["FileServer"]["upload_preallocate"] != "0";
+
+    auto count = ConfigWorkers(config["FileServer"]["upload_workers"]);
     for (std::size_t i = 0; i < count; ++i) {
-        _workers.emplace_back(std::make_unique<FileWorker>(i));
+        _workers.emplace_back(
+            std::make_unique<FileWorker>(i, this, sink_options));
     }
-    LOG_INFO("[FileWorkerPool] Init successfully");
+    // 全部 worker 构造完再启动，窃取时才能安全地遍历 _workers
+    for (auto& worker : _workers) worker->start();
+    LOG_INFO(
+        "[FileWorkerPool] Init successfully, workers={}, upload_sync={}, "
+        "preallocate={}",
+        count,
+        config["FileServer"]["upload_sync"],
+        sink_options.preallocate);
 }
 
 void FileWorkerPool::Stop() {
+    // worker 处理中会调度到其他 worker，全部停下后再析构
+    for (auto& worker : _workers) worker->stop();
+    for (auto& worker : _workers) worker->join();
     _workers.clear();
+
+    std::lock_guard<std::mutex> lock(_streams_mutex);
+    _streams.clear();
 }
 
 
@@ -19,9 +57,72 @@ std::size_t FileWorkerPool::GetWorkerIndex(const std::string& md5) {
 }
 
 void FileWorkerPool::Submit(const FsTask& task) {
-    auto idx = GetWorkerIndex(task.file_md5);
-    _workers[idx]->submit(task);
+    if (_workers.empty()) return;
+
+    // 锁只保护查表；拿到的流若恰好被 Retire 退役，重新查表
+    std::shared_ptr<FileStream> stream;
+    do {
+        std::lock_guard<std::mutex> lock(_streams_mutex);
+        auto& slot = _streams[task.file_md5];
+        if (!slot) slot = std::make_shared<FileStream>(task.file_md5);
+        stream = slot;
+    } while (!stream->AddPending());
+
+    // 先计数再入队再置标记：worker 清标记后看到计数非零就会重新调度
+    stream->tasks.Push(task);
+    if (stream->scheduled.exchange(true)) return;
+    Schedule(stream, GetWorkerIndex(task.file_md5));
+}
+
+void FileWorkerPool::Schedule(
+    const std::shared_ptr<FileStream>& stream, std::size_t target) {
+    _workers[target]->push(stream);
+    if (!_workers[target]->busy()) return;
+
+    for (std::size_t i = 1; i < _workers.size(); ++i) {
+        auto& worker = _workers[(target + i) % _workers.size()];
+        if (!worker->busy()) {
+            worker->wake();
+            return;
+        }
+    }
+}
+
+std::shared_ptr<FileStream> FileWorkerPool::Steal(std::size_t thief) {
+    for (std::size_t i = 1; i < _workers.size(); ++i) {
+        auto victim = (thief + i) % _workers.size();
+        if (auto stream = _workers[victim]->steal()) {
+            LOG_DEBUG(
+                "[FileWorkerPool] worker {} stole md5={} from worker {}",
+                thief,
+                stream->file_md5,
+                victim);
+            return stream;
+        }
+    }
+    return nullptr;
+}
+
+void FileWorkerPool::Retire(const std::shared_ptr<FileStream>& stream) {
+    std::lock_guard<std::mutex> lock(_streams_mutex);
+    // 退役后提交方无法再计入任务；未被调度说明也没有 worker 正在访问它
+    std::size_t idle = 0;
+    if (!stream->pending.compare_exchange_strong(idle, FileStream::RETIRED)) {
+        return;
+    }
+    if (stream->scheduled || stream->file) {
+        // 文件未关闭的流留在表里；锁内撤销，重试的提交方在锁上等到这里
+        stream->pending = 0;
+        return;
+    }
+    auto it = _streams.find(stream->file_md5);
+    if (it != _streams.end() && it->second == stream) _streams.erase(it);
+}
 
+std::vector<std::size_t> FileWorkerPool::QueueDepths() {
+    std::vector<std::size_t> depths;
+    for (auto& worker : _workers) depths.push_back(worker->queue_depth());
+    return depths;
 }
 
 FileWorkerPool::~FileWorkerPool() {
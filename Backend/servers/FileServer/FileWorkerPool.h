@@ -3,20 +3,44 @@
 
 #include "FileWorker.h"
 #include "common/singleton.h"
+#include <unordered_map>
 #include <vector>
 
+// 上传写盘线程池
+// 任务按 file_md5 归入文件流，同一文件的任务始终按提交顺序由一个 worker 处理；
+// 文件流优先交给 hash(md5) 对应的 worker，它忙时由空闲 worker 整条窃取。
+// worker 数取自 upload_workers，未配置时按 CPU 核数
 class FileWorkerPool : public SingleTon<FileWorkerPool> {
     friend class SingleTon<FileWorkerPool>;
+    friend class FileWorker;
 
 public:
         ~FileWorkerPool();
         void Stop();
         void Submit(const FsTask& task);
+
+        std::size_t WorkerCount() const { return _workers.size(); }
+        // @brief: 各 worker 尚未处理的任务数
+        std::vector<std::size_t> QueueDepths();
+
 private:
         std::size_t GetWorkerIndex(const std::string& md5);
+        // @brief: 流放入 target 的就绪队列，target 正忙时唤醒空闲 worker 窃取
+        void Schedule(
+            const std::shared_ptr<FileStream>& stream, std::size_t target);
+        // @brief: 从 thief 之外的 worker 就绪队列尾部窃取一条流
+        std::shared_ptr<FileStream> Steal(std::size_t thief);
+        // @brief: 流已空闲且文件已关闭时从表中移除
+        void Retire(const std::shared_ptr<FileStream>& stream);
+
 private:
-        FileWorkerPool(int count = 4);
+        FileWorkerPool();
         std::vector<std::unique_ptr<FileWorker>> _workers;
+        // 只保护文件流表的查找、插入与移除；任务入队不持锁
+        using StreamMap
+            = std::unordered_map<std::string, std::shared_ptr<FileStream>>;
+        std::mutex _streams_mutex;
+        StreamMap  _streams;
 };
 
 
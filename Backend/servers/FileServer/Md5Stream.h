@@ -0,0 +1,41 @@
+#ifndef MD5STREAM_H_
+#define MD5STREAM_H_
+
+#include <cstddef>
+#include <memory>
+#include <openssl/evp.h>
+#include <string>
+
+// 增量 MD5：数据分多次喂入，不需要把整块内容攒在内存里再计算
+class Md5Stream {
+public:
+    Md5Stream() : _ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free) { Reset(); }
+
+    void Reset() { EVP_DigestInit_ex(_ctx.get(), EVP_md5(), nullptr); }
+
+    void Update(const char* data, std::size_t size) {
+        EVP_DigestUpdate(_ctx.get(), data, size);
+    }
+
+    // @brief: 结束本轮计算并返回小写十六进制摘要，之后可继续喂入下一轮
+    std::string HexDigest() {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int  size = 0;
+        EVP_DigestFinal_ex(_ctx.get(), digest, &size);
+        Reset();
+
+        static const char* hex = "0123456789abcdef";
+        std::string        out;
+        out.reserve(size * 2);
+        for (unsigned int i = 0; i < size; ++i) {
+            out.push_back(hex[(digest[i] >> 4) & 0x0F]);
+            out.push_back(hex[digest[i] & 0x0F]);
+        }
+        return out;
+    }
+
+private:
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> _ctx;
+};
+
+#endif   // MD5STREAM_H_
@@ -0,0 +1,128 @@
+#include "OpenUploadSessionCallData.h"
+#include "FileIndexManager.h"
+#include "common/BlockBitmap.h"
+#include "const.h"
+#include "infra/LogManager.h"
+#include "repository/FileRepository.h"
+#include <filesystem>
+#include <grpcpp/support/status.h>
+
+OpenUploadSessionCallData::OpenUploadSessionCallData(
+    FileService::FileTransport::AsyncService* service,
+    grpc::ServerCompletionQueue*              cq)
+    : _service(service), _cq(cq), _responder(&_ctx), _state(CallState::CREATE) {
+    Proceed(true);
+}
+
+void OpenUploadSessionCallData::Proceed(bool ok) {
+    switch (_state) {
+    case CallState::CREATE: {
+        _state = CallState::PROCESS;
+        _service->RequestOpenUploadSession(
+            &_ctx, &_request, &_responder, _cq, _cq, this);
+        break;
+    }
+
+    case CallState::PROCESS: {
+        if (!ok) {
+            delete this;
+            break;
+        }
+        new OpenUploadSessionCallData(_service, _cq);
+
+        auto status = openSession();
+        _state      = CallState::FINISH;
+        if (status.ok()) {
+            _responder.Finish(_response, status, this);
+        } else {
+            _responder.FinishWithError(status, this);
+        }
+        break;
+    }
+
+    default: {
+        delete this;
+        break;
+    }
+    }
+}
+
+grpc::Status OpenUploadSessionCallData::openSession() {
+    const std::string& file_md5   = _request.file_md5();
+    const std::string& file_name  = _request.file_name();
+    const int64        total_size = _request.total_size();
+
+    if (file_md5.empty() || file_name.empty() || total_size <= 0) {
+        return grpc::Status(
+            grpc::StatusCode::INVALID_ARGUMENT,
+            "invalid session: empty file name or md5, or total_size <= 0");
+    }
+
+    // 内容已存在时直接链接，客户端跳过整个传输
+    auto index = FileIndexManager::getInstance();
+    if (index->link_existing(file_name, file_md5, total_size)) {
+        _response.set_file_exists(true);
+        LOG_INFO(
+            "[OpenUploadSessionCallData] Instant upload: {} -> {}",
+            file_name,
+            file_md5);
+        return grpc::Status::OK;
+    }
+
+    // 同一内容的会话已存在则沿用其块大小，位图里的块不必重传
+    UploadSession session;
+    auto          existing = FileRepository::GetUploadSession(file_md5);
+    if (existing.IsOK()) {
+        // md5 相同而大小不同说明请求有误，不能因此丢掉其他客户端的进度
+        if (existing.Value().total_size != total_size) {
+            LOG_WARN(
+                "[OpenUploadSessionCallData] Size mismatch: md5={}, "
+                "session={}, request={}",
+                file_md5,
+                existing.Value().total_size,
+                total_size);
+            return grpc::Status(
+                grpc::StatusCode::FAILED_PRECONDITION,
+                "upload session exists with a different total_size");
+        }
+        session = existing.Value();
+    } else {
+        // 新会话：清掉旧位图和残留的临时文件
+        FileRepository::DeleteUploadSession(file_md5);
+        std::error_code ec;
+        std::filesystem::remove(index->block_partial_path(file_md5), ec);
+
+        session.file_md5   = file_md5;
+        session.total_size = total_size;
+        session.block_size
+            = BlockBitmap::NormalizeBlockSize(_request.block_size());
+        session.block_count
+            = BlockBitmap::BlockCount(total_size, session.block_size);
+    }
+    // 以最近一次打开时的文件名为准，同时刷新过期时间
+    session.file_name = file_name;
+    if (!FileRepository::SaveUploadSession(session).IsOK()) {
+        return grpc::Status(
+            grpc::StatusCode::UNAVAILABLE, "failed to save upload session");
+    }
+
+    auto bitmap = FileRepository::GetReceivedBlocks(file_md5);
+    if (!bitmap.IsOK()) {
+        return grpc::Status(
+            grpc::StatusCode::UNAVAILABLE, "failed to load received blocks");
+    }
+
+    _response.set_block_size(session.block_size);
+    _response.set_block_count(session.block_count);
+    _response.set_received_blocks(bitmap.Value());
+
+    LOG_INFO(
+        "[OpenUploadSessionCallData] Session opened: file={}, md5={}, "
+        "block_size={}, received {}/{} blocks",
+        file_name,
+        file_md5,
+        session.block_size,
+        BlockBitmap::CountSet(bitmap.Value(), session.block_count),
+        session.block_count);
+    return grpc::Status::OK;
+}
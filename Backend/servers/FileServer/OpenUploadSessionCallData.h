@@ -0,0 +1,33 @@
+#ifndef OPENUPLOADSESSIONCALLDATA_H_
+#define OPENUPLOADSESSIONCALLDATA_H_
+
+#include "CallData.h"
+#include "const.h"
+#include "file.grpc.pb.h"
+
+// 打开（或续传）分块上传会话，返回块大小与已收到块的位图
+class OpenUploadSessionCallData : public CallData {
+public:
+    OpenUploadSessionCallData(
+        FileService::FileTransport::AsyncService* service,
+        grpc::ServerCompletionQueue*              cq);
+
+    void Proceed(bool ok) override;
+
+private:
+    // @brief: 建立或沿用会话并填充响应，失败时返回错误状态
+    grpc::Status openSession();
+
+    FileService::FileTransport::AsyncService* _service;
+    grpc::ServerCompletionQueue*              _cq;
+
+    grpc::ServerContext                    _ctx;
+    FileService::UploadSessionRequest      _request;
+    FileService::UploadSessionStatus       _response;
+    grpc::ServerAsyncResponseWriter<FileService::UploadSessionStatus>
+        _responder;
+
+    CallState _state;
+};
+
+#endif   // OPENUPLOADSESSIONCALLDATA_H_
@@ -66,6 +66,8 @@ void QueryDownloadCallData::Proceed(bool ok) {
                     this);
                 return;
             }
+            // blob 按内容寻址，文件名即 MD5；客户端据此校验并发区间下载的结果
+            _response.set_file_md5(fs::path(found_path).filename().string());
 
             // 查询下载断点
             auto progress_result
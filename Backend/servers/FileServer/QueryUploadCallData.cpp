@@ -1,4 +1,5 @@
 #include "QueryUploadCallData.h"
+#include "FileIndexManager.h"
 #include "const.h"
 #include "infra/LogManager.h"
 #include "repository/FileRepository.h"
@@ -30,6 +31,20 @@ void QueryUploadCallData::Proceed(bool ok) {
             "[QueryUploadCallData] Querying upload status for md5: {}",
             file_md5);
 
+        // 内容已存在时直接把新名字链接过去，客户端跳过整个传输
+        if (!_request.file_name().empty()
+            && FileIndexManager::getInstance()->link_existing(
+                _request.file_name(), file_md5, _request.total_size())) {
+            _response.set_file_exists(true);
+            LOG_INFO(
+                "[QueryUploadCallData] Instant upload: {} -> {}",
+                _request.file_name(),
+                file_md5);
+            _state = CallState::FINISH;
+            _responder.Finish(_response, grpc::Status::OK, this);
+            break;
+        }
+
         // 查询上传进度
         auto progress_result = FileRepository::GetUploadProgress(file_md5);
 
@@ -0,0 +1,143 @@
+#include "SmallFileCache.h"
+#include "infra/ConfigManager.h"
+#include "infra/LogManager.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// 未配置时返回 fallback，配置为 0 时返回 0
+int64_t ConfigNumber(const std::string& key, int64_t fallback) {
+    auto value = (*ConfigManager::getInstance())["FileServer"][key];
+    if (value.empty()) return fallback;
+    return std::max<int64_t>(0, std::atoll(value.c_str()));
+}
+
+int64_t SteadySeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+}   // namespace
+
+SmallFileCache::SmallFileCache() {
+    _max_bytes = static_cast<std::size_t>(
+        ConfigNumber("download_cache_mb", _max_bytes >> 20) << 20);
+    _max_file_size = static_cast<std::size_t>(
+        ConfigNumber("download_cache_file_kb", _max_file_size >> 10) << 10);
+    _max_file_size
+        = std::min({_max_file_size, _max_bytes, MAX_CACHED_FILE});
+    _ttl = std::chrono::seconds(ConfigNumber("download_cache_ttl_sec", 30));
+    _stats_interval
+        = std::chrono::seconds(ConfigNumber("download_cache_stats_sec", 60));
+    _last_stats_log = SteadySeconds();
+
+    LOG_INFO(
+        "[SmallFileCache] max bytes: {}, max file size: {}, ttl: {}s",
+        _max_bytes,
+        _max_file_size,
+        _ttl.count());
+}
+
+bool SmallFileCache::Get(const std::string& file_name, Entry& entry) {
+    if (!Enabled()) return false;
+    maybeLogStats();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _index.find(file_name);
+    if (it == _index.end()) return false;
+
+    if (it->second->expire_at <= std::chrono::steady_clock::now()) {
+        eraseLocked(it->second);
+        return false;
+    }
+
+    _lru.splice(_lru.begin(), _lru, it->second);
+    entry = it->second->entry;
+    _hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SmallFileCache::Put(
+    const std::string& file_name, const std::string& file_md5,
+    grpc::Slice data) {
+    if (!Enabled() || data.size() > _max_file_size) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _index.find(file_name);
+    if (it != _index.end()) {
+        eraseLocked(it->second);
+    }
+
+    _lru.push_front(Node{
+        file_name,
+        Entry{file_md5, std::move(data)},
+        std::chrono::steady_clock::now() + _ttl});
+    _index[file_name] = _lru.begin();
+    _bytes += _lru.front().entry.data.size();
+
+    while (_bytes > _max_bytes && !_lru.empty()) {
+        eraseLocked(std::prev(_lru.end()));
+        _evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SmallFileCache::Invalidate(const std::string& file_name) {
+    if (!Enabled()) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _index.find(file_name);
+    if (it != _index.end()) {
+        eraseLocked(it->second);
+    }
+}
+
+void SmallFileCache::RecordServed(std::size_t bytes) {
+    _bytes_served.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void SmallFileCache::eraseLocked(NodeList::iterator it) {
+    _bytes -= it->entry.data.size();
+    _index.erase(it->file_name);
+    _lru.erase(it);
+}
+
+SmallFileCacheStats SmallFileCache::GetStats() {
+    SmallFileCacheStats stats;
+    stats.hits         = _hits.load(std::memory_order_relaxed);
+    stats.misses       = _misses.load(std::memory_order_relaxed);
+    stats.evictions    = _evictions.load(std::memory_order_relaxed);
+    stats.bytes_served = _bytes_served.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.entries = _index.size();
+    stats.bytes   = _bytes;
+    return stats;
+}
+
+void SmallFileCache::LogStats() {
+    auto stats = GetStats();
+    LOG_INFO(
+        "[SmallFileCache] hits {}, misses {}, hit ratio {:.2f}%, "
+        "served from memory {} bytes, entries {}, bytes {}, evictions {}",
+        stats.hits,
+        stats.misses,
+        stats.hit_ratio() * 100.0,
+        stats.bytes_served,
+        stats.entries,
+        stats.bytes,
+        stats.evictions);
+}
+
+void SmallFileCache::maybeLogStats() {
+    if (_stats_interval.count() <= 0) return;
+
+    // 没有单独的上报线程，由下载请求顺带按间隔输出，只有一个线程抢到
+    auto now  = SteadySeconds();
+    auto last = _last_stats_log.load(std::memory_order_relaxed);
+    if (now - last < _stats_interval.count()) return;
+    if (_last_stats_log.compare_exchange_strong(last, now)) {
+        LogStats();
+    }
+}
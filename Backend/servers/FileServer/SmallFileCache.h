@@ -0,0 +1,97 @@
+#ifndef SMALLFILECACHE_H_
+#define SMALLFILECACHE_H_
+
+#include "common/singleton.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <grpcpp/support/slice.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct SmallFileCacheStats {
+    uint64_t    hits         = 0;
+    uint64_t    misses       = 0;   // 可缓存的小文件未命中
+    uint64_t    evictions    = 0;
+    uint64_t    bytes_served = 0;   // 从内存发出的字节数
+    std::size_t entries      = 0;
+    std::size_t bytes        = 0;
+
+    double hit_ratio() const {
+        auto total = hits + misses;
+        if (total == 0) return 0.0;
+        return static_cast<double>(hits) / total;
+    }
+};
+
+// 下载热点小文件的内存缓存（头像、缩略图等）
+// 按文件名缓存整个文件内容，命中时不查 Redis 索引、不打开文件，
+// 内容以 grpc::Slice 保存，发送时只增加引用计数，不拷贝
+// blob 按内容寻址不会被改写，但文件名可能改指向新内容：
+// 本进程内重新链接时立即失效，其他情况由 TTL 兜底
+class SmallFileCache : public SingleTon<SmallFileCache> {
+    friend class SingleTon<SmallFileCache>;
+
+public:
+    struct Entry {
+        std::string file_md5;
+        grpc::Slice data;
+    };
+
+    // @brief: 命中且未过期时填充 entry 并返回 true
+    bool Get(const std::string& file_name, Entry& entry);
+    // @brief: 放入整个文件的内容，超过单文件上限或缓存已停用时忽略
+    void Put(
+        const std::string& file_name, const std::string& file_md5,
+        grpc::Slice data);
+    // @brief: 文件名改指向其他内容
+    void Invalidate(const std::string& file_name);
+
+    // @brief: 大小不超过该值的文件可以缓存，0 表示停用
+    std::size_t MaxFileSize() const { return _max_file_size; }
+    bool        Enabled() const { return _max_file_size > 0; }
+
+    // @brief: 小文件未命中，用于统计命中率
+    void RecordMiss() { _misses.fetch_add(1, std::memory_order_relaxed); }
+    void RecordServed(std::size_t bytes);
+
+    SmallFileCacheStats GetStats();
+    void                LogStats();
+
+private:
+    SmallFileCache();
+
+    struct Node {
+        std::string                           file_name;
+        Entry                                 entry;
+        std::chrono::steady_clock::time_point expire_at;
+    };
+    using NodeList = std::list<Node>;
+
+    // 要求调用方已持有 _mutex
+    void eraseLocked(NodeList::iterator it);
+    void maybeLogStats();
+
+    std::mutex                                          _mutex;
+    NodeList                                            _lru;   // 头部最新
+    std::unordered_map<std::string, NodeList::iterator> _index;
+    std::size_t                                         _bytes = 0;
+
+    // 与下载块大小一致，命中的文件总是一块发完
+    static constexpr std::size_t MAX_CACHED_FILE = 2 * 1024 * 1024;
+
+    std::size_t          _max_bytes     = 64 * 1024 * 1024;
+    std::size_t          _max_file_size = 256 * 1024;
+    std::chrono::seconds _ttl{30};
+    std::chrono::seconds _stats_interval{60};
+
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _evictions{0};
+    std::atomic<uint64_t> _bytes_served{0};
+    std::atomic<int64_t>  _last_stats_log{0};   // steady_clock 秒数
+};
+
+#endif   // SMALLFILECACHE_H_
@@ -12,22 +12,48 @@ struct FsTask {
     std::string                  file_md5;
     std::shared_ptr<std::string> data;
     int64                        resume_offset = 0;
+    int64                        total_size = 0;  // META：声明的文件总大小，用于预分配
     bool                         complete = true; // END 任务是否按完成态收尾
+    std::function<void(bool)>    on_done;         // END 处理完后回调：文件是否校验通过并提交
+    int32_t                      block_index = 0; // BLOCK：块序号，resume_offset 为块偏移
+    int32_t                      block_count = 0; // BLOCK：会话总块数
+    std::string                  block_md5;       // BLOCK：可选的块校验值
+    std::string                  credit_key;      // DATA：写盘后归还背压额度的上传流，为空则不归还
 
-    static FsTask createMeta(const std::string& name, const std::string& md5, int64 offset = 0) {
-        return {TaskType::META, name, md5, nullptr, offset, true};
+    static FsTask createMeta(const std::string& name, const std::string& md5, int64 offset = 0,
+                             int64 total_size = 0) {
+        return {TaskType::META, name, md5, nullptr, offset, total_size, true};
     }
 
-    static FsTask createData(const std::string& md5, const std::string& chunk) {
-        return {TaskType::DATA, "", md5, std::make_shared<std::string>(chunk), 0, true};
+    static FsTask createData(const std::string& md5, const std::string& chunk,
+                             const std::string& credit_key = "") {
+        return {TaskType::DATA, "", md5, std::make_shared<std::string>(chunk), 0, 0, true,
+                nullptr, 0, 0, "", credit_key};
     }
 
-    static FsTask createData(const std::string& md5, const std::string&& chunk) {
-        return {TaskType::DATA, "", md5, std::make_shared<std::string>(std::move(chunk)), 0, true};
+    static FsTask createData(const std::string& md5, const std::string&& chunk,
+                             const std::string& credit_key = "") {
+        return {TaskType::DATA, "", md5, std::make_shared<std::string>(std::move(chunk)), 0, 0,
+                true, nullptr, 0, 0, "", credit_key};
     }
 
-    static FsTask createEnd(const std::string& md5, bool complete = true) {
-        return {TaskType::END, "", md5, nullptr, 0, complete};
+    static FsTask createEnd(const std::string& md5, bool complete = true,
+                            std::function<void(bool)> on_done = nullptr) {
+        return {TaskType::END, "", md5, nullptr, 0, 0, complete, std::move(on_done)};
+    }
+
+    // on_done(块是否写入并记入位图)
+    static FsTask createBlock(const std::string& name, const std::string& md5, int32_t index,
+                              int32_t count, int64 offset, int64 total_size,
+                              std::string&& data, const std::string& block_md5,
+                              std::function<void(bool)> on_done) {
+        return {TaskType::BLOCK, name, md5, std::make_shared<std::string>(std::move(data)),
+                offset, total_size, true, std::move(on_done), index, count, block_md5};
+    }
+
+    // on_done(此时文件是否已提交)
+    static FsTask createBarrier(const std::string& md5, std::function<void(bool)> on_done) {
+        return {TaskType::BARRIER, "", md5, nullptr, 0, 0, true, std::move(on_done)};
     }
 };
 
@@ -0,0 +1,190 @@
+#include "UploadBlocksCallData.h"
+#include "BackPressureManager.h"
+#include "FileWorkerPool.h"
+#include "TaskQueue.h"
+#include "common/BlockBitmap.h"
+#include "infra/LogManager.h"
+#include <string>
+
+UploadBlocksCallData::UploadBlocksCallData(
+    FileTransport::AsyncService* service, grpc::ServerCompletionQueue* cq)
+    : _service(service)
+    , _cq(cq)
+    , _ctx()
+    , _reader(&_ctx)
+    , _state(CallState::CREATE) {
+    _drain_tag.owner  = this;
+    _credit_tag.owner = this;
+    Proceed(true);
+}
+
+void UploadBlocksCallData::Proceed(bool ok) {
+    switch (_state) {
+    case CallState::CREATE: handleCreateState(); break;
+    case CallState::PROCESS: handleProcessState(ok); break;
+    default: cleanup(); break;
+    }
+}
+
+void UploadBlocksCallData::handleCreateState() {
+    _state = CallState::PROCESS;
+    _service->RequestUploadBlocks(&_ctx, &_reader, _cq, _cq, this);
+}
+
+void UploadBlocksCallData::handleProcessState(bool ok) {
+    if (!_stream_started) {
+        if (!ok) {
+            cleanup();
+            return;
+        }
+        _stream_started = true;
+        new UploadBlocksCallData(_service, _cq);
+        _reader.Read(&_request, this);
+        return;
+    }
+
+    // 客户端发送完毕（或流已断开）
+    if (!ok) {
+        drain();
+        return;
+    }
+
+    if (!submitBlock()) {
+        drain();
+        return;
+    }
+    readNext();
+}
+
+bool UploadBlocksCallData::submitBlock() {
+    if (!_session_loaded) {
+        auto session = FileRepository::GetUploadSession(_request.file_md5());
+        if (_request.file_md5().empty() || !session.IsOK()) {
+            fail(
+                grpc::StatusCode::FAILED_PRECONDITION,
+                "no upload session, call OpenUploadSession first");
+            return false;
+        }
+        _session        = session.Value();
+        _session_loaded = true;
+        // 同一文件的多条流各有自己的背压额度
+        _credit_key = BackPressureManager::getInstance()->new_stream(
+            _session.file_md5);
+    } else if (_request.file_md5() != _session.file_md5) {
+        fail(
+            grpc::StatusCode::INVALID_ARGUMENT,
+            "blocks of different files in one stream");
+        return false;
+    }
+
+    const int32_t index    = _request.block_index();
+    const int64   expected = BlockBitmap::BlockLength(
+        _session.total_size, _session.block_size, index);
+    if (expected == 0
+        || static_cast<int64>(_request.data().size()) != expected) {
+        fail(
+            grpc::StatusCode::INVALID_ARGUMENT,
+            "block " + std::to_string(index) + " out of range or has "
+                + std::to_string(_request.data().size()) + " bytes, expected "
+                + std::to_string(expected));
+        return false;
+    }
+
+    // 块计入本流的在途额度，worker 写完（或拒收）后在回调里归还
+    const std::size_t size = _request.data().size();
+    BackPressureManager::getInstance()->charge(_credit_key, size);
+    FileWorkerPool::getInstance()->Submit(FsTask::createBlock(
+        _session.file_name,
+        _session.file_md5,
+        index,
+        _session.block_count,
+        BlockBitmap::BlockOffset(index, _session.block_size),
+        _session.total_size,
+        std::move(*_request.mutable_data()),
+        _request.block_md5(),
+        [this, size](bool written) {
+            ++(written ? _blocks_written : _blocks_rejected);
+            BackPressureManager::getInstance()->notify_data_flushed(
+                _credit_key, size);
+        }));
+    return true;
+}
+
+void UploadBlocksCallData::readNext() {
+    if (!BackPressureManager::getInstance()->request_credit(
+            _credit_key, [this]() {
+                _credit_alarm.Set(
+                    _cq, gpr_now(GPR_CLOCK_MONOTONIC), &_credit_tag);
+            })) {
+        return;
+    }
+    _reader.Read(&_request, this);
+}
+
+void UploadBlocksCallData::handleCredit(bool ok) {
+    if (!ok) {
+        fail(
+            grpc::StatusCode::UNAVAILABLE,
+            "upload interrupted while waiting for write credit");
+        drain();
+        return;
+    }
+    _reader.Read(&_request, this);
+}
+
+void UploadBlocksCallData::drain() {
+    if (!_session_loaded) {
+        handleDrained(true);
+        return;
+    }
+    // 屏障排在本流所有块之后，回调时块回调都已执行完
+    FileWorkerPool::getInstance()->Submit(FsTask::createBarrier(
+        _session.file_md5, [this](bool committed) {
+            _file_committed = committed;
+            _drain_alarm.Set(_cq, gpr_now(GPR_CLOCK_MONOTONIC), &_drain_tag);
+        }));
+}
+
+void UploadBlocksCallData::handleDrained(bool ok) {
+    if (_session_loaded) {
+        BackPressureManager::getInstance()->close_stream(_credit_key);
+    }
+    _state = CallState::FINISH;
+
+    const int32_t rejected = _blocks_rejected;
+    _response.set_blocks_written(_blocks_written);
+    _response.set_file_committed(_file_committed);
+    if (_error_code == grpc::StatusCode::OK && rejected > 0) {
+        _error_message = std::to_string(rejected)
+                         + " blocks failed checksum or could not be stored";
+    }
+    _response.set_success(_error_message.empty());
+    _response.set_message(_error_message.empty() ? "OK" : _error_message);
+
+    LOG_INFO(
+        "[UploadBlocksCallData] Stream finished: md5={}, written={}, "
+        "rejected={}, committed={}",
+        _session.file_md5,
+        _response.blocks_written(),
+        rejected,
+        _file_committed);
+
+    // 块级失败仍以 OK 返回，客户端据响应重传；协议错误以状态码返回
+    _reader.Finish(
+        _response,
+        _error_code == grpc::StatusCode::OK
+            ? grpc::Status::OK
+            : grpc::Status(_error_code, _error_message),
+        this);
+}
+
+void UploadBlocksCallData::fail(
+    grpc::StatusCode code, const std::string& message) {
+    _error_code    = code;
+    _error_message = message;
+    LOG_WARN("[UploadBlocksCallData] {}", message);
+}
+
+void UploadBlocksCallData::cleanup() {
+    delete this;
+}
@@ -0,0 +1,82 @@
+#ifndef UPLOADBLOCKSCALLDATA_H_
+#define UPLOADBLOCKSCALLDATA_H_
+
+#include "CallData.h"
+#include "const.h"
+#include "file.grpc.pb.h"
+#include "file.pb.h"
+#include "repository/FileRepository.h"
+#include <atomic>
+#include <grpcpp/alarm.h>
+#include <grpcpp/completion_queue.h>
+#include <grpcpp/server_context.h>
+#include <grpcpp/support/status.h>
+
+// 分块上传的一条数据流
+// 同一会话可以同时有多条流，每条流发送任意一组块；块交给 FileWorker 定位写入，
+// 流结束时提交一个屏障任务，等本流的块都落盘后再回复
+class UploadBlocksCallData : public CallData {
+public:
+    UploadBlocksCallData(
+        FileService::FileTransport::AsyncService* service,
+        grpc::ServerCompletionQueue*              cq);
+    ~UploadBlocksCallData() = default;
+
+    void Proceed(bool ok) override;
+
+private:
+    void handleCreateState();
+    void handleProcessState(bool ok);
+    void handleCredit(bool ok);
+    void handleDrained(bool ok);
+
+    // @brief: 校验当前块并交给 worker，请求不合法时记下原因返回 false
+    bool submitBlock();
+    // @brief: 有背压额度时发起下一次 Read，否则等额度归还
+    void readNext();
+    // @brief: 停止读取，等本流已提交的块都处理完再回复客户端
+    void drain();
+    void fail(grpc::StatusCode code, const std::string& message);
+    void cleanup();
+
+    // 屏障任务完成时经 Alarm 投递到 CQ 的事件
+    struct DrainTag : public CallData {
+        UploadBlocksCallData* owner = nullptr;
+        void Proceed(bool ok) override { owner->handleDrained(ok); }
+    };
+    // 背压额度归还时经 Alarm 投递到 CQ 的事件
+    struct CreditTag : public CallData {
+        UploadBlocksCallData* owner = nullptr;
+        void Proceed(bool ok) override { owner->handleCredit(ok); }
+    };
+
+private:
+    FileService::FileTransport::AsyncService* _service;
+    grpc::ServerCompletionQueue*              _cq;
+
+    grpc::ServerContext _ctx;
+    grpc::ServerAsyncReader<
+        FileService::UploadBlocksResponse, FileService::UploadBlock>
+        _reader;
+
+    FileService::UploadBlock          _request;
+    FileService::UploadBlocksResponse _response;
+    grpc::Alarm                       _drain_alarm;
+    DrainTag                          _drain_tag;
+    grpc::Alarm                       _credit_alarm;
+    CreditTag                         _credit_tag;
+
+    CallState     _state;
+    UploadSession _session;
+    std::string   _credit_key;   // 本条流在背压管理器中的标识
+
+    bool                 _stream_started  = false;
+    bool                 _session_loaded  = false;
+    bool                 _file_committed  = false;
+    std::atomic<int32_t> _blocks_written{0};
+    std::atomic<int32_t> _blocks_rejected{0};
+    grpc::StatusCode     _error_code      = grpc::StatusCode::OK;
+    std::string          _error_message;
+};
+
+#endif   // UPLOADBLOCKSCALLDATA_H_
@@ -1,5 +1,6 @@
 #include "UploadCallData.h"
 #include "BackPressureManager.h"
+#include "FileIndexManager.h"
 #include "FileWorkerPool.h"
 #include "TaskQueue.h"
 #include "const.h"
@@ -7,9 +8,15 @@
 #include "file.pb.h"
 #include "infra/LogManager.h"
 #include "repository/FileRepository.h"
+#include <chrono>
 #include <grpcpp/support/status.h>
 #include <string>
 
+namespace {
+// 写入租约期限，持有期间由锁服务自动续期；进程崩溃后最多这么久可被接手
+constexpr std::chrono::seconds WRITER_LEASE{30};
+}   // namespace
+
 
 UploadCallData::UploadCallData(
     FileTransport::AsyncService* service, grpc::ServerCompletionQueue* cq)
@@ -18,6 +25,8 @@ UploadCallData::UploadCallData(
     , _ctx()
     , _reader(&_ctx)
     , _state(CallState::CREATE) {
+    _commit_tag.owner = this;
+    _credit_tag.owner = this;
     Proceed(true);
 }
 
@@ -70,30 +79,36 @@ void UploadCallData::handleProcessState(bool ok) {
             }
         }
 
-        if (_meta_received && !_finalize_submitted) {
-            FileWorkerPool::getInstance()->Submit(
-                FsTask::createEnd(_current_md5, stream_ok));
+        if (_deduplicated) {
+            // 内容已存在：数据没有写盘，只在完整收到后增加一条引用
+            if (stream_ok
+                && !FileIndexManager::getInstance()->link_existing(
+                    _current_filename, _current_md5, _expected_total_size)) {
+                stream_ok      = false;
+                _error_message = "failed to link existing content";
+            }
+        } else if (_meta_submitted && !_finalize_submitted) {
             _finalize_submitted = true;
+            if (stream_ok) {
+                // 等 worker 校验整个文件的 md5 并提交后再回复客户端
+                FileWorkerPool::getInstance()->Submit(FsTask::createEnd(
+                    _current_md5,
+                    true,
+                    [this, lease = std::move(_writer_lease)](bool committed) {
+                        _committed = committed;
+                        _commit_alarm.Set(
+                            _cq, gpr_now(GPR_CLOCK_MONOTONIC), &_commit_tag);
+                    }));
+                closeStream();
+                return;
+            }
+            auto lease = std::move(_writer_lease);
+            FileWorkerPool::getInstance()->Submit(
+                FsTask::createEnd(_current_md5, false, [lease](bool) {}));
         }
 
-        BackPressureManager::getInstance()->notify_all();
-        _state = CallState::FINISH;
-
-        if (stream_ok) {
-            _response.set_success(true);
-            _response.set_message("OK");
-            _reader.Finish(_response, grpc::Status::OK, this);
-        } else {
-            const std::string reason
-                = _error_message.empty() ? "upload terminated before completion"
-                                         : _error_message;
-            _response.set_success(false);
-            _response.set_message(reason);
-            _reader.Finish(
-                _response,
-                grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, reason),
-                this);
-        }
+        closeStream();
+        finishUpload(stream_ok);
         return;
     }
 
@@ -108,8 +123,13 @@ void UploadCallData::handleProcessState(bool ok) {
         if (!_meta_received) {
             _has_error     = true;
             _error_message = "chunk before meta";
+        } else if (_deduplicated) {
+            _received_stream_bytes
+                += static_cast<int64>(_request.chunk().size());
         } else {
-            applyBackPressure();
+            // 收到的块先计入在途额度，worker 写盘后归还
+            BackPressureManager::getInstance()->charge(
+                _credit_key, _request.chunk().size());
             _received_stream_bytes
                 += static_cast<int64>(_request.chunk().size());
             handleChunkMessage();
@@ -120,30 +140,90 @@ void UploadCallData::handleProcessState(bool ok) {
     }
 
     if (_has_error) {
-        if (_meta_received && !_finalize_submitted) {
-            FileWorkerPool::getInstance()->Submit(
-                FsTask::createEnd(_current_md5, false));
-            _finalize_submitted = true;
-        }
+        abortUpload(_error_code);
+        return;
+    }
 
-        BackPressureManager::getInstance()->notify_all();
-        _state = CallState::FINISH;
-        _response.set_success(false);
-        _response.set_message(_error_message);
-        _reader.Finish(
-            _response,
-            grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, _error_message),
-            this);
+    readNext();
+}
+
+void UploadCallData::readNext() {
+    // 额度不足时不发起 Read，HTTP/2 流控会让客户端停下；
+    // 额度归还后经 Alarm 回到 CQ 线程再读
+    if (_meta_received && !_deduplicated
+        && !BackPressureManager::getInstance()->request_credit(
+            _credit_key, [this]() {
+                _credit_alarm.Set(
+                    _cq, gpr_now(GPR_CLOCK_MONOTONIC), &_credit_tag);
+            })) {
         return;
     }
+    _reader.Read(&_request, this);
+}
 
+void UploadCallData::handleCredit(bool ok) {
+    if (!ok) {
+        _error_message = "upload interrupted while waiting for write credit";
+        abortUpload(grpc::StatusCode::UNAVAILABLE);
+        return;
+    }
     _reader.Read(&_request, this);
 }
 
+void UploadCallData::abortUpload(grpc::StatusCode code) {
+    // 只结束本调用打开的流：META 未提交时 md5 的流可能属于另一个调用
+    if (_meta_submitted && !_finalize_submitted) {
+        // 租约随 END 任务销毁释放，worker 处理完之前其他调用不能接手
+        auto lease = std::move(_writer_lease);
+        FileWorkerPool::getInstance()->Submit(
+            FsTask::createEnd(_current_md5, false, [lease](bool) {}));
+        _finalize_submitted = true;
+    }
+
+    closeStream();
+    _state = CallState::FINISH;
+    _response.set_success(false);
+    _response.set_message(_error_message);
+    _reader.Finish(_response, grpc::Status(code, _error_message), this);
+}
+
+void UploadCallData::closeStream() {
+    if (_meta_submitted) {
+        BackPressureManager::getInstance()->close_stream(_credit_key);
+    }
+}
+
 void UploadCallData::handleFinishState() {
     cleanup();
 }
 
+void UploadCallData::handleCommitted(bool ok) {
+    if (!ok || !_committed) {
+        _error_message = "file md5 mismatch or failed to store file";
+    }
+    finishUpload(ok && _committed);
+}
+
+void UploadCallData::finishUpload(bool stream_ok) {
+    _state = CallState::FINISH;
+
+    if (stream_ok) {
+        _response.set_success(true);
+        _response.set_message("OK");
+        _reader.Finish(_response, grpc::Status::OK, this);
+    } else {
+        const std::string reason = _error_message.empty()
+                                       ? "upload terminated before completion"
+                                       : _error_message;
+        _response.set_success(false);
+        _response.set_message(reason);
+        _reader.Finish(
+            _response,
+            grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, reason),
+            this);
+    }
+}
+
 // 消息处理
 void UploadCallData::handleMetaMessage() {
     const auto& meta = _request.meta();
@@ -172,6 +252,28 @@ void UploadCallData::handleMetaMessage() {
         return;
     }
 
+    // 相同内容已上传完成（秒传）：旧客户端仍会发完数据，直接丢弃不写盘；
+    // 新客户端应先用 QueryUploadStatus 带上 file_name 查询，完全跳过传输
+    if (_resume_offset == 0
+        && FileIndexManager::getInstance()->has_blob(
+            _current_md5, _expected_total_size)) {
+        _deduplicated = true;
+        LOG_INFO(
+            "[UploadCallData] Content already stored, discarding upload: "
+            "file={}, md5={}",
+            _current_filename,
+            _current_md5);
+        return;
+    }
+
+    if (!acquireWriterLease()) {
+        _has_error     = true;
+        _error_code    = grpc::StatusCode::UNAVAILABLE;
+        _error_message = "another upload of the same content is in progress, "
+                         "retry later";
+        return;
+    }
+
     if (!processResumeLogic(meta)) {
         _has_error = true;
         if (_error_message.empty()) {
@@ -186,14 +288,37 @@ void UploadCallData::handleMetaMessage() {
         _current_md5,
         _resume_offset);
 
-    FileWorkerPool::getInstance()->Submit(
-        FsTask::createMeta(_current_filename, _current_md5, _resume_offset));
+    // 同一内容可能同时有多个上传（其他用户），额度按调用区分
+    _credit_key = BackPressureManager::getInstance()->new_stream(_current_md5);
+
+    FileWorkerPool::getInstance()->Submit(FsTask::createMeta(
+        _current_filename, _current_md5, _resume_offset, _expected_total_size));
+    _meta_submitted = true;
+}
+
+bool UploadCallData::acquireWriterLease() {
+    // 两个调用共用一个 .part：后来者从 offset 0 打开会截断文件、清掉断点，
+    // 数据交错后 md5 校验失败还会删掉前者的数据。不等待，直接让客户端稍后重试，
+    // 届时前者已提交则走秒传，已取消则按断点续传
+    _writer_lease = std::make_shared<DistLock>(
+        LockService::getInstance()->TryAcquire(
+            "upload:" + _current_md5, WRITER_LEASE, true));
+    if (_writer_lease->isLocked()) return true;
+
+    LOG_WARN(
+        "[UploadCallData] Upload of md5={} already in progress, rejecting "
+        "file={}",
+        _current_md5,
+        _current_filename);
+    _writer_lease.reset();
+    return false;
 }
 
 void UploadCallData::handleChunkMessage() {
 
     FileWorkerPool::getInstance()->Submit(
-        FsTask::createData(_current_md5, std::move(*_request.mutable_chunk())));
+        FsTask::createData(
+            _current_md5, std::move(*_request.mutable_chunk()), _credit_key));
 }
 
 ResumeValidationResult UploadCallData::validateResumeRequest(
@@ -283,13 +408,6 @@ void UploadCallData::createNextHandler() {
     new UploadCallData(_service, _cq);
 }
 
-void UploadCallData::applyBackPressure() {
-    if (_request.has_chunk()) {
-        BackPressureManager::getInstance()->wait_if_needed(
-            _request.chunk().size());
-    }
-}
-
 void UploadCallData::cleanup() {
     delete this;
 }
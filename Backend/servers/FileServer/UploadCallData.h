@@ -5,10 +5,13 @@
 #include "const.h"
 #include "file.grpc.pb.h"
 #include "file.pb.h"
+#include "infra/DistLock.h"
 #include "repository/FileRepository.h"
+#include <grpcpp/alarm.h>
 #include <grpcpp/completion_queue.h>
 #include <grpcpp/server_context.h>
 #include <grpcpp/support/status.h>
+#include <memory>
 
 
 class UploadCallData : public CallData {
@@ -25,18 +28,36 @@ private:
     void handleCreateState();
     void handleProcessState(bool ok);
     void handleFinishState();
+    void handleCommitted(bool ok);
+    void handleCredit(bool ok);
+    void finishUpload(bool stream_ok);
+    void abortUpload(grpc::StatusCode code);
 
     // 消息处理
     void                   handleMetaMessage();
+    bool                   acquireWriterLease();
     void                   handleChunkMessage();
     ResumeValidationResult validateResumeRequest(
         const std::string& md5, int64 requested_offset);
     bool processResumeLogic(const FileService::FileMeta& meta);
 
+    // @brief: 有背压额度时发起下一次 Read，否则等额度归还
+    void readNext();
+    void closeStream();
     void createNextHandler();
-    void applyBackPressure();
     void cleanup();
 
+    // worker 提交完成时经 Alarm 投递到 CQ 的事件，与读完成事件区分
+    struct CommitTag : public CallData {
+        UploadCallData* owner = nullptr;
+        void Proceed(bool ok) override { owner->handleCommitted(ok); }
+    };
+    // 背压额度归还时经 Alarm 投递到 CQ 的事件
+    struct CreditTag : public CallData {
+        UploadCallData* owner = nullptr;
+        void Proceed(bool ok) override { owner->handleCredit(ok); }
+    };
+
 private:
     FileService::FileTransport::AsyncService* _service;
     grpc::ServerCompletionQueue*              _cq;
@@ -48,20 +69,34 @@ private:
 
     FileService::UploadRequest  _request;
     FileService::UploadResponse _response;
+    grpc::Alarm                 _commit_alarm;
+    CommitTag                   _commit_tag;
+    grpc::Alarm                 _credit_alarm;
+    CreditTag                   _credit_tag;
 
     CallState   _state;
     std::string _current_md5;
+    std::string _credit_key;   // 本次调用在背压管理器中的标识
     std::string _current_filename;
     int64       _resume_offset = 0;
 
+    // 同一 md5 同时只允许一个调用写 .part；END 任务持有租约直到 worker 处理完
+    std::shared_ptr<DistLock> _writer_lease;
+
     bool        _stream_started        = false;
     bool        _spawned_next_handler  = false;
     bool        _meta_received         = false;
     bool        _has_error             = false;
+    bool        _meta_submitted        = false;   // 已向 worker 提交 META
     bool        _finalize_submitted    = false;
+    bool        _deduplicated          = false;   // 内容已存在，不再写盘
+    bool        _committed             = false;   // worker 校验并提交成功
     int64       _expected_total_size   = 0;
     int64       _received_stream_bytes = 0;
     std::string _error_message;
+
+    // 中止时返回给客户端的状态码
+    grpc::StatusCode _error_code = grpc::StatusCode::INVALID_ARGUMENT;
 };
 
 #endif   // UPLOADCALLDATA_H_
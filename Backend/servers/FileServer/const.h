@@ -28,6 +28,7 @@ using FileService::FileMeta;
 using FileService::FileTransport;
 using FileService::QueryDownloadRequest;
 using FileService::QueryUploadRequest;
+using FileService::RangeDigest;
 using FileService::UploadRequest;
 using FileService::UploadResponse;
 using grpc::Server;
@@ -43,11 +44,18 @@ using grpc::Status;
 
 using int64 = int64_t;
 
+// DownloadFile 以原始 ByteBuffer 收发（帧编码见 DownloadFrame），
+// 其余方法仍是生成的类型化异步接口
+using FileTransportService
+    = FileTransport::WithRawMethod_DownloadFile<FileTransport::AsyncService>;
+
 
 enum class TaskType {
     META,   // 文件元数据（打开文件）
     DATA,   // 文件数据块（写入文件）
     END,    // 结束标志（关闭文件）
+    BLOCK,     // 分块上传的一块（按块定位写入，到齐后提交）
+    BARRIER,   // 屏障：同一文件此前提交的任务都已处理
 };
 
 enum class CallState {
@@ -70,6 +78,7 @@ struct DownloadValidationResult {
     bool             is_valid;
     std::string      file_path;
     int64            file_size;
+    int64            range_end;   // 本次发送的区间终点（不含）
     grpc::StatusCode error_code;
     std::string      error_message;
 };
@@ -87,16 +96,19 @@ struct DownloadSessionInfo {
 struct DownloadPerformanceMetrics {
     std::string session_id;
     std::string file_name;
+    std::string source = "read";   // read: 预读到块缓冲；mmap: 映射文件
 
     double file_open_duration_ms     = 0;
     double file_seek_duration_ms     = 0;
     double file_read_duration_ms     = 0;
     double network_write_duration_ms = 0;
+    double read_stall_duration_ms    = 0;   // 发送方等待预读完成的时间
     double total_duration_ms         = 0;
 
     // IO
-    int64 bytes_sent  = 0;
-    int   chunk_count = 0;
+    int64 bytes_sent    = 0;
+    int   chunk_count   = 0;
+    int   prefetch_hits = 0;   // 需要发送时已预读好的块数
 
     double avg_read_speed_mb_s() const {
         if (file_read_duration_ms <= 0.0) return 0.0;
@@ -120,6 +132,7 @@ struct DownloadPerformanceMetrics {
             "========== Download Performance Summary ==========\n"
             "  Session ID:      {}\n"
             "  File Name:       {}\n"
+            "  Source:          {}\n"
             "  Bytes Sent:      {} bytes ({:.2f} MB)\n"
             "  Chunk Count:     {}\n"
             "  Total Duration:  {:.2f} ms ({:.2f} s)\n"
@@ -128,12 +141,14 @@ struct DownloadPerformanceMetrics {
             "  File Seek:       {:.2f} ms\n"
             "  File Read:       {:.2f} ms (avg: {:.2f} ms/chunk)\n"
             "  Network Write:   {:.2f} ms (avg: {:.2f} ms/chunk)\n"
+            "  Read Stall:      {:.2f} ms (prefetch hits: {}/{})\n"
             "----------------------------------------\n"
             "  Avg Read Speed:  {:.2f} MB/s\n"
             "  Throughput:      {:.2f} MB/s (total)\n"
             "==========================================",
             session_id,
             file_name,
+            source,
             bytes_sent,
             bytes_sent / (1024.0 * 1024.0),
             chunk_count,
@@ -145,6 +160,9 @@ struct DownloadPerformanceMetrics {
             avg_read_duration_ms(),
             network_write_duration_ms,
             avg_write_duration_ms(),
+            read_stall_duration_ms,
+            prefetch_hits,
+            chunk_count,
             avg_read_speed_mb_s(),
             (bytes_sent / (1024.0 * 1024.0)) / (total_duration_ms / 1000.0));
     }
@@ -1,6 +1,7 @@
 #include "core/CServer.h"
 #include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
+#include "infra/MySqlPoolManager.h"
 #include <cstdlib>
 
 int main() {
@@ -20,6 +21,7 @@ int main() {
                     return;
                 }
                 ioc.stop();
+                MySqlPoolManager::getInstance()->LogStats();
             });
         std::make_shared<CServer>(ioc, gate_port)->Start();
         ioc.run();
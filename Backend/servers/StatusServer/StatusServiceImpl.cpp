@@ -28,31 +28,21 @@ void StatusServiceImpl::InsertToken(int uid, const std::string& token) {
 
 ChatServerInfo StatusServiceImpl::SelectChatServer() {
     std::lock_guard<std::mutex> lock(_server_mtx);
-    int                         MIN = INT_MAX;
-    ChatServerInfo              best_server;
-    bool isFound = false;
+    std::vector<std::string>    names;
+    names.reserve(_servers.size());
     for (const auto& [name, server] : _servers) {
-        if (!ChatServerRepository::isServerActivated(
-                name)) {   // 如果当前的服务器没有在线，就不注册当前服务器的信息
-            LOG_WARN("[StatusServer] {} is offline! ", name);
-            continue;
-        }
-        auto count = ChatServerRepository::GetConnectionCount(name);
-        if (count < MIN) {
-            MIN         = count;
-            best_server = server;
-            isFound = true;
-        }
+        names.push_back(name);
     }
-    
-    if (!isFound) {
+
+    int  count     = 0;
+    auto best_name = ChatServerRepository::SelectLeastLoadedServer(names, count);
+    if (best_name.empty()) {
         LOG_WARN("[StatusServer] no active chat server available");
         return ChatServerInfo{}; // name 为空
     }
 
-    LOG_INFO("best server is: {}, connection count is: {}", best_server.name, MIN);
-    return best_server;
-    
+    LOG_INFO("best server is: {}, connection count is: {}", best_name, count);
+    return _servers[best_name];
 }
 
 Status StatusServiceImpl::GetChatServer(
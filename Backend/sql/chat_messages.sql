@@ -0,0 +1,357 @@
+-- ----------------------------
+-- 消息分表 chat_messages_0 .. chat_messages_15
+-- 分表规则: (from_uid + to_uid) % 16，同一会话的双向消息落在同一张表
+-- 布局可在 config.ini [MessageShard] 中配置，新布局的分表/月份表按 chat_messages_template 自动创建
+-- peer_key: 会话键（两端 uid 排序后拼成 64 位），与方向无关
+-- seq: 会话内持久化序号（Redis chat:seq:<peer_key> 分配），0 表示历史数据未分配
+-- msg_type: 0 用户文本，1 机器人会话
+-- msg_ts: 消息时间（秒），写入时由消息体 timestamp 填充
+-- payload: 去掉 fromuid/touid/timestamp 后的紧凑 JSON；新行 content 为空，仅历史行保存完整帧
+-- idx_from_ts / idx_to_ts: 最近消息查询按单方向 uid + 时间窗范围扫描
+-- idx_peer_ts: 按会话翻页
+-- ----------------------------
+SET NAMES utf8mb4;
+
+DROP TABLE IF EXISTS `chat_messages_0`;
+CREATE TABLE `chat_messages_0`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_1`;
+CREATE TABLE `chat_messages_1`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_2`;
+CREATE TABLE `chat_messages_2`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_3`;
+CREATE TABLE `chat_messages_3`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_4`;
+CREATE TABLE `chat_messages_4`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_5`;
+CREATE TABLE `chat_messages_5`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_6`;
+CREATE TABLE `chat_messages_6`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_7`;
+CREATE TABLE `chat_messages_7`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_8`;
+CREATE TABLE `chat_messages_8`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_9`;
+CREATE TABLE `chat_messages_9`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_10`;
+CREATE TABLE `chat_messages_10`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_11`;
+CREATE TABLE `chat_messages_11`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_12`;
+CREATE TABLE `chat_messages_12`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_13`;
+CREATE TABLE `chat_messages_13`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_14`;
+CREATE TABLE `chat_messages_14`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+DROP TABLE IF EXISTS `chat_messages_15`;
+CREATE TABLE `chat_messages_15`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+-- 建表模板，不存放数据
+DROP TABLE IF EXISTS `chat_messages_template`;
+CREATE TABLE `chat_messages_template`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `peer_key` bigint NOT NULL DEFAULT 0,
+  `seq` bigint NOT NULL DEFAULT 0,
+  `msg_type` tinyint NOT NULL DEFAULT 0,
+  `content` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `created_at` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`) USING BTREE,
+  INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC) USING BTREE,
+  INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC) USING BTREE
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
+
+-- ----------------------------
+-- 聊天记录全文索引模板：chat_message_search_N 按 owner_uid 分表，首次写入时按它创建
+-- body 使用 ngram 分词（ngram_token_size 默认 2），中文无需空格分词
+-- ----------------------------
+DROP TABLE IF EXISTS `chat_message_search_template`;
+CREATE TABLE `chat_message_search_template`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `owner_uid` int NOT NULL,
+  `peer_uid` int NOT NULL,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `body` text CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  PRIMARY KEY (`id`) USING BTREE,
+  UNIQUE INDEX `uk_owner_msgid`(`owner_uid` ASC, `msgid` ASC) USING BTREE,
+  INDEX `idx_owner_ts`(`owner_uid` ASC, `msg_ts` ASC) USING BTREE,
+  FULLTEXT INDEX `ft_body`(`body`) WITH PARSER ngram
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
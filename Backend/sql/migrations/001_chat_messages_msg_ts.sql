@@ -0,0 +1,100 @@
+-- ----------------------------
+-- 已有消息分表升级：增加 msg_ts 列与时间窗复合索引，并用 created_at 回填历史行
+-- 大表建议在低峰期逐表执行
+-- ----------------------------
+
+ALTER TABLE `chat_messages_0`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_0` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_1`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_1` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_2`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_2` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_3`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_3` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_4`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_4` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_5`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_5` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_6`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_6` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_7`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_7` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_8`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_8` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_9`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_9` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_10`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_10` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_11`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_11` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_12`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_12` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_13`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_13` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_14`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_14` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
+
+ALTER TABLE `chat_messages_15`
+  ADD COLUMN `msg_ts` bigint NOT NULL DEFAULT 0 AFTER `content`,
+  ADD INDEX `idx_from_ts`(`from_uid` ASC, `msg_ts` ASC),
+  ADD INDEX `idx_to_ts`(`to_uid` ASC, `msg_ts` ASC);
+UPDATE `chat_messages_15` SET `msg_ts` = UNIX_TIMESTAMP(`created_at`) WHERE `msg_ts` = 0;
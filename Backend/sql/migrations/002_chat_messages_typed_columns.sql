@@ -0,0 +1,116 @@
+-- ----------------------------
+-- 已有消息分表升级：增加类型化列与紧凑 payload 列
+-- 只改表结构，历史行由 MsgBackfill 工具分批限速回填（payload IS NULL 的行）
+-- ----------------------------
+
+ALTER TABLE `chat_messages_0`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_1`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_2`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_3`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_4`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_5`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_6`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_7`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_8`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_9`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_10`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_11`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_12`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_13`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_14`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
+
+ALTER TABLE `chat_messages_15`
+  ADD COLUMN `peer_key` bigint NOT NULL DEFAULT 0 AFTER `to_uid`,
+  ADD COLUMN `seq` bigint NOT NULL DEFAULT 0 AFTER `peer_key`,
+  ADD COLUMN `msg_type` tinyint NOT NULL DEFAULT 0 AFTER `seq`,
+  ADD COLUMN `payload` mediumtext CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NULL AFTER `content`,
+  ADD INDEX `idx_peer_ts`(`peer_key` ASC, `msg_ts` ASC, `seq` ASC);
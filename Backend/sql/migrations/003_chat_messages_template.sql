@@ -0,0 +1,6 @@
+-- ----------------------------
+-- 消息表建表模板：按 [MessageShard] 布局自动创建的新分表/月份表以它为准
+-- 在 002 迁移之后执行，结构与现有 chat_messages_N 一致
+-- ----------------------------
+
+CREATE TABLE IF NOT EXISTS `chat_messages_template` LIKE `chat_messages_0`;
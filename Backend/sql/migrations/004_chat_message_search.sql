@@ -0,0 +1,20 @@
+-- ----------------------------
+-- 聊天记录全文索引模板：chat_message_search_N（[MessageSearch]）首次写入时按它创建
+-- body 使用 ngram 分词，ngram_token_size 保持默认 2
+-- 上线前的历史消息不会被索引，只有新持久化的消息可检索
+-- ----------------------------
+
+CREATE TABLE IF NOT EXISTS `chat_message_search_template`  (
+  `id` bigint NOT NULL AUTO_INCREMENT,
+  `owner_uid` int NOT NULL,
+  `peer_uid` int NOT NULL,
+  `msgid` varchar(64) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  `from_uid` int NOT NULL,
+  `to_uid` int NOT NULL,
+  `msg_ts` bigint NOT NULL DEFAULT 0,
+  `body` text CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci NOT NULL,
+  PRIMARY KEY (`id`) USING BTREE,
+  UNIQUE INDEX `uk_owner_msgid`(`owner_uid` ASC, `msgid` ASC) USING BTREE,
+  INDEX `idx_owner_ts`(`owner_uid` ASC, `msg_ts` ASC) USING BTREE,
+  FULLTEXT INDEX `ft_body`(`body`) WITH PARSER ngram
+) ENGINE = InnoDB CHARACTER SET = utf8mb4 COLLATE = utf8mb4_unicode_ci ROW_FORMAT = Dynamic;
@@ -0,0 +1,359 @@
+#ifndef ARCHIVESEGMENT_H_
+#define ARCHIVESEGMENT_H_
+
+#include "common/MessageRecord.h"
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+// 冷存储段文件：超过保留期的消息从 chat_messages_N 移出后写入的不可变文件
+//
+// 文件布局（整数均为小端）:
+//   header  "TCAS" + u32 版本
+//   block*  同一会话的若干条消息，按 (msg_ts, id) 升序编码后整体 zlib 压缩
+//   index   每个块一项（INDEX_ENTRY_SIZE 字节），按 (peer_key, min_ts) 排序
+//   footer  index 偏移 / 项数 / crc32 + 段内消息时间范围 + "TCAS"
+// 读取时只需加载 footer 与 index（每个会话每块 64 字节），
+// 翻页按会话二分定位到块，只解压涉及的块
+struct ArchiveRow {
+    int64_t       id = 0;   // 原消息表中的主键，与 msg_ts 一起作为翻页游标
+    MessageRecord record;
+};
+
+struct ArchiveBlockRef {
+    int64_t  peer_key = 0;
+    int64_t  min_ts   = 0;   // 块内第一条 (msg_ts, id)
+    int64_t  min_id   = 0;
+    int64_t  max_ts   = 0;   // 块内最后一条 (msg_ts, id)
+    int64_t  max_id   = 0;
+    uint64_t offset   = 0;
+    uint32_t size     = 0;   // 压缩后字节数
+    uint32_t raw_size = 0;
+    uint32_t count    = 0;
+    uint32_t crc      = 0;   // 压缩数据的 crc32
+};
+
+struct ArchiveFooter {
+    uint64_t index_offset = 0;
+    uint32_t index_count  = 0;
+    uint32_t index_crc    = 0;
+    int64_t  min_ts       = 0;
+    int64_t  max_ts       = 0;
+};
+
+class ArchiveSegment {
+public:
+    static constexpr uint32_t    VERSION          = 1;
+    static constexpr std::size_t HEADER_SIZE      = 8;
+    static constexpr std::size_t INDEX_ENTRY_SIZE = 64;
+    static constexpr std::size_t FOOTER_SIZE      = 36;
+    // 单块最多条数：越小翻页解压越少，越大压缩率越高
+    static constexpr std::size_t DEFAULT_BLOCK_ROWS = 256;
+
+    // @brief: (ts, id) 游标比较：a 是否早于 b
+    static bool Before(int64_t a_ts, int64_t a_id, int64_t b_ts, int64_t b_id) {
+        return a_ts < b_ts || (a_ts == b_ts && a_id < b_id);
+    }
+
+    // @brief: 编码一个段文件；rows 无需有序，按会话分组、组内按 (msg_ts, id)
+    //         排序，每 block_rows 条一块；rows 为空时返回空串
+    static std::string Encode(
+        std::vector<ArchiveRow> rows,
+        std::size_t             block_rows = DEFAULT_BLOCK_ROWS) {
+        if (rows.empty()) return {};
+        if (block_rows == 0) block_rows = DEFAULT_BLOCK_ROWS;
+
+        std::map<int64_t, std::vector<const ArchiveRow*>> by_peer;
+        for (const auto& row : rows) {
+            by_peer[row.record.peer_key].push_back(&row);
+        }
+
+        std::string file = MAGIC;
+        putFixed32(file, VERSION);
+
+        std::vector<ArchiveBlockRef> index;
+        ArchiveFooter                footer;
+        footer.min_ts = INT64_MAX;
+        footer.max_ts = INT64_MIN;
+
+        for (auto& [peer_key, peer_rows] : by_peer) {
+            std::sort(
+                peer_rows.begin(),
+                peer_rows.end(),
+                [](const ArchiveRow* a, const ArchiveRow* b) {
+                    return Before(
+                        a->record.msg_ts, a->id, b->record.msg_ts, b->id);
+                });
+
+            for (std::size_t begin = 0; begin < peer_rows.size();
+                 begin += block_rows) {
+                std::size_t end
+                    = std::min(begin + block_rows, peer_rows.size());
+
+                std::string raw;
+                for (std::size_t i = begin; i < end; ++i) {
+                    encodeRow(raw, *peer_rows[i]);
+                }
+
+                uLongf bound = compressBound(static_cast<uLong>(raw.size()));
+                std::string packed(bound, '\0');
+                compress2(
+                    reinterpret_cast<Bytef*>(&packed[0]),
+                    &bound,
+                    reinterpret_cast<const Bytef*>(raw.data()),
+                    static_cast<uLong>(raw.size()),
+                    Z_BEST_COMPRESSION);
+                packed.resize(bound);
+
+                const auto&     first = *peer_rows[begin];
+                const auto&     last  = *peer_rows[end - 1];
+                ArchiveBlockRef ref;
+                ref.peer_key = peer_key;
+                ref.min_ts   = first.record.msg_ts;
+                ref.min_id   = first.id;
+                ref.max_ts   = last.record.msg_ts;
+                ref.max_id   = last.id;
+                ref.offset   = file.size();
+                ref.size     = static_cast<uint32_t>(packed.size());
+                ref.raw_size = static_cast<uint32_t>(raw.size());
+                ref.count    = static_cast<uint32_t>(end - begin);
+                ref.crc      = checksum(packed.data(), packed.size());
+                index.push_back(ref);
+
+                footer.min_ts = std::min(footer.min_ts, ref.min_ts);
+                footer.max_ts = std::max(footer.max_ts, ref.max_ts);
+                file += packed;
+            }
+        }
+
+        footer.index_offset = file.size();
+        footer.index_count  = static_cast<uint32_t>(index.size());
+        std::string index_bytes;
+        index_bytes.reserve(index.size() * INDEX_ENTRY_SIZE);
+        for (const auto& ref : index) {
+            encodeIndexEntry(index_bytes, ref);
+        }
+        footer.index_crc = checksum(index_bytes.data(), index_bytes.size());
+        file += index_bytes;
+
+        putFixed64(file, footer.index_offset);
+        putFixed32(file, footer.index_count);
+        putFixed32(file, footer.index_crc);
+        putFixed64(file, static_cast<uint64_t>(footer.min_ts));
+        putFixed64(file, static_cast<uint64_t>(footer.max_ts));
+        file += MAGIC;
+        return file;
+    }
+
+    // @brief: 解析文件头（HEADER_SIZE 字节）与文件末尾 FOOTER_SIZE 字节
+    static bool ParseFooter(
+        const std::string& header, const std::string& tail,
+        ArchiveFooter& footer) {
+        if (header.size() != HEADER_SIZE || tail.size() != FOOTER_SIZE
+            || header.compare(0, 4, MAGIC) != 0
+            || getFixed32(header.data() + 4) != VERSION
+            || tail.compare(FOOTER_SIZE - 4, 4, MAGIC) != 0) {
+            return false;
+        }
+        const char* p       = tail.data();
+        footer.index_offset = getFixed64(p);
+        footer.index_count  = getFixed32(p + 8);
+        footer.index_crc    = getFixed32(p + 12);
+        footer.min_ts       = static_cast<int64_t>(getFixed64(p + 16));
+        footer.max_ts       = static_cast<int64_t>(getFixed64(p + 24));
+        return true;
+    }
+
+    // @brief: 解析 index 区（index_count * INDEX_ENTRY_SIZE 字节），校验 crc
+    static bool ParseIndex(
+        const std::string& bytes, const ArchiveFooter& footer,
+        std::vector<ArchiveBlockRef>& index) {
+        if (bytes.size()
+                != static_cast<std::size_t>(footer.index_count)
+                       * INDEX_ENTRY_SIZE
+            || checksum(bytes.data(), bytes.size()) != footer.index_crc) {
+            return false;
+        }
+        index.clear();
+        index.reserve(footer.index_count);
+        for (std::size_t off = 0; off < bytes.size(); off += INDEX_ENTRY_SIZE) {
+            const char*     p = bytes.data() + off;
+            ArchiveBlockRef ref;
+            ref.peer_key = static_cast<int64_t>(getFixed64(p));
+            ref.min_ts   = static_cast<int64_t>(getFixed64(p + 8));
+            ref.min_id   = static_cast<int64_t>(getFixed64(p + 16));
+            ref.max_ts   = static_cast<int64_t>(getFixed64(p + 24));
+            ref.max_id   = static_cast<int64_t>(getFixed64(p + 32));
+            ref.offset   = getFixed64(p + 40);
+            ref.size     = getFixed32(p + 48);
+            ref.raw_size = getFixed32(p + 52);
+            ref.count    = getFixed32(p + 56);
+            ref.crc      = getFixed32(p + 60);
+            index.push_back(ref);
+        }
+        return true;
+    }
+
+    // @brief: 解压并解码一个块，packed 为文件中 [offset, offset + size) 的内容
+    static bool DecodeBlock(
+        const std::string& packed, const ArchiveBlockRef& ref,
+        std::vector<ArchiveRow>& rows) {
+        if (packed.size() != ref.size
+            || checksum(packed.data(), packed.size()) != ref.crc) {
+            return false;
+        }
+        std::string raw(ref.raw_size, '\0');
+        uLongf      raw_size = ref.raw_size;
+        if (uncompress(
+                reinterpret_cast<Bytef*>(&raw[0]),
+                &raw_size,
+                reinterpret_cast<const Bytef*>(packed.data()),
+                static_cast<uLong>(packed.size()))
+                != Z_OK
+            || raw_size != ref.raw_size) {
+            return false;
+        }
+
+        rows.clear();
+        rows.reserve(ref.count);
+        std::size_t pos = 0;
+        for (uint32_t i = 0; i < ref.count; ++i) {
+            ArchiveRow row;
+            if (!decodeRow(raw, pos, row)) return false;
+            row.record.peer_key = ref.peer_key;
+            rows.push_back(std::move(row));
+        }
+        return pos == raw.size();
+    }
+
+    // @brief: 段文件所在的月份目录名（UTC yyyymm）
+    static std::string MonthOf(int64_t ts) {
+        std::time_t t = static_cast<std::time_t>(ts);
+        std::tm     tm{};
+        gmtime_r(&t, &tm);
+        return std::to_string((tm.tm_year + 1900) * 100 + (tm.tm_mon + 1));
+    }
+
+private:
+    static constexpr const char* MAGIC = "TCAS";
+
+    static uint32_t checksum(const char* data, std::size_t size) {
+        return static_cast<uint32_t>(crc32(
+            0L, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size)));
+    }
+
+    static void putFixed32(std::string& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            out += static_cast<char>((v >> (8 * i)) & 0xFF);
+        }
+    }
+    static void putFixed64(std::string& out, uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            out += static_cast<char>((v >> (8 * i)) & 0xFF);
+        }
+    }
+    static uint32_t getFixed32(const char* p) {
+        uint32_t v = 0;
+        for (int i = 3; i >= 0; --i) {
+            v = (v << 8) | static_cast<unsigned char>(p[i]);
+        }
+        return v;
+    }
+    static uint64_t getFixed64(const char* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i) {
+            v = (v << 8) | static_cast<unsigned char>(p[i]);
+        }
+        return v;
+    }
+
+    static void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out += static_cast<char>((v & 0x7F) | 0x80);
+            v >>= 7;
+        }
+        out += static_cast<char>(v);
+    }
+    static bool
+    getVarint(const std::string& in, std::size_t& pos, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            unsigned char byte = static_cast<unsigned char>(in[pos++]);
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+    // 有符号数（机器人 uid 为负）按 zigzag 编码
+    static void putSigned(std::string& out, int64_t v) {
+        putVarint(
+            out,
+            (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+    static bool getSigned(const std::string& in, std::size_t& pos, int64_t& v) {
+        uint64_t u = 0;
+        if (!getVarint(in, pos, u)) return false;
+        v = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+        return true;
+    }
+    static void putBytes(std::string& out, const std::string& s) {
+        putVarint(out, s.size());
+        out += s;
+    }
+    static bool
+    getBytes(const std::string& in, std::size_t& pos, std::string& s) {
+        uint64_t len = 0;
+        if (!getVarint(in, pos, len) || len > in.size() - pos) return false;
+        s.assign(in, pos, static_cast<std::size_t>(len));
+        pos += static_cast<std::size_t>(len);
+        return true;
+    }
+
+    static void encodeRow(std::string& out, const ArchiveRow& row) {
+        const auto& r = row.record;
+        putSigned(out, row.id);
+        putSigned(out, r.from_uid);
+        putSigned(out, r.to_uid);
+        putSigned(out, r.msg_ts);
+        putSigned(out, r.seq);
+        putVarint(out, static_cast<uint64_t>(r.msg_type));
+        putBytes(out, r.msgid);
+        putBytes(out, r.payload);
+    }
+
+    static bool
+    decodeRow(const std::string& in, std::size_t& pos, ArchiveRow& row) {
+        int64_t  from_uid = 0, to_uid = 0;
+        uint64_t msg_type = 0;
+        auto&    r        = row.record;
+        if (!getSigned(in, pos, row.id) || !getSigned(in, pos, from_uid)
+            || !getSigned(in, pos, to_uid) || !getSigned(in, pos, r.msg_ts)
+            || !getSigned(in, pos, r.seq) || !getVarint(in, pos, msg_type)
+            || !getBytes(in, pos, r.msgid) || !getBytes(in, pos, r.payload)) {
+            return false;
+        }
+        r.from_uid = static_cast<int>(from_uid);
+        r.to_uid   = static_cast<int>(to_uid);
+        r.msg_type = static_cast<MessageType>(msg_type);
+        return true;
+    }
+
+    static void encodeIndexEntry(std::string& out, const ArchiveBlockRef& ref) {
+        putFixed64(out, static_cast<uint64_t>(ref.peer_key));
+        putFixed64(out, static_cast<uint64_t>(ref.min_ts));
+        putFixed64(out, static_cast<uint64_t>(ref.min_id));
+        putFixed64(out, static_cast<uint64_t>(ref.max_ts));
+        putFixed64(out, static_cast<uint64_t>(ref.max_id));
+        putFixed64(out, ref.offset);
+        putFixed32(out, ref.size);
+        putFixed32(out, ref.raw_size);
+        putFixed32(out, ref.count);
+        putFixed32(out, ref.crc);
+    }
+};
+
+#endif   // ARCHIVESEGMENT_H_
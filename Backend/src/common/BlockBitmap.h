@@ -0,0 +1,60 @@
+#ifndef BLOCKBITMAP_H_
+#define BLOCKBITMAP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+// 分块上传会话的块划分与已收到块位图
+// 位图直接使用 Redis SETBIT 的位序：块 i 对应第 i/8 字节的 0x80 >> (i % 8) 位，
+// GET 出来的字符串原样返回给客户端
+class BlockBitmap {
+public:
+    static constexpr int32_t DEFAULT_BLOCK_SIZE = 4 * 1024 * 1024;
+    static constexpr int32_t MIN_BLOCK_SIZE     = 256 * 1024;
+    static constexpr int32_t MAX_BLOCK_SIZE     = 16 * 1024 * 1024;
+
+    // @brief: 客户端期望的块大小，0 取默认值，超出范围时截到上下限
+    static int32_t NormalizeBlockSize(int32_t requested) {
+        if (requested <= 0) return DEFAULT_BLOCK_SIZE;
+        return std::clamp(requested, MIN_BLOCK_SIZE, MAX_BLOCK_SIZE);
+    }
+
+    static int32_t BlockCount(int64_t total_size, int32_t block_size) {
+        if (total_size <= 0 || block_size <= 0) return 0;
+        return static_cast<int32_t>((total_size + block_size - 1) / block_size);
+    }
+
+    static int64_t BlockOffset(int32_t index, int32_t block_size) {
+        return static_cast<int64_t>(index) * block_size;
+    }
+
+    // @brief: 块 index 的字节数，只有最后一块可能不足 block_size；越界返回 0
+    static int64_t
+    BlockLength(int64_t total_size, int32_t block_size, int32_t index) {
+        if (index < 0 || index >= BlockCount(total_size, block_size)) return 0;
+        return std::min<int64_t>(
+            block_size, total_size - BlockOffset(index, block_size));
+    }
+
+    static bool IsSet(const std::string& bitmap, int32_t index) {
+        auto byte = static_cast<std::size_t>(index) / 8;
+        return index >= 0 && byte < bitmap.size()
+               && (static_cast<uint8_t>(bitmap[byte]) & (0x80 >> (index % 8)));
+    }
+
+    static void Set(std::string& bitmap, int32_t index) {
+        auto byte = static_cast<std::size_t>(index) / 8;
+        if (bitmap.size() <= byte) bitmap.resize(byte + 1, '\0');
+        bitmap[byte] = static_cast<char>(
+            static_cast<uint8_t>(bitmap[byte]) | (0x80 >> (index % 8)));
+    }
+
+    static int32_t CountSet(const std::string& bitmap, int32_t block_count) {
+        int32_t count = 0;
+        for (int32_t i = 0; i < block_count; ++i) count += IsSet(bitmap, i);
+        return count;
+    }
+};
+
+#endif   // BLOCKBITMAP_H_
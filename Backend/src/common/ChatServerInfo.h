@@ -3,8 +3,10 @@
 #include <string>
 #include <iostream>
 
-static const std::string LOGIN_COUNT = "chatserver:login:";
-static const std::string ACTIVATE = "chatserver:activate:";
+// 两个 hash 共用 {chatserver} hash tag，分片部署时落在同一节点，
+// 供 SELECT_LEAST_LOADED 脚本同时访问
+static const std::string LOGIN_COUNT = "{chatserver}:login:";
+static const std::string ACTIVATE = "{chatserver}:activate:";
 
 struct ChatServerInfo {
 
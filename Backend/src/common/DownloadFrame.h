@@ -0,0 +1,53 @@
+#ifndef DOWNLOADFRAME_H_
+#define DOWNLOADFRAME_H_
+
+#include "file.pb.h"
+#include <cstdint>
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <grpcpp/support/byte_buffer.h>
+#include <grpcpp/support/slice.h>
+#include <string>
+
+// DownloadFile 以原始 ByteBuffer 收发时的帧编码
+// 数据块帧只手工写出 DownloadResponse.chunk 的字段头（tag + 长度），
+// 数据本身作为第二个 Slice 直接引用映射内存或块缓冲，不经 protobuf 拷贝；
+// 接收方仍按普通 DownloadResponse 解析
+class DownloadFrame {
+public:
+    // DownloadResponse.chunk：字段号 2，wire type 2（length-delimited）
+    static constexpr uint8_t CHUNK_TAG = (2 << 3) | 2;
+
+    // @brief: 以 data 为 chunk 的 DownloadResponse
+    static grpc::ByteBuffer Chunk(grpc::Slice data) {
+        std::string header(1, static_cast<char>(CHUNK_TAG));
+        uint64_t    len = data.size();
+        while (len >= 0x80) {
+            header += static_cast<char>((len & 0x7F) | 0x80);
+            len >>= 7;
+        }
+        header += static_cast<char>(len);
+
+        grpc::Slice slices[2] = {grpc::Slice(header), std::move(data)};
+        return grpc::ByteBuffer(slices, 2);
+    }
+
+    // @brief: 序列化普通消息（元数据帧）
+    static grpc::ByteBuffer
+    Message(const FileService::DownloadResponse& response) {
+        grpc::ByteBuffer buffer;
+        bool             own_buffer = false;
+        grpc::SerializationTraits<FileService::DownloadResponse>::Serialize(
+            response, &buffer, &own_buffer);
+        return buffer;
+    }
+
+    // @brief: 解析原始请求
+    static bool
+    ParseRequest(grpc::ByteBuffer* buffer, FileService::DownloadRequest* req) {
+        return grpc::SerializationTraits<FileService::DownloadRequest>::
+            Deserialize(buffer, req)
+                .ok();
+    }
+};
+
+#endif   // DOWNLOADFRAME_H_
@@ -0,0 +1,63 @@
+#ifndef DOWNLOADRANGE_H_
+#define DOWNLOADRANGE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 区间下载的字节范围 [begin, end)
+// 请求里 end_offset 与 length 为 0 表示未指定，都未指定时读到文件末尾；
+// 超出文件末尾的部分按文件大小截断，与 HTTP Range 的处理一致
+class DownloadRange {
+public:
+    using Range = std::pair<int64_t, int64_t>;
+
+    // @brief: 解析请求的区间，参数不合法（越界的起点、负数、
+    //         end_offset 与 length 矛盾）返回 false
+    static bool Resolve(
+        int64_t start_offset, int64_t end_offset, int64_t length,
+        int64_t file_size, Range* range) {
+        if (start_offset < 0 || start_offset > file_size) return false;
+        if (end_offset < 0 || length < 0) return false;
+        if (end_offset > 0 && end_offset < start_offset) return false;
+        // length 由客户端给出，只做减法比较，不与 start_offset 相加
+        if (end_offset > 0 && length > 0
+            && length != end_offset - start_offset) {
+            return false;
+        }
+
+        int64_t end = file_size;
+        if (end_offset > 0) end = std::min(end_offset, file_size);
+        if (length > 0 && length < file_size - start_offset) {
+            end = start_offset + length;
+        }
+        range->first  = start_offset;
+        range->second = end;
+        return true;
+    }
+
+    // @brief: 请求是否限定了区间；限定区间的流由客户端自行记录进度
+    static bool IsPartial(int64_t end_offset, int64_t length) {
+        return end_offset > 0 || length > 0;
+    }
+
+    // @brief: 把文件切成最多 streams 段供并发下载，每段是 align 的整数倍
+    //         （最后一段除外），文件太小时段数相应减少；空文件返回空
+    static std::vector<Range>
+    Split(int64_t file_size, int streams, int64_t align) {
+        std::vector<Range> ranges;
+        if (file_size <= 0) return ranges;
+        align = std::max<int64_t>(align, 1);
+
+        int64_t units = (file_size + align - 1) / align;
+        int64_t parts = std::clamp<int64_t>(streams, 1, units);
+        int64_t step  = (units + parts - 1) / parts * align;
+        for (int64_t begin = 0; begin < file_size; begin += step) {
+            ranges.emplace_back(begin, std::min(begin + step, file_size));
+        }
+        return ranges;
+    }
+};
+
+#endif   // DOWNLOADRANGE_H_
@@ -0,0 +1,122 @@
+#ifndef MESSAGERECORD_H_
+#define MESSAGERECORD_H_
+
+#include "common/const.h"
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <json/reader.h>
+#include <json/value.h>
+#include <json/writer.h>
+#include <string>
+
+// chat_messages_N 的一行：检索用字段拆成独立列，其余部分压缩成 payload
+//
+// 聊天帧 JSON 中 fromuid / touid / timestamp 落到 from_uid / to_uid / msg_ts 列，
+// payload 只保存剩余字段的紧凑 JSON（去掉 toStyledString 的缩进换行）；
+// 读取时由列值与 payload 直接拼回完整帧，不需要再解析
+enum class MessageType : int {
+    TEXT = 0,   // 用户之间的文本消息
+    BOT  = 1,   // 与机器人（BOT_UID）的会话
+};
+
+struct MessageRecord {
+    std::string msgid;
+    int         from_uid = 0;
+    int         to_uid   = 0;
+    int64_t     peer_key = 0;   // 会话键，与方向无关
+    int64_t     seq      = 0;   // 会话内持久化序号，0 表示未分配（历史数据）
+    int64_t     msg_ts   = 0;   // 消息时间（秒）
+    MessageType msg_type = MessageType::TEXT;
+    std::string payload;
+};
+
+class MessageCodec {
+public:
+    // @brief: 会话键：两端 uid 排序后拼成 64 位，双向消息得到同一个值
+    static int64_t PeerKey(int a, int b) {
+        uint32_t lo = static_cast<uint32_t>(a < b ? a : b);
+        uint32_t hi = static_cast<uint32_t>(a < b ? b : a);
+        return static_cast<int64_t>((static_cast<uint64_t>(lo) << 32) | hi);
+    }
+
+    // @brief: 解析一条聊天帧，填充除 seq 外的全部字段；帧不是 JSON 对象时返回 false
+    static bool Parse(const std::string& frame, MessageRecord& record) {
+        Json::Reader reader;
+        Json::Value  root;
+        if (!reader.parse(frame, root) || !root.isObject()) {
+            return false;
+        }
+
+        record.from_uid = root["fromuid"].asInt();
+        record.to_uid   = root["touid"].asInt();
+        record.peer_key = PeerKey(record.from_uid, record.to_uid);
+        record.msg_ts   = Timestamp(root);
+        record.msg_type = (record.from_uid == BOT_UID || record.to_uid == BOT_UID)
+                              ? MessageType::BOT
+                              : MessageType::TEXT;
+
+        if (root["text_array"].isArray() && root["text_array"].size() > 0) {
+            record.msgid = root["text_array"][0]["msgid"].asString();
+        } else {
+            // 如果没有 msgid，生成一个
+            record.msgid = "msg_" + std::to_string(std::time(nullptr)) + "_"
+                           + std::to_string(rand());
+        }
+
+        root.removeMember("fromuid");
+        root.removeMember("touid");
+        root.removeMember("timestamp");
+        Json::FastWriter writer;
+        writer.omitEndingLineFeed();
+        record.payload = writer.write(root);
+        return true;
+    }
+
+    // @brief: 消息时间：顶层 timestamp，其次第一条文本的 timestamp，都没有时取当前时间
+    static int64_t Timestamp(const Json::Value& root) {
+        if (root.isMember("timestamp") && root["timestamp"].isInt64()) {
+            return root["timestamp"].asInt64();
+        }
+        if (root["text_array"].isArray() && root["text_array"].size() > 0) {
+            const auto& first = root["text_array"][0];
+            if (first.isMember("timestamp") && first["timestamp"].isInt64()) {
+                return first["timestamp"].asInt64();
+            }
+        }
+        return static_cast<int64_t>(std::time(nullptr));
+    }
+
+    // @brief: 聊天帧的消息时间，帧不是 JSON 对象时取当前时间
+    static int64_t FrameTimestamp(const std::string& frame) {
+        Json::Reader reader;
+        Json::Value  root;
+        if (!reader.parse(frame, root) || !root.isObject()) {
+            return static_cast<int64_t>(std::time(nullptr));
+        }
+        return Timestamp(root);
+    }
+
+    // @brief: 由列值和 payload 拼回聊天帧（字符串拼接，不解析 payload）
+    static std::string BuildFrame(
+        int from_uid, int to_uid, int64_t msg_ts, const std::string& payload) {
+        std::string frame;
+        frame.reserve(payload.size() + 64);
+        frame += "{\"fromuid\":";
+        frame += std::to_string(from_uid);
+        frame += ",\"touid\":";
+        frame += std::to_string(to_uid);
+        frame += ",\"timestamp\":";
+        frame += std::to_string(msg_ts);
+        // payload 是 Parse 产生的紧凑 JSON 对象，"{}" 时没有其余字段
+        if (payload.size() > 2 && payload.front() == '{') {
+            frame += ',';
+            frame.append(payload, 1, std::string::npos);
+        } else {
+            frame += '}';
+        }
+        return frame;
+    }
+};
+
+#endif   // MESSAGERECORD_H_
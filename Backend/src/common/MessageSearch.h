@@ -0,0 +1,174 @@
+#ifndef MESSAGESEARCH_H_
+#define MESSAGESEARCH_H_
+
+#include "common/MessageRecord.h"
+#include "common/const.h"
+#include <cstdint>
+#include <json/reader.h>
+#include <json/value.h>
+#include <string>
+#include <vector>
+
+// 聊天记录全文检索的索引文档与查询串
+//
+// 索引表 chat_message_search_N 按 owner_uid 分表，
+// 每条消息为收发双方各建一份文档，一个用户的检索只落在一张表上；
+// body 列建 FULLTEXT ... WITH PARSER ngram，
+// 中文按 ngram_token_size（默认 2）切词，不依赖空格分词
+struct SearchDocument {
+    int         owner_uid = 0;   // 文档归属（可检索到这条消息的用户）
+    int         peer_uid  = 0;   // 会话对象
+    std::string msgid;
+    int         from_uid = 0;
+    int         to_uid   = 0;
+    int64_t     msg_ts   = 0;
+    std::string body;
+};
+
+class MessageSearch {
+public:
+    // 单条文档正文上限，超出部分按 UTF-8 字符边界截断
+    static constexpr std::size_t MAX_BODY_BYTES = 4096;
+    // 查询最多取前几个词，每个词都必须命中
+    static constexpr std::size_t MAX_TERMS = 8;
+
+    // @brief: 聊天帧中可检索的文本：text_array 各条 content 以换行拼接
+    static std::string ExtractText(const Json::Value& root) {
+        std::string text;
+        const auto& texts = root["text_array"];
+        if (!texts.isArray()) return text;
+        for (const auto& one : texts) {
+            if (!one["content"].isString()) continue;
+            if (!text.empty()) text += '\n';
+            text += one["content"].asString();
+        }
+        return TruncateUtf8(text, MAX_BODY_BYTES);
+    }
+
+    // @brief: 由一条聊天帧生成索引文档，收发双方各一份（BOT 一方不建）；
+    //         帧无法解析、没有 msgid 或没有文本时返回空
+    static std::vector<SearchDocument> Documents(const std::string& frame) {
+        std::vector<SearchDocument> docs;
+        Json::Reader                reader;
+        Json::Value                 root;
+        if (!reader.parse(frame, root) || !root.isObject()) return docs;
+
+        const auto& texts = root["text_array"];
+        if (!texts.isArray() || texts.empty()
+            || !texts[0]["msgid"].isString()) {
+            return docs;
+        }
+
+        SearchDocument doc;
+        doc.msgid    = texts[0]["msgid"].asString();
+        doc.from_uid = root["fromuid"].asInt();
+        doc.to_uid   = root["touid"].asInt();
+        doc.msg_ts   = MessageCodec::Timestamp(root);
+        doc.body     = ExtractText(root);
+        if (doc.msgid.empty() || doc.body.empty()) return docs;
+
+        if (doc.from_uid != BOT_UID) {
+            doc.owner_uid = doc.from_uid;
+            doc.peer_uid  = doc.to_uid;
+            docs.push_back(doc);
+        }
+        if (doc.to_uid != BOT_UID && doc.to_uid != doc.from_uid) {
+            doc.owner_uid = doc.to_uid;
+            doc.peer_uid  = doc.from_uid;
+            docs.push_back(std::move(doc));
+        }
+        return docs;
+    }
+
+    // @brief: 用户输入转成 MATCH ... AGAINST(... IN BOOLEAN MODE) 的查询串
+    //         按空白（含全角空格）分词，去掉布尔运算符，每个词都必须出现：
+    //         多字词作为短语匹配（ngram 下即连续子串），单字词用前缀匹配
+    //         （短于 ngram_token_size 的词只能这样命中）；没有有效词时返回空串
+    static std::string BooleanQuery(const std::string& keyword) {
+        std::string query;
+        std::size_t terms = 0;
+        std::string term;
+
+        auto flush = [&]() {
+            if (term.empty() || terms >= MAX_TERMS) {
+                term.clear();
+                return;
+            }
+            if (!query.empty()) query += ' ';
+            if (CodePoints(term) == 1) {
+                query += '+' + term + '*';
+            } else {
+                query += "+\"" + term + '"';
+            }
+            ++terms;
+            term.clear();
+        };
+
+        for (std::size_t i = 0; i < keyword.size(); ++i) {
+            unsigned char ch = static_cast<unsigned char>(keyword[i]);
+            // U+3000 全角空格
+            if (ch == 0xE3 && i + 2 < keyword.size()
+                && static_cast<unsigned char>(keyword[i + 1]) == 0x80
+                && static_cast<unsigned char>(keyword[i + 2]) == 0x80) {
+                flush();
+                i += 2;
+                continue;
+            }
+            if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+                flush();
+                continue;
+            }
+            if (IsOperator(ch)) continue;
+            term += keyword[i];
+        }
+        flush();
+        return query;
+    }
+
+    // @brief: owner_uid 的文档所在的索引表
+    static std::string
+    TableFor(const std::string& prefix, int shards, int owner_uid) {
+        int shard = shards > 0 ? owner_uid % shards : 0;
+        if (shard < 0) shard += shards;
+        return prefix + "_" + std::to_string(shard);
+    }
+
+    // @brief: 截断到不超过 max_bytes，且不切断 UTF-8 多字节字符
+    static std::string
+    TruncateUtf8(const std::string& text, std::size_t max_bytes) {
+        if (text.size() <= max_bytes) return text;
+        std::size_t end = max_bytes;
+        while (end > 0
+               && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+            --end;
+        }
+        return text.substr(0, end);
+    }
+
+private:
+    static bool IsOperator(unsigned char ch) {
+        switch (ch) {
+        case '+':
+        case '-':
+        case '<':
+        case '>':
+        case '(':
+        case ')':
+        case '~':
+        case '*':
+        case '"':
+        case '@': return true;
+        default: return false;
+        }
+    }
+
+    static std::size_t CodePoints(const std::string& text) {
+        std::size_t count = 0;
+        for (unsigned char ch : text) {
+            if ((ch & 0xC0) != 0x80) ++count;
+        }
+        return count;
+    }
+};
+
+#endif   // MESSAGESEARCH_H_
@@ -0,0 +1,197 @@
+#ifndef USERCODEC_H_
+#define USERCODEC_H_
+
+#include "common/UserMessage.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 缓存记录的紧凑二进制编码（替代 JSON 字符串）
+//
+// 布局 v1:
+//   [0] MAGIC   0xB7，不可能是 JSON 文本的首字节，据此区分新旧格式
+//   [1] VERSION
+//   [2] KIND    1 = UserInfo, 2 = UserInfo 列表, 3 = ApplyInfo 列表
+//   列表: varint 条数，随后逐条记录
+//   UserInfo:  zigzag(uid) zigzag(sex) name nick email desc back icon
+//   ApplyInfo: zigzag(uid) zigzag(sex) zigzag(status) name desc icon nick
+//   字符串: varint 长度 + 原始字节
+// 密码字段不进缓存
+class UserCodec {
+public:
+    static constexpr uint8_t MAGIC   = 0xB7;
+    static constexpr uint8_t VERSION = 1;
+
+    enum Kind : uint8_t {
+        KIND_USER       = 1,
+        KIND_USER_LIST  = 2,
+        KIND_APPLY_LIST = 3,
+    };
+
+    static bool IsBinary(const std::string& data) {
+        return !data.empty() && static_cast<uint8_t>(data[0]) == MAGIC;
+    }
+
+    static std::string Encode(const UserInfo& info) {
+        std::string out = header(KIND_USER);
+        putUser(out, info);
+        return out;
+    }
+
+    static std::string Encode(const std::vector<UserInfo>& list) {
+        std::string out = header(KIND_USER_LIST);
+        putVarint(out, list.size());
+        for (const auto& info : list) putUser(out, info);
+        return out;
+    }
+
+    static std::string Encode(const std::vector<ApplyInfo>& list) {
+        std::string out = header(KIND_APPLY_LIST);
+        putVarint(out, list.size());
+        for (const auto& info : list) putApply(out, info);
+        return out;
+    }
+
+    static bool Decode(const std::string& data, UserInfo& info) {
+        Reader r{data, 0};
+        return checkHeader(r, KIND_USER) && getUser(r, info) && r.done();
+    }
+
+    static bool Decode(const std::string& data, std::vector<UserInfo>& list) {
+        Reader   r{data, 0};
+        uint64_t count = 0;
+        if (!checkHeader(r, KIND_USER_LIST) || !getVarint(r, count)
+            || count > data.size()) {
+            return false;
+        }
+        list.clear();
+        list.resize(count);
+        for (auto& info : list) {
+            if (!getUser(r, info)) return false;
+        }
+        return r.done();
+    }
+
+    static bool Decode(const std::string& data, std::vector<ApplyInfo>& list) {
+        Reader   r{data, 0};
+        uint64_t count = 0;
+        if (!checkHeader(r, KIND_APPLY_LIST) || !getVarint(r, count)
+            || count > data.size()) {
+            return false;
+        }
+        list.clear();
+        list.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            list.emplace_back(0, "", "", "", "", 0, 0);
+            if (!getApply(r, list.back())) return false;
+        }
+        return r.done();
+    }
+
+private:
+    struct Reader {
+        const std::string& data;
+        std::size_t        pos;
+
+        bool done() const { return pos == data.size(); }
+    };
+
+    static std::string header(Kind kind) {
+        std::string out;
+        out.reserve(64);
+        out.push_back(static_cast<char>(MAGIC));
+        out.push_back(static_cast<char>(VERSION));
+        out.push_back(static_cast<char>(kind));
+        return out;
+    }
+
+    static bool checkHeader(Reader& r, Kind kind) {
+        if (r.data.size() < 3 || static_cast<uint8_t>(r.data[0]) != MAGIC
+            || static_cast<uint8_t>(r.data[1]) != VERSION
+            || static_cast<uint8_t>(r.data[2]) != kind) {
+            return false;
+        }
+        r.pos = 3;
+        return true;
+    }
+
+    static void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    static void putInt(std::string& out, int64_t v) {
+        putVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+
+    static void putString(std::string& out, const std::string& s) {
+        putVarint(out, s.size());
+        out.append(s);
+    }
+
+    static bool getVarint(Reader& r, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (r.pos >= r.data.size()) return false;
+            auto byte = static_cast<uint8_t>(r.data[r.pos++]);
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    static bool getInt(Reader& r, int& v) {
+        uint64_t raw = 0;
+        if (!getVarint(r, raw)) return false;
+        v = static_cast<int>(static_cast<int64_t>((raw >> 1) ^ (~(raw & 1) + 1)));
+        return true;
+    }
+
+    static bool getString(Reader& r, std::string& s) {
+        uint64_t len = 0;
+        if (!getVarint(r, len) || len > r.data.size() - r.pos) return false;
+        s.assign(r.data, r.pos, len);
+        r.pos += len;
+        return true;
+    }
+
+    static void putUser(std::string& out, const UserInfo& info) {
+        putInt(out, info.uid);
+        putInt(out, info.sex);
+        putString(out, info.name);
+        putString(out, info.nick);
+        putString(out, info.email);
+        putString(out, info.desc);
+        putString(out, info.back);
+        putString(out, info.icon);
+    }
+
+    static bool getUser(Reader& r, UserInfo& info) {
+        return getInt(r, info.uid) && getInt(r, info.sex)
+               && getString(r, info.name) && getString(r, info.nick)
+               && getString(r, info.email) && getString(r, info.desc)
+               && getString(r, info.back) && getString(r, info.icon);
+    }
+
+    static void putApply(std::string& out, const ApplyInfo& info) {
+        putInt(out, info._uid);
+        putInt(out, info._sex);
+        putInt(out, info._status);
+        putString(out, info._name);
+        putString(out, info._desc);
+        putString(out, info._icon);
+        putString(out, info._nick);
+    }
+
+    static bool getApply(Reader& r, ApplyInfo& info) {
+        return getInt(r, info._uid) && getInt(r, info._sex)
+               && getInt(r, info._status) && getString(r, info._name)
+               && getString(r, info._desc) && getString(r, info._icon)
+               && getString(r, info._nick);
+    }
+};
+
+#endif   // USERCODEC_H_
@@ -21,7 +21,9 @@ struct UserInfo {
         , desc("")
         , back("")
         , icon("")
-        , pwd("") {}
+        , pwd("")
+        , uid(0)
+        , sex(0) {}
     std::string name;
     std::string nick;
     std::string email;
@@ -44,6 +44,9 @@ enum class ErrorCodes : int {
     TOKEN_INVALID           = 1015,
     REDIS_ERROR             = 1016,
     APPLYFRIEND_ERROR       = 1017,
+    MYSQL_POOL_TIMEOUT      = 1018,   // 借 MySQL 连接超时
+    SEARCH_KEYWORD_INVALID  = 1019,   // 检索词为空或只有运算符
+    ARCHIVE_IO_ERROR        = 1020,   // 冷存储段文件读写失败或损坏
 };
 
 constexpr const char* ErrorMsg(ErrorCodes code) {
@@ -84,6 +87,12 @@ constexpr const char* ErrorMsg(ErrorCodes code) {
 
     case ErrorCodes::APPLYFRIEND_ERROR: return "apply friend error";
 
+    case ErrorCodes::MYSQL_POOL_TIMEOUT: return "mysql connection pool timeout";
+
+    case ErrorCodes::SEARCH_KEYWORD_INVALID: return "search keyword invalid";
+
+    case ErrorCodes::ARCHIVE_IO_ERROR: return "archive io error";
+
     default: return "unknown error";
     }
 }
@@ -113,6 +122,10 @@ enum class MsgId : uint16_t {
     ID_PULL_HISTORY_MSG_REQ     = 123,   // 拉取历史消息请求
     ID_PULL_HISTORY_MSG_RSP     = 124,   // 拉取历史消息回复
     ID_NOTIFY_USER_ICON_REQ     = 125,
+    ID_SEARCH_MSG_REQ           = 126,   // 聊天记录检索请求
+    ID_SEARCH_MSG_RSP           = 127,   // 聊天记录检索回复
+    ID_PULL_CONV_HISTORY_REQ    = 128,   // 会话历史翻页请求
+    ID_PULL_CONV_HISTORY_RSP    = 129,   // 会话历史翻页回复
 };
 
 constexpr MsgId INVALID_MSG_ID = static_cast<MsgId>(0);
@@ -132,6 +145,10 @@ constexpr MsgId ReqToRsp(MsgId req) {
 
     case MsgId::ID_PULL_HISTORY_MSG_REQ: return MsgId::ID_PULL_HISTORY_MSG_RSP;
 
+    case MsgId::ID_SEARCH_MSG_REQ: return MsgId::ID_SEARCH_MSG_RSP;
+
+    case MsgId::ID_PULL_CONV_HISTORY_REQ: return MsgId::ID_PULL_CONV_HISTORY_RSP;
+
     default: return INVALID_MSG_ID;
     }
 }
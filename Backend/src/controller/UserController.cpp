@@ -7,9 +7,11 @@
 #include "grpcClient/FileClient.h"
 #include "grpcClient/StatusClient.h"
 #include "infra/LogManager.h"
+#include "infra/MySqlPoolManager.h"
 #include "message.pb.h"
 #include "repository/UserRepository.h"
 #include "service/UserService.h"
+#include <boost/asio/bind_executor.hpp>
 #include <boost/beast/core/buffers_to_string.hpp>
 #include <json/reader.h>
 #include <json/value.h>
@@ -236,24 +238,34 @@ void UserController::UpdateUserIcon(
         return;
     }
 
-    auto ownerRes = UserDAO::getInstance()->FindFriendOwnersByFriendId(uid);
-    if(ownerRes.IsOK()) {
-        for(auto ownerUid : ownerRes.Value()) {
-            auto srvRes = UserRepository::FindUserIpServerByUid(ownerUid);
-            if(!srvRes.IsOK()) {
-                continue;
-            }
-
-            const std::string serverName = srvRes.Value();
-
-            message::UserIconReq req;
-            req.set_uid(uid);
-            req.set_owner_uid(ownerUid);
-            req.set_icon(icon);
-
-            auto rsp = ChatClient::getInstance()->NotifyUserIcon(serverName, req);
-        }
-    }
+    // 好友查询与通知不阻塞当前请求：响应由本连接随处理函数返回写出，
+    // 查询完成后留在 DB 线程池上查好友所在服务器（Redis）并逐个通知
+    // ChatServer（同步 gRPC），不占用本连接的 io 线程
+    UserDAO::getInstance()->AsyncFindFriendOwnersByFriendId(
+        uid,
+        boost::asio::bind_executor(
+            MySqlPoolManager::getInstance()->Executor(),
+            [uid, icon](Result<std::vector<int>> ownerRes) {
+                if (!ownerRes.IsOK()) {
+                    return;
+                }
+                for (auto ownerUid : ownerRes.Value()) {
+                    auto srvRes
+                        = UserRepository::FindUserIpServerByUid(ownerUid);
+                    if (!srvRes.IsOK()) {
+                        continue;
+                    }
+
+                    const std::string serverName = srvRes.Value();
+
+                    message::UserIconReq req;
+                    req.set_uid(uid);
+                    req.set_owner_uid(ownerUid);
+                    req.set_icon(icon);
+
+                    ChatClient::getInstance()->NotifyUserIcon(serverName, req);
+                }
+            }));
 
     Json::Value data;
     data["icon"] = icon;
@@ -1,6 +1,8 @@
 #ifndef MESSAGEDAO_H_
 #define MESSAGEDAO_H_
 
+#include "common/ArchiveSegment.h"
+#include "common/MessageRecord.h"
 #include "common/result.h"
 #include "common/singleton.h"
 #include "dao/MySqlDAO.h"
@@ -9,12 +11,20 @@
 #include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
+#include <cppconn/statement.h>
 #include <json/reader.h>
 #include <json/writer.h>
 #include <json/value.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 
 struct FriendMessages {
@@ -22,225 +32,643 @@ struct FriendMessages {
     std::vector<std::string> messages;
 };
 
+// 历史数据回填的单批结果
+struct BackfillProgress {
+    int64_t last_id = 0;   // 本批处理到的最大 id，下一批从这里继续
+    int     scanned = 0;
+    int     updated = 0;
+};
+
 
 class MsgDAO : public SingleTon<MsgDAO>, public MySqlDAO {
     friend class SingleTon<MsgDAO>;
 
 public:
+    // 单条 multi-VALUES INSERT 最多携带的行数
+    static constexpr std::size_t INSERT_BATCH_ROWS = 100;
+    static constexpr int         ER_LOCK_DEADLOCK  = 1213;
+    static constexpr int         ER_NO_SUCH_TABLE  = 1146;
+    // 新分表/月份表按模板表建表
+    static constexpr const char* TEMPLATE_TABLE = "chat_messages_template";
+
+    // @brief: 确保消息表存在，不存在时按模板表创建（每个表每进程只检查一次）
+    Result<void> ensureTable(const std::string& table_name) {
+        {
+            std::lock_guard<std::mutex> lock(_tables_mutex);
+            if (_known_tables.count(table_name)) return Result<void>::OK();
+        }
+
+        auto res = executeWithConn<void>([&](sql::Connection* conn) {
+            std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+            stmt->execute(
+                "CREATE TABLE IF NOT EXISTS " + table_name + " LIKE "
+                + TEMPLATE_TABLE);
+            return Result<void>::OK();
+        });
+        if (res.IsOK()) {
+            std::lock_guard<std::mutex> lock(_tables_mutex);
+            _known_tables.insert(table_name);
+        }
+        return res;
+    }
+
+    // @brief: 列出以 prefix_ 开头的全部消息表
+    Result<std::vector<std::string>> listTables(const std::string& prefix) {
+        return executeWithConn<std::vector<std::string>>([&](sql::Connection*
+                                                                 conn) {
+            std::vector<std::string>                tables;
+            std::unique_ptr<sql::PreparedStatement> stmt(
+                conn->prepareStatement(
+                    "SELECT table_name AS name FROM information_schema.tables "
+                    "WHERE table_schema = DATABASE() AND table_name LIKE ? "
+                    "ORDER BY table_name"));
+            // 前缀中的 _ 也是通配符，调用方再按布局精确筛选
+            stmt->setString(1, prefix + "\\_%");
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            while (res->next()) {
+                tables.push_back(res->getString("name").asStdString());
+            }
+            return Result<std::vector<std::string>>::OK(tables);
+        });
+    }
+
+    // @brief: 批量持久化消息
+    //         所有行在一个显式事务内按 INSERT_BATCH_ROWS 行一条语句写入；
+    //         某条批量语句失败时仅对该批逐行重试，定位并跳过坏行
+    //         messages 与 Redis LRANGE 顺序一致（新 -> 旧），
+    //         first_seq > 0 时从最旧一条起依次分配会话序号
     Result<void> handleMessage(
         const std::string&              table_name,
-        const std::vector<std::string>& messages) {
+        const std::vector<std::string>& messages, int64_t first_seq = 0) {
 
-        return executeWithConn<void>([&](sql::Connection* conn) {
+        return executeWithConn<void>([&](sql::Connection* conn,
+                                         StatementCache&  stmts) {
             if (messages.empty()) {
                 return Result<void>::OK();
             }
 
-            Json::Reader reader;
-            int          success_count = 0;
-            int          error_count   = 0;
-
-            // 逐条插入消息
+            // 每条消息只解析一次，批量失败后的逐行重试直接复用
+            std::vector<MessageRecord> rows;
+            rows.reserve(messages.size());
+            int error_count = 0;
             for (const auto& msg_json : messages) {
-                Json::Value msg_root;
-                if (!reader.parse(msg_json, msg_root)) {
+                MessageRecord row;
+                if (!MessageCodec::Parse(msg_json, row)) {
                     LOG_WARN("Failed to parse message JSON, skipping");
                     error_count++;
                     continue;
                 }
+                rows.push_back(std::move(row));
+            }
 
-                // 提取字段
-                int from_uid = msg_root["fromuid"].asInt();
-                int to_uid   = msg_root["touid"].asInt();
+            if (rows.empty()) {
+                LOG_ERROR("All messages failed to parse for {}", table_name);
+                return Result<void>::Error(ErrorCodes::SQL_ERROR);
+            }
 
-                std::string msgid;
-                if (msg_root["text_array"].isArray()
-                    && msg_root["text_array"].size() > 0) {
-                    msgid = msg_root["text_array"][0]["msgid"].asString();
-                } else {
-                    // 如果没有 msgid，生成一个
-                    msgid = "msg_" + std::to_string(std::time(nullptr)) + "_"
-                            + std::to_string(rand());
+            if (first_seq > 0) {
+                for (std::size_t i = 0; i < rows.size(); ++i) {
+                    rows[i].seq = first_seq
+                                  + static_cast<int64_t>(rows.size() - 1 - i);
                 }
+            }
 
-                // 构建单条插入 SQL（使用普通 INSERT，允许相同 msgid）
-                std::string sql = "INSERT INTO " + table_name
-                                  + " (msgid, from_uid, to_uid, content) "
-                                    "VALUES (?, ?, ?, ?)";
+            TransactionGuard tx(conn);
+            int              success_count = 0;
 
-                try {
-                    std::unique_ptr<sql::PreparedStatement> stmt(
-                        conn->prepareStatement(sql));
+            // 满批/单行语句 SQL 固定，走语句缓存；尾批行数不定，临时准备
+            for (std::size_t begin = 0; begin < rows.size();
+                 begin += INSERT_BATCH_ROWS) {
+                std::size_t count
+                    = std::min(INSERT_BATCH_ROWS, rows.size() - begin);
 
-                    stmt->setString(1, msgid);
-                    stmt->setInt(2, from_uid);
-                    stmt->setInt(3, to_uid);
-                    stmt->setString(4, msg_json);
+                try {
+                    std::shared_ptr<sql::PreparedStatement> stmt;
+                    if (count == INSERT_BATCH_ROWS || count == 1) {
+                        stmt = stmts.Prepare(buildInsertSql(table_name, count));
+                    } else {
+                        stmt.reset(conn->prepareStatement(
+                            buildInsertSql(table_name, count)));
+                    }
 
+                    bindRows(stmt.get(), rows, begin, count);
                     stmt->executeUpdate();
-                    success_count++;
-
+                    success_count += static_cast<int>(count);
                 } catch (sql::SQLException& e) {
-                    // 记录错误但继续处理下一条
-                    LOG_ERROR(
-                        "Failed to insert message (msgid: {}): {}",
-                        msgid,
+                    // 死锁时 InnoDB 回滚整个事务，之前的批次已丢失，整体失败等下一轮重试
+                    if (e.getErrorCode() == ER_LOCK_DEADLOCK) {
+                        throw;
+                    }
+                    // 其他语句级失败只回滚该语句本身，事务内已写入的批次不受影响
+                    LOG_WARN(
+                        "Batch insert of {} rows to {} failed, retrying row by "
+                        "row: {}",
+                        count,
+                        table_name,
                         e.what());
-                    error_count++;
+                    insertRowByRow(
+                        stmts,
+                        table_name,
+                        rows,
+                        begin,
+                        count,
+                        success_count,
+                        error_count);
                 }
             }
 
-            // 记录处理结果
-            if (success_count > 0) {
-                LOG_INFO(
-                    "Message persistence to {}: {} inserted, {} error",
-                    table_name,
-                    success_count,
-                    error_count);
-            }
-
-            // 只要有至少一条成功，就返回 OK
-            if (success_count > 0) {
-                return Result<void>::OK();
-            } else {
+            if (success_count == 0) {
                 LOG_ERROR("All messages failed to insert to {}", table_name);
                 return Result<void>::Error(ErrorCodes::SQL_ERROR);
             }
+
+            tx.Commit();
+
+            LOG_INFO(
+                "Message persistence to {}: {} inserted, {} error",
+                table_name,
+                success_count,
+                error_count);
+
+            // 只要有至少一条成功，就返回 OK
+            return Result<void>::OK();
         });
     }
 
+    // @brief: 查询 uid 最近 days 天内与每个会话对象的最近 limit 条消息
+    //         时间窗与每个对象的条数限制都在 SQL 内完成（依赖 msg_ts 复合索引），
+    //         耗时只与窗口内消息量有关，与用户历史总量无关；
+    //         tables 为时间窗涉及的全部分表（由 MessageShardMap 展开），
+    //         各表在独立的池化连接上并行查询，尚未创建的月份表视为空表
     Result<std::vector<FriendMessages>> getRecentMessagesGroupedByFriend(
-        int uid, int days, int limit) {
-        return executeWithConn<std::vector<FriendMessages>>([&](sql::Connection*
-                                                                    conn) {
-            std::map<int, std::vector<std::string>> friend_message_map;
-            std::time_t                             now = std::time(nullptr);
-            std::time_t start_time = now - (days * 24 * 60 * 60);
-
-            struct MessageWithTime {
+        const std::vector<std::string>& tables, int uid, int days, int limit) {
+        std::time_t now        = std::time(nullptr);
+        std::time_t start_time = now - (days * 24 * 60 * 60);
+
+        // 帮手在 MySQL 工作线程池上执行，可能晚于本函数返回才开始，
+        // 共享状态放在堆上由各方共同持有
+        struct FanOut {
+            std::vector<std::string>              tables;
+            std::vector<std::vector<PeerMessage>> shard_rows;
+            std::atomic<int>                      next_shard{0};
+            std::atomic<int>                      failed_shards{0};
+            std::mutex                            mutex;
+            std::condition_variable               idle;
+            int                                   running = 0;
+        };
+        auto state    = std::make_shared<FanOut>();
+        state->tables = tables;
+        state->shard_rows.resize(tables.size());
+        const int table_count = static_cast<int>(tables.size());
+
+        // 每个参与者依次领取分表，直到领完
+        auto drain = [this, state, table_count, uid, start_time, now, limit]() {
+            for (int table_id = state->next_shard.fetch_add(1);
+                 table_id < table_count;
+                 table_id = state->next_shard.fetch_add(1)) {
+                auto res = queryRecentInShard(
+                    state->tables[table_id], uid, start_time, now, limit);
+                if (res.IsOK()) {
+                    state->shard_rows[table_id] = res.Value();
+                } else {
+                    state->failed_shards.fetch_add(1);
+                }
+            }
+        };
+
+        // 帮手投递到固定大小的 MySQL 工作线程池，不为每次请求新建线程；
+        // 调用方自己也领取分表，帮手迟迟排不上时由调用方独自查完，
+        // 只等待已经领到分表的帮手，线程池占满时也不会互相等待而卡死
+        std::size_t parallelism = std::min<std::size_t>(
+            tables.size(), std::max<std::size_t>(1, PoolSize()));
+        for (std::size_t i = 1; i < parallelism; ++i) {
+            boost::asio::post(
+                MySqlPoolManager::getInstance()->Executor(),
+                [state, table_count, drain]() {
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (state->next_shard.load() >= table_count) return;
+                        ++state->running;
+                    }
+                    drain();
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (--state->running == 0) state->idle.notify_all();
+                });
+        }
+        drain();
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->idle.wait(lock, [&state]() { return state->running == 0; });
+        }
+
+        if (table_count > 0 && state->failed_shards.load() == table_count) {
+            LOG_ERROR("Recent message query failed on all shards for {}", uid);
+            return Result<std::vector<FriendMessages>>::Error(
+                ErrorCodes::SQL_ERROR);
+        }
+
+        // 同一会话双向消息落在同一分表，这里仍按对象归并，不依赖分表规则
+        std::map<int, std::vector<PeerMessage>> peer_map;
+        for (auto& rows : state->shard_rows) {
+            for (auto& row : rows) {
+                peer_map[row.peer_uid].push_back(std::move(row));
+            }
+        }
+
+        std::vector<FriendMessages> result;
+        result.reserve(peer_map.size());
+        for (auto& [friend_uid, messages] : peer_map) {
+            std::sort(
+                messages.begin(),
+                messages.end(),
+                [](const PeerMessage& a, const PeerMessage& b) {
+                    return a.msg_ts > b.msg_ts;
+                });
+
+            FriendMessages fm;
+            fm.friend_uid = friend_uid;
+
+            // limit num
+            size_t count
+                = std::min(messages.size(), static_cast<size_t>(limit));
+            fm.messages.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                fm.messages.push_back(std::move(messages[i].content));
+            }
+
+            result.push_back(std::move(fm));
+        }
+
+        return Result<std::vector<FriendMessages>>::OK(result);
+    }
+
+    // @brief: getRecentMessagesGroupedByFriend 的异步版本，
+    //         分表查询在 MySQL 工作线程上发起，
+    //         完成签名 void(Result<std::vector<FriendMessages>>)
+    template<typename CompletionToken>
+    auto AsyncGetRecentMessagesGroupedByFriend(
+        std::vector<std::string> tables, int uid, int days, int limit,
+        CompletionToken&& token) {
+        return asyncExecute<std::vector<FriendMessages>>(
+            [this, tables = std::move(tables), uid, days, limit]() {
+                return getRecentMessagesGroupedByFriend(
+                    tables, uid, days, limit);
+            },
+            std::forward<CompletionToken>(token));
+    }
+
+    // @brief: 回填一批历史行的类型化列（peer_key / msg_type / msg_ts / payload）
+    //         按主键顺序从 after_id 之后取最多 batch_size 条 payload 为空的行，
+    //         一批一个事务；drop_content 为 true 时同时清空原始 content 释放空间
+    Result<BackfillProgress> backfillTypedColumns(
+        const std::string& table_name, int64_t after_id, int batch_size,
+        bool drop_content) {
+        return executeWithConn<BackfillProgress>([&](sql::Connection* conn,
+                                                     StatementCache&  stmts) {
+            BackfillProgress progress;
+            progress.last_id = after_id;
+
+            struct LegacyRow {
+                int64_t     id;
+                int64_t     created_ts;
                 std::string content;
-                std::time_t timestamp;
             };
-            std::map<int, std::vector<MessageWithTime>> timed_messages_map;
+            std::vector<LegacyRow> legacy;
+
+            auto select = stmts.Prepare(
+                "SELECT id, content, IFNULL(UNIX_TIMESTAMP(created_at), 0) AS "
+                "created_ts FROM "
+                + table_name
+                + " WHERE id > ? AND payload IS NULL ORDER BY id LIMIT ?");
+            select->setInt64(1, after_id);
+            select->setInt(2, batch_size);
+            {
+                std::unique_ptr<sql::ResultSet> res(select->executeQuery());
+                while (res->next()) {
+                    legacy.push_back(
+                        {res->getInt64("id"),
+                         res->getInt64("created_ts"),
+                         res->getString("content").asStdString()});
+                }
+            }
 
-            for (int table_id = 0; table_id < 16; ++table_id) {
-                std::string table_name
-                    = "chat_messages_" + std::to_string(table_id);
-                std::string sql
-                    = "SELECT content, IFNULL(UNIX_TIMESTAMP(created_at), 0) "
-                      "AS created_at_ts FROM "
-                      + table_name + " WHERE from_uid = ? OR to_uid = ?";
+            if (legacy.empty()) {
+                return Result<BackfillProgress>::OK(progress);
+            }
 
-                try {
-                    std::unique_ptr<sql::PreparedStatement> stmt(
-                        conn->prepareStatement(sql));
-                    stmt->setInt(1, uid);
-                    stmt->setInt(2, uid);
+            auto update = stmts.Prepare(
+                "UPDATE " + table_name
+                + " SET peer_key = ?, msg_type = ?, msg_ts = ?, payload = ?, "
+                  "content = IF(?, '', content) WHERE id = ?");
+
+            TransactionGuard tx(conn);
+            for (const auto& row : legacy) {
+                progress.scanned++;
+                progress.last_id = row.id;
+
+                MessageRecord record;
+                if (!MessageCodec::Parse(row.content, record)) {
+                    LOG_WARN(
+                        "Backfill skipped unparsable row {} in {}",
+                        row.id,
+                        table_name);
+                    continue;
+                }
+                // 帧内没有时间信息时 Parse 取的是当前时间，改用入库时间
+                if (row.content.find("\"timestamp\"") == std::string::npos
+                    && row.created_ts > 0) {
+                    record.msg_ts = row.created_ts;
+                }
+
+                update->setInt64(1, record.peer_key);
+                update->setInt(2, static_cast<int>(record.msg_type));
+                update->setInt64(3, record.msg_ts);
+                update->setString(4, record.payload);
+                update->setInt(5, drop_content ? 1 : 0);
+                update->setInt64(6, row.id);
+                progress.updated += update->executeUpdate();
+            }
+            tx.Commit();
+
+            return Result<BackfillProgress>::OK(progress);
+        });
+    }
+
+    // @brief: 会话 (uid, peer_uid) 中早于游标 (before_ts, before_id) 的最多
+    //         limit 条，按 (msg_ts, id) 从新到旧；tables 为会话可能所在的表
+    //         （从新到旧），取够 limit 条后不再查更早的表
+    Result<std::vector<ArchiveRow>> getConversationPage(
+        const std::vector<std::string>& tables, int uid, int peer_uid,
+        int64_t before_ts, int64_t before_id, int limit) {
+        const int64_t peer_key = MessageCodec::PeerKey(uid, peer_uid);
+        return executeReadOnly<std::vector<ArchiveRow>>(
+            uid, [&](sql::Connection*, StatementCache& stmts) {
+                std::vector<ArchiveRow> rows;
+                for (const auto& table_name : tables) {
+                    if (static_cast<int>(rows.size()) >= limit) break;
+
+                    std::shared_ptr<sql::PreparedStatement> stmt;
+                    try {
+                        stmt = stmts.Prepare(
+                            "SELECT " + std::string(ROW_COLUMNS) + " FROM "
+                            + table_name
+                            + " WHERE peer_key = ?"
+                              " AND (msg_ts < ? OR (msg_ts = ? AND id < ?))"
+                              " ORDER BY msg_ts DESC, id DESC LIMIT ?");
+                    } catch (sql::SQLException& e) {
+                        if (e.getErrorCode() == ER_NO_SUCH_TABLE) continue;
+                        throw;
+                    }
+                    stmt->setInt64(1, peer_key);
+                    stmt->setInt64(2, before_ts);
+                    stmt->setInt64(3, before_ts);
+                    stmt->setInt64(4, before_id);
+                    stmt->setInt(5, limit - static_cast<int>(rows.size()));
 
                     std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
                     while (res->next()) {
-                        std::string content = res->getString("content");
-                        std::time_t db_created_at
-                            = static_cast<std::time_t>(res->getInt64("created_at_ts"));
-
-                        Json::Value  root;
-                        Json::Reader reader;
-                        if (!reader.parse(content, root)) {
-                            LOG_WARN("Failed to parse message JSON, skipping");
-                            continue;
-                        }
+                        rows.push_back(readRow(res.get()));
+                    }
+                }
+                return Result<std::vector<ArchiveRow>>::OK(rows);
+            });
+    }
 
-                        int from_uid   = root["fromuid"].asInt();
-                        int to_uid     = root["touid"].asInt();
-                        int friend_uid = (from_uid == uid) ? to_uid : from_uid;
+    template<typename CompletionToken>
+    auto AsyncGetConversationPage(
+        std::vector<std::string> tables, int uid, int peer_uid,
+        int64_t before_ts, int64_t before_id, int limit,
+        CompletionToken&& token) {
+        return asyncExecute<std::vector<ArchiveRow>>(
+            [this,
+             tables = std::move(tables),
+             uid,
+             peer_uid,
+             before_ts,
+             before_id,
+             limit]() {
+                return getConversationPage(
+                    tables, uid, peer_uid, before_ts, before_id, limit);
+            },
+            std::forward<CompletionToken>(token));
+    }
 
-                        std::time_t msg_time = 0;
-                        if (root.isMember("timestamp")
-                            && root["timestamp"].isInt64()) {
-                            msg_time
-                                = static_cast<std::time_t>(root["timestamp"].asInt64());
-                        }
+    // @brief: 按主键顺序读取 after_id 之后、msg_ts 早于 cutoff_ts 的最多
+    //         batch_size 行（归档任务使用），未回填的历史行从原始帧解析
+    Result<std::vector<ArchiveRow>> readArchivable(
+        const std::string& table_name, int64_t after_id, int64_t cutoff_ts,
+        int batch_size) {
+        return executeWithConn<std::vector<ArchiveRow>>(
+            [&](sql::Connection*, StatementCache& stmts) {
+                auto stmt = stmts.Prepare(
+                    "SELECT " + std::string(ROW_COLUMNS) + " FROM " + table_name
+                    + " WHERE id > ? AND msg_ts < ? ORDER BY id LIMIT ?");
+                stmt->setInt64(1, after_id);
+                stmt->setInt64(2, cutoff_ts);
+                stmt->setInt(3, batch_size);
+
+                std::vector<ArchiveRow>         rows;
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+                while (res->next()) {
+                    rows.push_back(readRow(res.get()));
+                }
+                return Result<std::vector<ArchiveRow>>::OK(rows);
+            });
+    }
 
-                        if (msg_time <= 0
-                            && root["text_array"].isArray()
-                            && root["text_array"].size() > 0) {
-                            const auto& first = root["text_array"][0];
-                            if (first.isMember("timestamp")
-                                && first["timestamp"].isInt64()) {
-                                msg_time = static_cast<std::time_t>(
-                                    first["timestamp"].asInt64());
-                            }
-                        }
+    // @brief: 删除已归档的行：id 在 (after_id, last_id] 且 msg_ts 早于
+    //         cutoff_ts，即 readArchivable 在同一区间读到的行；
+    //         每条语句最多删 chunk 行，避免长时间持有行锁；返回删除行数
+    Result<int64_t> deleteArchived(
+        const std::string& table_name, int64_t after_id, int64_t last_id,
+        int64_t cutoff_ts, int chunk) {
+        return executeWithConn<int64_t>([&](sql::Connection*,
+                                            StatementCache& stmts) {
+            auto stmt = stmts.Prepare(
+                "DELETE FROM " + table_name
+                + " WHERE id > ? AND id <= ? AND msg_ts < ? LIMIT ?");
+            int64_t deleted = 0;
+            while (true) {
+                stmt->setInt64(1, after_id);
+                stmt->setInt64(2, last_id);
+                stmt->setInt64(3, cutoff_ts);
+                stmt->setInt(4, chunk);
+                int affected = stmt->executeUpdate();
+                deleted += affected;
+                if (affected < chunk) break;
+            }
+            return Result<int64_t>::OK(deleted);
+        });
+    }
 
-                        if (msg_time <= 0
-                            && root["text_array"].isArray()
-                            && root["text_array"].size() > 0) {
-                            std::string msgid
-                                = root["text_array"][0]["msgid"].asString();
-                            if (msgid.find("msg_") == 0) {
-                                size_t second_underscore = msgid.find('_', 4);
-                                if (second_underscore != std::string::npos) {
-                                    std::string timestamp_str
-                                        = msgid.substr(4, second_underscore - 4);
-                                    try {
-                                        msg_time = static_cast<std::time_t>(
-                                            std::stoll(timestamp_str));
-                                    } catch (...) {
-                                        msg_time = 0;
-                                    }
-                                }
-                            }
-                        }
-                        if (msg_time <= 0 && db_created_at > 0) {
-                            msg_time = db_created_at;
-                        }
-                        if (msg_time <= 0) {
-                            msg_time = now;
-                        }
+private:
+    MsgDAO() : MySqlDAO("MsgDAO") {}
+
+    struct PeerMessage {
+        int         peer_uid = 0;
+        int64_t     msg_ts   = 0;
+        std::string content;
+    };
+
+    // 单个分表：两个方向各走 (from_uid, msg_ts) / (to_uid, msg_ts) 索引做范围扫描，
+    // 再用窗口函数按会话对象截取最近 limit 条
+    Result<std::vector<PeerMessage>> queryRecentInShard(
+        const std::string& table_name, int uid, int64_t start_ts, int64_t end_ts,
+        int limit) {
+        return executeReadOnly<std::vector<PeerMessage>>(
+            uid, [&](sql::Connection*, StatementCache& stmts) {
+                std::shared_ptr<sql::PreparedStatement> stmt;
+                try {
+                    stmt = stmts.Prepare(
+                        "SELECT peer_uid, from_uid, to_uid, msg_ts, payload, content"
+                        " FROM ("
+                        " SELECT conv.*, ROW_NUMBER() OVER ("
+                        "  PARTITION BY peer_uid ORDER BY msg_ts DESC, seq DESC, id DESC)"
+                        "  AS rn"
+                        " FROM ("
+                        "  SELECT to_uid AS peer_uid, id, from_uid, to_uid, msg_ts, seq,"
+                        "   payload, content FROM "
+                        + table_name
+                        + "   WHERE from_uid = ? AND msg_ts BETWEEN ? AND ?"
+                          "  UNION ALL"
+                          "  SELECT from_uid AS peer_uid, id, from_uid, to_uid, msg_ts,"
+                          "   seq, payload, content FROM "
+                        + table_name
+                        + "   WHERE to_uid = ? AND from_uid <> ? AND msg_ts BETWEEN ? AND ?"
+                          " ) AS conv"
+                          ") AS ranked WHERE rn <= ?");
+                } catch (sql::SQLException& e) {
+                    // 按月分区时窗口内的月份表可能还没有写入过
+                    if (e.getErrorCode() == ER_NO_SUCH_TABLE) {
+                        return Result<std::vector<PeerMessage>>::OK({});
+                    }
+                    throw;
+                }
+                stmt->setInt(1, uid);
+                stmt->setInt64(2, start_ts);
+                stmt->setInt64(3, end_ts);
+                stmt->setInt(4, uid);
+                stmt->setInt(5, uid);
+                stmt->setInt64(6, start_ts);
+                stmt->setInt64(7, end_ts);
+                stmt->setInt(8, limit);
+
+                std::vector<PeerMessage>        rows;
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+                while (res->next()) {
+                    PeerMessage row;
+                    row.peer_uid = res->getInt("peer_uid");
+                    row.msg_ts   = res->getInt64("msg_ts");
+                    if (!res->isNull("payload")) {
+                        row.content = MessageCodec::BuildFrame(
+                            res->getInt("from_uid"),
+                            res->getInt("to_uid"),
+                            row.msg_ts,
+                            res->getString("payload").asStdString());
+                        rows.push_back(std::move(row));
+                        continue;
+                    }
 
-                        if (!root.isMember("timestamp") && msg_time > 0) {
-                            root["timestamp"]
-                                = static_cast<Json::Int64>(msg_time);
+                    // 尚未回填的历史行：读原始帧，
+                    // 早期消息体内没有 timestamp，按列值补上，客户端据此排序
+                    row.content = res->getString("content").asStdString();
+                    if (row.content.find("\"timestamp\"") == std::string::npos) {
+                        Json::Value  root;
+                        Json::Reader reader;
+                        if (reader.parse(row.content, root) && root.isObject()) {
+                            root["timestamp"] = static_cast<Json::Int64>(row.msg_ts);
                             Json::FastWriter writer;
-                            content = writer.write(root);
-                        }
-
-                        if (msg_time >= start_time && msg_time <= now) {
-                            timed_messages_map[friend_uid].push_back(
-                                {content, msg_time});
+                            row.content = writer.write(root);
                         }
                     }
-
-                } catch (sql::SQLException& e) {
-                    LOG_DEBUG("Table {} query skipped: {}", table_id, e.what());
+                    rows.push_back(std::move(row));
                 }
-            }
+                return Result<std::vector<PeerMessage>>::OK(rows);
+            });
+    }
 
-            std::vector<FriendMessages> result;
-            for (auto& [friend_uid, messages] : timed_messages_map) {
-                std::sort(
-                    messages.begin(),
-                    messages.end(),
-                    [](const MessageWithTime& a, const MessageWithTime& b) {
-                        return a.timestamp > b.timestamp;
-                    });
-
-                FriendMessages fm;
-                fm.friend_uid = friend_uid;
-
-                // limit num
-                size_t count
-                    = std::min(messages.size(), static_cast<size_t>(limit));
-                for (size_t i = 0; i < count; ++i) {
-                    fm.messages.push_back(messages[i].content);
-                }
+    // readRow 读取的列
+    static constexpr const char* ROW_COLUMNS
+        = "id, msgid, from_uid, to_uid, seq, msg_type, msg_ts, payload, "
+          "content";
+
+    // @brief: 一行消息转成 ArchiveRow；payload 为空的历史行解析原始帧，
+    //         时间与 msgid 以列值为准
+    static ArchiveRow readRow(sql::ResultSet* res) {
+        ArchiveRow row;
+        auto&      record = row.record;
+        row.id            = res->getInt64("id");
+        if (res->isNull("payload")) {
+            MessageCodec::Parse(
+                res->getString("content").asStdString(), record);
+        } else {
+            record.payload = res->getString("payload").asStdString();
+        }
+        record.msgid    = res->getString("msgid").asStdString();
+        record.from_uid = res->getInt("from_uid");
+        record.to_uid   = res->getInt("to_uid");
+        record.peer_key = MessageCodec::PeerKey(record.from_uid, record.to_uid);
+        record.seq      = res->getInt64("seq");
+        record.msg_type = static_cast<MessageType>(res->getInt("msg_type"));
+        record.msg_ts   = res->getInt64("msg_ts");
+        return row;
+    }
 
-                result.push_back(fm);
-            }
+    // 普通 INSERT，允许相同 msgid
+    // 新行只写 payload，content 留空（仅历史行保存完整帧）
+    static std::string
+    buildInsertSql(const std::string& table_name, std::size_t rows) {
+        std::string sql = "INSERT INTO " + table_name
+                          + " (msgid, from_uid, to_uid, peer_key, seq, msg_type, "
+                            "msg_ts, payload, content) VALUES ";
+        sql.reserve(sql.size() + rows * 32);
+        for (std::size_t i = 0; i < rows; ++i) {
+            if (i > 0) sql += ',';
+            sql += "(?, ?, ?, ?, ?, ?, ?, ?, '')";
+        }
+        return sql;
+    }
 
-            return Result<std::vector<FriendMessages>>::OK(result);
-        });
+    static void bindRows(
+        sql::PreparedStatement* stmt, const std::vector<MessageRecord>& rows,
+        std::size_t begin, std::size_t count) {
+        unsigned int idx = 1;
+        for (std::size_t i = begin; i < begin + count; ++i) {
+            const auto& row = rows[i];
+            stmt->setString(idx++, row.msgid);
+            stmt->setInt(idx++, row.from_uid);
+            stmt->setInt(idx++, row.to_uid);
+            stmt->setInt64(idx++, row.peer_key);
+            stmt->setInt64(idx++, row.seq);
+            stmt->setInt(idx++, static_cast<int>(row.msg_type));
+            stmt->setInt64(idx++, row.msg_ts);
+            stmt->setString(idx++, row.payload);
+        }
     }
+
+    static void insertRowByRow(
+        StatementCache& stmts, const std::string& table_name,
+        const std::vector<MessageRecord>& rows, std::size_t begin,
+        std::size_t count, int& success_count, int& error_count) {
+        auto stmt = stmts.Prepare(buildInsertSql(table_name, 1));
+        for (std::size_t i = begin; i < begin + count; ++i) {
+            try {
+                bindRows(stmt.get(), rows, i, 1);
+                stmt->executeUpdate();
+                success_count++;
+            } catch (sql::SQLException& e) {
+                // 记录错误但继续处理下一条
+                LOG_ERROR(
+                    "Failed to insert message (msgid: {}): {}",
+                    rows[i].msgid,
+                    e.what());
+                error_count++;
+            }
+        }
+    }
+
+    std::mutex                      _tables_mutex;
+    std::unordered_set<std::string> _known_tables;
 };
 
 #endif   // MESSAGEDAO_H_
@@ -0,0 +1,265 @@
+#ifndef MSGRESHARDDAO_H_
+#define MSGRESHARDDAO_H_
+
+#include "common/result.h"
+#include "common/singleton.h"
+#include "dao/MsgDAO.h"
+#include "dao/MySqlDAO.h"
+#include "infra/LogManager.h"
+#include "infra/MessageShardMap.h"
+#include <cppconn/connection.h>
+#include <cppconn/datatype.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 一个会话在若干表中的内容摘要：行数 + 逐行 CRC32 的异或（与行顺序、自增 id 无关）
+struct ConversationDigest {
+    int64_t  rows     = 0;
+    uint64_t checksum = 0;
+
+    bool operator==(const ConversationDigest& other) const {
+        return rows == other.rows && checksum == other.checksum;
+    }
+};
+
+struct CopyProgress {
+    int64_t last_id = 0;
+    int     copied  = 0;
+};
+
+// 消息重分片的数据搬迁：按新布局复制行、按会话校验、重新复制不一致的会话
+class MsgReshardDAO : public SingleTon<MsgReshardDAO>, public MySqlDAO {
+    friend class SingleTon<MsgReshardDAO>;
+
+public:
+    Result<int64_t> maxId(const std::string& table_name) {
+        return executeWithConn<int64_t>([&](sql::Connection* conn) {
+            std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT IFNULL(MAX(id), 0) AS max_id FROM " + table_name));
+            int64_t max_id = res->next() ? res->getInt64("max_id") : 0;
+            return Result<int64_t>::OK(max_id);
+        });
+    }
+
+    // @brief: 尚未回填类型化列的行数，重分片前必须为 0（peer_key 是校验依据）
+    Result<int64_t> countUnbackfilled(const std::string& table_name) {
+        return executeWithConn<int64_t>([&](sql::Connection* conn) {
+            std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT COUNT(*) AS cnt FROM " + table_name
+                + " WHERE payload IS NULL"));
+            int64_t count = res->next() ? res->getInt64("cnt") : 0;
+            return Result<int64_t>::OK(count);
+        });
+    }
+
+    // @brief: 复制 src 表中 (after_id, max_id] 范围内的一批行到目标布局，
+    //         一批一个事务；目标表由每行的会话与 msg_ts 决定
+    Result<CopyProgress> copyBatch(
+        const std::string& src_table, int64_t after_id, int64_t max_id,
+        int batch_size, const MessageShardLayout& target) {
+        return executeWithConn<CopyProgress>([&](sql::Connection* conn,
+                                                 StatementCache&  stmts) {
+            CopyProgress progress;
+            progress.last_id = after_id;
+
+            auto select = stmts.Prepare(
+                "SELECT " + std::string(ROW_COLUMNS) + ", id FROM " + src_table
+                + " WHERE id > ? AND id <= ? ORDER BY id LIMIT ?");
+            select->setInt64(1, after_id);
+            select->setInt64(2, max_id);
+            select->setInt(3, batch_size);
+
+            std::map<std::string, std::vector<CopiedRow>> by_table;
+            {
+                std::unique_ptr<sql::ResultSet> res(select->executeQuery());
+                while (res->next()) {
+                    CopiedRow row = readRow(res.get());
+                    progress.last_id = res->getInt64("id");
+                    by_table[target.TableFor(row.from_uid, row.to_uid, row.msg_ts)]
+                        .push_back(std::move(row));
+                    progress.copied++;
+                }
+            }
+
+            if (progress.copied == 0) {
+                return Result<CopyProgress>::OK(progress);
+            }
+
+            for (const auto& [table, rows] : by_table) {
+                MsgDAO::getInstance()->ensureTable(table);
+            }
+
+            TransactionGuard tx(conn);
+            for (const auto& [table, rows] : by_table) {
+                insertRows(conn, table, rows);
+            }
+            tx.Commit();
+            return Result<CopyProgress>::OK(progress);
+        });
+    }
+
+    // @brief: 列出表中 peer_key 大于 after 的若干个会话（走 idx_peer_ts）
+    Result<std::vector<int64_t>> listConversations(
+        const std::string& table_name, int64_t after, int batch_size) {
+        return executeWithConn<std::vector<int64_t>>([&](sql::Connection*,
+                                                         StatementCache& stmts) {
+            auto stmt = stmts.Prepare(
+                "SELECT DISTINCT peer_key FROM " + table_name
+                + " WHERE peer_key > ? ORDER BY peer_key LIMIT ?");
+            stmt->setInt64(1, after);
+            stmt->setInt(2, batch_size);
+
+            std::vector<int64_t>            peers;
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            while (res->next()) peers.push_back(res->getInt64("peer_key"));
+            return Result<std::vector<int64_t>>::OK(peers);
+        });
+    }
+
+    Result<ConversationDigest>
+    digest(const std::vector<std::string>& tables, int64_t peer_key) {
+        return executeWithConn<ConversationDigest>([&](sql::Connection*,
+                                                       StatementCache& stmts) {
+            ConversationDigest total;
+            for (const auto& table : tables) {
+                auto stmt = stmts.Prepare(
+                    "SELECT COUNT(*) AS cnt, BIT_XOR(CRC32(CONCAT_WS('|', msgid, "
+                    "from_uid, to_uid, seq, msg_ts, IFNULL(payload, content)))) "
+                    "AS crc FROM "
+                    + table + " WHERE peer_key = ?");
+                stmt->setInt64(1, peer_key);
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+                if (res->next()) {
+                    total.rows += res->getInt64("cnt");
+                    total.checksum ^= res->getUInt64("crc");
+                }
+            }
+            return Result<ConversationDigest>::OK(total);
+        });
+    }
+
+    // @brief: 用源表中的全部行覆盖目标表中的一个会话（删除后重新插入，单事务）
+    //         调用方需持有消息持久化锁，避免期间有新消息写入
+    Result<int> recopyConversation(
+        const std::vector<std::string>& src_tables,
+        const std::vector<std::string>& dst_tables, int64_t peer_key,
+        const MessageShardLayout& target) {
+        return executeWithConn<int>([&](sql::Connection* conn) {
+            std::map<std::string, std::vector<CopiedRow>> by_table;
+            int                                           copied = 0;
+            for (const auto& table : src_tables) {
+                std::unique_ptr<sql::PreparedStatement> select(
+                    conn->prepareStatement(
+                        "SELECT " + std::string(ROW_COLUMNS) + " FROM " + table
+                        + " WHERE peer_key = ? ORDER BY id"));
+                select->setInt64(1, peer_key);
+                std::unique_ptr<sql::ResultSet> res(select->executeQuery());
+                while (res->next()) {
+                    CopiedRow row = readRow(res.get());
+                    by_table[target.TableFor(row.from_uid, row.to_uid, row.msg_ts)]
+                        .push_back(std::move(row));
+                    copied++;
+                }
+            }
+
+            for (const auto& [table, rows] : by_table) {
+                MsgDAO::getInstance()->ensureTable(table);
+            }
+
+            TransactionGuard tx(conn);
+            for (const auto& table : dst_tables) {
+                std::unique_ptr<sql::PreparedStatement> del(conn->prepareStatement(
+                    "DELETE FROM " + table + " WHERE peer_key = ?"));
+                del->setInt64(1, peer_key);
+                del->executeUpdate();
+            }
+            for (const auto& [table, rows] : by_table) {
+                insertRows(conn, table, rows);
+            }
+            tx.Commit();
+            return Result<int>::OK(copied);
+        });
+    }
+
+private:
+    MsgReshardDAO() : MySqlDAO("MsgReshardDAO") {}
+
+    static constexpr const char* ROW_COLUMNS
+        = "msgid, from_uid, to_uid, peer_key, seq, msg_type, msg_ts, payload, "
+          "content, created_at";
+    static constexpr std::size_t INSERT_BATCH_ROWS = 100;
+
+    struct CopiedRow {
+        std::string msgid;
+        int         from_uid = 0;
+        int         to_uid   = 0;
+        int64_t     peer_key = 0;
+        int64_t     seq      = 0;
+        int         msg_type = 0;
+        int64_t     msg_ts   = 0;
+        bool        has_payload = false;
+        std::string payload;
+        std::string content;
+        std::string created_at;
+    };
+
+    static CopiedRow readRow(sql::ResultSet* res) {
+        CopiedRow row;
+        row.msgid       = res->getString("msgid").asStdString();
+        row.from_uid    = res->getInt("from_uid");
+        row.to_uid      = res->getInt("to_uid");
+        row.peer_key    = res->getInt64("peer_key");
+        row.seq         = res->getInt64("seq");
+        row.msg_type    = res->getInt("msg_type");
+        row.msg_ts      = res->getInt64("msg_ts");
+        row.has_payload = !res->isNull("payload");
+        if (row.has_payload) row.payload = res->getString("payload").asStdString();
+        row.content    = res->getString("content").asStdString();
+        row.created_at = res->getString("created_at").asStdString();
+        return row;
+    }
+
+    static void insertRows(
+        sql::Connection* conn, const std::string& table,
+        const std::vector<CopiedRow>& rows) {
+        for (std::size_t begin = 0; begin < rows.size(); begin += INSERT_BATCH_ROWS) {
+            std::size_t count = std::min(INSERT_BATCH_ROWS, rows.size() - begin);
+            std::string sql
+                = "INSERT INTO " + table + " (" + ROW_COLUMNS + ") VALUES ";
+            for (std::size_t i = 0; i < count; ++i) {
+                if (i > 0) sql += ',';
+                sql += "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+            }
+
+            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(sql));
+            unsigned int                            idx = 1;
+            for (std::size_t i = begin; i < begin + count; ++i) {
+                const auto& row = rows[i];
+                stmt->setString(idx++, row.msgid);
+                stmt->setInt(idx++, row.from_uid);
+                stmt->setInt(idx++, row.to_uid);
+                stmt->setInt64(idx++, row.peer_key);
+                stmt->setInt64(idx++, row.seq);
+                stmt->setInt(idx++, row.msg_type);
+                stmt->setInt64(idx++, row.msg_ts);
+                if (row.has_payload) {
+                    stmt->setString(idx++, row.payload);
+                } else {
+                    stmt->setNull(idx++, sql::DataType::LONGVARCHAR);
+                }
+                stmt->setString(idx++, row.content);
+                stmt->setString(idx++, row.created_at);
+            }
+            stmt->executeUpdate();
+        }
+    }
+};
+
+#endif   // MSGRESHARDDAO_H_
@@ -0,0 +1,237 @@
+// MsgSearchDAO.h
+#ifndef MSGSEARCHDAO_H_
+#define MSGSEARCHDAO_H_
+
+#include "common/MessageSearch.h"
+#include "common/result.h"
+#include "common/singleton.h"
+#include "dao/MySqlDAO.h"
+#include "infra/ConfigManager.h"
+#include "infra/LogManager.h"
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+struct SearchHit {
+    int64_t     id       = 0;
+    int         peer_uid = 0;
+    std::string msgid;
+    int         from_uid = 0;
+    int         to_uid   = 0;
+    int64_t     msg_ts   = 0;
+    std::string body;
+};
+
+// 一页检索结果，按 (msg_ts, id) 倒序；
+// has_more 时以最后一条的 (msg_ts, id) 作为下一页游标
+struct SearchPage {
+    std::vector<SearchHit> hits;
+    bool                   has_more = false;
+};
+
+// 聊天记录全文索引：chat_message_search_N，按 owner_uid 分表
+// （config.ini [MessageSearch]），表在第一次写入时按模板表创建
+class MsgSearchDAO : public SingleTon<MsgSearchDAO>, public MySqlDAO {
+    friend class SingleTon<MsgSearchDAO>;
+
+public:
+    static constexpr std::size_t INSERT_BATCH_ROWS = 100;
+    static constexpr int         ER_NO_SUCH_TABLE  = 1146;
+    static constexpr const char* TEMPLATE_TABLE
+        = "chat_message_search_template";
+
+    std::string TableFor(int owner_uid) const {
+        return MessageSearch::TableFor(_prefix, _shards, owner_uid);
+    }
+
+    // @brief: 写入索引文档；(owner_uid, msgid) 唯一，重复写入被忽略，
+    //         持久化重试或重建索引时可以直接重放
+    Result<void> indexDocuments(const std::vector<SearchDocument>& docs) {
+        std::map<std::string, std::vector<const SearchDocument*>> by_table;
+        for (const auto& doc : docs) {
+            by_table[TableFor(doc.owner_uid)].push_back(&doc);
+        }
+
+        for (const auto& [table_name, rows] : by_table) {
+            auto ensure_res = ensureTable(table_name);
+            if (!ensure_res.IsOK()) return ensure_res;
+
+            auto res = executeWithConn<void>([&](sql::Connection* conn,
+                                                 StatementCache&  stmts) {
+                for (std::size_t begin = 0; begin < rows.size();
+                     begin += INSERT_BATCH_ROWS) {
+                    std::size_t count
+                        = std::min(INSERT_BATCH_ROWS, rows.size() - begin);
+
+                    std::shared_ptr<sql::PreparedStatement> stmt;
+                    if (count == INSERT_BATCH_ROWS || count == 1) {
+                        stmt = stmts.Prepare(buildInsertSql(table_name, count));
+                    } else {
+                        stmt.reset(conn->prepareStatement(
+                            buildInsertSql(table_name, count)));
+                    }
+
+                    unsigned int idx = 1;
+                    for (std::size_t i = begin; i < begin + count; ++i) {
+                        const auto& doc = *rows[i];
+                        stmt->setInt(idx++, doc.owner_uid);
+                        stmt->setInt(idx++, doc.peer_uid);
+                        stmt->setString(idx++, doc.msgid);
+                        stmt->setInt(idx++, doc.from_uid);
+                        stmt->setInt(idx++, doc.to_uid);
+                        stmt->setInt64(idx++, doc.msg_ts);
+                        stmt->setString(idx++, doc.body);
+                    }
+                    stmt->executeUpdate();
+                }
+                return Result<void>::OK();
+            });
+            if (!res.IsOK()) {
+                LOG_ERROR(
+                    "Failed to index {} documents into {}",
+                    rows.size(),
+                    table_name);
+                return res;
+            }
+        }
+        return Result<void>::OK();
+    }
+
+    // @brief: 在 uid 的聊天记录中检索，
+    //         query 为 MessageSearch::BooleanQuery 的结果；
+    //         before_ts/before_id 为上一页最后一条的游标，首页传 0
+    Result<SearchPage> search(
+        int uid, const std::string& query, int64_t before_ts, int64_t before_id,
+        int limit) {
+        const std::string table_name = TableFor(uid);
+        if (before_ts <= 0) {
+            before_ts = INT64_MAX;
+            before_id = INT64_MAX;
+        }
+
+        return executeReadOnly<SearchPage>(
+            uid, [&](sql::Connection*, StatementCache& stmts) {
+                SearchPage                              page;
+                std::shared_ptr<sql::PreparedStatement> stmt;
+                try {
+                    // 全文索引先按词过滤，再按 owner_uid 与游标取一页；
+                    // 多取一条用来判断是否还有下一页
+                    stmt = stmts.Prepare(
+                        "SELECT id, peer_uid, msgid, from_uid, to_uid, msg_ts,"
+                        " body FROM " + table_name
+                        + " WHERE MATCH(body) AGAINST(? IN BOOLEAN MODE)"
+                          " AND owner_uid = ?"
+                          " AND (msg_ts < ? OR (msg_ts = ? AND id < ?))"
+                          " ORDER BY msg_ts DESC, id DESC LIMIT ?");
+                } catch (sql::SQLException& e) {
+                    // 该分表还没有写入过任何文档
+                    if (e.getErrorCode() == ER_NO_SUCH_TABLE) {
+                        return Result<SearchPage>::OK(page);
+                    }
+                    throw;
+                }
+                stmt->setString(1, query);
+                stmt->setInt(2, uid);
+                stmt->setInt64(3, before_ts);
+                stmt->setInt64(4, before_ts);
+                stmt->setInt64(5, before_id);
+                stmt->setInt(6, limit + 1);
+
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+                while (res->next()) {
+                    if (static_cast<int>(page.hits.size()) == limit) {
+                        page.has_more = true;
+                        break;
+                    }
+                    SearchHit hit;
+                    hit.id       = res->getInt64("id");
+                    hit.peer_uid = res->getInt("peer_uid");
+                    hit.msgid    = res->getString("msgid").asStdString();
+                    hit.from_uid = res->getInt("from_uid");
+                    hit.to_uid   = res->getInt("to_uid");
+                    hit.msg_ts   = res->getInt64("msg_ts");
+                    hit.body     = res->getString("body").asStdString();
+                    page.hits.push_back(std::move(hit));
+                }
+                return Result<SearchPage>::OK(page);
+            });
+    }
+
+    template<typename CompletionToken>
+    auto AsyncSearch(
+        int uid, std::string query, int64_t before_ts, int64_t before_id,
+        int limit, CompletionToken&& token) {
+        return asyncExecute<SearchPage>(
+            [this,
+             uid,
+             query = std::move(query),
+             before_ts,
+             before_id,
+             limit]() {
+                return search(uid, query, before_ts, before_id, limit);
+            },
+            std::forward<CompletionToken>(token));
+    }
+
+private:
+    MsgSearchDAO() : MySqlDAO("MsgSearchDAO") {
+        auto config = ConfigManager::getInstance();
+        auto prefix = (*config)["MessageSearch"]["prefix"];
+        auto shards = std::atoi((*config)["MessageSearch"]["shards"].c_str());
+        if (!prefix.empty()) _prefix = prefix;
+        if (shards > 0) _shards = shards;
+    }
+
+    Result<void> ensureTable(const std::string& table_name) {
+        {
+            std::lock_guard<std::mutex> lock(_tables_mutex);
+            if (_known_tables.count(table_name)) return Result<void>::OK();
+        }
+
+        auto res = executeWithConn<void>([&](sql::Connection* conn) {
+            std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+            stmt->execute(
+                "CREATE TABLE IF NOT EXISTS " + table_name + " LIKE "
+                + TEMPLATE_TABLE);
+            return Result<void>::OK();
+        });
+        if (res.IsOK()) {
+            std::lock_guard<std::mutex> lock(_tables_mutex);
+            _known_tables.insert(table_name);
+        }
+        return res;
+    }
+
+    static std::string
+    buildInsertSql(const std::string& table_name, std::size_t rows) {
+        std::string sql = "INSERT IGNORE INTO " + table_name
+                          + " (owner_uid, peer_uid, msgid, from_uid, to_uid, "
+                            "msg_ts, body) VALUES ";
+        sql.reserve(sql.size() + rows * 24);
+        for (std::size_t i = 0; i < rows; ++i) {
+            if (i > 0) sql += ',';
+            sql += "(?, ?, ?, ?, ?, ?, ?)";
+        }
+        return sql;
+    }
+
+    std::string _prefix = "chat_message_search";
+    int         _shards = 16;
+
+    std::mutex                      _tables_mutex;
+    std::unordered_set<std::string> _known_tables;
+};
+
+#endif   // MSGSEARCHDAO_H_
@@ -7,110 +7,238 @@
 #include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
 #include "infra/MySqlPool.h"
+#include "infra/MySqlPoolManager.h"
+#include "infra/StatementCache.h"
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
 #include <cppconn/connection.h>
+#include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <string>
 
-// RAII 守卫保持不变
+// RAII 守卫：借出池化连接，析构时归还；借连接超时时 get() 返回空
 class MySqlConnGuard {
 public:
-    MySqlConnGuard(MySqlPool* pool) : _pool(pool) {
-        _connection = _pool->getConnection();
+    MySqlConnGuard(MySqlPool* pool, MySqlPoolClient* client) : _pool(pool) {
+        _connection = _pool->getConnection(client, &_timed_out);
     }
     ~MySqlConnGuard() {
         if (_connection) {
             _pool->returnConnection(std::move(_connection));
         }
     }
-    sql::Connection* get() { return _connection.get(); }
+    sql::Connection* get() { return _connection ? _connection->conn.get() : nullptr; }
+    StatementCache&  statements() { return _connection->statements; }
+    bool             TimedOut() const { return _timed_out; }
+    // @brief: 标记连接可能已损坏，下次借出前先检查
+    void MarkSuspect() { _connection->suspect = true; }
 
 private:
-    MySqlPool*                       _pool;
-    std::unique_ptr<sql::Connection> _connection;
+    MySqlPool*                        _pool;
+    std::unique_ptr<PooledConnection> _connection;
+    bool                              _timed_out = false;
+};
+
+// 显式事务守卫：关闭自动提交，未 Commit 时析构回滚；
+// 无论成败都恢复自动提交，连接归还连接池时保持原状
+class TransactionGuard {
+public:
+    explicit TransactionGuard(sql::Connection* conn) : _conn(conn) {
+        _conn->setAutoCommit(false);
+    }
+    ~TransactionGuard() {
+        try {
+            if (!_committed) _conn->rollback();
+            _conn->setAutoCommit(true);
+        } catch (sql::SQLException& e) {
+            LOG_ERROR("Failed to finish transaction: {}", e.what());
+        }
+    }
+    void Commit() {
+        _conn->commit();
+        _committed = true;
+    }
+
+private:
+    sql::Connection* _conn;
+    bool             _committed = false;
 };
 
 // --- 基类 DAO ---
+// executeWithConn 总是在主库执行；只读查询用 executeReadOnly，
+// 配置了只读副本时按延迟分流到副本，写入后调用 markWritten 保证读己之写
+// 子类的 Async* 接口经 asyncExecute 把同名阻塞方法投递到 MySQL 工作线程，
+// 结果以 Result<T> 交给完成令牌（回调、bind_executor(strand, ...)、use_future）
 class MySqlDAO {
 public:
-    MySqlDAO() {
-        auto        globalConfig = ConfigManager::getInstance();
-        const auto& host         = (*globalConfig)["MySQL"]["host"];
-        const auto& port         = (*globalConfig)["MySQL"]["port"];
-        const auto& user         = (*globalConfig)["MySQL"]["user"];
-        const auto& passwd       = (*globalConfig)["MySQL"]["passwd"];
-        const auto& schema       = (*globalConfig)["MySQL"]["schema"];
-
-        // 格式化为 tcp://127.0.0.1:3306
-        std::string url = "tcp://" + host + ":" + port;
-
-        _pool.reset(new MySqlPool(url, user, passwd, schema, 5));
-        LOG_INFO("[MySQL] Pool initialized for URL: {}", url);
-    }
+    // @brief: name 用于在共享连接池中登记配额与统计（config.ini [MySQLQuota]）
+    explicit MySqlDAO(const std::string& name)
+        : _clients(MySqlPoolManager::getInstance()->RegisterClient(name)) {}
     virtual ~MySqlDAO() = default;
 
+    // @brief: 主库连接池的预编译语句缓存命中统计
+    StatementCacheStats GetStatementCacheStats() const {
+        return MySqlPoolManager::getInstance()->Primary().GetStatementCacheStats();
+    }
+
 protected:
+    // @brief: 本 DAO 可同时占用的连接数，并行查询据此控制并发度
+    std::size_t PoolSize() const { return _clients.primary->quota; }
+
     // 通用执行接口：处理存储过程或复杂逻辑
     // 回调函数接收一个原生的 sql::Connection*，由基类负责生命周期
     template<typename T>
     Result<T>
     executeWithConn(std::function<Result<T>(sql::Connection*)> handler) const {
-        try {
-            MySqlConnGuard   guard(_pool.get());
-            sql::Connection* conn = guard.get();
-            if (!conn) {
-                LOG_ERROR("[MySQL] Failed to get connection from pool.");
-                return Result<T>::Error(
-                    ErrorCodes::MYSQL_CONNECTION_ERROR);   // 约定 -1 为错误
-            }
-            return handler(conn);
-        } catch (sql::SQLException& e) {
-            LOG_ERROR(
-                "[MySQL] SQLException: {} Error Code: {}, SQLState: {}",
-                e.what(),
-                e.getErrorCode(),
-                e.getSQLState());
-            return Result<T>::Error(ErrorCodes::SQL_ERROR);
-        } catch (std::exception& e) {
-            LOG_ERROR("[MySQL] Standard Exception: {}", e.what());
-            return Result<T>::Error(ErrorCodes::SQL_STAND_EXCEPTION);
-        } catch (...) {
-            LOG_ERROR("[MySQL] Unknown exception occurred");
-            return Result<T>::Error(ErrorCodes::MYSQL_UNKNOWN_ERROR);
-        }
+        return run<T>(writeRoute(), [&](MySqlConnGuard& guard) {
+            return handler(guard.get());
+        });
+    }
+
+    // 同上，额外传入该连接的预编译语句缓存，SQL 文本固定的语句应通过
+    // statements.Prepare(sql) 获取，省去每次调用的服务端 prepare 往返
+    template<typename T>
+    Result<T> executeWithConn(
+        std::function<Result<T>(sql::Connection*, StatementCache&)> handler) const {
+        return run<T>(writeRoute(), [&](MySqlConnGuard& guard) {
+            return handler(guard.get(), guard.statements());
+        });
     }
 
     Result<void>
     executeWithConn(std::function<Result<void>(sql::Connection*)> handler) const {
+        return run<void>(writeRoute(), [&](MySqlConnGuard& guard) {
+            return handler(guard.get());
+        });
+    }
+
+    // 只读查询：uid 为这次读取所属的用户（其近期写入决定是否必须读主库），
+    // 与具体用户无关时传 0；副本借不到连接时退回主库
+    template<typename T>
+    Result<T> executeReadOnly(
+        int uid,
+        std::function<Result<T>(sql::Connection*, StatementCache&)> handler) const {
+        auto route = MySqlPoolManager::getInstance()->ReadRoute(_clients, uid);
+        auto fn    = [&](MySqlConnGuard& guard) {
+            return handler(guard.get(), guard.statements());
+        };
+        auto result = run<T>(route, fn);
+        if (route.replica >= 0 && isConnectionError(result.Error())) {
+            LOG_WARN("[MySQL] Replica {} unavailable, reading from primary", route.replica);
+            return run<T>(writeRoute(), fn);
+        }
+        return result;
+    }
+
+    // @brief: 写入成功后调用，随后一段时间内 uid 的只读查询走主库
+    void markWritten(int uid) const { MySqlPoolManager::getInstance()->MarkWrite(uid); }
+
+    // @brief: 在 MySQL 工作线程上执行 work，完成签名为 void(Result<T>)
+    //         回调在令牌关联的执行器上运行（保持调用方的 strand），
+    //         未关联执行器时直接在工作线程上回调；回调执行前保持该执行器的 work
+    //         work 仍是阻塞的 Connector/C++ 调用，执行期间占用一个工作线程：
+    //         它只让查询不再阻塞 io 线程，并不提高并发，同时在途的异步查询
+    //         最多 [MySQL] async_threads 个，其余在执行器队列中排队
+    template<typename T, typename CompletionToken>
+    static auto
+    asyncExecute(std::function<Result<T>()> work, CompletionToken&& token) {
+        return boost::asio::async_initiate<CompletionToken, void(Result<T>)>(
+            [](auto handler, std::function<Result<T>()> work) {
+                auto guard = boost::asio::make_work_guard(
+                    boost::asio::get_associated_executor(handler));
+                boost::asio::post(
+                    MySqlPoolManager::getInstance()->Executor(),
+                    [handler = std::move(handler),
+                     work    = std::move(work),
+                     guard   = std::move(guard)]() mutable {
+                        auto result   = work();
+                        auto executor = guard.get_executor();
+                        boost::asio::dispatch(
+                            executor,
+                            [handler = std::move(handler),
+                             result  = std::move(result)]() mutable {
+                                handler(std::move(result));
+                            });
+                        guard.reset();
+                    });
+            },
+            token,
+            std::move(work));
+    }
+
+
+private:
+    MySqlRoute writeRoute() const {
+        return MySqlPoolManager::getInstance()->WriteRoute(_clients);
+    }
+
+    static bool isConnectionError(ErrorCodes code) {
+        return code == ErrorCodes::MYSQL_POOL_TIMEOUT
+               || code == ErrorCodes::MYSQL_CONNECTION_ERROR;
+    }
+
+    static constexpr int CR_SERVER_GONE_ERROR = 2006;
+    static constexpr int CR_SERVER_LOST       = 2013;
+
+    // @brief: 异常是否由连接断开引起；语法错误、约束冲突等不影响连接本身
+    static bool isConnectionLost(const sql::SQLException& e) {
+        return e.getErrorCode() == CR_SERVER_GONE_ERROR
+               || e.getErrorCode() == CR_SERVER_LOST
+               || e.getSQLState().compare(0, 2, "08") == 0;
+    }
+
+    template<typename T>
+    Result<T> run(
+        const MySqlRoute&                                    route,
+        const std::function<Result<T>(MySqlConnGuard&)>& handler) const {
         try {
-            MySqlConnGuard   guard(_pool.get());
+            MySqlConnGuard   guard(route.pool, route.client);
             sql::Connection* conn = guard.get();
             if (!conn) {
                 LOG_ERROR("[MySQL] Failed to get connection from pool.");
-                return Result<void>::Error(
-                    ErrorCodes::MYSQL_CONNECTION_ERROR);   // 约定 -1 为错误
+                return Result<T>::Error(
+                    guard.TimedOut() ? ErrorCodes::MYSQL_POOL_TIMEOUT
+                                     : ErrorCodes::MYSQL_CONNECTION_ERROR);
+            }
+            auto start = std::chrono::steady_clock::now();
+            try {
+                auto result = handler(guard);
+                route.client->query.Record(std::chrono::steady_clock::now() - start);
+                return result;
+            } catch (sql::SQLException& e) {
+                route.client->query.Record(std::chrono::steady_clock::now() - start);
+                // 连接已断开时其上的预编译语句一并作废，下次重新 prepare；
+                // 借出前会先检查连接，断开则重连。其他错误保留缓存
+                if (isConnectionLost(e)) {
+                    guard.statements().Clear();
+                    guard.MarkSuspect();
+                }
+                throw;
             }
-            return handler(conn);
         } catch (sql::SQLException& e) {
             LOG_ERROR(
                 "[MySQL] SQLException: {} Error Code: {}, SQLState: {}",
                 e.what(),
                 e.getErrorCode(),
                 e.getSQLState());
-            return Result<void>::Error(ErrorCodes::SQL_ERROR);
+            return Result<T>::Error(ErrorCodes::SQL_ERROR);
         } catch (std::exception& e) {
             LOG_ERROR("[MySQL] Standard Exception: {}", e.what());
-            return Result<void>::Error(ErrorCodes::SQL_STAND_EXCEPTION);
+            return Result<T>::Error(ErrorCodes::SQL_STAND_EXCEPTION);
         } catch (...) {
             LOG_ERROR("[MySQL] Unknown exception occurred");
-            return Result<void>::Error(ErrorCodes::MYSQL_UNKNOWN_ERROR);
+            return Result<T>::Error(ErrorCodes::MYSQL_UNKNOWN_ERROR);
         }
     }
 
-
-private:
-    std::unique_ptr<MySqlPool> _pool;
+    MySqlClients _clients;
 };
 
 #endif
@@ -13,6 +13,8 @@
 #include <cppconn/resultset.h>
 #include <cppconn/statement.h>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 class UserDAO : public MySqlDAO, public SingleTon<UserDAO> {
@@ -23,6 +25,7 @@ public:
         const std::string& name, const std::string& email,
         const std::string& pwd) {
         return executeWithConn<int>([&](sql::Connection* con) {
+            // 存储过程调用会返回多个结果集，不放进语句缓存
             std::unique_ptr<sql::PreparedStatement> stmt(
                 con->prepareStatement("CALL reg_user(?,?,?,@result)"));
             stmt->setString(1, name);
@@ -49,9 +52,9 @@ public:
     }
 
     Result<std::string> FindEmailByName(const std::string& name) {
-        return executeWithConn<std::string>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
-                "SELECT email FROM user WHERE name = ?"));
+        return executeWithConn<std::string>([&](sql::Connection*,
+                                                StatementCache& stmts) {
+            auto stmt = stmts.Prepare("SELECT email FROM user WHERE name = ?");
             stmt->setString(1, name);
             std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
             while (res->next()) {
@@ -68,9 +71,9 @@ public:
 
     Result<void> ResetPwd(
         const std::string& name, const std::string& new_pass) const {
-        return executeWithConn<void>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
-                "UPDATE user SET pwd = ? WHERE name = ?"));
+        return executeWithConn<void>([&](sql::Connection*,
+                                         StatementCache& stmts) {
+            auto stmt = stmts.Prepare("UPDATE user SET pwd = ? WHERE name = ?");
             stmt->setString(1, new_pass);
             stmt->setString(2, name);
             auto res = stmt->executeUpdate();
@@ -85,9 +88,9 @@ public:
     }
 
     Result<UserInfo> FindUserByEmail(const std::string& email) const {
-        return executeWithConn<UserInfo>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement("SELECT * FROM user WHERE email = ?"));
+        return executeWithConn<UserInfo>([&](sql::Connection*,
+                                             StatementCache& stmts) {
+            auto stmt = stmts.Prepare("SELECT * FROM user WHERE email = ?");
             stmt->setString(1, email);
             std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
@@ -109,9 +112,9 @@ public:
     }
 
     Result<UserInfo> FindUserByUid(int uid) const {
-        return executeWithConn<UserInfo>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement("SELECT * FROM user WHERE uid = ?"));
+        return executeReadOnly<UserInfo>(uid, [&](sql::Connection*,
+                                                  StatementCache& stmts) {
+            auto stmt = stmts.Prepare("SELECT * FROM user WHERE uid = ?");
             stmt->setInt(1, uid);
             std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
             UserInfo                        userInfo;
@@ -132,11 +135,12 @@ public:
         });
     }
     Result<void> AddFriendApply(const int& from, const int& to) {
-        return executeWithConn<void>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
+        auto res = executeWithConn<void>([&](sql::Connection*,
+                                             StatementCache& stmts) {
+            auto stmt = stmts.Prepare(
                 "INSERT INTO friend_apply (from_uid, to_uid) values (?,?) "
                 "ON DUPLICATE KEY UPDATE from_uid = from_uid, to_uid = "
-                "to_uid "));
+                "to_uid ");
             stmt->setInt(1, from);
             stmt->setInt(2, to);
             std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
@@ -146,42 +150,46 @@ public:
                 return Result<void>::Error(ErrorCodes::APPLYFRIEND_ERROR);
             }
         });
+        if (res.IsOK()) {
+            markWritten(from);
+            markWritten(to);
+        }
+        return res;
     }
-    Result<std::vector<std::shared_ptr<ApplyInfo>>> GetApplyList(
+    Result<std::vector<ApplyInfo>> GetApplyList(
         int touid, int begin, int limit) {
-        return executeWithConn<std::vector<
-            std::shared_ptr<ApplyInfo>>>([&](sql::Connection* conn) {
-            std::vector<std::shared_ptr<ApplyInfo>> app_list;
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
-                "select apply.from_uid, apply.status, user.name, "
-                "user.nick, user.sex from friend_apply as apply join user on "
-                "apply.from_uid = user.uid where apply.to_uid = ? "
-                "and apply.id > ? order by apply.id ASC LIMIT ? "));
-            stmt->setInt(1, touid);
-            stmt->setInt(2, begin);
-            stmt->setInt(3, limit);
-            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
-            while (res->next()) {
-                auto name      = res->getString("name");
-                auto uid       = res->getInt("from_uid");
-                auto status    = res->getInt("status");
-                auto nick      = res->getString("nick");
-                auto sex       = res->getInt("sex");
-                auto apply_ptr = std::make_shared<ApplyInfo>(
-                    uid, name, "", "", nick, sex, status);
-                app_list.push_back(apply_ptr);
-            }
-            return Result<std::vector<std::shared_ptr<ApplyInfo>>>::OK(
-                app_list);
-        });
+        return executeReadOnly<std::vector<ApplyInfo>>(
+            touid, [&](sql::Connection*, StatementCache& stmts) {
+                std::vector<ApplyInfo> app_list;
+                auto                   stmt = stmts.Prepare(
+                    "select apply.from_uid, apply.status, user.name, "
+                    "user.nick, user.sex from friend_apply as apply "
+                    "join user on apply.from_uid = user.uid "
+                    "where apply.to_uid = ? "
+                    "and apply.id > ? order by apply.id ASC LIMIT ? ");
+                stmt->setInt(1, touid);
+                stmt->setInt(2, begin);
+                stmt->setInt(3, limit);
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+                while (res->next()) {
+                    auto name      = res->getString("name");
+                    auto uid       = res->getInt("from_uid");
+                    auto status    = res->getInt("status");
+                    auto nick      = res->getString("nick");
+                    auto sex       = res->getInt("sex");
+                    app_list.emplace_back(uid, name, "", "", nick, sex, status);
+                }
+                return Result<std::vector<ApplyInfo>>::OK(app_list);
+            });
     }
 
 
     Result<void> AuthFriendApply(const int& from, const int& to) {
-        return executeWithConn<void>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
+        auto res = executeWithConn<void>([&](sql::Connection*,
+                                             StatementCache& stmts) {
+            auto stmt = stmts.Prepare(
                 "UPDATE friend_apply SET status = 1 "
-                "WHERE from_uid = ? AND to_uid = ?"));
+                "WHERE from_uid = ? AND to_uid = ?");
             stmt->setInt(1, from);
             stmt->setInt(2, to);
             std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
@@ -191,69 +199,77 @@ public:
                 return Result<void>::Error(ErrorCodes::MYSQL_UNKNOWN_ERROR);
             }
         });
+        if (res.IsOK()) {
+            markWritten(from);
+            markWritten(to);
+        }
+        return res;
     }
 
     Result<void> AddFriend(
         const int& from, const int& to, const std::string& back_name) {
-        return executeWithConn<void>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt1(
-                conn->prepareStatement(
-                    "INSERT IGNORE INTO friend(self_id, friend_id, back) "
-                    "VALUES (?, ?, ?) "));
-            stmt1->setInt(1, from);
-            stmt1->setInt(2, to);
-            stmt1->setString(3, back_name);
-            std::unique_ptr<sql::ResultSet> res1(stmt1->executeQuery());
+        auto res = executeWithConn<void>([&](sql::Connection*,
+                                             StatementCache& stmts) {
+            // 双向关系复用同一条语句，第二次执行前先释放上一次的结果集
+            auto stmt = stmts.Prepare(
+                "INSERT IGNORE INTO friend(self_id, friend_id, back) "
+                "VALUES (?, ?, ?) ");
+            stmt->setInt(1, from);
+            stmt->setInt(2, to);
+            stmt->setString(3, back_name);
+            std::unique_ptr<sql::ResultSet> res1(stmt->executeQuery());
             if (!res1) {
                 return Result<void>::Error(ErrorCodes::MYSQL_UNKNOWN_ERROR);
             }
+            res1.reset();
 
-            std::unique_ptr<sql::PreparedStatement> stmt2(
-                conn->prepareStatement(
-                    "INSERT IGNORE INTO friend(self_id, friend_id, back) "
-                    "VALUES (?, ?, ?) "));
-            stmt2->setInt(1, to);
-            stmt2->setInt(2, from);
-            stmt2->setString(3, "");
-            std::unique_ptr<sql::ResultSet> res2(stmt2->executeQuery());
+            stmt->setInt(1, to);
+            stmt->setInt(2, from);
+            stmt->setString(3, "");
+            std::unique_ptr<sql::ResultSet> res2(stmt->executeQuery());
             if (!res2) {
                 return Result<void>::Error(ErrorCodes::MYSQL_UNKNOWN_ERROR);
             }
 
             return Result<void>::OK();
         });
+        if (res.IsOK()) {
+            markWritten(from);
+            markWritten(to);
+        }
+        return res;
     }
 
-    using ArrayUserInfo = std::vector<std::shared_ptr<UserInfo>>;
+    using ArrayUserInfo = std::vector<UserInfo>;
     Result<ArrayUserInfo> GetFriendList(int uid) {
-        return executeWithConn<ArrayUserInfo>([&](sql::Connection* conn) {
-            ArrayUserInfo                           user_info_list;
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
+        return executeReadOnly<ArrayUserInfo>(uid, [&](sql::Connection*,
+                                                       StatementCache& stmts) {
+            ArrayUserInfo user_info_list;
+            auto          stmt = stmts.Prepare(
                 "select user.uid, user.name, user.email, user.nick, "
                 "user.desc, user.sex, user.icon,  friend.back as "
                 "remark from friend join user on friend.friend_id = user.uid "
-                "where friend.self_id = ? "));
+                "where friend.self_id = ? ");
             stmt->setInt(1, uid);
             std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
             while (res->next()) {
-                auto user_info   = std::make_shared<UserInfo>();
-                user_info->uid   = res->getInt("uid");
-                user_info->name  = res->getString("name");
-                user_info->email = res->getString("email");
-                user_info->nick  = res->getString("nick");
-                user_info->desc  = res->getString("desc");
-                user_info->sex   = res->getInt("sex");
-                user_info->icon  = res->getString("icon");
-                user_info_list.push_back(user_info);
+                auto& user_info = user_info_list.emplace_back();
+                user_info.uid   = res->getInt("uid");
+                user_info.name  = res->getString("name");
+                user_info.email = res->getString("email");
+                user_info.nick  = res->getString("nick");
+                user_info.desc  = res->getString("desc");
+                user_info.sex   = res->getInt("sex");
+                user_info.icon  = res->getString("icon");
             }
             return Result<ArrayUserInfo>::OK(user_info_list);
         });
     }
 
     Result<void> UpdateUserIcon(int uid, const std::string& icon) {
-        return executeWithConn<void>([&](sql::Connection* conn) {
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
-                "UPDATE user SET icon = ? WHERE uid = ?"));
+        auto res = executeWithConn<void>([&](sql::Connection*,
+                                             StatementCache& stmts) {
+            auto stmt = stmts.Prepare("UPDATE user SET icon = ? WHERE uid = ?");
             stmt->setString(1, icon);
             stmt->setInt(2, uid);
 
@@ -262,19 +278,108 @@ public:
 
             return Result<void>::Error(ErrorCodes::MYSQL_UNKNOWN_ERROR);
         });
+        if (res.IsOK()) {
+            markWritten(uid);
+        }
+        return res;
     }
 
     Result<std::vector<int>> FindFriendOwnersByFriendId(int friend_id) {
-        return executeWithConn<std::vector<int>>([&](sql::Connection* conn) {
-            std::vector<int>                        owners;
-            std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(
-                "SELECT self_id FROM friend WHERE friend_id = ? "));
-            stmt->setInt(1, friend_id);
-            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
-            while (res->next()) owners.push_back(res->getInt("self_id"));
-            return Result<std::vector<int>>::OK(owners);
-        });
+        return executeReadOnly<std::vector<int>>(
+            friend_id, [&](sql::Connection*, StatementCache& stmts) {
+                std::vector<int> owners;
+                auto             stmt = stmts.Prepare(
+                    "SELECT self_id FROM friend WHERE friend_id = ? ");
+                stmt->setInt(1, friend_id);
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+                while (res->next()) owners.push_back(res->getInt("self_id"));
+                return Result<std::vector<int>>::OK(owners);
+            });
+    }
+
+    // --- 异步接口 ---
+    // 与同名阻塞方法等价，在 MySQL 工作线程上执行，
+    // 结果 Result<T> 交给完成令牌；阻塞方法保留给尚未迁移的调用方
+    template<typename CompletionToken>
+    auto AsyncFindUserByUid(int uid, CompletionToken&& token) const {
+        return asyncExecute<UserInfo>(
+            [this, uid]() { return FindUserByUid(uid); },
+            std::forward<CompletionToken>(token));
     }
+
+    template<typename CompletionToken>
+    auto
+    AsyncFindUserByEmail(std::string email, CompletionToken&& token) const {
+        return asyncExecute<UserInfo>(
+            [this, email = std::move(email)]() {
+                return FindUserByEmail(email);
+            },
+            std::forward<CompletionToken>(token));
+    }
+
+    template<typename CompletionToken>
+    auto AsyncGetApplyList(
+        int touid, int begin, int limit, CompletionToken&& token) {
+        return asyncExecute<std::vector<ApplyInfo>>(
+            [this, touid, begin, limit]() {
+                return GetApplyList(touid, begin, limit);
+            },
+            std::forward<CompletionToken>(token));
+    }
+
+    template<typename CompletionToken>
+    auto AsyncGetFriendList(int uid, CompletionToken&& token) {
+        return asyncExecute<ArrayUserInfo>(
+            [this, uid]() { return GetFriendList(uid); },
+            std::forward<CompletionToken>(token));
+    }
+
+    template<typename CompletionToken>
+    auto
+    AsyncFindFriendOwnersByFriendId(int friend_id, CompletionToken&& token) {
+        return asyncExecute<std::vector<int>>(
+            [this, friend_id]() {
+                return FindFriendOwnersByFriendId(friend_id);
+            },
+            std::forward<CompletionToken>(token));
+    }
+
+    template<typename CompletionToken>
+    auto AsyncAddFriendApply(int from, int to, CompletionToken&& token) {
+        return asyncExecute<void>(
+            [this, from, to]() { return AddFriendApply(from, to); },
+            std::forward<CompletionToken>(token));
+    }
+
+    template<typename CompletionToken>
+    auto AsyncAuthFriendApply(int from, int to, CompletionToken&& token) {
+        return asyncExecute<void>(
+            [this, from, to]() { return AuthFriendApply(from, to); },
+            std::forward<CompletionToken>(token));
+    }
+
+    template<typename CompletionToken>
+    auto AsyncAddFriend(
+        int from, int to, std::string back_name, CompletionToken&& token) {
+        return asyncExecute<void>(
+            [this, from, to, back_name = std::move(back_name)]() {
+                return AddFriend(from, to, back_name);
+            },
+            std::forward<CompletionToken>(token));
+    }
+
+    template<typename CompletionToken>
+    auto
+    AsyncUpdateUserIcon(int uid, std::string icon, CompletionToken&& token) {
+        return asyncExecute<void>(
+            [this, uid, icon = std::move(icon)]() {
+                return UpdateUserIcon(uid, icon);
+            },
+            std::forward<CompletionToken>(token));
+    }
+
+private:
+    UserDAO() : MySqlDAO("UserDAO") {}
 };
 
 
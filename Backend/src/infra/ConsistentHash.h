@@ -0,0 +1,59 @@
+#ifndef CONSISTENTHASH_H_
+#define CONSISTENTHASH_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// 一致性哈希环：每个节点放 VIRTUAL_NODES 个虚拟节点，增删节点时只迁移约 1/N 的 key
+// key 中含 {tag} 时只对 tag 部分哈希（与 Redis Cluster 的 hash tag 规则一致），
+// 需要落在同一节点上的多个 key（如 Lua 脚本的 KEYS）用相同的 tag 即可
+class ConsistentHashRing {
+public:
+    static constexpr int VIRTUAL_NODES = 160;
+
+    explicit ConsistentHashRing(const std::vector<std::string>& nodes = {}) {
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            for (int v = 0; v < VIRTUAL_NODES; ++v) {
+                _ring[Hash(nodes[i] + "#" + std::to_string(v))] = i;
+            }
+        }
+    }
+
+    // @brief: key 所属节点下标；环为空时返回 0
+    std::size_t NodeOf(const std::string& key) const {
+        if (_ring.empty()) return 0;
+        auto it = _ring.lower_bound(Hash(HashTag(key)));
+        if (it == _ring.end()) it = _ring.begin();
+        return it->second;
+    }
+
+    // @brief: 取出参与哈希的部分：第一个 '{' 与其后第一个 '}' 之间的非空内容，否则整个 key
+    static std::string HashTag(const std::string& key) {
+        auto open = key.find('{');
+        if (open == std::string::npos) return key;
+        auto close = key.find('}', open + 1);
+        if (close == std::string::npos || close == open + 1) return key;
+        return key.substr(open + 1, close - open - 1);
+    }
+
+    // FNV-1a 64，跨进程、跨编译器稳定（std::hash 不保证）
+    static uint64_t Hash(const std::string& data) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        // 末尾再混合一次，改善相近字符串（node#1, node#2）在环上的分布
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+private:
+    std::map<uint64_t, std::size_t> _ring;
+};
+
+#endif   // CONSISTENTHASH_H_
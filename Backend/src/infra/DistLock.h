@@ -1,8 +1,9 @@
 #ifndef DISTLOCK_H_
 #define DISTLOCK_H_
 
+#include <chrono>
 #include <string>
-#include "infra/RedisManager.h"
+#include "infra/LockService.h"
 
 class DistLock {
 public:
@@ -10,28 +11,27 @@ public:
      * @brief 构造函数，在创建时尝试获取分布式锁
      * @param lock_name 锁的名称 (例如， "user_kick:12345")
      * @param lock_timeout 锁的自动过期时间（秒）。防止死锁。
-     * @param acquire_timeout 获取锁的超时时间（秒）。在这段时间内会不断尝试。
+     * @param acquire_timeout 获取锁的超时时间（秒）。等待期间由释放通知唤醒，不轮询。
+     * @param auto_extend 持有期间是否自动续期，适合耗时不确定的临界区
      */
     DistLock(
         const std::string& lock_name, int lock_timeout = 10,
-        int acquire_timeout = 5)
-        : _lock_name(lock_name), _is_locked(false) {
+        int acquire_timeout = 5, bool auto_extend = false)
+        : _grant(LockService::getInstance()->Acquire(
+              lock_name, std::chrono::seconds(lock_timeout),
+              std::chrono::seconds(acquire_timeout), auto_extend)) {}
 
-        auto redis = RedisManager::getInstance();
-        _lock_id = redis->AcquireLock(lock_name, lock_timeout, acquire_timeout);
-
-        if (!_lock_id.empty()) {
-            _is_locked = true;
-        }
-    }
+    /**
+     * @brief 接管一个已获得的锁凭证（例如 TryAcquire / AcquireAsync 的结果）
+     */
+    explicit DistLock(LockGrant grant) : _grant(std::move(grant)) {}
 
     /**
      * @brief 析构函数，如果持有锁，则自动释放
      */
     ~DistLock() {
-        if (_is_locked) {
-            auto redis = RedisManager::getInstance();
-            redis->ReleaseLock(_lock_name, _lock_id);
+        if (_grant.ok()) {
+            LockService::getInstance()->Release(_grant);
         }
     }
 
@@ -39,7 +39,12 @@ public:
      * @brief 检查是否成功获取了锁
      * @return true 如果持有锁, false 如果获取失败
      */
-    bool isLocked() const { return _is_locked; }
+    bool isLocked() const { return _grant.ok(); }
+
+    /**
+     * @brief fencing token，写共享资源时带上，供下游拒绝过期持有者的写入
+     */
+    int64_t fencingToken() const { return _grant.token; }
 
     // --- 禁止拷贝和移动，锁的上下文是唯一的 ---
     DistLock(const DistLock&)            = delete;
@@ -48,9 +53,7 @@ public:
     DistLock& operator=(DistLock&&)      = delete;
 
 private:
-    std::string _lock_name;
-    std::string _lock_id;
-    bool        _is_locked;
+    LockGrant _grant;
 };
 
 
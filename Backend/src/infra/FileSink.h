@@ -0,0 +1,81 @@
+#ifndef FILESINK_H_
+#define FILESINK_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// 上传文件的定位写入端
+// 每次写入用 pwrite 指定偏移，续传不依赖追加模式和 seekp；
+// 打开时按声明的总大小预留磁盘空间（不改变文件长度），写入过程中不再逐块分配；
+// 何时 fdatasync 由 SyncPolicy 决定，统计写调用次数和 fdatasync 耗时
+class FileSink {
+public:
+    enum class SyncPolicy {
+        NONE,         // 只写入页缓存，由内核回写
+        CHECKPOINT,   // 每个断点和关闭时 fdatasync，断点记录的数据保证已落盘
+        CLOSE,        // 只在关闭时 fdatasync
+    };
+
+    struct Options {
+        SyncPolicy sync        = SyncPolicy::CHECKPOINT;
+        bool       preallocate = true;
+    };
+
+    struct Stats {
+        int64_t bytes       = 0;   // 写入的数据字节数
+        int64_t write_calls = 0;   // pwrite 调用次数
+        int     sync_count  = 0;
+        double  sync_ms     = 0;   // fdatasync 累计耗时
+        double  max_sync_ms = 0;
+
+        double WriteCallsPerMB() const {
+            return bytes > 0 ? write_calls / (bytes / (1024.0 * 1024.0)) : 0;
+        }
+        double AvgSyncMs() const {
+            return sync_count > 0 ? sync_ms / sync_count : 0;
+        }
+    };
+
+    // @brief: "none" / "checkpoint" / "close"，无法识别时返回 CHECKPOINT
+    static SyncPolicy ParseSyncPolicy(const std::string& value);
+
+    // @brief: 打开 path 并从 offset 处继续写，offset 之后的旧数据被截掉；
+    //         开启预分配时预留到 total_size；失败返回 nullptr
+    static std::unique_ptr<FileSink> Open(
+        const std::string& path, int64_t offset, int64_t total_size,
+        const Options& options);
+    // @brief: 打开 path 按块定位写入，不截断已有数据；
+    //         开启预分配时预留 [0, total_size)；失败返回 nullptr
+    static std::unique_ptr<FileSink> OpenForBlocks(
+        const std::string& path, int64_t total_size, const Options& options);
+    ~FileSink();
+
+    // @brief: 在当前偏移写入并前移偏移，处理短写和 EINTR
+    bool Write(const char* data, std::size_t size);
+    // @brief: 从 offset 处写入，之后的 Write 从写完的位置继续
+    bool WriteAt(int64_t offset, const char* data, std::size_t size);
+    // @brief: 到达断点，CHECKPOINT 策略下 fdatasync
+    bool Checkpoint();
+    // @brief: 按策略 fdatasync 后关闭，重复调用无副作用
+    bool Close();
+
+    int64_t      Offset() const { return _offset; }
+    const Stats& GetStats() const { return _stats; }
+    // @brief: 最近一次写入或 fdatasync 失败时的 errno，未失败为 0
+    int LastError() const { return _last_errno; }
+
+private:
+    FileSink(int fd, int64_t offset, const Options& options);
+    bool sync();
+    static void preallocate(
+        int fd, const std::string& path, int64_t offset, int64_t total_size);
+
+    int     _fd;
+    int64_t _offset;
+    Options _options;
+    Stats   _stats;
+    int     _last_errno = 0;
+};
+
+#endif   // FILESINK_H_
@@ -0,0 +1,76 @@
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+struct LatencySnapshot {
+    static constexpr std::size_t BUCKETS = 32;
+
+    uint64_t                          count  = 0;
+    uint64_t                          sum_us = 0;
+    uint64_t                          max_us = 0;
+    std::array<uint64_t, BUCKETS>     buckets{};
+
+    double mean_us() const {
+        return count == 0 ? 0.0 : static_cast<double>(sum_us) / count;
+    }
+
+    // @brief: 分位数的上界估计（所在桶的上界，不超过观测到的最大值）
+    uint64_t percentile_us(double p) const {
+        if (count == 0) return 0;
+        auto     rank = static_cast<uint64_t>(p * count);
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen > rank) {
+                uint64_t upper = (uint64_t{1} << i) - 1;
+                return upper < max_us ? upper : max_us;
+            }
+        }
+        return max_us;
+    }
+};
+
+// 无锁耗时直方图，按微秒取 2 的幂分桶：桶 i 覆盖 [2^(i-1), 2^i) us
+// 多线程并发 Record，只用于统计，计数之间不要求强一致
+class LatencyHistogram {
+public:
+    void Record(std::chrono::steady_clock::duration elapsed) {
+        auto us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        std::size_t bucket = 0;
+        while (bucket + 1 < LatencySnapshot::BUCKETS && (us >> bucket) != 0) {
+            ++bucket;
+        }
+        _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum_us.fetch_add(us, std::memory_order_relaxed);
+
+        uint64_t prev = _max_us.load(std::memory_order_relaxed);
+        while (us > prev
+               && !_max_us.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    LatencySnapshot Snapshot() const {
+        LatencySnapshot snap;
+        snap.count  = _count.load(std::memory_order_relaxed);
+        snap.sum_us = _sum_us.load(std::memory_order_relaxed);
+        snap.max_us = _max_us.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < LatencySnapshot::BUCKETS; ++i) {
+            snap.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, LatencySnapshot::BUCKETS> _buckets{};
+    std::atomic<uint64_t>                                        _count{0};
+    std::atomic<uint64_t>                                        _sum_us{0};
+    std::atomic<uint64_t>                                        _max_us{0};
+};
+
+#endif   // LATENCYHISTOGRAM_H_
@@ -0,0 +1,392 @@
+#include "LockService.h"
+#include "LogManager.h"
+#include "RedisManager.h"
+#include "RedisScripts.h"
+#include "hiredis.h"
+#include <algorithm>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <sys/socket.h>
+#include <vector>
+
+namespace {
+
+const std::string LOCK_PREFIX       = "lock:";
+const std::string FENCE_PREFIX      = "lock:fence:";
+const std::string RELEASE_CHANNEL   = "lock:released";
+
+// 订阅不可用时的兜底轮询间隔
+constexpr std::chrono::milliseconds FALLBACK_POLL{50};
+
+}   // namespace
+
+LockService::LockService() {
+    _shard_count = RedisManager::getInstance()->ShardCount();
+    _conns.assign(_shard_count, nullptr);
+    for (std::size_t shard = 0; shard < _shard_count; ++shard) {
+        _subscribe_threads.emplace_back([this, shard]() { subscribeLoop(shard); });
+    }
+    _worker_thread = std::thread([this]() { workerLoop(); });
+    LOG_INFO("[LockService] started");
+}
+
+LockService::~LockService() {
+    Stop();
+}
+
+void LockService::Stop() {
+    if (_stop.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lock(_conn_mutex);
+        for (auto* conn : _conns) {
+            if (conn) shutdown(conn->fd, SHUT_RDWR);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cv.notify_all();
+    }
+    for (auto& thread : _subscribe_threads) {
+        if (thread.joinable()) thread.join();
+    }
+    if (_worker_thread.joinable()) _worker_thread.join();
+}
+
+std::string LockService::lockKey(const std::string& name) {
+    return LOCK_PREFIX + name;
+}
+
+std::string LockService::newLockId() {
+    thread_local boost::uuids::random_generator generator;
+    return boost::uuids::to_string(generator());
+}
+
+int64_t LockService::tryOnce(
+    const std::string& name, const std::string& id,
+    std::chrono::milliseconds lease, std::chrono::milliseconds& wait_hint) {
+    long long result = 0;
+    if (!RedisManager::getInstance()->EvalScript(
+            RedisScripts::ACQUIRE_LOCK,
+            {lockKey(name), FENCE_PREFIX + name},
+            {id, std::to_string(lease.count())},
+            result)) {
+        wait_hint = FALLBACK_POLL;
+        return 0;
+    }
+    if (result > 0) {
+        return result;
+    }
+    wait_hint = std::chrono::milliseconds(-result - 1);
+    return 0;
+}
+
+std::chrono::milliseconds LockService::retryDelay(
+    std::chrono::milliseconds wait_hint) const {
+    // 订阅正常时主要靠释放通知唤醒，剩余 TTL 只用来覆盖持有者崩溃、锁自然过期的情况
+    auto delay = std::max(wait_hint, std::chrono::milliseconds(1));
+    if (_subscribed_shards.load(std::memory_order_acquire) < _shard_count) {
+        delay = std::min(delay, FALLBACK_POLL);
+    }
+    return delay;
+}
+
+LockGrant LockService::TryAcquire(
+    const std::string& name, std::chrono::milliseconds lease,
+    bool auto_extend) {
+    LockGrant                 grant{name, newLockId(), 0};
+    std::chrono::milliseconds wait_hint{0};
+    grant.token = tryOnce(name, grant.id, lease, wait_hint);
+    if (grant.ok() && auto_extend) {
+        addLease(grant, lease);
+    }
+    return grant;
+}
+
+LockGrant LockService::Acquire(
+    const std::string& name, std::chrono::milliseconds lease,
+    std::chrono::milliseconds timeout, bool auto_extend) {
+    LockGrant   grant{name, newLockId(), 0};
+    std::string key      = lockKey(name);
+    auto        deadline = std::chrono::steady_clock::now() + timeout;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    registerWaiterLocked(key);
+    while (!_stop.load()) {
+        // 先记下代数再尝试，失败后等待期间的释放通知不会丢
+        uint64_t generation = generationLocked(key);
+        lock.unlock();
+
+        std::chrono::milliseconds wait_hint{0};
+        grant.token = tryOnce(name, grant.id, lease, wait_hint);
+
+        lock.lock();
+        auto now = std::chrono::steady_clock::now();
+        if (grant.ok() || now >= deadline) {
+            break;
+        }
+
+        auto wait_until = std::min(deadline, now + retryDelay(wait_hint));
+        _cv.wait_until(lock, wait_until, [&]() {
+            return _stop.load() || generationLocked(key) != generation;
+        });
+    }
+    unregisterWaiterLocked(key);
+    lock.unlock();
+
+    if (grant.ok() && auto_extend) {
+        addLease(grant, lease);
+    }
+    return grant;
+}
+
+void LockService::AcquireAsync(
+    const std::string& name, std::chrono::milliseconds lease,
+    std::chrono::milliseconds timeout, AcquireCallback callback,
+    bool auto_extend) {
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    registerWaiterLocked(lockKey(name));
+    _async_waiters.push_back(AsyncWaiter{
+        name,
+        newLockId(),
+        lease,
+        now + timeout,
+        now,
+        generationLocked(lockKey(name)),
+        auto_extend,
+        std::move(callback)});
+    _cv.notify_all();
+}
+
+bool LockService::Release(const LockGrant& grant) {
+    if (!grant.ok()) return false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _leases.erase(grant.id);
+    }
+
+    long long deleted = 0;
+    if (!RedisManager::getInstance()->EvalScript(
+            RedisScripts::RELEASE_LOCK,
+            {lockKey(grant.name)},
+            {grant.id, RELEASE_CHANNEL},
+            deleted)) {
+        return false;
+    }
+    if (deleted != 1) {
+        LOG_WARN(
+            "[LockService] lock {} (token {}) already expired before release",
+            grant.name,
+            grant.token);
+    }
+    return deleted == 1;
+}
+
+bool LockService::Extend(
+    const LockGrant& grant, std::chrono::milliseconds lease) {
+    if (!grant.ok()) return false;
+    long long extended = 0;
+    if (!RedisManager::getInstance()->EvalScript(
+            RedisScripts::EXTEND_LOCK,
+            {lockKey(grant.name)},
+            {grant.id, std::to_string(lease.count())},
+            extended)) {
+        return false;
+    }
+    return extended == 1;
+}
+
+void LockService::registerWaiterLocked(const std::string& key) {
+    _waiting[key].waiters++;
+}
+
+void LockService::unregisterWaiterLocked(const std::string& key) {
+    auto it = _waiting.find(key);
+    if (it != _waiting.end() && --it->second.waiters <= 0) {
+        _waiting.erase(it);
+    }
+}
+
+uint64_t LockService::generationLocked(const std::string& key) const {
+    auto it = _waiting.find(key);
+    return it == _waiting.end() ? 0 : it->second.generation;
+}
+
+void LockService::addLease(
+    const LockGrant& grant, std::chrono::milliseconds lease) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _leases[grant.id] = Lease{
+        grant.name, lease, std::chrono::steady_clock::now() + lease / 3};
+    _cv.notify_all();
+}
+
+void LockService::onReleased(const std::string& key) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _waiting.find(key);
+    if (it == _waiting.end()) return;
+    it->second.generation++;
+    _cv.notify_all();
+}
+
+redisContext* LockService::connectSubscriber(std::size_t shard) {
+    redisContext* context
+        = RedisManager::getInstance()->NewDedicatedConnection(shard);
+    if (context == nullptr) return nullptr;
+
+    auto* reply = (redisReply*) redisCommand(
+        context, "SUBSCRIBE %s", RELEASE_CHANNEL.c_str());
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
+        LOG_ERROR("[LockService] SUBSCRIBE {} failed", RELEASE_CHANNEL);
+        if (reply) freeReplyObject(reply);
+        redisFree(context);
+        return nullptr;
+    }
+    freeReplyObject(reply);
+    return context;
+}
+
+void LockService::subscribeLoop(std::size_t shard) {
+    while (!_stop.load()) {
+        redisContext* context = connectSubscriber(shard);
+        if (context == nullptr) {
+            for (int i = 0; i < 10 && !_stop.load(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_conn_mutex);
+            _conns[shard] = context;
+        }
+        _subscribed_shards.fetch_add(1, std::memory_order_acq_rel);
+
+        while (!_stop.load()) {
+            void* raw = nullptr;
+            if (redisGetReply(context, &raw) != REDIS_OK) {
+                break;
+            }
+            auto* reply = static_cast<redisReply*>(raw);
+            // ["message", channel, lock key]
+            if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 3
+                && reply->element[2]->str != nullptr) {
+                onReleased(
+                    std::string(reply->element[2]->str, reply->element[2]->len));
+            }
+            freeReplyObject(reply);
+        }
+
+        _subscribed_shards.fetch_sub(1, std::memory_order_acq_rel);
+        {
+            std::lock_guard<std::mutex> lock(_conn_mutex);
+            _conns[shard] = nullptr;
+        }
+        redisFree(context);
+        {
+            // 等待者改用兜底轮询间隔
+            std::lock_guard<std::mutex> lock(_mutex);
+            _cv.notify_all();
+        }
+        if (!_stop.load()) {
+            LOG_WARN(
+                "[LockService] release channel on shard {} lost, falling back "
+                "to polling",
+                shard);
+        }
+    }
+}
+
+void LockService::workerLoop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop.load()) {
+        auto now       = std::chrono::steady_clock::now();
+        auto next_wake = now + std::chrono::seconds(1);
+
+        // 1. 取出需要重试的异步等待者
+        std::vector<AsyncWaiter> ready;
+        for (auto it = _async_waiters.begin(); it != _async_waiters.end();) {
+            auto key = lockKey(it->name);
+            if (it->next_try <= now || it->deadline <= now
+                || generationLocked(key) != it->generation) {
+                ready.push_back(std::move(*it));
+                it = _async_waiters.erase(it);
+            } else {
+                next_wake = std::min(next_wake, std::min(it->next_try, it->deadline));
+                ++it;
+            }
+        }
+
+        // 2. 取出到期需要续期的锁
+        std::vector<LockGrant> renew;
+        for (auto& [id, lease] : _leases) {
+            if (lease.next_renew <= now) {
+                renew.push_back(LockGrant{lease.name, id, 1});
+                lease.next_renew = now + lease.lease / 3;
+            }
+            next_wake = std::min(next_wake, lease.next_renew);
+        }
+
+        if (ready.empty() && renew.empty()) {
+            _cv.wait_until(lock, next_wake);
+            continue;
+        }
+
+        lock.unlock();
+        for (auto& grant : renew) {
+            std::chrono::milliseconds lease{0};
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                auto                        it = _leases.find(grant.id);
+                if (it == _leases.end()) continue;   // 期间已释放
+                lease = it->second.lease;
+            }
+            if (!Extend(grant, lease)) {
+                LOG_WARN("[LockService] lost lease of lock {}", grant.name);
+                std::lock_guard<std::mutex> guard(_mutex);
+                _leases.erase(grant.id);
+            }
+        }
+
+        std::vector<AsyncWaiter> pending;
+        for (auto& waiter : ready) {
+            std::chrono::milliseconds wait_hint{0};
+            uint64_t                  generation = 0;
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                generation = generationLocked(lockKey(waiter.name));
+            }
+
+            LockGrant grant{waiter.name, waiter.id, 0};
+            grant.token = tryOnce(waiter.name, waiter.id, waiter.lease, wait_hint);
+            auto now_after = std::chrono::steady_clock::now();
+            if (grant.ok() || now_after >= waiter.deadline) {
+                {
+                    std::lock_guard<std::mutex> guard(_mutex);
+                    unregisterWaiterLocked(lockKey(waiter.name));
+                }
+                if (grant.ok() && waiter.auto_extend) {
+                    addLease(grant, waiter.lease);
+                }
+                waiter.callback(grant);
+                continue;
+            }
+
+            waiter.generation = generation;
+            waiter.next_try   = now_after + retryDelay(wait_hint);
+            pending.push_back(std::move(waiter));
+        }
+        lock.lock();
+        for (auto& waiter : pending) {
+            _async_waiters.push_back(std::move(waiter));
+        }
+    }
+
+    // 停止时未完成的异步请求统一回调失败
+    std::list<AsyncWaiter> remaining;
+    remaining.swap(_async_waiters);
+    lock.unlock();
+    for (auto& waiter : remaining) {
+        waiter.callback(LockGrant{waiter.name, waiter.id, 0});
+    }
+}
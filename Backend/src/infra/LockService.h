@@ -0,0 +1,127 @@
+#ifndef LOCKSERVICE_H_
+#define LOCKSERVICE_H_
+
+#include "common/singleton.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct redisContext;
+
+// 一次成功加锁的凭证
+struct LockGrant {
+    std::string name;        // 锁名称（不含 lock: 前缀）
+    std::string id;          // 本次持有者标识，释放/续期时校验
+    int64_t     token = 0;   // fencing token，同一把锁单调递增；0 表示未获得锁
+
+    bool ok() const { return token > 0; }
+};
+
+// 基于 Redis 的分布式锁服务
+// - 加锁: 一次 Lua 脚本完成 SET NX PX + INCR fencing 计数
+// - 等待: 订阅释放频道，锁被释放时立即唤醒；订阅断开或锁过期时按剩余 TTL 兜底重试
+// - 续期: auto_extend 的锁由后台线程每 1/3 租期续一次
+class LockService : public SingleTon<LockService> {
+    friend class SingleTon<LockService>;
+
+public:
+    using AcquireCallback = std::function<void(LockGrant)>;
+
+    ~LockService();
+
+    // @brief: 非阻塞尝试加锁，失败立即返回空凭证
+    LockGrant TryAcquire(
+        const std::string& name, std::chrono::milliseconds lease,
+        bool auto_extend = false);
+
+    // @brief: 阻塞加锁，最多等待 timeout
+    LockGrant Acquire(
+        const std::string& name, std::chrono::milliseconds lease,
+        std::chrono::milliseconds timeout, bool auto_extend = false);
+
+    // @brief: 异步加锁，立即返回；成功或超时后在锁服务线程上回调
+    //         （回调内不要做阻塞操作）
+    void AcquireAsync(
+        const std::string& name, std::chrono::milliseconds lease,
+        std::chrono::milliseconds timeout, AcquireCallback callback,
+        bool auto_extend = false);
+
+    // @brief: 释放锁并通知等待者
+    bool Release(const LockGrant& grant);
+
+    // @brief: 手动续期
+    bool Extend(const LockGrant& grant, std::chrono::milliseconds lease);
+
+    void Stop();
+
+private:
+    LockService();
+
+    struct Waiting {
+        uint64_t generation = 0;
+        int      waiters    = 0;
+    };
+
+    struct AsyncWaiter {
+        std::string                           name;
+        std::string                           id;
+        std::chrono::milliseconds             lease;
+        std::chrono::steady_clock::time_point deadline;
+        std::chrono::steady_clock::time_point next_try;
+        uint64_t                              generation;
+        bool                                  auto_extend;
+        AcquireCallback                       callback;
+    };
+
+    struct Lease {
+        std::string                           name;
+        std::chrono::milliseconds             lease;
+        std::chrono::steady_clock::time_point next_renew;
+    };
+
+    static std::string lockKey(const std::string& name);
+    static std::string newLockId();
+
+    // @brief: 执行一次加锁脚本，失败时 wait_hint 为锁剩余毫秒
+    int64_t tryOnce(
+        const std::string& name, const std::string& id,
+        std::chrono::milliseconds lease, std::chrono::milliseconds& wait_hint);
+    std::chrono::milliseconds retryDelay(std::chrono::milliseconds wait_hint) const;
+
+    // 以下三个函数要求调用方已持有 _mutex
+    void     registerWaiterLocked(const std::string& key);
+    void     unregisterWaiterLocked(const std::string& key);
+    uint64_t generationLocked(const std::string& key) const;
+
+    void addLease(const LockGrant& grant, std::chrono::milliseconds lease);
+    void onReleased(const std::string& key);
+
+    void          subscribeLoop(std::size_t shard);
+    void          workerLoop();
+    redisContext* connectSubscriber(std::size_t shard);
+
+    std::mutex                               _mutex;
+    std::condition_variable                  _cv;
+    std::unordered_map<std::string, Waiting> _waiting;   // lock key -> 等待代数
+    std::list<AsyncWaiter>                   _async_waiters;
+    std::unordered_map<std::string, Lease>   _leases;   // lock id -> 续期信息
+
+    // 锁 key 分布在各个 Redis 分片上，释放通知在所在分片发布，每个分片订阅一次
+    std::size_t                _shard_count = 0;
+    std::atomic<std::size_t>   _subscribed_shards{0};
+    std::atomic<bool>          _stop{false};
+    std::mutex                 _conn_mutex;
+    std::vector<redisContext*> _conns;
+    std::vector<std::thread>   _subscribe_threads;
+    std::thread                _worker_thread;
+};
+
+#endif   // LOCKSERVICE_H_
@@ -0,0 +1,71 @@
+#include "MappedFile.h"
+#include "LogManager.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Slice 的释放回调：user_data 是映射的一个引用
+void ReleaseMapping(void* user_data) {
+    delete static_cast<std::shared_ptr<MappedFile>*>(user_data);
+}
+
+}   // namespace
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR(
+            "[MappedFile] Failed to open {}: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    // 映射建立后即可关闭描述符，映射本身保持文件引用
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR(
+            "[MappedFile] Failed to map {}: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+    ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    return std::shared_ptr<MappedFile>(
+        new MappedFile(static_cast<char*>(data), st.st_size));
+}
+
+MappedFile::MappedFile(char* data, int64_t size)
+    : _data(data)
+    , _size(size) {}
+
+MappedFile::~MappedFile() {
+    ::munmap(_data, _size);
+}
+
+grpc::Slice MappedFile::SliceAt(int64_t offset, std::size_t len) {
+    return grpc::Slice(
+        _data + offset,
+        len,
+        &ReleaseMapping,
+        new std::shared_ptr<MappedFile>(shared_from_this()));
+}
+
+void MappedFile::WillNeed(int64_t offset, std::size_t len) const {
+    if (offset >= _size) return;
+    // madvise 要求起始地址按页对齐
+    static const int64_t page = ::sysconf(_SC_PAGESIZE);
+    int64_t              begin = offset - offset % page;
+    int64_t              end   = std::min<int64_t>(_size, offset + len);
+    ::madvise(_data + begin, end - begin, MADV_WILLNEED);
+}
@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstdint>
+#include <grpcpp/support/slice.h>
+#include <memory>
+#include <string>
+
+// 只读映射整个文件，按区间切出引用映射内存的 grpc::Slice
+// 每个 Slice 持有映射的一个引用，gRPC 发送完释放最后一个 Slice 后才 munmap，
+// 数据从页缓存直接进入 gRPC 的发送队列，用户态不再拷贝
+// 映射期间文件被截断会使访问越界的页触发 SIGBUS，只用于上传完成后不再改写的文件
+class MappedFile : public std::enable_shared_from_this<MappedFile> {
+public:
+    // @brief: 映射文件并提示内核按顺序访问；失败（含空文件）返回 nullptr
+    static std::shared_ptr<MappedFile> Open(const std::string& path);
+    ~MappedFile();
+
+    int64_t Size() const { return _size; }
+
+    // @brief: [offset, offset + len) 的零拷贝 Slice
+    grpc::Slice SliceAt(int64_t offset, std::size_t len);
+    // @brief: 提示内核提前把 [offset, offset + len) 读入页缓存
+    void WillNeed(int64_t offset, std::size_t len) const;
+
+private:
+    MappedFile(char* data, int64_t size);
+
+    char*   _data;
+    int64_t _size;
+};
+
+#endif   // MAPPEDFILE_H_
@@ -0,0 +1,314 @@
+#include "MessageArchive.h"
+#include "ConfigManager.h"
+#include "LogManager.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* SEGMENT_EXT = ".seg";
+
+long ConfigNumber(const std::string& key, long fallback) {
+    auto value = (*ConfigManager::getInstance())["MessageArchive"][key];
+    if (value.empty()) return fallback;
+    long number = std::atol(value.c_str());
+    return number >= 0 ? number : fallback;
+}
+
+// 写入并落盘；失败时返回 false，errno 保留
+bool WriteFully(const std::string& path, const std::string& data) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    std::size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return false;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    bool ok = ::fsync(fd) == 0;
+    return ::close(fd) == 0 && ok;
+}
+
+// 改名后同步目录项，掉电后段文件不会消失
+void SyncDir(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+}   // namespace
+
+MessageArchive::MessageArchive() {
+    auto dir = (*ConfigManager::getInstance())["MessageArchive"]["dir"];
+    if (!dir.empty()) _dir = dir;
+    _age_days     = static_cast<int>(ConfigNumber("age_days", _age_days));
+    _segment_rows = static_cast<std::size_t>(std::max(
+        1L, ConfigNumber("segment_rows", static_cast<long>(_segment_rows))));
+    _block_rows = static_cast<std::size_t>(std::max(
+        1L, ConfigNumber("block_rows", static_cast<long>(_block_rows))));
+    _refresh_interval = std::chrono::seconds(
+        ConfigNumber("refresh_sec", _refresh_interval.count()));
+
+    if (Enabled()) {
+        LOG_INFO(
+            "[MessageArchive] Messages older than {} days are archived to {}",
+            _age_days,
+            _dir);
+    }
+}
+
+Result<std::string> MessageArchive::WriteSegment(
+    const std::string& month, const std::string& name,
+    std::vector<ArchiveRow> rows) {
+    std::string data = ArchiveSegment::Encode(std::move(rows), _block_rows);
+    if (data.empty()) {
+        return Result<std::string>::Error(ErrorCodes::ARCHIVE_IO_ERROR);
+    }
+
+    std::string     month_dir = _dir + "/" + month;
+    std::error_code ec;
+    fs::create_directories(month_dir, ec);
+    if (ec) {
+        LOG_ERROR(
+            "[MessageArchive] Failed to create {}: {}",
+            month_dir,
+            ec.message());
+        return Result<std::string>::Error(ErrorCodes::ARCHIVE_IO_ERROR);
+    }
+
+    std::string path = month_dir + "/" + name + SEGMENT_EXT;
+    std::string tmp  = path + ".tmp";
+    if (!WriteFully(tmp, data)) {
+        LOG_ERROR(
+            "[MessageArchive] Failed to write {}: {}",
+            tmp,
+            std::strerror(errno));
+        ::unlink(tmp.c_str());
+        return Result<std::string>::Error(ErrorCodes::ARCHIVE_IO_ERROR);
+    }
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOG_ERROR(
+            "[MessageArchive] Failed to publish {}: {}",
+            path,
+            std::strerror(errno));
+        ::unlink(tmp.c_str());
+        return Result<std::string>::Error(ErrorCodes::ARCHIVE_IO_ERROR);
+    }
+    SyncDir(month_dir);
+
+    LOG_INFO("[MessageArchive] Wrote {} ({} bytes)", path, data.size());
+    return Result<std::string>::OK(path);
+}
+
+Result<std::vector<ArchiveRow>> MessageArchive::Page(
+    int64_t peer_key, int64_t before_ts, int64_t before_id, int64_t min_ts,
+    int limit) {
+    std::vector<ArchiveRow> page;
+    if (limit <= 0) return Result<std::vector<ArchiveRow>>::OK(page);
+
+    auto catalog = this->catalog();
+    auto blocks  = candidates(*catalog, peer_key, before_ts, before_id, min_ts);
+    // 从最新的块开始读；不同段的块时间上可能交错，
+    // 攒够 limit 条后，直到下一块的最新一条也早于已取到的最旧一条才停止
+    std::sort(blocks.begin(), blocks.end(), [](const auto& a, const auto& b) {
+        return ArchiveSegment::Before(
+            b.second.max_ts, b.second.max_id, a.second.max_ts, a.second.max_id);
+    });
+
+    auto newer = [](const ArchiveRow& a, const ArchiveRow& b) {
+        return ArchiveSegment::Before(
+            b.record.msg_ts, b.id, a.record.msg_ts, a.id);
+    };
+    auto same = [](const ArchiveRow& a, const ArchiveRow& b) {
+        return a.record.msg_ts == b.record.msg_ts && a.id == b.id;
+    };
+
+    std::vector<ArchiveRow> rows;
+    for (const auto& [segment, ref] : blocks) {
+        if (static_cast<int>(page.size()) >= limit) {
+            const auto& oldest = page.back();
+            if (ArchiveSegment::Before(
+                    ref.max_ts, ref.max_id, oldest.record.msg_ts, oldest.id)) {
+                break;
+            }
+        }
+        if (!readBlock(*segment, ref, rows)) {
+            LOG_ERROR(
+                "[MessageArchive] Corrupted block at {} in {}",
+                ref.offset,
+                segment->path);
+            return Result<std::vector<ArchiveRow>>::Error(
+                ErrorCodes::ARCHIVE_IO_ERROR);
+        }
+        for (auto& row : rows) {
+            if (row.record.msg_ts >= min_ts
+                && ArchiveSegment::Before(
+                    row.record.msg_ts, row.id, before_ts, before_id)) {
+                page.push_back(std::move(row));
+            }
+        }
+        std::sort(page.begin(), page.end(), newer);
+        page.erase(std::unique(page.begin(), page.end(), same), page.end());
+        if (static_cast<int>(page.size()) > limit) page.resize(limit);
+    }
+    return Result<std::vector<ArchiveRow>>::OK(page);
+}
+
+bool MessageArchive::Newest(
+    int64_t peer_key, int64_t before_ts, int64_t before_id, int64_t& ts,
+    int64_t& id) {
+    auto catalog = this->catalog();
+    bool found   = false;
+    for (const auto& [segment, ref] :
+         candidates(*catalog, peer_key, before_ts, before_id, INT64_MIN)) {
+        // 块内最新一条可能晚于游标，此时只能保守地以游标本身为上界
+        int64_t block_ts = ref.max_ts;
+        int64_t block_id = ref.max_id;
+        if (!ArchiveSegment::Before(block_ts, block_id, before_ts, before_id)) {
+            block_ts = before_ts;
+            block_id = before_id;
+        }
+        if (!found || ArchiveSegment::Before(ts, id, block_ts, block_id)) {
+            ts    = block_ts;
+            id    = block_id;
+            found = true;
+        }
+    }
+    return found;
+}
+
+std::shared_ptr<const MessageArchive::Catalog> MessageArchive::catalog() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (_catalog && now - _refreshed_at < _refresh_interval) {
+        return _catalog;
+    }
+    _refreshed_at = now;
+
+    auto            fresh = std::make_shared<Catalog>();
+    std::error_code ec;
+    if (fs::is_directory(_dir, ec)) {
+        for (fs::recursive_directory_iterator it(_dir, ec), end;
+             !ec && it != end;
+             it.increment(ec)) {
+            if (!it->is_regular_file(ec)
+                || it->path().extension() != SEGMENT_EXT) {
+                continue;
+            }
+            std::string path = it->path().string();
+            if (_catalog) {
+                auto known = _catalog->find(path);
+                if (known != _catalog->end()) {
+                    fresh->emplace(path, known->second);
+                    continue;
+                }
+            }
+            auto segment = std::make_shared<Segment>();
+            if (loadSegment(path, *segment)) {
+                fresh->emplace(path, std::move(segment));
+            } else {
+                LOG_WARN(
+                    "[MessageArchive] Skipping unreadable segment {}", path);
+            }
+        }
+    }
+    if (ec) {
+        LOG_WARN("[MessageArchive] Failed to scan {}: {}", _dir, ec.message());
+    }
+
+    if (!_catalog || _catalog->size() != fresh->size()) {
+        LOG_INFO("[MessageArchive] {} segments in {}", fresh->size(), _dir);
+    }
+    _catalog = std::move(fresh);
+    return _catalog;
+}
+
+std::vector<std::pair<const MessageArchive::Segment*, ArchiveBlockRef>>
+MessageArchive::candidates(
+    const Catalog& catalog, int64_t peer_key, int64_t before_ts,
+    int64_t before_id, int64_t min_ts) const {
+    std::vector<std::pair<const Segment*, ArchiveBlockRef>> blocks;
+    for (const auto& [path, segment] : catalog) {
+        if (segment->footer.min_ts > before_ts
+            || segment->footer.max_ts < min_ts) {
+            continue;
+        }
+        // index 按 (peer_key, min_ts) 排序
+        auto range = std::equal_range(
+            segment->index.begin(),
+            segment->index.end(),
+            ArchiveBlockRef{peer_key},
+            [](const ArchiveBlockRef& a, const ArchiveBlockRef& b) {
+                return a.peer_key < b.peer_key;
+            });
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->max_ts >= min_ts
+                && ArchiveSegment::Before(
+                    it->min_ts, it->min_id, before_ts, before_id)) {
+                blocks.emplace_back(segment.get(), *it);
+            }
+        }
+    }
+    return blocks;
+}
+
+bool MessageArchive::loadSegment(const std::string& path, Segment& segment) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    in.seekg(0, std::ios::end);
+    auto size = static_cast<std::size_t>(in.tellg());
+    if (size < ArchiveSegment::HEADER_SIZE + ArchiveSegment::FOOTER_SIZE) {
+        return false;
+    }
+
+    std::string header(ArchiveSegment::HEADER_SIZE, '\0');
+    std::string tail(ArchiveSegment::FOOTER_SIZE, '\0');
+    in.seekg(0);
+    in.read(&header[0], static_cast<std::streamsize>(header.size()));
+    in.seekg(static_cast<std::streamoff>(size - tail.size()));
+    in.read(&tail[0], static_cast<std::streamsize>(tail.size()));
+    if (!in || !ArchiveSegment::ParseFooter(header, tail, segment.footer)) {
+        return false;
+    }
+
+    std::size_t index_size
+        = static_cast<std::size_t>(segment.footer.index_count)
+          * ArchiveSegment::INDEX_ENTRY_SIZE;
+    if (segment.footer.index_offset + index_size + tail.size() != size) {
+        return false;
+    }
+    std::string index(index_size, '\0');
+    in.seekg(static_cast<std::streamoff>(segment.footer.index_offset));
+    in.read(&index[0], static_cast<std::streamsize>(index.size()));
+    if (!in
+        || !ArchiveSegment::ParseIndex(index, segment.footer, segment.index)) {
+        return false;
+    }
+    segment.path = path;
+    return true;
+}
+
+bool MessageArchive::readBlock(
+    const Segment& segment, const ArchiveBlockRef& ref,
+    std::vector<ArchiveRow>& rows) {
+    std::ifstream in(segment.path, std::ios::binary);
+    if (!in) return false;
+    std::string packed(ref.size, '\0');
+    in.seekg(static_cast<std::streamoff>(ref.offset));
+    in.read(&packed[0], static_cast<std::streamsize>(packed.size()));
+    return in && ArchiveSegment::DecodeBlock(packed, ref, rows);
+}
@@ -0,0 +1,85 @@
+#ifndef MESSAGEARCHIVE_H_
+#define MESSAGEARCHIVE_H_
+
+#include "common/ArchiveSegment.h"
+#include "common/result.h"
+#include "common/singleton.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 消息冷存储：超过 [MessageArchive] age_days 的消息由 MsgArchive 工具
+// 从消息表移到 dir/{yyyymm}/ 下的不可变段文件（格式见 ArchiveSegment）
+//   - 写入：临时文件写完并 fsync 后原子改名，读取方看不到半个段
+//   - 读取：进程内只常驻各段的 footer 与 index，按 refresh_sec 重新扫描目录；
+//     会话翻页按 peer_key 在各段 index 中定位块，只解压命中的块
+// 工具中断重跑时同一批消息可能写进两个段，读取按 (msg_ts, id) 去重
+class MessageArchive : public SingleTon<MessageArchive> {
+    friend class SingleTon<MessageArchive>;
+
+public:
+    // @brief: age_days > 0 时启用归档
+    bool Enabled() const { return _age_days > 0; }
+
+    // @brief: 归档分界：早于该时间（秒）的消息会被移出消息表
+    int64_t Cutoff(int64_t now) const {
+        return now - static_cast<int64_t>(_age_days) * 24 * 60 * 60;
+    }
+
+    std::size_t SegmentRows() const { return _segment_rows; }
+
+    // @brief: 写入一个段文件 dir/{month}/{name}.seg，返回最终路径
+    Result<std::string> WriteSegment(
+        const std::string& month, const std::string& name,
+        std::vector<ArchiveRow> rows);
+
+    // @brief: 会话中早于游标 (before_ts, before_id)、不早于 min_ts 的
+    //         最多 limit 条，按 (msg_ts, id) 从新到旧
+    Result<std::vector<ArchiveRow>> Page(
+        int64_t peer_key, int64_t before_ts, int64_t before_id, int64_t min_ts,
+        int limit);
+
+    // @brief: 会话在归档中早于游标的最新一条的 (ts, id)，只查 index 不读块；
+    //         没有时返回 false
+    bool Newest(
+        int64_t peer_key, int64_t before_ts, int64_t before_id, int64_t& ts,
+        int64_t& id);
+
+private:
+    MessageArchive();
+
+    struct Segment {
+        std::string                  path;
+        ArchiveFooter                footer;
+        std::vector<ArchiveBlockRef> index;
+    };
+    using Catalog = std::map<std::string, std::shared_ptr<const Segment>>;
+
+    // @brief: 当前段目录快照，超过 refresh_sec 时重新扫描（只加载新出现的段）
+    std::shared_ptr<const Catalog> catalog();
+    // @brief: 各段中属于 peer_key、含有早于游标的消息的块
+    std::vector<std::pair<const Segment*, ArchiveBlockRef>> candidates(
+        const Catalog& catalog, int64_t peer_key, int64_t before_ts,
+        int64_t before_id, int64_t min_ts) const;
+
+    static bool loadSegment(const std::string& path, Segment& segment);
+    static bool readBlock(
+        const Segment& segment, const ArchiveBlockRef& ref,
+        std::vector<ArchiveRow>& rows);
+
+    std::string          _dir          = "./archive";
+    int                  _age_days     = 0;
+    std::size_t          _segment_rows = 50000;
+    std::size_t          _block_rows   = ArchiveSegment::DEFAULT_BLOCK_ROWS;
+    std::chrono::seconds _refresh_interval{60};
+
+    std::mutex                            _mutex;
+    std::shared_ptr<const Catalog>        _catalog;
+    std::chrono::steady_clock::time_point _refreshed_at{};
+};
+
+#endif   // MESSAGEARCHIVE_H_
@@ -0,0 +1,241 @@
+#include "MessageShardMap.h"
+#include "common/MessageRecord.h"
+#include "infra/ConfigManager.h"
+#include "infra/LogManager.h"
+#include "infra/RedisManager.h"
+#include <cctype>
+
+const std::string MessageShardMap::RESHARD_KEY       = "msg:reshard";
+const std::string MessageShardMap::RESHARD_DIRTY_KEY = "msg:reshard:dirty";
+
+namespace {
+
+// 按 UTC 取年月，各实例时区不同也得到同一张表
+int YearMonth(std::time_t ts) {
+    std::tm tm{};
+    gmtime_r(&ts, &tm);
+    return (tm.tm_year + 1900) * 100 + (tm.tm_mon + 1);
+}
+
+bool AllDigits(const std::string& s) {
+    if (s.empty()) return false;
+    for (char c : s) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+    }
+    return true;
+}
+
+bool ParseLayout(
+    const std::string& prefix, const std::string& shards,
+    const std::string& partition, MessageShardLayout& layout) {
+    if (prefix.empty() || !AllDigits(shards)) return false;
+    layout.prefix  = prefix;
+    layout.shards  = std::stoi(shards);
+    layout.monthly = partition == "monthly";
+    return layout.shards > 0;
+}
+
+}   // namespace
+
+int MessageShardLayout::ShardOf(int from_uid, int to_uid) const {
+    // 与最初的 (from_uid + to_uid) % 16 保持一致，机器人 uid 为负时取非负余数
+    int shard = (from_uid + to_uid) % shards;
+    return shard < 0 ? shard + shards : shard;
+}
+
+std::string
+MessageShardLayout::TableFor(int from_uid, int to_uid, std::time_t ts) const {
+    std::string table = prefix + "_" + std::to_string(ShardOf(from_uid, to_uid));
+    if (monthly) {
+        table += "_" + std::to_string(YearMonth(ts));
+    }
+    return table;
+}
+
+std::vector<std::string>
+MessageShardLayout::TablesInRange(std::time_t start, std::time_t end) const {
+    std::vector<int> months;
+    if (monthly) {
+        int first = YearMonth(start);
+        int last  = YearMonth(end);
+        for (int ym = first; ym <= last;) {
+            months.push_back(ym);
+            ym = (ym % 100 == 12) ? (ym / 100 + 1) * 100 + 1 : ym + 1;
+        }
+    }
+
+    std::vector<std::string> tables;
+    for (int shard = 0; shard < shards; ++shard) {
+        std::string base = prefix + "_" + std::to_string(shard);
+        if (!monthly) {
+            tables.push_back(base);
+            continue;
+        }
+        for (int ym : months) {
+            tables.push_back(base + "_" + std::to_string(ym));
+        }
+    }
+    return tables;
+}
+
+std::vector<std::string> MessageShardLayout::ConversationTables(
+    int from_uid, int to_uid, std::time_t start, std::time_t end) const {
+    std::string base = prefix + "_" + std::to_string(ShardOf(from_uid, to_uid));
+    if (!monthly) return {base};
+
+    std::vector<std::string> tables;
+    int                      first = YearMonth(start);
+    for (int ym = YearMonth(end); ym >= first;) {
+        tables.push_back(base + "_" + std::to_string(ym));
+        ym = (ym % 100 == 1) ? (ym / 100 - 1) * 100 + 12 : ym - 1;
+    }
+    return tables;
+}
+
+int MessageShardLayout::TableShard(const std::string& table) const {
+    if (table.compare(0, prefix.size() + 1, prefix + "_") != 0) return -1;
+
+    std::string rest  = table.substr(prefix.size() + 1);
+    auto        split = rest.find('_');
+    std::string shard = rest.substr(0, split);
+    if (!AllDigits(shard) || shard.size() > 6 || std::stoi(shard) >= shards) {
+        return -1;
+    }
+
+    if (!monthly) {
+        return split == std::string::npos ? std::stoi(shard) : -1;
+    }
+    std::string month = split == std::string::npos ? "" : rest.substr(split + 1);
+    return (month.size() == 6 && AllDigits(month)) ? std::stoi(shard) : -1;
+}
+
+MessageShardMap::MessageShardMap() {
+    auto               config = ConfigManager::getInstance();
+    MessageShardLayout layout;
+    std::string        prefix    = (*config)["MessageShard"]["prefix"];
+    std::string        shards    = (*config)["MessageShard"]["shards"];
+    std::string        partition = (*config)["MessageShard"]["partition"];
+    if (prefix.empty()) prefix = layout.prefix;
+    if (shards.empty()) shards = std::to_string(layout.shards);
+
+    if (ParseLayout(prefix, shards, partition, layout)) {
+        _active = layout;
+    } else {
+        LOG_WARN("[MessageShardMap] Invalid [MessageShard] config, using defaults");
+    }
+
+    LOG_INFO(
+        "[MessageShardMap] Active layout: prefix={}, shards={}, partition={}",
+        _active.prefix,
+        _active.shards,
+        PartitionName(_active.monthly));
+}
+
+void MessageShardMap::refreshLocked(bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && _refreshed_at != std::chrono::steady_clock::time_point{}
+        && now - _refreshed_at < REFRESH_INTERVAL) {
+        return;
+    }
+    _refreshed_at = now;
+
+    auto fields = RedisManager::getInstance()->HGetAll(RESHARD_KEY);
+    if (fields.empty()) {
+        _phase = ReshardPhase::NONE;
+        return;
+    }
+
+    MessageShardLayout target;
+    ReshardPhase       phase = ParsePhase(fields["phase"]);
+    if (phase == ReshardPhase::NONE
+        || !ParseLayout(fields["prefix"], fields["shards"], fields["partition"], target)) {
+        _phase = ReshardPhase::NONE;
+        return;
+    }
+
+    if (phase != _phase || !(target == _target)) {
+        LOG_INFO(
+            "[MessageShardMap] Reshard phase {} -> {}, target: prefix={}, "
+            "shards={}, partition={}",
+            PhaseName(_phase),
+            PhaseName(phase),
+            target.prefix,
+            target.shards,
+            PartitionName(target.monthly));
+    }
+    _phase  = phase;
+    _target = target;
+}
+
+ReshardPhase MessageShardMap::Phase(bool force) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    refreshLocked(force);
+    return _phase;
+}
+
+bool MessageShardMap::Target(MessageShardLayout& target, bool force) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    refreshLocked(force);
+    if (_phase == ReshardPhase::NONE) return false;
+    target = _target;
+    return true;
+}
+
+MessageShardLayout MessageShardMap::ReadLayout() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    refreshLocked(false);
+    if (_phase == ReshardPhase::CUTOVER || _phase == ReshardPhase::DONE) {
+        return _target;
+    }
+    return _active;
+}
+
+std::vector<std::string>
+MessageShardMap::WriteTables(int from_uid, int to_uid, std::time_t ts) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    refreshLocked(false);
+
+    switch (_phase) {
+    case ReshardPhase::DUAL_WRITE:
+        return {
+            _active.TableFor(from_uid, to_uid, ts),
+            _target.TableFor(from_uid, to_uid, ts)};
+    case ReshardPhase::CUTOVER:
+        return {
+            _target.TableFor(from_uid, to_uid, ts),
+            _active.TableFor(from_uid, to_uid, ts)};
+    case ReshardPhase::DONE:
+        return {_target.TableFor(from_uid, to_uid, ts)};
+    default:
+        return {_active.TableFor(from_uid, to_uid, ts)};
+    }
+}
+
+void MessageShardMap::AcknowledgePhase() {
+    ReshardPhase phase = Phase(true);
+    if (phase == ReshardPhase::NONE) return;
+    RedisManager::getInstance()->HSet(RESHARD_KEY, "ack", PhaseName(phase));
+}
+
+void MessageShardMap::MarkDirty(int from_uid, int to_uid) {
+    RedisManager::getInstance()->HSet(
+        RESHARD_DIRTY_KEY,
+        std::to_string(MessageCodec::PeerKey(from_uid, to_uid)),
+        "1");
+}
+
+const char* MessageShardMap::PhaseName(ReshardPhase phase) {
+    switch (phase) {
+    case ReshardPhase::DUAL_WRITE: return "dual_write";
+    case ReshardPhase::CUTOVER: return "cutover";
+    case ReshardPhase::DONE: return "done";
+    default: return "none";
+    }
+}
+
+ReshardPhase MessageShardMap::ParsePhase(const std::string& name) {
+    if (name == "dual_write") return ReshardPhase::DUAL_WRITE;
+    if (name == "cutover") return ReshardPhase::CUTOVER;
+    if (name == "done") return ReshardPhase::DONE;
+    return ReshardPhase::NONE;
+}
@@ -0,0 +1,98 @@
+#ifndef MESSAGESHARDMAP_H_
+#define MESSAGESHARDMAP_H_
+
+#include "common/singleton.h"
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 消息表布局：表名前缀 + 分表数 + 是否按月分区
+//   不分区: {prefix}_{shard}            如 chat_messages_3
+//   按月:   {prefix}_{shard}_{yyyymm}   如 chat_messages_v2_3_202610
+// 会话按 (from_uid + to_uid) % shards 选分表，双向消息落在同一分表；
+// 按月分区时以消息时间（msg_ts）选月份表，查询按时间窗覆盖的月份展开
+struct MessageShardLayout {
+    std::string prefix  = "chat_messages";
+    int         shards  = 16;
+    bool        monthly = false;
+
+    int         ShardOf(int from_uid, int to_uid) const;
+    std::string TableFor(int from_uid, int to_uid, std::time_t ts) const;
+    // @brief: [start, end] 时间窗可能涉及的全部表（按分表、月份展开）
+    std::vector<std::string> TablesInRange(std::time_t start, std::time_t end) const;
+    // @brief: 一个会话在 [start, end] 内可能所在的表，按时间从新到旧
+    std::vector<std::string> ConversationTables(
+        int from_uid, int to_uid, std::time_t start, std::time_t end) const;
+    // @brief: 表名对应的分表号，不属于本布局（如模板表、其他布局的表）时返回 -1
+    int  TableShard(const std::string& table) const;
+    bool Owns(const std::string& table) const { return TableShard(table) >= 0; }
+
+    bool operator==(const MessageShardLayout& other) const {
+        return prefix == other.prefix && shards == other.shards
+               && monthly == other.monthly;
+    }
+};
+
+// 在线重分片阶段，保存在 Redis（RESHARD_KEY），所有 ChatServer 共享
+//   NONE:       只用 active 布局
+//   DUAL_WRITE: 读 active，写 active + target；迁移工具复制并校验历史数据
+//   CUTOVER:    读 target，仍双写，出问题可退回 DUAL_WRITE
+//   DONE:       只用 target；各实例把 config.ini 改成 target 布局后清除状态
+enum class ReshardPhase : int {
+    NONE = 0,
+    DUAL_WRITE,
+    CUTOVER,
+    DONE,
+};
+
+class MessageShardMap : public SingleTon<MessageShardMap> {
+    friend class SingleTon<MessageShardMap>;
+
+public:
+    static const std::string RESHARD_KEY;         // 阶段与目标布局
+    static const std::string RESHARD_DIRTY_KEY;   // 目标表写入失败、需重新复制的会话
+
+    // @brief: config.ini [MessageShard] 中的当前布局
+    const MessageShardLayout& Active() const { return _active; }
+
+    // @brief: 当前重分片阶段与目标布局（带短时缓存，force 时立即从 Redis 刷新）
+    ReshardPhase Phase(bool force = false);
+    bool         Target(MessageShardLayout& target, bool force = false);
+
+    // @brief: 提供读服务的布局
+    MessageShardLayout ReadLayout();
+
+    // @brief: 一次写入应落的表，第一个为主表（其结果决定写入成败），
+    //         其余为双写窗口内的影子表
+    std::vector<std::string> WriteTables(int from_uid, int to_uid, std::time_t ts);
+
+    // @brief: 持久化轮次开始时调用：强制刷新阶段并把看到的阶段写回 ack 字段
+    //         迁移工具只在持有持久化锁时切换阶段，因此一轮之内阶段不会变化
+    void AcknowledgePhase();
+
+    // @brief: 记录影子表写入失败的会话，迁移工具会重新复制
+    void MarkDirty(int from_uid, int to_uid);
+
+    static const char*  PhaseName(ReshardPhase phase);
+    static ReshardPhase ParsePhase(const std::string& name);
+    static std::string  PartitionName(bool monthly) { return monthly ? "monthly" : "none"; }
+
+private:
+    MessageShardMap();
+
+    void refreshLocked(bool force);
+
+    static constexpr std::chrono::seconds REFRESH_INTERVAL{5};
+
+    MessageShardLayout _active;
+
+    std::mutex                            _mutex;
+    ReshardPhase                          _phase = ReshardPhase::NONE;
+    MessageShardLayout                    _target;
+    std::chrono::steady_clock::time_point _refreshed_at{};
+};
+
+#endif   // MESSAGESHARDMAP_H_
@@ -0,0 +1,67 @@
+#ifndef MPSCQUEUE_H_
+#define MPSCQUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+// 无锁多生产者单消费者队列（Vyukov 链表队列）
+// 生产者只做一次 exchange 和一次 store，互不等待，也不与消费者争锁；
+// 同一时刻只能有一个消费者，消费者可以换线程，但交接必须有 happens-before
+// （例如经由互斥锁或 seq_cst 原子变量）
+//
+// 生产者 exchange 之后、链接 next 之前，消费者 pop 会短暂地看到空队列，
+// 而 Empty() 已经返回 false；调用方需容忍这一瞬间的不一致
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue()
+        : _head(new Node)
+        , _tail(_head.load()) {}
+
+    ~MpscQueue() {
+        T value;
+        while (Pop(value)) {
+        }
+        delete _tail;
+    }
+
+    MpscQueue(const MpscQueue&)            = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // @brief: 任意线程可调用
+    void Push(T value) {
+        auto* node = new Node(std::move(value));
+        auto* prev = _head.exchange(node);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // @brief: 仅消费者调用，队列为空时返回 false
+    bool Pop(T& value) {
+        auto* tail = _tail;
+        auto* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        value = std::move(next->value);
+        _tail = next;
+        delete tail;
+        return true;
+    }
+
+    // @brief: 仅消费者调用；与生产者的 exchange 构成 seq_cst 顺序，
+    //         用于"先清除调度标记再检查队列"这类交接
+    bool Empty() const { return _head.load() == _tail; }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v)
+            : value(std::move(v)) {}
+
+        std::atomic<Node*> next{nullptr};
+        T                  value{};
+    };
+
+    std::atomic<Node*> _head;   // 生产者端
+    Node*              _tail;   // 消费者端，指向已消费的哨兵节点
+};
+
+#endif   // MPSCQUEUE_H_
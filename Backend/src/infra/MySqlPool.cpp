@@ -0,0 +1,250 @@
+#include "MySqlPool.h"
+#include "infra/LogManager.h"
+
+MySqlPool::MySqlPool(MySqlPoolOptions options) : _options(std::move(options)) {
+    for (std::size_t i = 0; i < _options.min_size; ++i) {
+        auto connection = connect();
+        if (!connection) break;
+        _idle.push_back(std::move(connection));
+        ++_total;
+    }
+
+    LOG_INFO(
+        "[MySqlPool] Created {}: {} connections (min {}, max {})",
+        _options.url,
+        _total,
+        _options.min_size,
+        _options.max_size);
+}
+
+MySqlPool::~MySqlPool() {
+    Close();
+}
+
+MySqlPoolClient*
+MySqlPool::RegisterClient(const std::string& name, std::size_t quota) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto&                       client = _clients[name];
+    if (!client) {
+        client       = std::make_unique<MySqlPoolClient>();
+        client->name = name;
+    }
+    client->quota = (quota == 0 || quota > _options.max_size) ? _options.max_size
+                                                               : quota;
+    return client.get();
+}
+
+std::unique_ptr<PooledConnection>
+MySqlPool::getConnection(MySqlPoolClient* client, bool* timed_out) {
+    if (timed_out) *timed_out = false;
+    auto start    = std::chrono::steady_clock::now();
+    auto deadline = start + _options.acquire_timeout;
+
+    std::unique_ptr<PooledConnection> connection;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            if (_stop) return nullptr;
+            if (client->in_use < client->quota) {
+                if (!_idle.empty()) {
+                    connection = std::move(_idle.back());
+                    _idle.pop_back();
+                    break;
+                }
+                if (_total < _options.max_size) {
+                    // 先占住名额，在锁外建连接（connection 保持为空）
+                    ++_total;
+                    break;
+                }
+            }
+            if (_cond.wait_until(lock, deadline) == std::cv_status::timeout) {
+                client->timeouts.fetch_add(1, std::memory_order_relaxed);
+                _timeouts.fetch_add(1, std::memory_order_relaxed);
+                LOG_WARN(
+                    "[MySqlPool] {} timed out waiting for a connection "
+                    "(in use {}/{}, pool {}/{})",
+                    client->name,
+                    client->in_use,
+                    client->quota,
+                    _total,
+                    _options.max_size);
+                if (timed_out) *timed_out = true;
+                return nullptr;
+            }
+        }
+        ++client->in_use;
+    }
+    client->wait.Record(std::chrono::steady_clock::now() - start);
+
+    if (!connection) {
+        connection = connect();
+    } else if (!revive(*connection)) {
+        connection.reset();
+        _discarded.fetch_add(1, std::memory_order_relaxed);
+        connection = connect();
+    }
+
+    if (!connection) {
+        // 建连失败，归还占用的名额
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_total;
+        --client->in_use;
+        _cond.notify_all();
+        return nullptr;
+    }
+
+    connection->client = client;
+    return connection;
+}
+
+void MySqlPool::returnConnection(std::unique_ptr<PooledConnection> connection) {
+    std::vector<std::unique_ptr<PooledConnection>> reaped;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (connection->client) {
+            --connection->client->in_use;
+            connection->client = nullptr;
+        }
+        if (_stop) {
+            --_total;
+            return;
+        }
+        connection->last_used = std::chrono::steady_clock::now();
+        _idle.push_back(std::move(connection));
+        reapIdleLocked(reaped);
+        // 等待者的条件各不相同（配额/空闲连接），全部唤醒重新判断
+        _cond.notify_all();
+    }
+}
+
+void MySqlPool::reapIdleLocked(std::vector<std::unique_ptr<PooledConnection>>& reaped) {
+    auto now = std::chrono::steady_clock::now();
+    // 头部是最久未用的连接；借出总是取尾部，多余的连接会自然沉到头部
+    while (_total > _options.min_size && !_idle.empty()
+           && now - _idle.front()->last_used > _options.idle_timeout) {
+        reaped.push_back(std::move(_idle.front()));
+        _idle.pop_front();
+        --_total;
+    }
+}
+
+std::unique_ptr<PooledConnection> MySqlPool::connect() {
+    try {
+        sql::mysql::MySQL_Driver* driver = sql::mysql::get_mysql_driver_instance();
+        std::unique_ptr<sql::Connection> connection(
+            driver->connect(_options.url, _options.user, _options.passwd));
+        connection->setSchema(_options.schema);
+        _created.fetch_add(1, std::memory_order_relaxed);
+        return std::make_unique<PooledConnection>(
+            std::move(connection), _options.stmt_cache_size, &_stmt_counters);
+    } catch (sql::SQLException& e) {
+        LOG_ERROR(
+            "[MySqlPool] Failed to connect to {}: {} (Error Code: {})",
+            _options.url,
+            e.what(),
+            e.getErrorCode());
+        return nullptr;
+    }
+}
+
+bool MySqlPool::revive(PooledConnection& connection) {
+    auto idle = std::chrono::steady_clock::now() - connection.last_used;
+    if (!connection.suspect && idle < _options.validate_after) {
+        return true;
+    }
+
+    try {
+        if (connection.conn->isValid()) {
+            connection.suspect = false;
+            return true;
+        }
+        // 服务端预编译语句随旧会话失效
+        connection.statements.Clear();
+        if (connection.conn->reconnect()) {
+            connection.conn->setSchema(_options.schema);
+            connection.suspect = false;
+            _reconnects.fetch_add(1, std::memory_order_relaxed);
+            LOG_INFO("[MySqlPool] Reconnected stale connection to {}", _options.url);
+            return true;
+        }
+    } catch (sql::SQLException& e) {
+        LOG_WARN("[MySqlPool] Stale connection could not be revived: {}", e.what());
+    }
+    return false;
+}
+
+StatementCacheStats MySqlPool::GetStatementCacheStats() const {
+    StatementCacheStats stats;
+    stats.hits      = _stmt_counters.hits.load(std::memory_order_relaxed);
+    stats.misses    = _stmt_counters.misses.load(std::memory_order_relaxed);
+    stats.evictions = _stmt_counters.evictions.load(std::memory_order_relaxed);
+    return stats;
+}
+
+MySqlPoolStats MySqlPool::GetStats() {
+    MySqlPoolStats stats;
+    stats.created    = _created.load(std::memory_order_relaxed);
+    stats.reconnects = _reconnects.load(std::memory_order_relaxed);
+    stats.discarded  = _discarded.load(std::memory_order_relaxed);
+    stats.timeouts   = _timeouts.load(std::memory_order_relaxed);
+    stats.statements = GetStatementCacheStats();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.total = _total;
+    stats.idle  = _idle.size();
+    for (const auto& [name, client] : _clients) {
+        MySqlPoolClientStats c;
+        c.name     = name;
+        c.quota    = client->quota;
+        c.in_use   = client->in_use;
+        c.timeouts = client->timeouts.load(std::memory_order_relaxed);
+        c.wait     = client->wait.Snapshot();
+        c.query    = client->query.Snapshot();
+        stats.clients.push_back(std::move(c));
+    }
+    return stats;
+}
+
+void MySqlPool::LogStats(const std::string& label) {
+    auto stats = GetStats();
+    LOG_INFO(
+        "[MySqlPool] {}: connections {} (idle {}), created {}, reconnects {}, "
+        "discarded {}, timeouts {}, statement cache hit ratio {:.2f}",
+        label,
+        stats.total,
+        stats.idle,
+        stats.created,
+        stats.reconnects,
+        stats.discarded,
+        stats.timeouts,
+        stats.statements.hit_ratio());
+    for (const auto& c : stats.clients) {
+        LOG_INFO(
+            "[MySqlPool] {}/{}: quota {}, in use {}, timeouts {}, "
+            "wait p50/p99/max {}/{}/{} us, query n={} p50/p99/max {}/{}/{} us",
+            label,
+            c.name,
+            c.quota,
+            c.in_use,
+            c.timeouts,
+            c.wait.percentile_us(0.50),
+            c.wait.percentile_us(0.99),
+            c.wait.max_us,
+            c.query.count,
+            c.query.percentile_us(0.50),
+            c.query.percentile_us(0.99),
+            c.query.max_us);
+    }
+}
+
+void MySqlPool::Close() {
+    std::deque<std::unique_ptr<PooledConnection>> idle;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop) return;
+        _stop = true;
+        _total -= _idle.size();
+        idle.swap(_idle);
+    }
+    _cond.notify_all();
+}
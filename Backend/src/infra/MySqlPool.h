@@ -2,89 +2,143 @@
 #define MYSQLPOOL_H_
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cppconn/connection.h>
 #include <cppconn/driver.h>
 #include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/statement.h>
+#include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <mysql_connection.h>
 #include <mysql_driver.h>
-#include <queue>
-#include "infra/LogManager.h"
+#include <string>
+#include <vector>
+#include "infra/LatencyHistogram.h"
+#include "infra/StatementCache.h"
 
 
+struct MySqlPoolOptions {
+    std::string url;
+    std::string user;
+    std::string passwd;
+    std::string schema;
+    std::size_t min_size = 2;    // 启动时预建、空闲回收时保留的连接数
+    std::size_t max_size = 16;   // 按需扩容的上限
+    // 借连接的最长等待，超时返回空而不是一直阻塞
+    std::chrono::milliseconds acquire_timeout{3000};
+    // 空闲超过该时长的连接借出前先 isValid() 检查，失效则重连
+    // （应小于服务端 wait_timeout）
+    std::chrono::seconds validate_after{30};
+    // 超过 min_size 的连接空闲这么久后关闭
+    std::chrono::seconds idle_timeout{300};
+    std::size_t          stmt_cache_size = 128;
+};
+
+// 连接池的一个使用方（每个 DAO 一个），有各自的连接配额与耗时统计
+// 由 MySqlPool::RegisterClient 创建，生命周期与连接池相同
+struct MySqlPoolClient {
+    std::string           name;
+    std::size_t           quota  = 0;
+    std::size_t           in_use = 0;   // 受池内互斥锁保护
+    std::atomic<uint64_t> timeouts{0};
+    LatencyHistogram      wait;    // 借连接的等待时间
+    LatencyHistogram      query;   // 借出后回调执行时间
+};
+
+// 池化连接：原生连接 + 该连接上的预编译语句缓存
+// 成员按声明逆序析构，语句先于连接释放
+struct PooledConnection {
+    std::unique_ptr<sql::Connection>      conn;
+    StatementCache                        statements;
+    std::chrono::steady_clock::time_point last_used;
+    MySqlPoolClient*                      client  = nullptr;
+    bool                                  suspect = false;   // 上次使用时连接断开
+
+    PooledConnection(
+        std::unique_ptr<sql::Connection> connection, std::size_t stmt_cache_size,
+        StatementCacheCounters* counters)
+        : conn(std::move(connection))
+        , statements(conn.get(), stmt_cache_size, counters)
+        , last_used(std::chrono::steady_clock::now()) {}
+};
+
+struct MySqlPoolClientStats {
+    std::string     name;
+    std::size_t     quota    = 0;
+    std::size_t     in_use   = 0;
+    uint64_t        timeouts = 0;
+    LatencySnapshot wait;
+    LatencySnapshot query;
+};
+
+struct MySqlPoolStats {
+    std::size_t total      = 0;
+    std::size_t idle       = 0;
+    uint64_t    created    = 0;
+    uint64_t    reconnects = 0;
+    uint64_t    discarded  = 0;
+    uint64_t    timeouts   = 0;
+
+    StatementCacheStats               statements;
+    std::vector<MySqlPoolClientStats> clients;
+};
 
+
+// 可伸缩的共享连接池
+//   - 启动预建 min_size 个连接，并发高时按需扩到 max_size，空闲超时后缩回 min_size
+//   - 空闲较久或上次使用时断开的连接借出前检查有效性，被 wait_timeout 断开的连接自动重连
+//   - 每个使用方有连接配额，单个 DAO 的慢查询不会占满整个池
+//   - 借连接超时返回空，由调用方返回错误码
 class MySqlPool {
 public:
-    MySqlPool(
-        const std::string& url, const std::string& user,
-        const std::string& passwd, const std::string& _schema, std::size_t size)
-        : _url(url)
-        , _user(user)
-        , _passwd(passwd)
-        , _schema(_schema)
-        , _poolSize(size)
-        , _stop(false) {
-
-
-        for (std::size_t i = 0; i < _poolSize; ++i) {
-            sql::mysql::MySQL_Driver* driver
-                = sql::mysql::get_mysql_driver_instance();
-            std::unique_ptr<sql::Connection> connection(
-                driver->connect(_url, _user, _passwd));
-            connection->setSchema(_schema);
-            _pool.push(std::move(connection));
-        }
-
-        LOG_INFO("MySqlPool Created");
-    }
-    std::unique_ptr<sql::Connection> getConnection() {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _cond.wait(lock, [this]() {
-            if (_stop) return true;
-            return !_pool.empty();
-        });
-
-        if (_stop) {
-            return nullptr;
-        }
-
-        std::unique_ptr<sql::Connection> connection(std::move(_pool.front()));
-        _pool.pop();
-        return connection;
-    }
-
-    void returnConnection(std::unique_ptr<sql::Connection> connection) {
-        std::unique_lock<std::mutex> lock(_mutex);
-        if (_stop) return;
-        _pool.push(std::move(connection));
-        _cond.notify_one();
-    }
-    void Close() {
-        _stop.store(true);
-        _cond.notify_all();
-        std::unique_lock<std::mutex> lock(_mutex);
-        while (!_pool.empty()) {
-            _pool.pop();
-        }
-    }
-    ~MySqlPool() {
-        if (!_stop.load()) Close();
-    }
+    explicit MySqlPool(MySqlPoolOptions options);
+    ~MySqlPool();
+
+    MySqlPool(const MySqlPool&)            = delete;
+    MySqlPool& operator=(const MySqlPool&) = delete;
+
+    // @brief: 注册使用方，quota 为 0 或超过 max_size 时取 max_size；同名重复注册返回同一个
+    MySqlPoolClient* RegisterClient(const std::string& name, std::size_t quota);
+
+    // @brief: 借出连接，超时、建连失败或连接池已关闭时返回空；
+    //         timed_out 非空时区分是否因等待超时
+    std::unique_ptr<PooledConnection>
+    getConnection(MySqlPoolClient* client, bool* timed_out = nullptr);
+    void returnConnection(std::unique_ptr<PooledConnection> connection);
+
+    std::size_t MaxSize() const { return _options.max_size; }
+
+    StatementCacheStats GetStatementCacheStats() const;
+    MySqlPoolStats      GetStats();
+    void                LogStats(const std::string& label);
+
+    void Close();
 
 private:
-    std::string                                  _url;
-    std::string                                  _user;
-    std::string                                  _passwd;
-    std::string                                  _schema;
-    std::size_t                                  _poolSize;
-    std::queue<std::unique_ptr<sql::Connection>> _pool;
-    std::mutex                                   _mutex;
-    std::condition_variable                      _cond;
-    std::atomic<bool>                            _stop;
+    std::unique_ptr<PooledConnection> connect();
+    // @brief: 借出前检查连接，失效时重连；无法恢复返回 false
+    bool revive(PooledConnection& connection);
+    // @brief: 取出空闲过久的多余连接（持锁调用），在锁外析构
+    void reapIdleLocked(std::vector<std::unique_ptr<PooledConnection>>& reaped);
+
+    const MySqlPoolOptions _options;
+    StatementCacheCounters _stmt_counters;
+
+    std::mutex                                              _mutex;
+    std::condition_variable                                 _cond;
+    std::deque<std::unique_ptr<PooledConnection>>           _idle;   // 尾部最近归还
+    std::size_t                                             _total = 0;
+    std::map<std::string, std::unique_ptr<MySqlPoolClient>> _clients;
+    bool                                                    _stop = false;
+
+    std::atomic<uint64_t> _created{0};
+    std::atomic<uint64_t> _reconnects{0};
+    std::atomic<uint64_t> _discarded{0};
+    std::atomic<uint64_t> _timeouts{0};
 };
 
 #endif   // MYSQLPOOL_H_
@@ -0,0 +1,257 @@
+#include "MySqlPoolManager.h"
+#include "ConfigManager.h"
+#include "LogManager.h"
+#include "RedisManager.h"
+#include <algorithm>
+#include <cppconn/resultset.h>
+#include <cstdlib>
+#include <sstream>
+
+const std::string MySqlPoolManager::RYW_PREFIX = "mysql:ryw:";
+
+namespace {
+
+long ConfigNumber(const std::string& section, const std::string& key, long fallback) {
+    auto value = (*ConfigManager::getInstance())[section][key];
+    if (value.empty()) return fallback;
+    long number = std::atol(value.c_str());
+    return number > 0 ? number : fallback;
+}
+
+}   // namespace
+
+MySqlPoolManager::MySqlPoolManager() {
+    auto globalConfig = ConfigManager::getInstance();
+
+    MySqlPoolOptions options;
+    // 格式化为 tcp://127.0.0.1:3306
+    options.url = "tcp://" + (*globalConfig)["MySQL"]["host"] + ":"
+                  + (*globalConfig)["MySQL"]["port"];
+    options.user   = (*globalConfig)["MySQL"]["user"];
+    options.passwd = (*globalConfig)["MySQL"]["passwd"];
+    options.schema = (*globalConfig)["MySQL"]["schema"];
+
+    options.min_size = ConfigNumber("MySQL", "pool_min", options.min_size);
+    options.max_size = ConfigNumber("MySQL", "pool_max", options.max_size);
+    options.max_size = std::max(options.max_size, options.min_size);
+    options.acquire_timeout = std::chrono::milliseconds(ConfigNumber(
+        "MySQL", "acquire_timeout_ms", options.acquire_timeout.count()));
+    options.validate_after = std::chrono::seconds(ConfigNumber(
+        "MySQL", "validate_after_sec", options.validate_after.count()));
+    options.idle_timeout = std::chrono::seconds(
+        ConfigNumber("MySQL", "idle_timeout_sec", options.idle_timeout.count()));
+
+    // 每个连接缓存的预编译语句数，0 表示不缓存
+    const auto& cache_size_str = (*globalConfig)["MySQL"]["stmt_cache_size"];
+    if (!cache_size_str.empty()) {
+        options.stmt_cache_size = std::stoul(cache_size_str);
+    }
+
+    _max_lag_sec = ConfigNumber("MySQL", "max_replica_lag_sec", _max_lag_sec);
+    _probe_interval = std::chrono::milliseconds(
+        ConfigNumber("MySQL", "replica_lag_check_ms", _probe_interval.count()));
+    _ryw_window = std::chrono::milliseconds(
+        ConfigNumber("MySQL", "read_your_writes_ms", _ryw_window.count()));
+
+    // replicas = host1:port1,host2:port2；账号、库名与主库相同
+    std::stringstream ss((*globalConfig)["MySQL"]["replicas"]);
+    std::string       endpoint;
+    while (std::getline(ss, endpoint, ',')) {
+        endpoint.erase(0, endpoint.find_first_not_of(" \t"));
+        endpoint.erase(endpoint.find_last_not_of(" \t") + 1);
+        if (endpoint.empty()) continue;
+
+        auto replica = std::make_unique<Replica>();
+        replica->url = "tcp://" + endpoint;
+
+        MySqlPoolOptions replica_options = options;
+        replica_options.url              = replica->url;
+        replica->pool  = std::make_unique<MySqlPool>(std::move(replica_options));
+        replica->probe = replica->pool->RegisterClient("LagProbe", 1);
+        _replicas.push_back(std::move(replica));
+    }
+
+    // 工作线程多于可用连接只会排队等连接，默认与连接池上限一致
+    auto threads = ConfigNumber("MySQL", "async_threads", options.max_size);
+    _workers = std::make_unique<boost::asio::thread_pool>(threads);
+
+    _primary = std::make_unique<MySqlPool>(std::move(options));
+
+    if (!_replicas.empty()) {
+        LOG_INFO(
+            "[MySqlPoolManager] {} replicas, max lag {}s, read-your-writes {}ms",
+            _replicas.size(),
+            _max_lag_sec,
+            _ryw_window.count());
+        _probe_thread = std::thread([this]() { probeLoop(); });
+    }
+}
+
+MySqlPoolManager::~MySqlPoolManager() {
+    Close();
+}
+
+MySqlClients MySqlPoolManager::RegisterClient(const std::string& name) {
+    auto         quota = static_cast<std::size_t>(ConfigNumber("MySQLQuota", name, 0));
+    MySqlClients clients;
+    clients.primary = _primary->RegisterClient(name, quota);
+    for (auto& replica : _replicas) {
+        clients.replicas.push_back(replica->pool->RegisterClient(name, quota));
+    }
+    LOG_INFO(
+        "[MySqlPoolManager] {} registered, quota {}/{}",
+        name,
+        clients.primary->quota,
+        _primary->MaxSize());
+    return clients;
+}
+
+MySqlRoute MySqlPoolManager::WriteRoute(const MySqlClients& clients) {
+    return MySqlRoute{_primary.get(), clients.primary, -1};
+}
+
+MySqlRoute MySqlPoolManager::ReadRoute(const MySqlClients& clients, int uid) {
+    if (_replicas.empty()) {
+        return WriteRoute(clients);
+    }
+    if (uid > 0 && recentlyWrote(uid)) {
+        _sticky_reads.fetch_add(1, std::memory_order_relaxed);
+        return WriteRoute(clients);
+    }
+
+    // 在延迟达标的副本间轮询
+    std::size_t count = _replicas.size();
+    std::size_t start = _rr.fetch_add(1, std::memory_order_relaxed) % count;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t idx = (start + i) % count;
+        int64_t     lag = _replicas[idx]->lag_sec.load(std::memory_order_relaxed);
+        if (lag >= 0 && lag <= _max_lag_sec) {
+            _replicas[idx]->reads.fetch_add(1, std::memory_order_relaxed);
+            return MySqlRoute{
+                _replicas[idx]->pool.get(),
+                clients.replicas[idx],
+                static_cast<int>(idx)};
+        }
+    }
+
+    _primary_reads.fetch_add(1, std::memory_order_relaxed);
+    return WriteRoute(clients);
+}
+
+void MySqlPoolManager::MarkWrite(int uid) {
+    if (_replicas.empty() || uid <= 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(_ryw_mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (_ryw_until.size() > 10000) {
+            for (auto it = _ryw_until.begin(); it != _ryw_until.end();) {
+                it = it->second < now ? _ryw_until.erase(it) : std::next(it);
+            }
+        }
+        _ryw_until[uid] = now + _ryw_window;
+    }
+
+    // 写入提交后才打标记，其他实例看到标记时主库上一定已有新数据
+    RedisManager::getInstance()->SetEx(
+        RYW_PREFIX + std::to_string(uid),
+        static_cast<int>((_ryw_window.count() + 999) / 1000),
+        "1");
+}
+
+bool MySqlPoolManager::recentlyWrote(int uid) {
+    {
+        std::lock_guard<std::mutex> lock(_ryw_mutex);
+        auto                        it = _ryw_until.find(uid);
+        if (it != _ryw_until.end()) {
+            if (std::chrono::steady_clock::now() < it->second) return true;
+            _ryw_until.erase(it);
+        }
+    }
+    return RedisManager::getInstance()->ExistsKey(RYW_PREFIX + std::to_string(uid));
+}
+
+void MySqlPoolManager::probeLoop() {
+    while (true) {
+        for (auto& replica : _replicas) {
+            int64_t lag  = probeLag(*replica);
+            int64_t prev = replica->lag_sec.exchange(lag, std::memory_order_relaxed);
+            bool    was_ok = prev >= 0 && prev <= _max_lag_sec;
+            bool    is_ok  = lag >= 0 && lag <= _max_lag_sec;
+            if (was_ok != is_ok) {
+                LOG_WARN(
+                    "[MySqlPoolManager] Replica {} {} (lag {}s)",
+                    replica->url,
+                    is_ok ? "back in rotation" : "removed from rotation",
+                    lag);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(_probe_mutex);
+        if (_probe_cond.wait_for(lock, _probe_interval, [this]() { return _stop; })) {
+            return;
+        }
+    }
+}
+
+int64_t MySqlPoolManager::probeLag(Replica& replica) {
+    auto connection = replica.pool->getConnection(replica.probe);
+    if (!connection) return -1;
+
+    int64_t lag = -1;
+    try {
+        std::unique_ptr<sql::Statement> stmt(connection->conn->createStatement());
+        std::unique_ptr<sql::ResultSet> res;
+        std::string                     column = "Seconds_Behind_Source";
+        try {
+            res.reset(stmt->executeQuery("SHOW REPLICA STATUS"));
+        } catch (sql::SQLException&) {
+            // 8.0.22 之前的版本
+            res.reset(stmt->executeQuery("SHOW SLAVE STATUS"));
+            column = "Seconds_Behind_Master";
+        }
+        // 没有复制状态（不是副本）或延迟为 NULL（复制线程停止）都视为不可用
+        if (res && res->next() && !res->isNull(column)) {
+            lag = res->getInt64(column);
+        }
+    } catch (sql::SQLException& e) {
+        LOG_WARN("[MySqlPoolManager] Lag probe on {} failed: {}", replica.url, e.what());
+        connection->suspect = true;
+    }
+    replica.pool->returnConnection(std::move(connection));
+    return lag;
+}
+
+void MySqlPoolManager::LogStats() {
+    _primary->LogStats("primary");
+    for (std::size_t i = 0; i < _replicas.size(); ++i) {
+        const auto& replica = _replicas[i];
+        LOG_INFO(
+            "[MySqlPoolManager] replica {} {}: lag {}s, reads {}",
+            i,
+            replica->url,
+            replica->lag_sec.load(),
+            replica->reads.load());
+        replica->pool->LogStats("replica " + std::to_string(i));
+    }
+    if (!_replicas.empty()) {
+        LOG_INFO(
+            "[MySqlPoolManager] reads on primary: {} read-your-writes, {} no healthy replica",
+            _sticky_reads.load(),
+            _primary_reads.load());
+    }
+}
+
+void MySqlPoolManager::Close() {
+    {
+        std::lock_guard<std::mutex> lock(_probe_mutex);
+        _stop = true;
+    }
+    _probe_cond.notify_all();
+    if (_probe_thread.joinable()) _probe_thread.join();
+
+    // 先关闭连接池，排队中的异步调用借不到连接会立即返回错误
+    _primary->Close();
+    for (auto& replica : _replicas) replica->pool->Close();
+    _workers->join();
+}
@@ -0,0 +1,107 @@
+#ifndef MYSQLPOOLMANAGER_H_
+#define MYSQLPOOLMANAGER_H_
+
+#include "common/singleton.h"
+#include "infra/MySqlPool.h"
+#include <atomic>
+#include <boost/asio/thread_pool.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 一个 DAO 在各个连接池中的登记项，下标与 MySqlPoolManager 的副本顺序一致
+struct MySqlClients {
+    MySqlPoolClient*              primary = nullptr;
+    std::vector<MySqlPoolClient*> replicas;
+};
+
+// 一次查询选中的连接池
+struct MySqlRoute {
+    MySqlPool*       pool    = nullptr;
+    MySqlPoolClient* client  = nullptr;
+    int              replica = -1;   // -1 表示主库
+};
+
+// 进程内唯一的 MySQL 连接池集合，所有 DAO 共享
+//   - 主库一个池，[MySQL] replicas 中的每个只读副本各一个池
+//   - 后台线程定期查询各副本的复制延迟，延迟超过 max_replica_lag_sec
+//     或复制中断的副本不参与分流
+//   - 读己之写：用户写入后 read_your_writes_ms 内，与其相关的读请求固定走主库；
+//     标记同时写入 Redis，其他实例上的读（以及随后回填的缓存）也能看到
+//   - 异步 DAO 调用在独立的工作线程池上执行，不占用 io_context 线程
+// 池参数来自 config.ini [MySQL]，各 DAO 的连接配额来自 [MySQLQuota]
+class MySqlPoolManager : public SingleTon<MySqlPoolManager> {
+    friend class SingleTon<MySqlPoolManager>;
+
+public:
+    ~MySqlPoolManager();
+
+    MySqlPool& Primary() { return *_primary; }
+
+    // @brief: 异步 DAO 调用的执行器，阻塞的 Connector/C++ 调用在这些线程上完成
+    //         线程数取 [MySQL] async_threads，默认与主库 pool_max 相同，
+    //         也就是同时在途的异步查询上限
+    boost::asio::thread_pool::executor_type Executor() {
+        return _workers->get_executor();
+    }
+
+    // @brief: 以 DAO 名在主库和各副本池中注册，配额取 [MySQLQuota] 中的同名项，
+    //         未配置时不限（即 max_size）
+    MySqlClients RegisterClient(const std::string& name);
+
+    MySqlRoute WriteRoute(const MySqlClients& clients);
+    // @brief: 只读查询的路由：uid 近期有写入、没有可用副本时返回主库
+    //         uid <= 0 表示与具体用户无关的读
+    MySqlRoute ReadRoute(const MySqlClients& clients, int uid);
+
+    // @brief: 记录 uid 刚发生写入，随后一段时间内其读请求走主库
+    void MarkWrite(int uid);
+
+    void LogStats();
+    void Close();
+
+private:
+    MySqlPoolManager();
+
+    struct Replica {
+        std::string                url;
+        std::unique_ptr<MySqlPool> pool;
+        MySqlPoolClient*           probe = nullptr;
+        std::atomic<int64_t>       lag_sec{-1};   // -1 表示不可用
+        std::atomic<uint64_t>      reads{0};
+    };
+
+    bool recentlyWrote(int uid);
+    void probeLoop();
+    // @brief: 查询副本的复制延迟（秒），副本不可达或复制中断返回 -1
+    int64_t probeLag(Replica& replica);
+
+    static const std::string RYW_PREFIX;
+
+    std::unique_ptr<MySqlPool>            _primary;
+    std::vector<std::unique_ptr<Replica>> _replicas;
+    std::unique_ptr<boost::asio::thread_pool> _workers;
+
+    int64_t                   _max_lag_sec = 3;
+    std::chrono::milliseconds _probe_interval{1000};
+    std::chrono::milliseconds _ryw_window{5000};
+
+    std::atomic<uint64_t> _rr{0};
+    std::atomic<uint64_t> _primary_reads{0};
+    std::atomic<uint64_t> _sticky_reads{0};
+
+    std::mutex                                                     _ryw_mutex;
+    std::unordered_map<int, std::chrono::steady_clock::time_point> _ryw_until;
+
+    std::mutex              _probe_mutex;
+    std::condition_variable _probe_cond;
+    bool                    _stop = false;
+    std::thread             _probe_thread;
+};
+
+#endif   // MYSQLPOOLMANAGER_H_
@@ -0,0 +1,332 @@
+#include "NearCache.h"
+#include "ConfigManager.h"
+#include "LogManager.h"
+#include "RedisManager.h"
+#include "common/UserMessage.h"
+#include "hiredis.h"
+#include <cstdlib>
+#include <iterator>
+#include <sys/socket.h>
+
+namespace {
+
+const char* const FAMILY_NAMES[] = {"user:base", "friend:list", "friend:apply"};
+
+bool ReplyIsError(redisReply* reply) {
+    return reply == nullptr || reply->type == REDIS_REPLY_ERROR;
+}
+
+}   // namespace
+
+NearCache::NearCache() {
+    auto globalConfig = ConfigManager::getInstance();
+    auto enabled      = (*globalConfig)["NearCache"]["enabled"];
+    auto max_mb       = (*globalConfig)["NearCache"]["max_mb"];
+    auto ttl_sec      = (*globalConfig)["NearCache"]["ttl_sec"];
+
+    if (enabled == "false" || enabled == "0") {
+        _enabled = false;
+    }
+    if (!max_mb.empty() && atoi(max_mb.c_str()) > 0) {
+        _max_bytes = static_cast<std::size_t>(atoi(max_mb.c_str())) * 1024 * 1024;
+    }
+    if (!ttl_sec.empty() && atoi(ttl_sec.c_str()) > 0) {
+        _ttl = std::chrono::seconds(atoi(ttl_sec.c_str()));
+    }
+
+    if (_enabled) {
+        _shard_count = RedisManager::getInstance()->ShardCount();
+        _conns.assign(_shard_count, nullptr);
+        for (std::size_t shard = 0; shard < _shard_count; ++shard) {
+            _tracking_threads.emplace_back([this, shard]() { trackingLoop(shard); });
+        }
+    }
+    LOG_INFO(
+        "[NearCache] enabled: {}, max bytes: {}, ttl: {}s",
+        _enabled,
+        _max_bytes,
+        _ttl.count());
+}
+
+NearCache::~NearCache() {
+    Stop();
+}
+
+void NearCache::Stop() {
+    if (_stop.exchange(true)) return;
+    {
+        // 阻塞在 redisGetReply 上的跟踪线程需要靠关闭 socket 唤醒
+        std::lock_guard<std::mutex> lock(_conn_mutex);
+        for (auto* conn : _conns) {
+            if (conn) shutdown(conn->fd, SHUT_RDWR);
+        }
+    }
+    for (auto& thread : _tracking_threads) {
+        if (thread.joinable()) thread.join();
+    }
+    Clear();
+}
+
+bool NearCache::familyOf(const std::string& key, NearCacheFamily& family) {
+    if (key.compare(0, USER_BASE_PREFIX.size(), USER_BASE_PREFIX) == 0) {
+        family = NearCacheFamily::USER_BASE;
+        return true;
+    }
+    if (key.compare(0, FRIEND_LIST_PREFIX.size(), FRIEND_LIST_PREFIX) == 0) {
+        family = NearCacheFamily::FRIEND_LIST;
+        return true;
+    }
+    if (key.compare(0, FRIEND_APPLY_PREFIX.size(), FRIEND_APPLY_PREFIX) == 0) {
+        family = NearCacheFamily::FRIEND_APPLY;
+        return true;
+    }
+    return false;
+}
+
+std::shared_ptr<const void> NearCache::get(const std::string& key) {
+    NearCacheFamily family;
+    if (!familyOf(key, family)) return nullptr;
+
+    auto& counters = _counters[static_cast<int>(family)];
+    if (!_enabled || !Enabled()) {
+        counters.misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _index.find(key);
+    if (it == _index.end()) {
+        counters.misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // TTL 只是兜底，正常情况下由跟踪推送失效
+    if (it->second->expire_at <= std::chrono::steady_clock::now()) {
+        eraseLocked(it->second);
+        counters.misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    _lru.splice(_lru.begin(), _lru, it->second);
+    counters.hits.fetch_add(1, std::memory_order_relaxed);
+    return it->second->value;
+}
+
+void NearCache::put(
+    const std::string& key, std::shared_ptr<const void> value,
+    std::size_t bytes, uint64_t epoch) {
+    NearCacheFamily family;
+    if (!_enabled || !Enabled() || !value || !familyOf(key, family)) return;
+
+    bytes += key.size() + sizeof(Entry);
+    if (bytes > _max_bytes) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (epoch != _epoch.load(std::memory_order_acquire)) {
+        // 读 Redis 期间收到过失效，这份数据可能已经过期
+        return;
+    }
+
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        eraseLocked(it->second);
+    }
+
+    _lru.push_front(
+        Entry{key, std::move(value), bytes, family,
+              std::chrono::steady_clock::now() + _ttl});
+    _index[key] = _lru.begin();
+    _bytes += bytes;
+
+    auto& counters = _counters[static_cast<int>(family)];
+    counters.entries++;
+    counters.bytes += bytes;
+
+    evictLocked();
+}
+
+void NearCache::Invalidate(const std::string& key) {
+    NearCacheFamily family;
+    if (!familyOf(key, family)) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _epoch.fetch_add(1, std::memory_order_acq_rel);
+    auto it = _index.find(key);
+    if (it == _index.end()) return;
+
+    eraseLocked(it->second);
+    _counters[static_cast<int>(family)].invalidations.fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+void NearCache::Clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    clearLocked();
+}
+
+void NearCache::eraseLocked(EntryList::iterator it) {
+    auto& counters = _counters[static_cast<int>(it->family)];
+    counters.entries--;
+    counters.bytes -= it->bytes;
+    _bytes -= it->bytes;
+    _index.erase(it->key);
+    _lru.erase(it);
+}
+
+void NearCache::evictLocked() {
+    while (_bytes > _max_bytes && !_lru.empty()) {
+        auto last = std::prev(_lru.end());
+        _counters[static_cast<int>(last->family)].evictions.fetch_add(
+            1, std::memory_order_relaxed);
+        eraseLocked(last);
+    }
+}
+
+void NearCache::clearLocked() {
+    _epoch.fetch_add(1, std::memory_order_acq_rel);
+    _lru.clear();
+    _index.clear();
+    _bytes = 0;
+    for (auto& counters : _counters) {
+        counters.entries = 0;
+        counters.bytes   = 0;
+    }
+}
+
+std::vector<NearCacheStats> NearCache::GetStats() {
+    std::vector<NearCacheStats> stats;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int i = 0; i < static_cast<int>(NearCacheFamily::COUNT); ++i) {
+        NearCacheStats s;
+        s.family        = FAMILY_NAMES[i];
+        s.hits          = _counters[i].hits.load(std::memory_order_relaxed);
+        s.misses        = _counters[i].misses.load(std::memory_order_relaxed);
+        s.evictions     = _counters[i].evictions.load(std::memory_order_relaxed);
+        s.invalidations = _counters[i].invalidations.load(std::memory_order_relaxed);
+        s.entries       = _counters[i].entries;
+        s.bytes         = _counters[i].bytes;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void NearCache::LogStats() {
+    for (const auto& s : GetStats()) {
+        LOG_INFO(
+            "[NearCache] {}: hits {}, misses {}, hit ratio {:.2f}%, entries {}, "
+            "bytes {}, evictions {}, invalidations {}",
+            s.family,
+            s.hits,
+            s.misses,
+            s.hit_ratio() * 100.0,
+            s.entries,
+            s.bytes,
+            s.evictions,
+            s.invalidations);
+    }
+}
+
+redisContext* NearCache::connectTracking(std::size_t shard) {
+    redisContext* context
+        = RedisManager::getInstance()->NewDedicatedConnection(shard);
+    if (context == nullptr) {
+        return nullptr;
+    }
+
+    // 推送消息不交给回调，直接由 redisGetReply 返回
+    redisSetPushCallback(context, nullptr);
+
+    // 专用连接已先完成 AUTH；未认证时 HELLO 会以 NOAUTH 失败，跟踪永远建不起来
+    auto* reply = (redisReply*) redisCommand(context, "HELLO 3");
+    if (ReplyIsError(reply)) {
+        // 不一定是不支持 RESP3，按 Redis 返回的错误输出
+        LOG_ERROR(
+            "[NearCache] HELLO 3 failed: {}",
+            reply && reply->str ? reply->str : context->errstr);
+        if (reply) freeReplyObject(reply);
+        redisFree(context);
+        return nullptr;
+    }
+    freeReplyObject(reply);
+
+    // BCAST 模式：受管前缀下任何 key 被修改都会推送失效，不依赖本连接是否读过
+    reply = (redisReply*) redisCommand(
+        context,
+        "CLIENT TRACKING ON BCAST PREFIX %s PREFIX %s PREFIX %s",
+        USER_BASE_PREFIX.c_str(),
+        FRIEND_LIST_PREFIX.c_str(),
+        FRIEND_APPLY_PREFIX.c_str());
+    if (ReplyIsError(reply)) {
+        LOG_ERROR("[NearCache] CLIENT TRACKING failed");
+        if (reply) freeReplyObject(reply);
+        redisFree(context);
+        return nullptr;
+    }
+    freeReplyObject(reply);
+    return context;
+}
+
+void NearCache::handlePush(void* raw) {
+    auto* reply = static_cast<redisReply*>(raw);
+    if (reply == nullptr
+        || (reply->type != REDIS_REPLY_PUSH && reply->type != REDIS_REPLY_ARRAY)
+        || reply->elements < 2 || reply->element[0]->str == nullptr
+        || std::string(reply->element[0]->str, reply->element[0]->len)
+               != "invalidate") {
+        return;
+    }
+
+    auto* keys = reply->element[1];
+    if (keys->type != REDIS_REPLY_ARRAY) {
+        // nil 表示 FLUSHALL / FLUSHDB，整体失效
+        Clear();
+        return;
+    }
+    for (std::size_t i = 0; i < keys->elements; ++i) {
+        Invalidate(std::string(keys->element[i]->str, keys->element[i]->len));
+    }
+}
+
+void NearCache::trackingLoop(std::size_t shard) {
+    while (!_stop.load()) {
+        redisContext* context = connectTracking(shard);
+        if (context == nullptr) {
+            for (int i = 0; i < 10 && !_stop.load(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_conn_mutex);
+            _conns[shard] = context;
+        }
+        // 断线期间可能漏掉了失效推送，重新启用前先清空
+        Clear();
+        _tracking_shards.fetch_add(1, std::memory_order_acq_rel);
+        LOG_INFO("[NearCache] client tracking enabled on shard {}", shard);
+
+        while (!_stop.load()) {
+            void* reply = nullptr;
+            if (redisGetReply(context, &reply) != REDIS_OK) {
+                break;
+            }
+            handlePush(reply);
+            freeReplyObject(reply);
+        }
+
+        _tracking_shards.fetch_sub(1, std::memory_order_acq_rel);
+        Clear();
+        {
+            std::lock_guard<std::mutex> lock(_conn_mutex);
+            _conns[shard] = nullptr;
+        }
+        redisFree(context);
+        if (!_stop.load()) {
+            LOG_WARN(
+                "[NearCache] tracking connection to shard {} lost, cache "
+                "disabled until reconnect",
+                shard);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef NEARCACHE_H_
+#define NEARCACHE_H_
+
+#include "common/singleton.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct redisContext;
+
+// 进程内近端缓存：缓存已解析好的 user:base:* / friend:list:* / friend:apply:* 对象，
+// 避免每次都 Redis GET + JSON 解析。
+// 失效依赖 Redis 6 客户端缓存（RESP3 CLIENT TRACKING BCAST），
+// 跟踪连接断开期间近端缓存整体停用，重连后清空再启用，保证不会读到过期数据。
+enum class NearCacheFamily : int {
+    USER_BASE = 0,
+    FRIEND_LIST,
+    FRIEND_APPLY,
+    COUNT
+};
+
+struct NearCacheStats {
+    std::string family;
+    uint64_t    hits          = 0;
+    uint64_t    misses        = 0;
+    uint64_t    evictions     = 0;
+    uint64_t    invalidations = 0;
+    std::size_t entries       = 0;
+    std::size_t bytes         = 0;
+
+    double hit_ratio() const {
+        auto total = hits + misses;
+        if (total == 0) return 0.0;
+        return static_cast<double>(hits) / total;
+    }
+};
+
+class NearCache : public SingleTon<NearCache> {
+    friend class SingleTon<NearCache>;
+
+public:
+    ~NearCache();
+
+    // @brief: 查找缓存，key 不属于受管前缀或跟踪未就绪时直接返回 nullptr
+    template <typename T>
+    std::shared_ptr<const T> Get(const std::string& key) {
+        return std::static_pointer_cast<const T>(get(key));
+    }
+
+    // @brief: 写入缓存，epoch 必须是读 Redis 之前通过 Epoch() 取得的值；
+    //         期间发生过失效则放弃写入，防止把旧值塞回缓存
+    template <typename T>
+    void Put(
+        const std::string& key, std::shared_ptr<const T> value,
+        std::size_t bytes, uint64_t epoch) {
+        put(key, std::static_pointer_cast<const void>(value), bytes, epoch);
+    }
+
+    // @brief: 当前失效代数，每次失效/清空都会递增
+    uint64_t Epoch() const { return _epoch.load(std::memory_order_acquire); }
+
+    // @brief: 本地失效单个 key（写路径调用，不等待 Redis 推送）
+    void Invalidate(const std::string& key);
+
+    // @brief: 清空全部缓存
+    void Clear();
+
+    // @brief: 所有分片的跟踪连接是否都已就绪（未就绪时缓存不可用）
+    bool Enabled() const {
+        return _shard_count > 0
+               && _tracking_shards.load(std::memory_order_acquire) == _shard_count;
+    }
+
+    std::vector<NearCacheStats> GetStats();
+    void                        LogStats();
+
+    void Stop();
+
+private:
+    NearCache();
+
+    struct Entry {
+        std::string                           key;
+        std::shared_ptr<const void>           value;
+        std::size_t                           bytes;
+        NearCacheFamily                       family;
+        std::chrono::steady_clock::time_point expire_at;
+    };
+    using EntryList = std::list<Entry>;
+
+    struct FamilyCounters {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> evictions{0};
+        std::atomic<uint64_t> invalidations{0};
+        std::size_t           entries = 0;   // 受 _mutex 保护
+        std::size_t           bytes   = 0;   // 受 _mutex 保护
+    };
+
+    static bool familyOf(const std::string& key, NearCacheFamily& family);
+
+    std::shared_ptr<const void> get(const std::string& key);
+    void                        put(
+                               const std::string& key, std::shared_ptr<const void> value,
+                               std::size_t bytes, uint64_t epoch);
+
+    // 以下三个函数要求调用方已持有 _mutex
+    void eraseLocked(EntryList::iterator it);
+    void evictLocked();
+    void clearLocked();
+
+    void          trackingLoop(std::size_t shard);
+    redisContext* connectTracking(std::size_t shard);
+    void          handlePush(void* reply);
+
+    std::mutex                                                _mutex;
+    EntryList                                                 _lru;   // 头部最新
+    std::unordered_map<std::string, EntryList::iterator>      _index;
+    std::size_t                                               _bytes = 0;
+    FamilyCounters _counters[static_cast<int>(NearCacheFamily::COUNT)];
+
+    bool                 _enabled   = true;
+    std::size_t          _max_bytes = 64 * 1024 * 1024;
+    std::chrono::seconds _ttl{300};
+
+    // 每个 Redis 分片一条跟踪连接、一个线程
+    std::atomic<uint64_t>      _epoch{0};
+    std::size_t                _shard_count = 0;
+    std::atomic<std::size_t>   _tracking_shards{0};
+    std::atomic<bool>          _stop{false};
+    std::mutex                 _conn_mutex;
+    std::vector<redisContext*> _conns;
+    std::vector<std::thread>   _tracking_threads;
+};
+
+#endif   // NEARCACHE_H_
@@ -2,25 +2,121 @@
 #include "ConfigManager.h"
 #include "LogManager.h"
 #include "RedisConPool.h"
+#include "RedisScripts.h"
 #include "hiredis.h"
 #include "read.h"
-#include <boost/uuid/random_generator.hpp>
-#include <boost/uuid/uuid_io.hpp>
 #include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 
 
 RedisManager::RedisManager() {
     auto globalConfig = ConfigManager::getInstance();
     auto host         = (*globalConfig)["Redis"]["host"];
     auto port_str     = (*globalConfig)["Redis"]["port"];
-    auto port         = atoi(port_str.c_str());
-    auto passwd       = (*globalConfig)["Redis"]["passwd"];
-    _pool.reset(new RedisConPool(host.c_str(), port, passwd.c_str(), 5));
-    LOG_INFO("[RedisManager] Pool initialized with 5 connections.");
+    auto shards       = (*globalConfig)["Redis"]["shards"];
+    auto pool_size    = atoi((*globalConfig)["Redis"]["pool_size"].c_str());
+    _passwd           = (*globalConfig)["Redis"]["passwd"];
+    if (pool_size <= 0) pool_size = 5;
+
+    // shards = host1:port1,host2:port2,...；未配置时退化为单节点 host/port
+    std::vector<std::string> endpoints;
+    std::stringstream        ss(shards);
+    std::string              endpoint;
+    while (std::getline(ss, endpoint, ',')) {
+        endpoint.erase(0, endpoint.find_first_not_of(" \t"));
+        endpoint.erase(endpoint.find_last_not_of(" \t") + 1);
+        if (!endpoint.empty()) endpoints.push_back(endpoint);
+    }
+    if (endpoints.empty()) {
+        endpoints.push_back(host + ":" + port_str);
+    }
+
+    for (const auto& ep : endpoints) {
+        auto  colon = ep.rfind(':');
+        Shard shard;
+        shard.host = colon == std::string::npos ? ep : ep.substr(0, colon);
+        shard.port = colon == std::string::npos
+                         ? 6379
+                         : atoi(ep.substr(colon + 1).c_str());
+        shard.pool.reset(new RedisConPool(
+            shard.host.c_str(), shard.port, _passwd.c_str(), pool_size));
+        LOG_INFO(
+            "[RedisManager] Shard {} ({}:{}) initialized with {} connections.",
+            _shards.size(),
+            shard.host,
+            shard.port,
+            pool_size);
+        _shards.push_back(std::move(shard));
+    }
+    _ring = ConsistentHashRing(endpoints);
+    loadBuiltinScripts();
+}
+
+std::size_t RedisManager::ShardOf(const std::string& key) const {
+    return _shards.size() == 1 ? 0 : _ring.NodeOf(key);
+}
+
+RedisConPool* RedisManager::poolFor(const std::string& key) {
+    return _shards[ShardOf(key)].pool.get();
+}
+
+std::vector<RedisManager::ShardBatch> RedisManager::groupByShard(
+    const std::vector<std::string>& keys) const {
+    std::vector<ShardBatch>                       batches;
+    std::unordered_map<std::size_t, std::size_t> shard_to_batch;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        auto shard = ShardOf(keys[i]);
+        auto it    = shard_to_batch.find(shard);
+        if (it == shard_to_batch.end()) {
+            it = shard_to_batch.emplace(shard, batches.size()).first;
+            batches.push_back(ShardBatch{shard, keys, {}});
+        }
+        batches[it->second].indexes.push_back(i);
+    }
+    return batches;
+}
+
+redisReply* RedisManager::commandArgv(
+    redisContext* context, const std::vector<std::string>& argv) {
+    std::vector<const char*> args;
+    std::vector<size_t>      lens;
+    args.reserve(argv.size());
+    lens.reserve(argv.size());
+    for (const auto& arg : argv) {
+        args.push_back(arg.data());
+        lens.push_back(arg.size());
+    }
+    return (redisReply*) redisCommandArgv(
+        context, static_cast<int>(args.size()), args.data(), lens.data());
+}
+
+bool RedisManager::sendCommandArgv(
+    redisContext* context, const std::vector<std::string>& argv) {
+    std::vector<const char*> args;
+    std::vector<size_t>      lens;
+    args.reserve(argv.size());
+    lens.reserve(argv.size());
+    for (const auto& arg : argv) {
+        args.push_back(arg.data());
+        lens.push_back(arg.size());
+    }
+    if (redisAppendCommandArgv(
+            context, static_cast<int>(args.size()), args.data(), lens.data())
+        != REDIS_OK) {
+        return false;
+    }
+    // redisGetReply 才会写出缓冲区，这里先写出，各分片的命令同时在途
+    int done = 0;
+    do {
+        if (redisBufferWrite(context, &done) != REDIS_OK) return false;
+    } while (!done);
+    return true;
 }
 
 RedisManager::~RedisManager() {
@@ -29,7 +125,7 @@ RedisManager::~RedisManager() {
 }
 
 bool RedisManager::Get(const std::string& key, std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     redisReply*    reply
         = (redisReply*) redisCommand(context, "GET %s", key.c_str());
@@ -48,19 +144,20 @@ bool RedisManager::Get(const std::string& key, std::string& value) {
         return false;
     }
 
-    value = reply->str;
+    // 按长度拷贝，值可能是含 \0 的二进制编码
+    value.assign(reply->str, reply->len);
     freeReplyObject(reply);
-    LOG_INFO("[RedisManager] Get success: {} = {}  ", key, value);
+    LOG_INFO("[RedisManager] Get success: {} ({} bytes)", key, value.size());
     return true;
 }
 
 bool RedisManager::Set(const std::string& key, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
     redisReply* reply = (redisReply*) redisCommand(
-        context, "SET %s %s", key.c_str(), value.c_str());
+        context, "SET %s %b", key.c_str(), value.data(), value.size());
     if (reply == nullptr) {
         LOG_ERROR("[RedisManager] Set failed: key: {}", key);
         return false;
@@ -73,14 +170,14 @@ bool RedisManager::Set(const std::string& key, const std::string& value) {
 
 
     if (ok)
-        LOG_INFO("[RedisManager] Set success: {} = {} ", key, value);
+        LOG_INFO("[RedisManager] Set success: {} ({} bytes)", key, value.size());
     else
         LOG_ERROR("[RedisManager] Set failed: status error for key: {}", key);
     return ok;
 }
 
 bool RedisManager::LPush(const std::string& key, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -99,7 +196,7 @@ bool RedisManager::LPush(const std::string& key, const std::string& value) {
 }
 
 bool RedisManager::LPop(const std::string& key, std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -118,7 +215,7 @@ bool RedisManager::LPop(const std::string& key, std::string& value) {
 }
 
 bool RedisManager::RPush(const std::string& key, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -137,7 +234,7 @@ bool RedisManager::RPush(const std::string& key, const std::string& value) {
 }
 
 bool RedisManager::RPop(const std::string& key, std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -157,7 +254,7 @@ bool RedisManager::RPop(const std::string& key, std::string& value) {
 
 bool RedisManager::HSet(
     const std::string& hkey, const std::string& key, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(hkey));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -180,7 +277,7 @@ bool RedisManager::HSet(
 
 std::string RedisManager::HGet(
     const std::string& key, const std::string& hkey) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return "";
 
@@ -200,7 +297,7 @@ std::string RedisManager::HGet(
 }
 
 bool RedisManager::Del(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -222,7 +319,7 @@ bool RedisManager::Del(const std::string& key) {
 }
 
 bool RedisManager::ExistsKey(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -245,7 +342,7 @@ bool RedisManager::ExistsKey(const std::string& key) {
 }
 
 bool RedisManager::HDel(const std::string& hkey, const std::string& field) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(hkey));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] HDEL failed: No available connection");
@@ -286,13 +383,15 @@ bool RedisManager::HDel(const std::string& hkey, const std::string& field) {
 }
 
 void RedisManager::Close() {
-    _pool->Close();
+    for (auto& shard : _shards) {
+        shard.pool->Close();
+    }
     LOG_INFO("[RedisManager] Pool closed.");
 }
 
 long long RedisManager::HIncrBy(
     const std::string& hkey, const std::string& field, long long delta) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(hkey));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] HINCRBY failed: no available connection");
@@ -336,7 +435,7 @@ long long RedisManager::HIncrBy(
 bool RedisManager::LRange(
     const std::string& key, int start, int stop,
     std::vector<std::string>& values) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) return false;
 
@@ -367,67 +466,8 @@ bool RedisManager::LRange(
     return true;
 }
 
-std::string RedisManager::AcquireLock(
-    const std::string& lock_name, int lock_timeout, int acquire_timeout) {
-    std::string id       = generateUUID();
-    std::string lock_key = "lock:" + lock_name;
-    auto        end_time = std::chrono::steady_clock::now()
-                    + std::chrono::seconds(acquire_timeout);
-    RedisConnGuard guard(_pool.get());
-    redisContext*  context = guard.get();
-    while (std::chrono::steady_clock::now() < end_time) {
-        redisReply* reply = (redisReply*) redisCommand(
-            context,
-            "SET %s %s NX EX %d",
-            lock_key.c_str(),
-            id.c_str(),
-            lock_timeout);
-        if (reply != nullptr) {
-            if (reply->type == REDIS_REPLY_STATUS
-                && std::string(reply->str) == "OK") {
-                freeReplyObject(reply);
-                return id;
-            }
-            freeReplyObject(reply);
-        }
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(1));   // 防止忙等待
-    }
-
-    return "";
-}
-bool RedisManager::ReleaseLock(
-    const std::string& lock_name, const std::string& id) {
-    std::string    lock_key = "lock:" + lock_name;
-    RedisConnGuard guard(_pool.get());
-    redisContext*  context = guard.get();
-
-    // Lua Script: 检查锁表示是否匹配，匹配则删除
-    const char* lua_script = "if redis.call('get', KEYS[1]) == ARGV[1] then \
-                                return redis.call('del', KEYS[1]) \
-                             else \
-                                return 0 \
-                             end";
-    redisReply* reply      = (redisReply*) redisCommand(
-        context, "EVAL %s 1 %s %s", lua_script, lock_key.c_str(), id.c_str());
-    bool success = false;
-    if (reply != nullptr) {
-        if (reply->type == REDIS_REPLY_INTEGER && reply->integer == 1) {
-            success = true;
-        }
-
-        freeReplyObject(reply);
-    }
-    return success;
-}
-
-std::string RedisManager::generateUUID() {
-    auto uuid = boost::uuids::random_generator()();
-    return boost::uuids::to_string(uuid);
-}
-
 bool RedisManager::Expire(const std::string& key, int seconds) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] EXPIRE failed: no available connection");
@@ -461,7 +501,7 @@ bool RedisManager::Expire(const std::string& key, int seconds) {
 
 std::map<std::string, std::string> RedisManager::HGetAll(
     const std::string& key) {
-    RedisConnGuard                     guard(_pool.get());
+    RedisConnGuard                     guard(poolFor(key));
     redisContext*                      context = guard.get();
     std::map<std::string, std::string> result;
 
@@ -512,7 +552,7 @@ std::map<std::string, std::string> RedisManager::HGetAll(
 }
 
 std::vector<std::string> RedisManager::HKeys(const std::string& key) {
-    RedisConnGuard           guard(_pool.get());
+    RedisConnGuard           guard(poolFor(key));
     redisContext*            context = guard.get();
     std::vector<std::string> result;
 
@@ -556,7 +596,7 @@ std::vector<std::string> RedisManager::HKeys(const std::string& key) {
 }
 
 std::vector<std::string> RedisManager::HVals(const std::string& key) {
-    RedisConnGuard           guard(_pool.get());
+    RedisConnGuard           guard(poolFor(key));
     redisContext*            context = guard.get();
     std::vector<std::string> result;
 
@@ -603,7 +643,7 @@ bool RedisManager::HMSet(
     const std::string&                        key,
     const std::map<std::string, std::string>& field_values) {
 
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] HMSET failed: no available connection");
@@ -642,7 +682,7 @@ bool RedisManager::HMSet(
 }
 
 bool RedisManager::HExists(const std::string& key, const std::string& field) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] HEXISTS failed: no available connection");
@@ -674,7 +714,7 @@ bool RedisManager::HExists(const std::string& key, const std::string& field) {
 }
 
 long long RedisManager::HLen(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] HLEN failed: no available connection");
@@ -704,7 +744,7 @@ long long RedisManager::HLen(const std::string& key) {
 // 过期时间相关操作
 
 bool RedisManager::PExpire(const std::string& key, long long milliseconds) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] PEXPIRE failed: no available connection");
@@ -736,7 +776,7 @@ bool RedisManager::PExpire(const std::string& key, long long milliseconds) {
 }
 
 long long RedisManager::TTL(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] TTL failed: no available connection");
@@ -763,7 +803,7 @@ long long RedisManager::TTL(const std::string& key) {
 }
 
 long long RedisManager::PTTL(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] PTTL failed: no available connection");
@@ -793,7 +833,14 @@ long long RedisManager::PTTL(const std::string& key) {
 
 bool RedisManager::Rename(
     const std::string& old_key, const std::string& new_key) {
-    RedisConnGuard guard(_pool.get());
+    if (ShardOf(old_key) != ShardOf(new_key)) {
+        LOG_ERROR(
+            "[RedisManager] RENAME failed: {} and {} are on different shards",
+            old_key,
+            new_key);
+        return false;
+    }
+    RedisConnGuard guard(poolFor(old_key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] RENAME failed: no available connection");
@@ -824,7 +871,14 @@ bool RedisManager::Rename(
 
 bool RedisManager::RenameNX(
     const std::string& old_key, const std::string& new_key) {
-    RedisConnGuard guard(_pool.get());
+    if (ShardOf(old_key) != ShardOf(new_key)) {
+        LOG_ERROR(
+            "[RedisManager] RENAMENX failed: {} and {} are on different shards",
+            old_key,
+            new_key);
+        return false;
+    }
+    RedisConnGuard guard(poolFor(old_key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] RENAMENX failed: no available connection");
@@ -854,38 +908,31 @@ bool RedisManager::RenameNX(
 // 批量删除操作
 
 long long RedisManager::Del(const std::vector<std::string>& keys) {
-    RedisConnGuard guard(_pool.get());
-    redisContext*  context = guard.get();
-    if (!context) {
-        LOG_ERROR("[RedisManager] DEL (batch) failed: no available connection");
-        return 0;
-    }
-
     if (keys.empty()) {
         return 0;
     }
 
-    // 构建DEL命令
-    std::string cmd = "DEL";
-    for (const auto& key : keys) {
-        cmd += " " + key;
-    }
-
-    redisReply* reply = (redisReply*) redisCommand(context, cmd.c_str());
-
-    if (reply == nullptr) {
-        LOG_ERROR("[RedisManager] DEL (batch) failed: command error");
-        return 0;
-    }
-
-    long long count = 0;
-    if (reply->type == REDIS_REPLY_INTEGER) {
-        count = reply->integer;
+    // 按分片拆成多条 DEL，各分片的命令同时发出
+    auto      groups = groupByShard(keys);
+    long long count  = 0;
+    for (long long deleted : runOnShards<long long>(
+             groups,
+             [](const ShardBatch& batch) {
+                 std::vector<std::string> argv{"DEL"};
+                 for (auto idx : batch.indexes) argv.push_back(batch.keys[idx]);
+                 return argv;
+             },
+             [](redisReply* reply, const ShardBatch&) {
+                 if (reply == nullptr) {
+                     LOG_ERROR("[RedisManager] DEL (batch) failed: command error");
+                     return 0LL;
+                 }
+                 return reply->type == REDIS_REPLY_INTEGER ? reply->integer : 0LL;
+             })) {
+        count += deleted;
     }
 
-    freeReplyObject(reply);
     LOG_INFO("[RedisManager] DEL (batch) success: deleted {} keys", count);
-
     return count;
 }
 
@@ -893,7 +940,7 @@ long long RedisManager::Del(const std::vector<std::string>& keys) {
 
 bool RedisManager::SetEx(
     const std::string& key, int seconds, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] SETEX failed: no available connection");
@@ -925,7 +972,7 @@ bool RedisManager::SetEx(
 }
 
 bool RedisManager::SetNX(const std::string& key, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] SETNX failed: no available connection");
@@ -954,35 +1001,43 @@ bool RedisManager::SetNX(const std::string& key, const std::string& value) {
 }
 
 bool RedisManager::MSet(const std::map<std::string, std::string>& key_values) {
-    RedisConnGuard guard(_pool.get());
-    redisContext*  context = guard.get();
-    if (!context) {
-        LOG_ERROR("[RedisManager] MSET failed: no available connection");
-        return false;
-    }
-
     if (key_values.empty()) {
         return false;
     }
 
-    // 构建MSET命令
-    std::string cmd = "MSET";
+    std::vector<std::string> keys;
+    std::vector<std::string> values;
+    keys.reserve(key_values.size());
+    values.reserve(key_values.size());
     for (const auto& [key, value] : key_values) {
-        cmd += " " + key + " " + value;
+        keys.push_back(key);
+        values.push_back(value);
+    }
+
+    // 每个分片各自一条 MSET；跨分片时整体不再是原子的
+    auto groups = groupByShard(keys);
+    bool ok     = true;
+    for (bool shard_ok : runOnShards<bool>(
+             groups,
+             [&values](const ShardBatch& batch) {
+                 std::vector<std::string> argv{"MSET"};
+                 for (auto idx : batch.indexes) {
+                     argv.push_back(batch.keys[idx]);
+                     argv.push_back(values[idx]);
+                 }
+                 return argv;
+             },
+             [](redisReply* reply, const ShardBatch&) {
+                 if (reply == nullptr) {
+                     LOG_ERROR("[RedisManager] MSET failed: command error");
+                     return false;
+                 }
+                 return reply->type == REDIS_REPLY_STATUS
+                        && strcasecmp(reply->str, "OK") == 0;
+             })) {
+        ok = ok && shard_ok;
     }
 
-    redisReply* reply = (redisReply*) redisCommand(context, cmd.c_str());
-
-    if (reply == nullptr) {
-        LOG_ERROR("[RedisManager] MSET failed: command error");
-        return false;
-    }
-
-    bool ok
-        = (reply->type == REDIS_REPLY_STATUS
-           && strcasecmp(reply->str, "OK") == 0);
-    freeReplyObject(reply);
-
     if (ok) {
         LOG_INFO("[RedisManager] MSET success: {} keys", key_values.size());
     } else {
@@ -994,58 +1049,57 @@ bool RedisManager::MSet(const std::map<std::string, std::string>& key_values) {
 
 std::vector<std::string> RedisManager::MGet(
     const std::vector<std::string>& keys) {
-    RedisConnGuard           guard(_pool.get());
-    redisContext*            context = guard.get();
     std::vector<std::string> result;
-
-    if (!context) {
-        LOG_ERROR("[RedisManager] MGET failed: no available connection");
-        return result;
-    }
-
     if (keys.empty()) {
         return result;
     }
 
-    // 构建MGET命令
-    std::string cmd = "MGET";
-    for (const auto& key : keys) {
-        cmd += " " + key;
-    }
-
-    redisReply* reply = (redisReply*) redisCommand(context, cmd.c_str());
-
-    if (reply == nullptr) {
-        LOG_ERROR("[RedisManager] MGET failed: command error");
-        return result;
-    }
-
-    if (reply->type != REDIS_REPLY_ARRAY) {
-        LOG_ERROR(
-            "[RedisManager] MGET failed: wrong type: {}, expected array",
-            reply->type);
-        freeReplyObject(reply);
+    // 每个分片一条 MGET 同时发出，结果按原始顺序回填
+    result.resize(keys.size());
+    auto groups = groupByShard(keys);
+    bool ok     = true;
+    for (bool shard_ok : runOnShards<bool>(
+             groups,
+             [](const ShardBatch& batch) {
+                 std::vector<std::string> argv{"MGET"};
+                 for (auto idx : batch.indexes) argv.push_back(batch.keys[idx]);
+                 return argv;
+             },
+             [&result](redisReply* reply, const ShardBatch& batch) {
+                 if (reply == nullptr) {
+                     LOG_ERROR("[RedisManager] MGET failed: command error");
+                     return false;
+                 }
+                 if (reply->type != REDIS_REPLY_ARRAY
+                     || reply->elements != batch.indexes.size()) {
+                     LOG_ERROR(
+                         "[RedisManager] MGET failed: wrong type: {}, expected array",
+                         reply->type);
+                     return false;
+                 }
+                 for (size_t i = 0; i < reply->elements; i++) {
+                     if (reply->element[i]->type == REDIS_REPLY_STRING) {
+                         result[batch.indexes[i]].assign(
+                             reply->element[i]->str, reply->element[i]->len);
+                     }   // nil or other types return empty string
+                 }
+                 return true;
+             })) {
+        ok = ok && shard_ok;
+    }
+
+    if (!ok) {
+        result.clear();
         return result;
     }
-
-    for (size_t i = 0; i < reply->elements; i++) {
-        if (reply->element[i]->type == REDIS_REPLY_STRING) {
-            result.push_back(reply->element[i]->str);
-        } else {
-            result.push_back("");   // nil or other types return empty string
-        }
-    }
-
-    freeReplyObject(reply);
     LOG_INFO("[RedisManager] MGET success: {} keys", keys.size());
-
     return result;
 }
 
 // 计数器操作
 
 long long RedisManager::Incr(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] INCR failed: no available connection");
@@ -1073,7 +1127,7 @@ long long RedisManager::Incr(const std::string& key) {
 }
 
 long long RedisManager::IncrBy(const std::string& key, long long delta) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] INCRBY failed: no available connection");
@@ -1105,7 +1159,7 @@ long long RedisManager::IncrBy(const std::string& key, long long delta) {
 }
 
 long long RedisManager::Decr(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] DECR failed: no available connection");
@@ -1133,7 +1187,7 @@ long long RedisManager::Decr(const std::string& key) {
 }
 
 long long RedisManager::DecrBy(const std::string& key, long long delta) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] DECRBY failed: no available connection");
@@ -1168,7 +1222,7 @@ long long RedisManager::DecrBy(const std::string& key, long long delta) {
 // 列表扩展操作
 
 bool RedisManager::LPushX(const std::string& key, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] LPUSHX failed: no available connection");
@@ -1197,7 +1251,7 @@ bool RedisManager::LPushX(const std::string& key, const std::string& value) {
 }
 
 bool RedisManager::RPushX(const std::string& key, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] RPUSHX failed: no available connection");
@@ -1226,7 +1280,7 @@ bool RedisManager::RPushX(const std::string& key, const std::string& value) {
 }
 
 long long RedisManager::LLen(const std::string& key) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] LLEN failed: no available connection");
@@ -1254,7 +1308,7 @@ long long RedisManager::LLen(const std::string& key) {
 
 bool RedisManager::LSet(
     const std::string& key, int index, const std::string& value) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] LSET failed: no available connection");
@@ -1284,7 +1338,7 @@ bool RedisManager::LSet(
 }
 
 std::string RedisManager::LIndex(const std::string& key, int index) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] LINDEX failed: no available connection");
@@ -1310,7 +1364,7 @@ std::string RedisManager::LIndex(const std::string& key, int index) {
 }
 
 bool RedisManager::LTrim(const std::string& key, int start, int stop) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] LTRIM failed: no available connection");
@@ -1346,7 +1400,14 @@ bool RedisManager::LTrim(const std::string& key, int start, int stop) {
 
 std::string RedisManager::RPopLPush(
     const std::string& source, const std::string& destination) {
-    RedisConnGuard guard(_pool.get());
+    if (ShardOf(source) != ShardOf(destination)) {
+        LOG_ERROR(
+            "[RedisManager] RPOPLPUSH failed: {} and {} are on different shards",
+            source,
+            destination);
+        return "";
+    }
+    RedisConnGuard guard(poolFor(source));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] RPOPLPUSH failed: no available connection");
@@ -1374,7 +1435,7 @@ std::string RedisManager::RPopLPush(
 
 bool RedisManager::ZAdd(
     const std::string& key, double score, const std::string& member) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] ZADD failed: no available connection");
@@ -1406,7 +1467,7 @@ bool RedisManager::ZAdd(
 }
 
 double RedisManager::ZScore(const std::string& key, const std::string& member) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] ZSCORE failed: no available connection");
@@ -1440,7 +1501,7 @@ double RedisManager::ZScore(const std::string& key, const std::string& member) {
 
 std::vector<std::string> RedisManager::ZRange(
     const std::string& key, int start, int stop) {
-    RedisConnGuard           guard(_pool.get());
+    RedisConnGuard           guard(poolFor(key));
     redisContext*            context = guard.get();
     std::vector<std::string> result;
 
@@ -1480,7 +1541,7 @@ std::vector<std::string> RedisManager::ZRange(
 
 long long RedisManager::ZRem(
     const std::string& key, const std::string& member) {
-    RedisConnGuard guard(_pool.get());
+    RedisConnGuard guard(poolFor(key));
     redisContext*  context = guard.get();
     if (!context) {
         LOG_ERROR("[RedisManager] ZREM failed: no available connection");
@@ -1513,38 +1574,284 @@ long long RedisManager::ZRem(
 
 bool RedisManager::Scan(
     const std::string& pattern, std::vector<std::string>& keys) {
-    RedisConnGuard guard(_pool.get());
-    redisContext*  context = guard.get();
+    keys.clear();
 
-    if (!context) {
-        return false;
+    // 每个分片各自 SCAN 一遍再合并
+    for (auto& shard : _shards) {
+        RedisConnGuard guard(shard.pool.get());
+        redisContext*  context = guard.get();
+
+        if (!context) {
+            return false;
+        }
+
+        std::string cursor = "0";
+        do {
+            redisReply* reply = (redisReply*) redisCommand(
+                context,
+                "SCAN %s MATCH %s COUNT 100",
+                cursor.c_str(),
+                pattern.c_str());
+
+            if (!reply || reply->type == REDIS_REPLY_ERROR) {
+                if (reply) freeReplyObject(reply);
+                return false;
+            }
+
+            cursor = reply->element[0]->str;
+
+            redisReply* keys_reply = reply->element[1];
+            for (size_t i = 0; i < keys_reply->elements; ++i) {
+                keys.push_back(keys_reply->element[i]->str);
+            }
+
+            freeReplyObject(reply);
+
+        } while (cursor != "0");
     }
 
-    std::string cursor = "0";
-    keys.clear();
+    return true;
+}
+
+
+// ============================================================================
+// Lua 脚本注册表
+// ============================================================================
+
+void RedisManager::loadBuiltinScripts() {
+    int loaded = 0;
+    for (const auto& script : RedisScripts::BUILTIN_SCRIPTS) {
+        if (LoadScript(script.name, script.source)) {
+            ++loaded;
+        }
+    }
+    LOG_INFO(
+        "[RedisManager] Loaded {}/{} builtin scripts",
+        loaded,
+        std::size(RedisScripts::BUILTIN_SCRIPTS));
+}
+
+bool RedisManager::LoadScript(
+    const std::string& name, const std::string& source) {
+    // 先登记源码，即使 SCRIPT LOAD 失败，EvalScript 也能回退到 EVAL
+    {
+        std::lock_guard<std::mutex> lock(_script_mutex);
+        _scripts[name].source = source;
+    }
+
+    // 同一脚本在所有分片上的 SHA 相同，逐个分片加载
+    std::string sha;
+    for (auto& shard : _shards) {
+        RedisConnGuard guard(shard.pool.get());
+        redisContext*  context = guard.get();
+        if (!context) {
+            LOG_ERROR("[RedisManager] SCRIPT LOAD failed: no available connection");
+            return false;
+        }
 
-    do {
         redisReply* reply = (redisReply*) redisCommand(
-            context,
-            "SCAN %s MATCH %s COUNT 100",
-            cursor.c_str(),
-            pattern.c_str());
+            context, "SCRIPT LOAD %b", source.data(), source.size());
+        if (reply == nullptr) {
+            LOG_ERROR("[RedisManager] SCRIPT LOAD failed: script={}", name);
+            return false;
+        }
 
-        if (!reply || reply->type == REDIS_REPLY_ERROR) {
-            if (reply) freeReplyObject(reply);
+        if (reply->type != REDIS_REPLY_STRING) {
+            LOG_ERROR(
+                "[RedisManager] SCRIPT LOAD failed: script={}, error={}",
+                name,
+                reply->type == REDIS_REPLY_ERROR ? reply->str : "wrong type");
+            freeReplyObject(reply);
             return false;
         }
 
-        cursor = reply->element[0]->str;
+        sha.assign(reply->str, reply->len);
+        freeReplyObject(reply);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_script_mutex);
+        _scripts[name].sha = sha;
+    }
+    LOG_INFO("[RedisManager] SCRIPT LOAD success: {} -> {}", name, sha);
+    return true;
+}
+
+redisReply* RedisManager::evalScript(
+    redisContext* context, const std::string& name,
+    const std::vector<std::string>& keys,
+    const std::vector<std::string>& args) {
+    ScriptEntry script;
+    {
+        std::lock_guard<std::mutex> lock(_script_mutex);
+        auto                        it = _scripts.find(name);
+        if (it == _scripts.end()) {
+            LOG_ERROR("[RedisManager] Unknown script: {}", name);
+            return nullptr;
+        }
+        script = it->second;
+    }
+
+    const std::string numkeys = std::to_string(keys.size());
 
-        redisReply* keys_reply = reply->element[1];
-        for (size_t i = 0; i < keys_reply->elements; ++i) {
-            keys.push_back(keys_reply->element[i]->str);
+    // argv: EVALSHA|EVAL <sha|source> numkeys key... arg...
+    std::vector<const char*> argv;
+    std::vector<size_t>      argvlen;
+    argv.reserve(3 + keys.size() + args.size());
+    argvlen.reserve(3 + keys.size() + args.size());
+
+    argv.push_back("EVALSHA");
+    argvlen.push_back(7);
+    argv.push_back(script.sha.data());
+    argvlen.push_back(script.sha.size());
+    argv.push_back(numkeys.data());
+    argvlen.push_back(numkeys.size());
+    for (const auto& key : keys) {
+        argv.push_back(key.data());
+        argvlen.push_back(key.size());
+    }
+    for (const auto& arg : args) {
+        argv.push_back(arg.data());
+        argvlen.push_back(arg.size());
+    }
+
+    redisReply* reply = nullptr;
+    if (!script.sha.empty()) {
+        reply = (redisReply*) redisCommandArgv(
+            context, static_cast<int>(argv.size()), argv.data(),
+            argvlen.data());
+        if (reply == nullptr) {
+            return nullptr;
+        }
+        if (reply->type != REDIS_REPLY_ERROR
+            || strncmp(reply->str, "NOSCRIPT", 8) != 0) {
+            return reply;
         }
+        freeReplyObject(reply);
+        LOG_WARN(
+            "[RedisManager] NOSCRIPT for {}, falling back to EVAL", name);
+    }
+
+    // 服务器脚本缓存被清空（重启 / SCRIPT FLUSH）或尚未加载：
+    // 直接 EVAL 源码，Redis 会顺带重新缓存该脚本，后续 EVALSHA 即可命中
+    argv[0]    = "EVAL";
+    argvlen[0] = 4;
+    argv[1]    = script.source.data();
+    argvlen[1] = script.source.size();
+    return (redisReply*) redisCommandArgv(
+        context, static_cast<int>(argv.size()), argv.data(), argvlen.data());
+}
+
+bool RedisManager::EvalScript(
+    const std::string& name, const std::vector<std::string>& keys,
+    const std::vector<std::string>& args, long long& result) {
+    // 按 KEYS[1] 路由；脚本里其他 key 要么只在脚本内访问，要么与 KEYS[1] 共用 hash tag
+    RedisConnGuard guard(poolFor(keys.empty() ? std::string() : keys[0]));
+    redisContext*  context = guard.get();
+    if (!context) {
+        LOG_ERROR("[RedisManager] EVALSHA failed: no available connection");
+        return false;
+    }
+
+    redisReply* reply = evalScript(context, name, keys, args);
+    if (reply == nullptr) {
+        LOG_ERROR("[RedisManager] EVALSHA failed: script={}", name);
+        return false;
+    }
 
+    if (reply->type != REDIS_REPLY_INTEGER) {
+        LOG_ERROR(
+            "[RedisManager] EVALSHA wrong reply: script={}, type={}, error={}",
+            name,
+            reply->type,
+            reply->type == REDIS_REPLY_ERROR ? reply->str : "");
         freeReplyObject(reply);
+        return false;
+    }
 
-    } while (cursor != "0");
+    result = reply->integer;
+    freeReplyObject(reply);
+    LOG_DEBUG("[RedisManager] EVALSHA success: {} => {}", name, result);
+    return true;
+}
 
+bool RedisManager::EvalScript(
+    const std::string& name, const std::vector<std::string>& keys,
+    const std::vector<std::string>& args, std::vector<std::string>& result) {
+    RedisConnGuard guard(poolFor(keys.empty() ? std::string() : keys[0]));
+    redisContext*  context = guard.get();
+    if (!context) {
+        LOG_ERROR("[RedisManager] EVALSHA failed: no available connection");
+        return false;
+    }
+
+    redisReply* reply = evalScript(context, name, keys, args);
+    if (reply == nullptr) {
+        LOG_ERROR("[RedisManager] EVALSHA failed: script={}", name);
+        return false;
+    }
+
+    if (reply->type != REDIS_REPLY_ARRAY) {
+        LOG_ERROR(
+            "[RedisManager] EVALSHA wrong reply: script={}, type={}, error={}",
+            name,
+            reply->type,
+            reply->type == REDIS_REPLY_ERROR ? reply->str : "");
+        freeReplyObject(reply);
+        return false;
+    }
+
+    result.clear();
+    result.reserve(reply->elements);
+    for (size_t i = 0; i < reply->elements; ++i) {
+        const redisReply* element = reply->element[i];
+        if (element->type == REDIS_REPLY_STRING
+            || element->type == REDIS_REPLY_STATUS) {
+            result.emplace_back(element->str, element->len);
+        } else if (element->type == REDIS_REPLY_INTEGER) {
+            result.push_back(std::to_string(element->integer));
+        } else {
+            result.emplace_back();
+        }
+    }
+
+    freeReplyObject(reply);
+    LOG_DEBUG(
+        "[RedisManager] EVALSHA success: {} => {} elements",
+        name,
+        result.size());
     return true;
 }
+
+redisContext* RedisManager::NewDedicatedConnection(std::size_t shard) {
+    if (shard >= _shards.size()) return nullptr;
+    const auto& host   = _shards[shard].host;
+    auto        port   = _shards[shard].port;
+    const auto& passwd = _passwd;
+
+    struct timeval timeout = {2, 0};
+    redisContext*  context
+        = redisConnectWithTimeout(host.c_str(), port, timeout);
+    if (context == nullptr || context->err != 0) {
+        if (context) {
+            LOG_ERROR(
+                "[RedisManager] dedicated connection failed: {}",
+                context->errstr);
+            redisFree(context);
+        }
+        return nullptr;
+    }
+
+    if (!passwd.empty()) {
+        auto* reply
+            = (redisReply*) redisCommand(context, "AUTH %s", passwd.c_str());
+        if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
+            LOG_ERROR("[RedisManager] dedicated connection auth failed");
+            if (reply) freeReplyObject(reply);
+            redisFree(context);
+            return nullptr;
+        }
+        freeReplyObject(reply);
+    }
+    return context;
+}
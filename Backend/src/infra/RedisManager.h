@@ -1,13 +1,16 @@
 #ifndef REDISMANAGER_H_
 #define REDISMANAGER_H_
 
+#include "ConsistentHash.h"
 #include "RedisConPool.h"
 #include "common/singleton.h"
 #include <hiredis/hiredis.h>
+#include <functional>
 #include <map>
 #include <memory>
 #include <spdlog/fmt/fmt.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -60,9 +63,6 @@ public:
     bool LRange(
         const std::string& key, int start, int stop,
         std::vector<std::string>& values);
-    std::string AcquireLock(
-        const std::string& lock_name, int lock_timout, int acquire_timeout);
-    bool ReleaseLock(const std::string& lock_name, const std::string& id);
 
     // @brief: 设置键的过期时间（秒）
     bool Expire(const std::string& key, int seconds);
@@ -167,11 +167,109 @@ public:
     // @brief: 扫描匹配的键
     bool Scan(const std::string& pattern, std::vector<std::string>& keys);
 
+    // @brief: 注册 Lua 脚本并 SCRIPT LOAD 到服务器
+    bool LoadScript(const std::string& name, const std::string& source);
+
+    // @brief: 按名称执行已注册脚本（EVALSHA，NOSCRIPT 时回退 EVAL），整数返回值
+    bool EvalScript(
+        const std::string& name, const std::vector<std::string>& keys,
+        const std::vector<std::string>& args, long long& result);
+
+    // @brief: 按名称执行已注册脚本，数组返回值（nil 元素记为空串）
+    bool EvalScript(
+        const std::string& name, const std::vector<std::string>& keys,
+        const std::vector<std::string>& args, std::vector<std::string>& result);
+
+    // @brief: 分片数量（[Redis] shards 未配置时为 1）
+    std::size_t ShardCount() const { return _shards.size(); }
+
+    // @brief: key 所在分片下标
+    std::size_t ShardOf(const std::string& key) const;
+
+    // @brief: 在指定分片上建立一条不进连接池的独立连接（已认证），
+    //         用于订阅/推送等长期阻塞读，调用方负责 redisFree
+    redisContext* NewDedicatedConnection(std::size_t shard = 0);
+
 private:
-    // @brief: 为每个锁分配一个uuid
-    std::string generateUUID();
+    struct ScriptEntry {
+        std::string source;
+        std::string sha;
+    };
+
+    void        loadBuiltinScripts();
+    redisReply* evalScript(
+        redisContext* context, const std::string& name,
+        const std::vector<std::string>& keys,
+        const std::vector<std::string>& args);
+
     RedisManager();
-    std::unique_ptr<RedisConPool> _pool;
+    struct Shard {
+        std::string                   host;
+        int                           port;
+        std::unique_ptr<RedisConPool> pool;
+    };
+
+    RedisConPool* poolFor(const std::string& key);
+
+    // 多 key 命令按分片拆分后的一批：indexes 为 keys 中属于该分片的下标
+    struct ShardBatch {
+        std::size_t                     shard;
+        const std::vector<std::string>& keys;
+        std::vector<std::size_t>        indexes;
+    };
+
+    std::vector<ShardBatch> groupByShard(const std::vector<std::string>& keys) const;
+
+    // @brief: 每个分片各取一条连接，先把各分片的命令全部发出再依次读回复，
+    //         各分片在服务端并发执行，调用线程上完成，不另起线程；
+    //         build 生成分片的命令，parse 解析回复（出错时为 nullptr，
+    //         由本函数释放），返回值按 batches 顺序排列
+    template <typename R, typename Build, typename Parse>
+    std::vector<R> runOnShards(
+        const std::vector<ShardBatch>& batches, Build build, Parse parse) {
+        std::vector<std::unique_ptr<RedisConnGuard>> guards;
+        std::vector<bool>                            sent(batches.size());
+        guards.reserve(batches.size());
+        for (std::size_t i = 0; i < batches.size(); ++i) {
+            guards.push_back(std::make_unique<RedisConnGuard>(
+                _shards[batches[i].shard].pool.get()));
+            redisContext* context = guards.back()->get();
+            if (!context) {
+                LOG_ERROR(
+                    "[RedisManager] shard {} has no available connection",
+                    batches[i].shard);
+                continue;
+            }
+            sent[i] = sendCommandArgv(context, build(batches[i]));
+        }
+
+        std::vector<R> results;
+        results.reserve(batches.size());
+        for (std::size_t i = 0; i < batches.size(); ++i) {
+            void* reply = nullptr;
+            if (sent[i]
+                && redisGetReply(guards[i]->get(), &reply) != REDIS_OK) {
+                reply = nullptr;
+            }
+            results.push_back(
+                parse(static_cast<redisReply*>(reply), batches[i]));
+            if (reply) freeReplyObject(reply);
+        }
+        return results;
+    }
+
+    static redisReply* commandArgv(
+        redisContext* context, const std::vector<std::string>& argv);
+    // @brief: 追加命令并立即写出，不等待回复
+    static bool sendCommandArgv(
+        redisContext* context, const std::vector<std::string>& argv);
+
+    std::vector<Shard> _shards;
+    ConsistentHashRing _ring;
+    std::string        _passwd;
+
+    std::mutex                                   _script_mutex;
+    std::unordered_map<std::string, ScriptEntry> _scripts;
 };
 
 
@@ -0,0 +1,172 @@
+#ifndef REDISSCRIPTS_H_
+#define REDISSCRIPTS_H_
+
+// 服务端 Lua 脚本集合
+// RedisManager 启动时统一 SCRIPT LOAD，之后按名称通过 EVALSHA 调用，
+// 把多步 读-改-写 操作合并成一次原子的往返
+
+namespace RedisScripts {
+
+struct ScriptDef {
+    const char* name;
+    const char* source;
+};
+
+// KEYS[1]: lock key, KEYS[2]: fencing 计数 key, ARGV[1]: lock id, ARGV[2]: 租期毫秒
+// 返回: 成功时为单调递增的 fencing token (>0)，失败时为 -(剩余毫秒 + 1)
+inline constexpr const char* ACQUIRE_LOCK = "acquire_lock";
+
+// KEYS[1]: lock key, ARGV[1]: lock id, ARGV[2]: 释放通知频道
+// 删除成功后向频道发布 lock key，唤醒等待者
+inline constexpr const char* RELEASE_LOCK = "release_lock";
+
+// KEYS[1]: lock key, ARGV[1]: lock id, ARGV[2]: 新租期毫秒
+inline constexpr const char* EXTEND_LOCK = "extend_lock";
+
+// KEYS[1]: chat:msg:<from>:<to>, KEYS[2]: chat:meta:<from>:<to>
+// ARGV[1]: message json, ARGV[2]: 当前时间戳
+inline constexpr const char* APPEND_CHAT_MSG = "append_chat_msg";
+
+// KEYS[1]: chat:msg:<from>:<to>, KEYS[2]: chat:meta:<from>:<to>
+// ARGV[1]: 已持久化（需要从队尾删除）的条数
+// 返回: 剩余条数
+inline constexpr const char* TRIM_PERSISTED_MSGS = "trim_persisted_msgs";
+
+// KEYS[1]: list key
+// 返回: 列表全部元素，并删除该列表
+inline constexpr const char* LIST_DRAIN = "list_drain";
+
+// KEYS[1]: hash key, ARGV[1]: 过期秒数, ARGV[2..]: field value ...
+inline constexpr const char* HASH_SET_EXPIRE = "hash_set_expire";
+
+// KEYS[1]: string key, ARGV[1]: 期望的旧值, ARGV[2]: 新值
+// 旧值未被改动时才替换（保留 TTL），用于缓存格式的惰性迁移
+// 返回: 1 替换成功, 0 值已变化
+inline constexpr const char* REPLACE_IF_EQUAL = "replace_if_equal";
+
+// KEYS[1]: 计数 hash, ARGV[1]: field, ARGV[2]: delta
+// 返回: 新值（不会小于 0）
+inline constexpr const char* HINCR_FLOOR_ZERO = "hincr_floor_zero";
+
+// KEYS[1]: 激活 hash, KEYS[2]: 计数 hash, ARGV: 候选服务器名
+// 返回: {name, count}，没有可用服务器时返回空数组
+inline constexpr const char* SELECT_LEAST_LOADED = "select_least_loaded";
+
+// KEYS[1]: 文件名 -> md5 hash, KEYS[2]: md5 -> 引用计数 hash
+// ARGV[1]: 文件名, ARGV[2]: md5
+// 返回: {新 md5 的引用计数, 引用减到 0 的旧 md5（没有则为空串）}
+inline constexpr const char* LINK_FILE_BLOB = "link_file_blob";
+
+// KEYS[1]: 分块上传位图, ARGV[1]: 块序号, ARGV[2]: 总块数, ARGV[3]: 过期秒数
+// 返回: 1 本次置位后全部块到齐（只会有一次调用返回 1）, 0 其他情况
+inline constexpr const char* MARK_UPLOAD_BLOCK = "mark_upload_block";
+
+inline constexpr ScriptDef BUILTIN_SCRIPTS[] = {
+    {ACQUIRE_LOCK,
+     "if redis.call('SET', KEYS[1], ARGV[1], 'NX', 'PX', ARGV[2]) then "
+     "  return redis.call('INCR', KEYS[2]) "
+     "end "
+     "local ttl = redis.call('PTTL', KEYS[1]) "
+     "if ttl < 0 then ttl = 0 end "
+     "return -ttl - 1"},
+
+    {RELEASE_LOCK,
+     "if redis.call('GET', KEYS[1]) == ARGV[1] then "
+     "  redis.call('DEL', KEYS[1]) "
+     "  redis.call('PUBLISH', ARGV[2], KEYS[1]) "
+     "  return 1 "
+     "end "
+     "return 0"},
+
+    {EXTEND_LOCK,
+     "if redis.call('GET', KEYS[1]) == ARGV[1] then "
+     "  return redis.call('PEXPIRE', KEYS[1], ARGV[2]) "
+     "end "
+     "return 0"},
+
+    {APPEND_CHAT_MSG,
+     "local n = redis.call('LPUSH', KEYS[1], ARGV[1]) "
+     "redis.call('HINCRBY', KEYS[2], 'count', 1) "
+     "redis.call('HSET', KEYS[2], 'last_write', ARGV[2]) "
+     "return n"},
+
+    {TRIM_PERSISTED_MSGS,
+     "local len = redis.call('LLEN', KEYS[1]) "
+     "if len == 0 then return 0 end "
+     "local keep = len - tonumber(ARGV[1]) "
+     "if keep <= 0 then "
+     "  redis.call('DEL', KEYS[1], KEYS[2]) "
+     "  return 0 "
+     "end "
+     "redis.call('LTRIM', KEYS[1], 0, keep - 1) "
+     "redis.call('HSET', KEYS[2], 'count', keep) "
+     "return keep"},
+
+    {LIST_DRAIN,
+     "local values = redis.call('LRANGE', KEYS[1], 0, -1) "
+     "if #values > 0 then redis.call('DEL', KEYS[1]) end "
+     "return values"},
+
+    {HASH_SET_EXPIRE,
+     "for i = 2, #ARGV, 2 do "
+     "  redis.call('HSET', KEYS[1], ARGV[i], ARGV[i + 1]) "
+     "end "
+     "local ttl = tonumber(ARGV[1]) "
+     "if ttl > 0 then redis.call('EXPIRE', KEYS[1], ttl) end "
+     "return 1"},
+
+    {REPLACE_IF_EQUAL,
+     "if redis.call('GET', KEYS[1]) == ARGV[1] then "
+     "  redis.call('SET', KEYS[1], ARGV[2], 'KEEPTTL') "
+     "  return 1 "
+     "end "
+     "return 0"},
+
+    {HINCR_FLOOR_ZERO,
+     "local v = redis.call('HINCRBY', KEYS[1], ARGV[1], ARGV[2]) "
+     "if v < 0 then "
+     "  redis.call('HSET', KEYS[1], ARGV[1], 0) "
+     "  return 0 "
+     "end "
+     "return v"},
+
+    {SELECT_LEAST_LOADED,
+     "local best, best_count = nil, nil "
+     "for i = 1, #ARGV do "
+     "  if redis.call('HEXISTS', KEYS[1], ARGV[i]) == 1 then "
+     "    local c = tonumber(redis.call('HGET', KEYS[2], ARGV[i]) or '0') "
+     "    if best_count == nil or c < best_count then "
+     "      best, best_count = ARGV[i], c "
+     "    end "
+     "  end "
+     "end "
+     "if best == nil then return {} end "
+     "return {best, tostring(best_count)}"},
+
+    {LINK_FILE_BLOB,
+     "local old = redis.call('HGET', KEYS[1], ARGV[1]) "
+     "if old == ARGV[2] then "
+     "  return {redis.call('HGET', KEYS[2], old) or '0', ''} "
+     "end "
+     "redis.call('HSET', KEYS[1], ARGV[1], ARGV[2]) "
+     "local refs = redis.call('HINCRBY', KEYS[2], ARGV[2], 1) "
+     "local orphan = '' "
+     "if old then "
+     "  if redis.call('HINCRBY', KEYS[2], old, -1) <= 0 then "
+     "    redis.call('HDEL', KEYS[2], old) "
+     "    orphan = old "
+     "  end "
+     "end "
+     "return {tostring(refs), orphan}"},
+
+    {MARK_UPLOAD_BLOCK,
+     "local old = redis.call('SETBIT', KEYS[1], ARGV[1], 1) "
+     "redis.call('EXPIRE', KEYS[1], ARGV[3]) "
+     "if old == 0 and redis.call('BITCOUNT', KEYS[1]) == tonumber(ARGV[2]) "
+     "then return 1 end "
+     "return 0"},
+};
+
+}   // namespace RedisScripts
+
+#endif   // REDISSCRIPTS_H_
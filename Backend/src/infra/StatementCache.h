@@ -0,0 +1,88 @@
+#ifndef STATEMENTCACHE_H_
+#define STATEMENTCACHE_H_
+
+#include <atomic>
+#include <cppconn/connection.h>
+#include <cppconn/prepared_statement.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// 同一连接池内所有连接共享的命中计数
+struct StatementCacheCounters {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+struct StatementCacheStats {
+    uint64_t hits      = 0;
+    uint64_t misses    = 0;
+    uint64_t evictions = 0;
+
+    double hit_ratio() const {
+        auto total = hits + misses;
+        if (total == 0) return 0.0;
+        return static_cast<double>(hits) / total;
+    }
+};
+
+// 单个连接上的预编译语句 LRU 缓存，按 SQL 文本索引
+// 服务端预编译语句只在创建它的连接上有效，因此每个池化连接各持有一份；
+// 连接被借出期间只有一个线程使用，内部不加锁
+class StatementCache {
+public:
+    StatementCache(
+        sql::Connection* conn, std::size_t capacity,
+        StatementCacheCounters* counters)
+        : _conn(conn), _capacity(capacity), _counters(counters) {}
+
+    // @brief: 取出（或首次预编译并缓存）SQL 对应的语句
+    //         返回 shared_ptr，调用方持有期间即使被淘汰也不会失效；
+    //         只适合 SQL 文本固定的语句，表名/VALUES 个数会变的语句直接 prepareStatement
+    std::shared_ptr<sql::PreparedStatement> Prepare(const std::string& sql) {
+        auto it = _index.find(sql);
+        if (it != _index.end()) {
+            _lru.splice(_lru.begin(), _lru, it->second);
+            _counters->hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->second;
+        }
+
+        _counters->misses.fetch_add(1, std::memory_order_relaxed);
+        std::shared_ptr<sql::PreparedStatement> stmt(_conn->prepareStatement(sql));
+        if (_capacity == 0) {
+            return stmt;
+        }
+
+        _lru.emplace_front(sql, stmt);
+        _index[sql] = _lru.begin();
+        while (_lru.size() > _capacity) {
+            _index.erase(_lru.back().first);
+            _lru.pop_back();
+            _counters->evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        return stmt;
+    }
+
+    // @brief: 丢弃全部语句（连接出错或重连后调用，旧语句已不可用）
+    void Clear() {
+        _index.clear();
+        _lru.clear();
+    }
+
+    std::size_t Size() const { return _lru.size(); }
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<sql::PreparedStatement>>;
+
+    sql::Connection*                                           _conn;
+    std::size_t                                                _capacity;
+    StatementCacheCounters*                                    _counters;
+    std::list<Entry>                                           _lru;   // 头部最新
+    std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+};
+
+#endif   // STATEMENTCACHE_H_
@@ -1,6 +1,7 @@
 #include "ChatServerRepository.h"
 #include "common/ChatServerInfo.h"
 #include "infra/RedisManager.h"
+#include "infra/RedisScripts.h"
 #include <cstdlib>
 
 
@@ -14,7 +15,12 @@ void ChatServerRepository::DelConnectionCount(const std::string &server_name) {
 }
 
 int ChatServerRepository::DecrConnection(const std::string &server_name) {
-    return RedisManager::getInstance()->HIncrBy(LOGIN_COUNT, server_name, -1);
+    // 计数在服务端夹到 0，避免重置后迟到的断开把计数减成负数
+    long long count = -1;
+    RedisManager::getInstance()->EvalScript(
+        RedisScripts::HINCR_FLOOR_ZERO, {LOGIN_COUNT}, {server_name, "-1"},
+        count);
+    return static_cast<int>(count);
 }
 
 int ChatServerRepository::GetConnectionCount(const std::string &server_name) {
@@ -40,3 +46,20 @@ bool ChatServerRepository::isServerActivated(const std::string& server_name) {
 void ChatServerRepository::DeactivateServer(const std::string& server_name) {
     RedisManager::getInstance()->HDel(ACTIVATE, server_name);
 }
+
+std::string ChatServerRepository::SelectLeastLoadedServer(
+    const std::vector<std::string>& server_names, int& count) {
+    // 激活检查 + 计数读取 + 取最小值在一次脚本调用里完成，
+    // 替代逐个服务器 HGET ACTIVATE / HGET LOGIN_COUNT 的 2N 次往返
+    std::vector<std::string> best;
+    if (!RedisManager::getInstance()->EvalScript(
+            RedisScripts::SELECT_LEAST_LOADED,
+            {ACTIVATE, LOGIN_COUNT},
+            server_names,
+            best)
+        || best.size() != 2) {
+        return "";
+    }
+    count = std::atoi(best[1].c_str());
+    return best[0];
+}
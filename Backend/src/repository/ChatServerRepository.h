@@ -3,6 +3,9 @@
 
 #include "common/ChatServerInfo.h"
 #include "common/singleton.h"
+#include <string>
+#include <vector>
+
 class ChatServerRepository : public SingleTon<ChatServerRepository> {
     friend class SingleTon<ChatServerRepository>;
 
@@ -15,6 +18,9 @@ public:
     static void ActivateServer(const std::string& server_name);
     static void DeactivateServer(const std::string& server_name);
     static bool isServerActivated(const std::string& server_name);
+    // @brief: 在候选服务器中选出已激活且连接数最少的一个，没有则返回空串
+    static std::string SelectLeastLoadedServer(
+        const std::vector<std::string>& server_names, int& count);
 
 private:
 };
@@ -4,6 +4,7 @@
 #include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
 #include "infra/RedisManager.h"
+#include "infra/RedisScripts.h"
 #include "read.h"
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -16,6 +17,8 @@
 
 static constexpr const char* UPLOAD_PROGRESS_PREFIX = "upload_progress:";
 static constexpr const char* UPLOAD_BLOCK_PREFIX    = "upload_blocks:";
+static constexpr const char* UPLOAD_SESSION_PREFIX  = "upload_session:";
+static constexpr const char* UPLOAD_BITMAP_PREFIX   = "upload_bitmap:";
 static constexpr int         DEFAULT_EXPIRE_SECONDS = 24 * 3600;   // 24小时
 static constexpr int         BLOCK_CHECKPOINT_EXPIRE_SECONDS = 7 * 24 * 3600;
 using int64                                                  = int64_t;
@@ -32,6 +35,14 @@ std::string FileRepository::FormatBlockFieldKey(int block_index) {
     return "block_" + std::to_string(block_index);
 }
 
+std::string FileRepository::FormatSessionKey(const std::string& file_md5) {
+    return std::string(UPLOAD_SESSION_PREFIX) + file_md5;
+}
+
+std::string FileRepository::FormatBitmapKey(const std::string& file_md5) {
+    return std::string(UPLOAD_BITMAP_PREFIX) + file_md5;
+}
+
 int FileRepository::GetCurrentTimestamp() {
     return std::chrono::duration_cast<std::chrono::seconds>(
                std::chrono::system_clock::now().time_since_epoch())
@@ -66,50 +77,24 @@ Result<void> FileRepository::SaveUploadProgress(
     std::string key       = FormatProgressKey(file_md5);
     int         timestamp = GetCurrentTimestamp();
 
-    auto hset_file_name = redisManager->HSet(key, "file_name", file_name);
-    if (!hset_file_name) {
-        LOG_ERROR(
-            "[FileRepository] Failed to set file_name for md5: {}", file_md5);
-        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
-    }
-
-    auto hset_total_size
-        = redisManager->HSet(key, "total_size", std::to_string(total_size));
-    if (!hset_total_size) {
+    // 全部字段 + EXPIRE 一次往返完成
+    long long ok = 0;
+    if (!redisManager->EvalScript(
+            RedisScripts::HASH_SET_EXPIRE,
+            {key},
+            {std::to_string(DEFAULT_EXPIRE_SECONDS),
+             "file_name", file_name,
+             "total_size", std::to_string(total_size),
+             "uploaded_bytes", std::to_string(uploaded_bytes),
+             "status", status,
+             "updated_at", std::to_string(timestamp)},
+            ok)) {
         LOG_ERROR(
-            "[FileRepository] Failed to set total_size for md5: {}", file_md5);
-        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
-    }
-
-    auto hset_uploaded_bytes = redisManager->HSet(
-        key, "uploaded_bytes", std::to_string(uploaded_bytes));
-    if (!hset_uploaded_bytes) {
-        LOG_ERROR(
-            "[FileRepository] Failed to set uploaded_bytes for md5: {}",
+            "[FileRepository] Failed to save upload progress for md5: {}",
             file_md5);
         return Result<void>::Error(ErrorCodes::REDIS_ERROR);
     }
 
-    auto hset_status = redisManager->HSet(key, "status", status);
-    if (!hset_status) {
-        LOG_ERROR(
-            "[FileRepository] Failed to set status for md5: {}", file_md5);
-        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
-    }
-
-    auto hset_updated_at
-        = redisManager->HSet(key, "updated_at", std::to_string(timestamp));
-    if (!hset_updated_at) {
-        LOG_WARN(
-            "[FileRepository] Failed to set updated_at for md5: {}", file_md5);
-    }
-
-    auto set_expire = SetUploadExpire(file_md5, DEFAULT_EXPIRE_SECONDS);
-    if (!set_expire.IsOK()) {
-        LOG_WARN(
-            "[FileRepository] Failed to set expiration for md5: {}", file_md5);
-    }
-
     LOG_INFO(
         "[FileRepository] Saved upload progress: md5={}, name={}, total={}, "
         "uploaded={}, status={}",
@@ -133,8 +118,9 @@ Result<UploadProgress> FileRepository::GetUploadProgress(
 
     std::string key = FormatProgressKey(file_md5);
 
-    auto exists = ExistsUploadProgress(file_md5);
-    if (!exists.IsOK() || !exists.Value()) {
+    // 一次 HGETALL 取回全部字段
+    auto fields = redisManager->HGetAll(key);
+    if (fields.empty()) {
         LOG_DEBUG(
             "[FileRepository] No upload progress found for md5: {}", file_md5);
         return Result<UploadProgress>::Error(ErrorCodes::REDIS_ERROR);
@@ -143,14 +129,18 @@ Result<UploadProgress> FileRepository::GetUploadProgress(
     UploadProgress progress;
     progress.file_md5 = file_md5;
 
-    auto file_name = redisManager->HGet(key, "file_name");
-    if (file_name.empty()) {
+    const auto field = [&fields](const char* name) -> std::string {
+        auto it = fields.find(name);
+        return it == fields.end() ? std::string() : it->second;
+    };
+
+    progress.file_name = field("file_name");
+    if (progress.file_name.empty()) {
         LOG_ERROR("[FileRepository] file_name not found for md5: {}", file_md5);
         return Result<UploadProgress>::Error(ErrorCodes::REDIS_ERROR);
     }
-    progress.file_name = file_name;
 
-    auto total_size_str = redisManager->HGet(key, "total_size");
+    auto total_size_str = field("total_size");
     if (total_size_str.empty()) {
         LOG_ERROR(
             "[FileRepository] total_size not found for md5: {}", file_md5);
@@ -158,7 +148,7 @@ Result<UploadProgress> FileRepository::GetUploadProgress(
     }
     progress.total_size = std::atoll(total_size_str.c_str());
 
-    auto uploaded_bytes_str = redisManager->HGet(key, "uploaded_bytes");
+    auto uploaded_bytes_str = field("uploaded_bytes");
     if (uploaded_bytes_str.empty()) {
         LOG_ERROR(
             "[FileRepository] uploaded_bytes not found for md5: {}", file_md5);
@@ -166,14 +156,13 @@ Result<UploadProgress> FileRepository::GetUploadProgress(
     }
     progress.uploaded_bytes = std::atoll(uploaded_bytes_str.c_str());
 
-    auto status = redisManager->HGet(key, "status");
-    if (status.empty()) {
+    progress.status = field("status");
+    if (progress.status.empty()) {
         LOG_ERROR("[FileRepository] status not found for md5: {}", file_md5);
         return Result<UploadProgress>::Error(ErrorCodes::REDIS_ERROR);
     }
-    progress.status = status;
 
-    auto updated_at_str = redisManager->HGet(key, "updated_at");
+    auto updated_at_str = field("updated_at");
     if (!updated_at_str.empty()) {
         progress.updated_at = std::atoi(updated_at_str.c_str());
     }
@@ -200,24 +189,21 @@ Result<void> FileRepository::UpdateUploadProgress(
 
     std::string key = FormatProgressKey(file_md5);
 
-    auto hset_uploaded = redisManager->HSet(
-        key, "uploaded_bytes", std::to_string(uploaded_bytes));
-    if (!hset_uploaded) {
+    // uploaded_bytes + updated_at 一次往返，TTL 为 0 表示不修改过期时间
+    long long ok = 0;
+    if (!redisManager->EvalScript(
+            RedisScripts::HASH_SET_EXPIRE,
+            {key},
+            {"0",
+             "uploaded_bytes", std::to_string(uploaded_bytes),
+             "updated_at", std::to_string(GetCurrentTimestamp())},
+            ok)) {
         LOG_ERROR(
             "[FileRepository] Failed to update uploaded_bytes for md5: {}",
             file_md5);
         return Result<void>::Error(ErrorCodes::REDIS_ERROR);
     }
 
-    int  timestamp = GetCurrentTimestamp();
-    auto hset_updated
-        = redisManager->HSet(key, "updated_at", std::to_string(timestamp));
-    if (!hset_updated) {
-        LOG_WARN(
-            "[FileRepository] Failed to update updated_at for md5: {}",
-            file_md5);
-    }
-
     LOG_DEBUG(
         "[FileRepository] Updated upload progress: md5={}, uploaded_bytes={}",
         file_md5,
@@ -360,38 +346,23 @@ Result<void> FileRepository::SaveDownloadProgress(
     std::string key       = FormatDownloadProgressKey(file_name, session_id);
     int         timestamp = GetCurrentTimestamp();
 
-    auto hset_file_name = redisManager->HSet(key, "file_name", file_name);
-    if (!hset_file_name) {
-        LOG_ERROR(
-            "[FileRepository] Failed to set file_name for: {}", file_name);
-        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
-    }
-
-    auto hset_session_id = redisManager->HSet(key, "session_id", session_id);
-    if (!hset_session_id) {
-        LOG_ERROR(
-            "[FileRepository] Failed to set session_id for: {}", session_id);
-        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
-    }
-
-    auto hset_downloaded = redisManager->HSet(
-        key, "downloaded_bytes", std::to_string(downloaded_bytes));
-    if (!hset_downloaded) {
+    long long ok = 0;
+    if (!redisManager->EvalScript(
+            RedisScripts::HASH_SET_EXPIRE,
+            {key},
+            {std::to_string(DEFAULT_EXPIRE_SECONDS),
+             "file_name", file_name,
+             "session_id", session_id,
+             "downloaded_bytes", std::to_string(downloaded_bytes),
+             "updated_at", std::to_string(timestamp)},
+            ok)) {
         LOG_ERROR(
-            "[FileRepository] Failed to set downloaded_bytes for: {}",
-            downloaded_bytes);
+            "[FileRepository] Failed to save download progress for: {}:{}",
+            file_name,
+            session_id);
         return Result<void>::Error(ErrorCodes::REDIS_ERROR);
     }
 
-    auto hset_updated_at
-        = redisManager->HSet(key, "updated_at", std::to_string(timestamp));
-    if (!hset_updated_at) {
-        LOG_WARN(
-            "[FileRepository] Failed to set updated_at for: {}", file_name);
-    }
-
-    redisManager->Expire(key, DEFAULT_EXPIRE_SECONDS);
-
     LOG_INFO(
         "[FileRepository] Saved download progress: file={}, session={}, "
         "bytes={}",
@@ -413,8 +384,9 @@ Result<DownloadProgress> FileRepository::GetDownloadProgress(
 
     std::string key = FormatDownloadProgressKey(file_name, session_id);
 
-    std::string retrieved_file_name = redisManager->HGet(key, "file_name");
-    if (retrieved_file_name.empty()) {
+    auto fields = redisManager->HGetAll(key);
+    auto file_it = fields.find("file_name");
+    if (file_it == fields.end() || file_it->second.empty()) {
         LOG_DEBUG(
             "[FileRepository] Download progress not found for: {}:{}",
             file_name,
@@ -423,19 +395,19 @@ Result<DownloadProgress> FileRepository::GetDownloadProgress(
     }
 
     DownloadProgress progress;
-    progress.file_name  = retrieved_file_name;
+    progress.file_name  = file_it->second;
     progress.session_id = session_id;
 
-    auto downloaded_bytes_str = redisManager->HGet(key, "downloaded_bytes");
-    if (downloaded_bytes_str.empty()) {
+    auto downloaded_it = fields.find("downloaded_bytes");
+    if (downloaded_it == fields.end() || downloaded_it->second.empty()) {
         LOG_ERROR("[FileRepository] downloaded_bytes not found for: {}", key);
         return Result<DownloadProgress>::Error(ErrorCodes::REDIS_ERROR);
     }
-    progress.downloaded_bytes = std::atoll(downloaded_bytes_str.c_str());
+    progress.downloaded_bytes = std::atoll(downloaded_it->second.c_str());
 
-    auto updated_at_str = redisManager->HGet(key, "updated_at");
-    if (!updated_at_str.empty()) {
-        progress.updated_at = std::atoi(updated_at_str.c_str());
+    auto updated_it = fields.find("updated_at");
+    if (updated_it != fields.end() && !updated_it->second.empty()) {
+        progress.updated_at = std::atoi(updated_it->second.c_str());
     }
 
     return Result<DownloadProgress>::OK(progress);
@@ -453,9 +425,14 @@ Result<void> FileRepository::UpdateDownloadProgress(
 
     std::string key = FormatDownloadProgressKey(file_name, session_id);
 
-    auto hset_downloaded = redisManager->HSet(
-        key, "downloaded_bytes", std::to_string(downloaded_bytes));
-    if (!hset_downloaded) {
+    long long ok = 0;
+    if (!redisManager->EvalScript(
+            RedisScripts::HASH_SET_EXPIRE,
+            {key},
+            {"0",
+             "downloaded_bytes", std::to_string(downloaded_bytes),
+             "updated_at", std::to_string(GetCurrentTimestamp())},
+            ok)) {
         LOG_ERROR(
             "[FileRepository] Failed to update downloaded_bytes for: {}:{}",
             file_name,
@@ -463,16 +440,6 @@ Result<void> FileRepository::UpdateDownloadProgress(
         return Result<void>::Error(ErrorCodes::REDIS_ERROR);
     }
 
-    int  timestamp = GetCurrentTimestamp();
-    auto hset_updated_at
-        = redisManager->HSet(key, "updated_at", std::to_string(timestamp));
-    if (!hset_updated_at) {
-        LOG_WARN(
-            "[FileRepository] Failed to update updated_at for::{}",
-            file_name,
-            session_id);
-    }
-
     LOG_DEBUG(
         "[FileRepository] Updated download progress: file={}, session={}, "
         "bytes={}",
@@ -613,8 +580,13 @@ Result<void> FileRepository::SaveBlockCheckpoint(
     std::string key   = FormatBlockKey(file_md5);
     std::string field = FormatBlockFieldKey(block_index);
 
-    auto hset_result = redisManager->HSet(key, field, block_md5);
-    if (!hset_result) {
+    // HSET + EXPIRE 一次往返完成
+    long long ok = 0;
+    if (!redisManager->EvalScript(
+            RedisScripts::HASH_SET_EXPIRE,
+            {key},
+            {std::to_string(BLOCK_CHECKPOINT_EXPIRE_SECONDS), field, block_md5},
+            ok)) {
         LOG_ERROR(
             "[FileRepository] Failed to save block checkpoint: md5={}, "
             "block={}",
@@ -623,9 +595,6 @@ Result<void> FileRepository::SaveBlockCheckpoint(
         return Result<void>::Error(ErrorCodes::REDIS_ERROR);
     }
 
-    // 设置块校验点的过期时间
-    redisManager->Expire(key, BLOCK_CHECKPOINT_EXPIRE_SECONDS);
-
     LOG_DEBUG(
         "[FileRepository] Saved block checkpoint: md5={}, block={}, md5={}",
         file_md5,
@@ -769,6 +738,142 @@ Result<int> FileRepository::CountCompletedBlocks(
     return Result<int>::OK(count);
 }
 
+// ============================================================================
+// 分块上传会话实现
+// ============================================================================
+
+Result<void> FileRepository::SaveUploadSession(const UploadSession& session) {
+    auto redisManager = RedisManager::getInstance();
+    if (!redisManager) {
+        LOG_ERROR("[FileRepository] RedisManager instance is null");
+        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    long long ok = 0;
+    if (!redisManager->EvalScript(
+            RedisScripts::HASH_SET_EXPIRE,
+            {FormatSessionKey(session.file_md5)},
+            {std::to_string(BLOCK_CHECKPOINT_EXPIRE_SECONDS),
+             "file_name", session.file_name,
+             "total_size", std::to_string(session.total_size),
+             "block_size", std::to_string(session.block_size),
+             "block_count", std::to_string(session.block_count)},
+            ok)) {
+        LOG_ERROR(
+            "[FileRepository] Failed to save upload session for md5: {}",
+            session.file_md5);
+        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    LOG_INFO(
+        "[FileRepository] Saved upload session: md5={}, name={}, total={}, "
+        "block_size={}, blocks={}",
+        session.file_md5,
+        session.file_name,
+        session.total_size,
+        session.block_size,
+        session.block_count);
+
+    return Result<void>::OK();
+}
+
+Result<UploadSession> FileRepository::GetUploadSession(
+    const std::string& file_md5) {
+
+    auto redisManager = RedisManager::getInstance();
+    if (!redisManager) {
+        LOG_ERROR("[FileRepository] RedisManager instance is null");
+        return Result<UploadSession>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    auto fields = redisManager->HGetAll(FormatSessionKey(file_md5));
+    if (fields.empty()) {
+        LOG_DEBUG(
+            "[FileRepository] No upload session found for md5: {}", file_md5);
+        return Result<UploadSession>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    const auto field = [&fields](const char* name) -> std::string {
+        auto it = fields.find(name);
+        return it == fields.end() ? std::string() : it->second;
+    };
+
+    UploadSession session;
+    session.file_md5    = file_md5;
+    session.file_name   = field("file_name");
+    session.total_size  = std::atoll(field("total_size").c_str());
+    session.block_size  = std::atoi(field("block_size").c_str());
+    session.block_count = std::atoi(field("block_count").c_str());
+    if (session.file_name.empty() || session.total_size <= 0
+        || session.block_size <= 0 || session.block_count <= 0) {
+        LOG_ERROR(
+            "[FileRepository] Corrupted upload session for md5: {}", file_md5);
+        return Result<UploadSession>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    return Result<UploadSession>::OK(session);
+}
+
+Result<std::string> FileRepository::GetReceivedBlocks(
+    const std::string& file_md5) {
+
+    auto redisManager = RedisManager::getInstance();
+    if (!redisManager) {
+        LOG_ERROR("[FileRepository] RedisManager instance is null");
+        return Result<std::string>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    std::string key = FormatBitmapKey(file_md5);
+    std::string bitmap;
+    if (redisManager->ExistsKey(key) && !redisManager->Get(key, bitmap)) {
+        return Result<std::string>::Error(ErrorCodes::REDIS_ERROR);
+    }
+    return Result<std::string>::OK(bitmap);
+}
+
+Result<bool> FileRepository::MarkBlockReceived(
+    const std::string& file_md5, int32_t block_index, int32_t block_count) {
+
+    auto redisManager = RedisManager::getInstance();
+    if (!redisManager) {
+        LOG_ERROR("[FileRepository] RedisManager instance is null");
+        return Result<bool>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    // SETBIT + EXPIRE + BITCOUNT 一次往返，并发的流里只有一个会看到"到齐"
+    long long completed = 0;
+    if (!redisManager->EvalScript(
+            RedisScripts::MARK_UPLOAD_BLOCK,
+            {FormatBitmapKey(file_md5)},
+            {std::to_string(block_index),
+             std::to_string(block_count),
+             std::to_string(BLOCK_CHECKPOINT_EXPIRE_SECONDS)},
+            completed)) {
+        LOG_ERROR(
+            "[FileRepository] Failed to mark block: md5={}, block={}",
+            file_md5,
+            block_index);
+        return Result<bool>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    return Result<bool>::OK(completed == 1);
+}
+
+Result<void> FileRepository::DeleteUploadSession(const std::string& file_md5) {
+    auto redisManager = RedisManager::getInstance();
+    if (!redisManager) {
+        LOG_ERROR("[FileRepository] RedisManager instance is null");
+        return Result<void>::Error(ErrorCodes::REDIS_ERROR);
+    }
+
+    redisManager->Del(FormatSessionKey(file_md5));
+    redisManager->Del(FormatBitmapKey(file_md5));
+
+    LOG_INFO("[FileRepository] Deleted upload session for md5: {}", file_md5);
+
+    return Result<void>::OK();
+}
+
 Result<DownloadProgress> FileRepository::GetLatestDownloadProgress(
     const std::string& file_name) {
 
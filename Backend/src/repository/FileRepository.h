@@ -25,6 +25,15 @@ struct DownloadProgress {
     int         updated_at;
 };
 
+// 分块上传会话
+struct UploadSession {
+    std::string file_md5;
+    std::string file_name;
+    int64_t     total_size  = 0;
+    int32_t     block_size  = 0;
+    int32_t     block_count = 0;
+};
+
 // 分块信息结构
 struct ChunkInfo {
     int32_t     chunk_index;
@@ -77,6 +86,16 @@ public:
     static Result<int>  CountCompletedBlocks(
          const std::string& file_md5, int block_size = DEFAULT_BLOCK_SIZE);
 
+    // 分块上传会话：会话信息与已收到块的位图，块序号即位图中的位
+    static Result<void> SaveUploadSession(const UploadSession& session);
+    static Result<UploadSession> GetUploadSession(const std::string& file_md5);
+    // @brief: 位图原样返回（Redis 位序），没有记录时为空串
+    static Result<std::string> GetReceivedBlocks(const std::string& file_md5);
+    // @brief: 标记块已落盘；本次标记使全部块到齐时返回 true
+    static Result<bool> MarkBlockReceived(
+        const std::string& file_md5, int32_t block_index, int32_t block_count);
+    static Result<void> DeleteUploadSession(const std::string& file_md5);
+
     // 下载断点管理方法
     static Result<void> SaveDownloadProgress(
         const std::string& file_name, const std::string& session_id,
@@ -113,6 +132,8 @@ private:
     static std::string FormatProgressKey(const std::string& file_md5);
     static std::string FormatBlockKey(const std::string& file_md5);
     static std::string FormatBlockFieldKey(int block_index);
+    static std::string FormatSessionKey(const std::string& file_md5);
+    static std::string FormatBitmapKey(const std::string& file_md5);
     static std::string FormatDownloadProgressKey(
         const std::string& file_name, const std::string& session_id);
     static int         GetCurrentTimestamp();
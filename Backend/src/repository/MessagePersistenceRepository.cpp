@@ -1,20 +1,33 @@
 #include "MessagePersistenceRepository.h"
+#include "common/MessageRecord.h"
+#include "common/MessageSearch.h"
 #include "common/const.h"
 #include "common/result.h"
 #include "dao/MsgDAO.h"
+#include "dao/MsgSearchDAO.h"
 #include "infra/LogManager.h"
+#include "infra/MessageArchive.h"
+#include "infra/MessageShardMap.h"
 #include "infra/RedisManager.h"
+#include "infra/RedisScripts.h"
 #include "service/UserService.h"
 #include <json/reader.h>
 #include <json/writer.h>
 #include <string>
 #include <algorithm>
+#include <iterator>
+#include <map>
 #include <vector>
 const std::string MessagePersistenceRepository::CHAT_MSG_PREFIX  = "chat:msg:";
 const std::string MessagePersistenceRepository::CHAT_META_PREFIX = "chat:meta:";
 const std::string MessagePersistenceRepository::RECENT_MSG_PREFIX
     = "recent:msgs:";
+const std::string MessagePersistenceRepository::CHAT_SEQ_PREFIX = "chat:seq:";
 const int MessagePersistenceRepository::CACHE_TTL_SECONDS = 7200;   // 2 hours
+const int64_t MessagePersistenceRepository::HOT_TABLE_SLACK_SEC
+    = 31 * 24 * 60 * 60;
+const int64_t MessagePersistenceRepository::HOT_LOOKBACK_SEC
+    = 400 * 24 * 60 * 60;
 
 Result<void> MessagePersistenceRepository::SaveChatMessage(
     int from_uid, int to_uid, const std::string& msg_json) {
@@ -24,16 +37,18 @@ Result<void> MessagePersistenceRepository::SaveChatMessage(
     std::string meta_key = CHAT_META_PREFIX + std::to_string(from_uid) + ":"
                            + std::to_string(to_uid);
 
-    if (!redis->LPush(msg_key, msg_json)) {
+    // LPUSH + 元数据更新（count / last_write）合并为一次原子脚本调用
+    long long queue_len = 0;
+    if (!redis->EvalScript(
+            RedisScripts::APPEND_CHAT_MSG,
+            {msg_key, meta_key},
+            {msg_json, std::to_string(std::time(nullptr))},
+            queue_len)) {
         LOG_ERROR(
             "Failed to push message to Redis cache: {}:{}", from_uid, to_uid);
         return Result<void>::Error(ErrorCodes::REDIS_ERROR);
     }
 
-    // 更新元数据（消息计数）
-    redis->HIncrBy(meta_key, "count", 1);
-    redis->HSet(meta_key, "last_write", std::to_string(std::time(nullptr)));
-
     LOG_DEBUG("Saved message to cache: {} -> {}", from_uid, to_uid);
     return Result<void>::OK();
 }
@@ -45,26 +60,16 @@ MessagePersistenceRepository::GetMessagesFromCache(
     std::string msg_key = CHAT_MSG_PREFIX + std::to_string(from_uid) + ":"
                           + std::to_string(to_uid);
 
-    // 从 Redis 读取所有消息
-    std::vector<std::string> all_msgs;
-    if (!redis->LRange(msg_key, 0, -1, all_msgs)) {
-        LOG_ERROR("Failed to get messages from Redis: {}:{}", from_uid, to_uid);
-        return Result<std::vector<std::string>>::Error(ErrorCodes::REDIS_ERROR);
-    }
-
-    if (all_msgs.empty()) {
+    if (count <= 0) {
         return Result<std::vector<std::string>>::OK(std::vector<std::string>());
     }
 
-    // 取最后 count 条（最旧的消息）
+    // 只取最后 count 条（最旧的消息）
     // List 结构：左侧是最新消息，右侧是最旧消息
     std::vector<std::string> result;
-    size_t start = (all_msgs.size() > static_cast<size_t>(count))
-                       ? (all_msgs.size() - count)
-                       : 0;
-
-    for (size_t i = start; i < all_msgs.size(); ++i) {
-        result.push_back(all_msgs[i]);
+    if (!redis->LRange(msg_key, -count, -1, result)) {
+        LOG_ERROR("Failed to get messages from Redis: {}:{}", from_uid, to_uid);
+        return Result<std::vector<std::string>>::Error(ErrorCodes::REDIS_ERROR);
     }
 
     LOG_DEBUG(
@@ -83,41 +88,228 @@ Result<void> MessagePersistenceRepository::RemovePersistedMessages(
     std::string meta_key = CHAT_META_PREFIX + std::to_string(from_uid) + ":"
                            + std::to_string(to_uid);
 
-    // 获取当前队列长度
-    std::vector<std::string> all_msgs;
-    if (!redis->LRange(msg_key, 0, -1, all_msgs)) {
-        LOG_ERROR("Failed to get queue length: {}:{}", from_uid, to_uid);
+    // LLEN + LTRIM/DEL + 元数据更新在服务端原子完成，
+    // 期间新 LPUSH 的消息位于左侧，不会被误删
+    long long remaining = 0;
+    if (!redis->EvalScript(
+            RedisScripts::TRIM_PERSISTED_MSGS,
+            {msg_key, meta_key},
+            {std::to_string(count)},
+            remaining)) {
+        LOG_ERROR(
+            "Failed to trim persisted messages: {}:{}", from_uid, to_uid);
         return Result<void>::Error(ErrorCodes::REDIS_ERROR);
     }
 
-    if (all_msgs.empty()) {
+    LOG_DEBUG(
+        "Removed {} persisted messages: {} -> {}", count, from_uid, to_uid);
+    return Result<void>::OK();
+}
+
+
+Result<void> MessagePersistenceRepository::BatchInsertToMySQL(
+    const std::string& table_name, const std::vector<std::string>& messages,
+    int64_t first_seq) {
+    auto dao = MsgDAO::getInstance();
+    // 新分表、新月份的表在第一次写入时创建
+    auto ensure_res = dao->ensureTable(table_name);
+    if (!ensure_res.IsOK()) {
+        LOG_ERROR("Failed to prepare message table {}", table_name);
+        return ensure_res;
+    }
+    return dao->handleMessage(table_name, messages, first_seq);
+}
+
+Result<void> MessagePersistenceRepository::IndexMessagesForSearch(
+    const std::vector<std::string>& messages) {
+    std::vector<SearchDocument> docs;
+    docs.reserve(messages.size() * 2);
+    for (const auto& frame : messages) {
+        auto one = MessageSearch::Documents(frame);
+        std::move(one.begin(), one.end(), std::back_inserter(docs));
+    }
+    if (docs.empty()) {
         return Result<void>::OK();
     }
+    return MsgSearchDAO::getInstance()->indexDocuments(docs);
+}
 
-    // 计算保留的起始位置
-    long long keep_count = static_cast<long long>(all_msgs.size()) - count;
-    if (keep_count <= 0) {
-        // 删除全部
-        redis->Del(msg_key);
-        redis->Del(meta_key);
-    } else {
-        // 保留前面的 keep_count 条，删除后面的 count 条
-        // LTRIM 保留索引 0 到 keep_count-1 的元素
-        redis->LTrim(msg_key, 0, keep_count - 1);
+void MessagePersistenceRepository::AsyncSearchMessages(
+    int uid, const std::string& keyword, int64_t before_ts, int64_t before_id,
+    int limit, SearchHandler handler) {
+    auto query = MessageSearch::BooleanQuery(keyword);
+    if (query.empty()) {
+        handler(Result<SearchPage>::Error(ErrorCodes::SEARCH_KEYWORD_INVALID));
+        return;
+    }
+    MsgSearchDAO::getInstance()->AsyncSearch(
+        uid, std::move(query), before_ts, before_id, limit, std::move(handler));
+}
 
-        // 更新元数据
-        redis->HSet(meta_key, "count", std::to_string(keep_count));
+void MessagePersistenceRepository::AsyncGetConversationHistory(
+    int uid, int peer_uid, int64_t before_ts, int64_t before_id, int limit,
+    ConversationHandler handler) {
+    if (before_ts <= 0) {
+        before_ts = INT64_MAX;
+        before_id = INT64_MAX;
     }
 
-    LOG_DEBUG(
-        "Removed {} persisted messages: {} -> {}", count, from_uid, to_uid);
-    return Result<void>::OK();
+    // 消息表只需覆盖归档分界之后的月份，更早的部分直接由冷存储提供
+    auto    archive   = MessageArchive::getInstance();
+    int64_t now       = static_cast<int64_t>(std::time(nullptr));
+    int64_t hot_start = archive->Enabled()
+                            ? archive->Cutoff(now) - HOT_TABLE_SLACK_SEC
+                            : now - HOT_LOOKBACK_SEC;
+    auto layout = MessageShardMap::getInstance()->ReadLayout();
+    auto tables = layout.ConversationTables(
+        uid,
+        peer_uid,
+        static_cast<std::time_t>(hot_start),
+        static_cast<std::time_t>(std::min(before_ts, now)));
+
+    // 多取一条用来判断是否还有下一页
+    MsgDAO::getInstance()->AsyncGetConversationPage(
+        std::move(tables),
+        uid,
+        peer_uid,
+        before_ts,
+        before_id,
+        limit + 1,
+        [uid,
+         peer_uid,
+         before_ts,
+         before_id,
+         limit,
+         handler = std::move(handler)](Result<std::vector<ArchiveRow>> db_res) {
+            if (!db_res.IsOK()) {
+                handler(Result<ConversationPage>::Error(db_res.Error()));
+                return;
+            }
+            handler(mergeArchived(
+                MessageCodec::PeerKey(uid, peer_uid),
+                before_ts,
+                before_id,
+                limit,
+                db_res.Value()));
+        });
 }
 
+Result<ConversationPage> MessagePersistenceRepository::mergeArchived(
+    int64_t peer_key, int64_t before_ts, int64_t before_id, int limit,
+    std::vector<ArchiveRow> rows) {
+    auto archive = MessageArchive::getInstance();
+
+    // 消息表不足一页，或归档中有比这一页最旧一条更新的消息（归档任务
+    // 写完段文件、尚未删除原行时）才读冷存储；翻最近的页不会解压任何块
+    bool need_archive = static_cast<int>(rows.size()) <= limit;
+    if (!need_archive) {
+        const auto& oldest = rows.back();
+        int64_t     ts     = 0;
+        int64_t     id     = 0;
+        need_archive = archive->Newest(peer_key, before_ts, before_id, ts, id)
+                       && ArchiveSegment::Before(
+                           oldest.record.msg_ts, oldest.id, ts, id);
+    }
 
-Result<void> MessagePersistenceRepository::BatchInsertToMySQL(
-    const std::string& table_name, const std::vector<std::string>& messages) {
-    return MsgDAO::getInstance()->handleMessage(table_name, messages);
+    if (need_archive) {
+        auto cold_res = archive->Page(
+            peer_key, before_ts, before_id, INT64_MIN, limit + 1);
+        if (!cold_res.IsOK()) {
+            // 冷存储损坏时至少返回消息表中的部分
+            if (rows.empty()) {
+                return Result<ConversationPage>::Error(cold_res.Error());
+            }
+            LOG_WARN("Archive unavailable for conversation {}", peer_key);
+        } else if (!cold_res.Value().empty()) {
+            const auto& cold = cold_res.Value();
+            rows.insert(rows.end(), cold.begin(), cold.end());
+            std::sort(
+                rows.begin(),
+                rows.end(),
+                [](const ArchiveRow& a, const ArchiveRow& b) {
+                    return ArchiveSegment::Before(
+                        b.record.msg_ts, b.id, a.record.msg_ts, a.id);
+                });
+            // 删除原行之前，同一条消息会同时出现在两边
+            rows.erase(
+                std::unique(
+                    rows.begin(),
+                    rows.end(),
+                    [](const ArchiveRow& a, const ArchiveRow& b) {
+                        return a.record.msg_ts == b.record.msg_ts
+                               && a.id == b.id;
+                    }),
+                rows.end());
+            LOG_DEBUG(
+                "Conversation {} page filled from archive ({} rows)",
+                peer_key,
+                cold.size());
+        }
+    }
+
+    ConversationPage page;
+    if (static_cast<int>(rows.size()) > limit) {
+        page.has_more = true;
+        rows.resize(limit);
+    }
+    page.messages.reserve(rows.size());
+    for (const auto& row : rows) {
+        const auto& record = row.record;
+        page.messages.push_back(MessageCodec::BuildFrame(
+            record.from_uid, record.to_uid, record.msg_ts, record.payload));
+    }
+    if (!rows.empty()) {
+        page.next_ts = rows.back().record.msg_ts;
+        page.next_id = rows.back().id;
+    }
+    return Result<ConversationPage>::OK(page);
+}
+
+void MessagePersistenceRepository::appendArchived(
+    int uid, int friend_uid, int64_t window_start, int limit,
+    std::vector<std::string>& messages) {
+    if (static_cast<int>(messages.size()) >= limit) return;
+
+    int64_t before_ts = INT64_MAX;
+    if (!messages.empty()) {
+        Json::Value  root;
+        Json::Reader reader;
+        if (reader.parse(messages.back(), root) && root.isObject()) {
+            before_ts = MessageCodec::Timestamp(root);
+        }
+    }
+
+    // before_id 取最小值：只要严格早于消息表中最旧一条的消息
+    auto cold_res = MessageArchive::getInstance()->Page(
+        MessageCodec::PeerKey(uid, friend_uid),
+        before_ts,
+        INT64_MIN,
+        window_start,
+        limit - static_cast<int>(messages.size()));
+    if (!cold_res.IsOK()) return;
+    for (const auto& row : cold_res.Value()) {
+        const auto& record = row.record;
+        messages.push_back(MessageCodec::BuildFrame(
+            record.from_uid, record.to_uid, record.msg_ts, record.payload));
+    }
+}
+
+int64_t MessagePersistenceRepository::AllocateMessageSeq(
+    int from_uid, int to_uid, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    // 双向消息共用一个计数器；插入失败时预留的序号作废，只保证单调不保证连续
+    std::string seq_key
+        = CHAT_SEQ_PREFIX
+          + std::to_string(MessageCodec::PeerKey(from_uid, to_uid));
+    long long last = RedisManager::getInstance()->IncrBy(seq_key, count);
+    if (last < count) {
+        LOG_WARN("Failed to allocate message seq: {} -> {}", from_uid, to_uid);
+        return 0;
+    }
+    return last - count + 1;
 }
 
 Result<std::vector<std::pair<int, int>>>
@@ -156,21 +348,80 @@ MessagePersistenceRepository::GetAllChatQueues() {
     return Result<std::vector<std::pair<int, int>>>::OK(result);
 }
 
-int MessagePersistenceRepository::GetChatMessageTable(
-    int from_uid, int to_uid) {
-    return (from_uid + to_uid) % 16;
-}
-
-std::string MessagePersistenceRepository::GetChatMessageTableName(
-    int from_uid, int to_uid) {
-    return "chat_messages_"
-           + std::to_string(GetChatMessageTable(from_uid, to_uid));
+std::vector<MessageTableRun> MessagePersistenceRepository::GetChatMessageTables(
+    int from_uid, int to_uid, const std::vector<std::string>& messages) {
+    // 月份表按消息时间而非持久化时间选，否则跨月前发出、跨月后才落库的消息
+    // 会写进下个月的表，按 msg_ts 翻页时永远查不到
+    auto                         shard_map = MessageShardMap::getInstance();
+    std::vector<MessageTableRun> runs;
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        auto tables = shard_map->WriteTables(
+            from_uid,
+            to_uid,
+            static_cast<std::time_t>(
+                MessageCodec::FrameTimestamp(messages[i])));
+        if (!runs.empty() && runs.back().tables == tables) {
+            runs.back().end = i + 1;
+            continue;
+        }
+        runs.push_back(MessageTableRun{std::move(tables), i, i + 1});
+    }
+    return runs;
 }
 
 
 Result<std::vector<FriendMessages>>
 MessagePersistenceRepository::GetRecentMessagesWithCache(
     int uid, int days, int limit) {
+    std::vector<int> cache_miss_friends;
+    auto             cached_res = collectCachedRecent(uid, cache_miss_friends);
+    if (!cached_res.IsOK() || cache_miss_friends.empty()) {
+        return finishRecent(
+            uid, days, limit, cached_res, cache_miss_friends, nullptr);
+    }
+
+    auto db_res = MsgDAO::getInstance()->getRecentMessagesGroupedByFriend(
+        recentTables(days), uid, days, limit);
+    return finishRecent(
+        uid, days, limit, cached_res, cache_miss_friends, &db_res);
+}
+
+void MessagePersistenceRepository::AsyncGetRecentMessagesWithCache(
+    int uid, int days, int limit, RecentMessagesHandler handler) {
+    std::vector<int> cache_miss_friends;
+    auto             cached_res = collectCachedRecent(uid, cache_miss_friends);
+    if (!cached_res.IsOK() || cache_miss_friends.empty()) {
+        handler(finishRecent(
+            uid, days, limit, cached_res, cache_miss_friends, nullptr));
+        return;
+    }
+
+    MsgDAO::getInstance()->AsyncGetRecentMessagesGroupedByFriend(
+        recentTables(days),
+        uid,
+        days,
+        limit,
+        [uid,
+         days,
+         limit,
+         cached_res,
+         cache_miss_friends,
+         handler = std::move(handler)](
+            Result<std::vector<FriendMessages>> db_res) {
+            handler(finishRecent(
+                uid, days, limit, cached_res, cache_miss_friends, &db_res));
+        });
+}
+
+std::vector<std::string> MessagePersistenceRepository::recentTables(int days) {
+    std::time_t now = std::time(nullptr);
+    return MessageShardMap::getInstance()->ReadLayout().TablesInRange(
+        now - static_cast<std::time_t>(days) * 24 * 60 * 60, now);
+}
+
+Result<std::vector<FriendMessages>>
+MessagePersistenceRepository::collectCachedRecent(
+    int uid, std::vector<int>& cache_miss_friends) {
     auto friend_list_res = UserService::GetFriendList(uid);
     if (!friend_list_res.IsOK()) {
         LOG_WARN("Failed to get friend list for uid");
@@ -180,30 +431,10 @@ MessagePersistenceRepository::GetRecentMessagesWithCache(
 
     auto                        friend_list = friend_list_res.Value();
     std::vector<FriendMessages> result;
-    std::vector<int>            cache_miss_friends;
-
-    auto extract_ts = [](const std::string& msg_json) -> int64_t {
-        Json::Value root;
-        Json::Reader reader;
-        if (!reader.parse(msg_json, root) || !root.isObject()) {
-            return 0;
-        }
-        if (root.isMember("timestamp") && root["timestamp"].isInt64()) {
-            return root["timestamp"].asInt64();
-        }
-        if (root.isMember("text_array") && root["text_array"].isArray()
-            && root["text_array"].size() > 0) {
-            const auto& first = root["text_array"][0];
-            if (first.isMember("timestamp") && first["timestamp"].isInt64()) {
-                return first["timestamp"].asInt64();
-            }
-        }
-        return 0;
-    };
 
     // get friend_info from cache
     for (const auto& friend_info : friend_list) {
-        int  friend_uid = friend_info->uid;
+        int  friend_uid = friend_info.uid;
         auto cached_res = GetCachedFriendMessages(uid, friend_uid);
 
         if (cached_res.IsOK()) {
@@ -214,31 +445,54 @@ MessagePersistenceRepository::GetRecentMessagesWithCache(
         }
     }
 
-    // query for database
     if (!cache_miss_friends.empty()) {
         LOG_DEBUG(
             "Cache miss for {} friends, querying database",
             cache_miss_friends.size());
+    }
+    return Result<std::vector<FriendMessages>>::OK(result);
+}
 
-        auto db_res = MsgDAO::getInstance()->getRecentMessagesGroupedByFriend(
-            uid, days, limit);
+Result<std::vector<FriendMessages>> MessagePersistenceRepository::finishRecent(
+    int uid, int days, int limit,
+    const Result<std::vector<FriendMessages>>& cached_res,
+    const std::vector<int>&                    cache_miss_friends,
+    const Result<std::vector<FriendMessages>>* db_res) {
+    if (!cached_res.IsOK()) {
+        return cached_res;
+    }
+    auto result = cached_res.Value();
 
-        if (db_res.IsOK()) {
-            auto db_friend_messages = db_res.Value();
+    if (db_res && db_res->IsOK()) {
+        std::map<int, std::vector<std::string>> from_db;
+        for (const auto& db_fm : db_res->Value()) {
+            from_db[db_fm.friend_uid] = db_fm.messages;
+        }
 
-            for (const auto& db_fm : db_friend_messages) {
-                bool exists = false;
-                for (auto& existing_fm : result) {
-                    if (existing_fm.friend_uid == db_fm.friend_uid) {
-                        exists = true;
-                        break;
-                    }
-                }
-                if (!exists) {
-                    result.push_back(db_fm);
-                    CacheFriendMessages(uid, db_fm.friend_uid, db_fm.messages);
+        // 时间窗跨过归档分界时，消息表里不足 limit 条的会话由冷存储补齐
+        auto    archive      = MessageArchive::getInstance();
+        int64_t now          = static_cast<int64_t>(std::time(nullptr));
+        int64_t window_start = now - static_cast<int64_t>(days) * 24 * 60 * 60;
+        if (archive->Enabled() && window_start < archive->Cutoff(now)) {
+            for (int friend_uid : cache_miss_friends) {
+                appendArchived(
+                    uid, friend_uid, window_start, limit, from_db[friend_uid]);
+            }
+        }
+
+        for (const auto& [friend_uid, messages] : from_db) {
+            if (messages.empty()) continue;
+            bool exists = false;
+            for (auto& existing_fm : result) {
+                if (existing_fm.friend_uid == friend_uid) {
+                    exists = true;
+                    break;
                 }
             }
+            if (!exists) {
+                result.push_back(FriendMessages{friend_uid, messages});
+                CacheFriendMessages(uid, friend_uid, messages);
+            }
         }
     }
 
@@ -256,12 +510,25 @@ MessagePersistenceRepository::GetRecentMessagesWithCache(
     }
 
     if (!bot_msgs.empty()) {
-        std::sort(
-            bot_msgs.begin(),
-            bot_msgs.end(),
-            [&](const std::string& a, const std::string& b) {
-                return extract_ts(a) < extract_ts(b);
-            });
+        // 每条消息只解析一次取时间戳，再按时间排序
+        std::vector<std::pair<int64_t, std::string>> timed;
+        timed.reserve(bot_msgs.size());
+        for (auto& msg : bot_msgs) {
+            Json::Value  root;
+            Json::Reader reader;
+            int64_t      ts = 0;
+            if (reader.parse(msg, root) && root.isObject()) {
+                ts = MessageCodec::Timestamp(root);
+            }
+            timed.emplace_back(ts, std::move(msg));
+        }
+        std::stable_sort(
+            timed.begin(),
+            timed.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (std::size_t i = 0; i < timed.size(); ++i) {
+            bot_msgs[i] = std::move(timed[i].second);
+        }
 
         const size_t keep = static_cast<size_t>(std::max(limit, 1));
         if (bot_msgs.size() > keep) {
@@ -283,7 +550,7 @@ MessagePersistenceRepository::GetRecentMessagesWithCache(
     LOG_INFO(
         "Retrieved recent messages for uid {} (cache hits: {}, misses: {})",
         uid,
-        friend_list.size() - cache_miss_friends.size(),
+        cached_res.Value().size(),
         cache_miss_friends.size());
 
     return Result<std::vector<FriendMessages>>::OK(result);
@@ -3,30 +3,99 @@
 
 #include "common/result.h"
 #include "dao/MsgDAO.h"
+#include "dao/MsgSearchDAO.h"
+#include <functional>
 #include <vector>
 
 struct FriendMessages;
+
+// 一页会话历史（聊天帧），按时间从新到旧；
+// has_more 时以 (next_ts, next_id) 作为下一页游标
+struct ConversationPage {
+    std::vector<std::string> messages;
+    bool                     has_more = false;
+    int64_t                  next_ts  = 0;
+    int64_t                  next_id  = 0;
+};
+
+// 一批消息中写入同一组表的一段 [begin, end)：tables 第一个为主表，
+// 其余为重分片双写窗口内的影子表
+struct MessageTableRun {
+    std::vector<std::string> tables;
+    std::size_t              begin = 0;
+    std::size_t              end   = 0;
+};
+
 class MessagePersistenceRepository {
 public:
     static Result<void> SaveChatMessage(
         int from_uid, int to_uid, const std::string& msg_json);
     static Result<std::vector<std::string>> GetMessagesFromCache(int from_uid, int to_uid, int count);
     static Result<void> RemovePersistedMessages(int from_uid, int to_uid, int count);
-    static Result<void> BatchInsertToMySQL(const std::string& table_name, const std::vector<std::string>& messages);
+    static Result<void> BatchInsertToMySQL(const std::string& table_name, const std::vector<std::string>& messages, int64_t first_seq = 0);
+    // @brief: 为会话预留 count 个连续序号，返回第一个；失败返回 0（消息按未分配序号写入）
+    static int64_t AllocateMessageSeq(int from_uid, int to_uid, int count);
 
     static Result<std::vector<std::pair<int, int>>> GetAllChatQueues();
-    static int GetChatMessageTable(int from_uid, int to_uid);
-    static std::string GetChatMessageTableName(int from_uid, int to_uid);
+    // @brief: 按每条消息的 msg_ts 选表（与读路径一致），连续写入同一组表的
+    //         消息合为一段；按月分区时跨月的批次拆成多段，按批次顺序返回
+    static std::vector<MessageTableRun> GetChatMessageTables(
+        int from_uid, int to_uid, const std::vector<std::string>& messages);
 
     static Result<std::vector<FriendMessages>> GetRecentMessagesWithCache(int uid, int days, int limit);
+    // @brief: 同上，缓存未命中的部分在 MySQL 工作线程上查询，不阻塞调用线程；
+    //         全部命中时 handler 在调用线程上直接执行，否则在工作线程上执行
+    using RecentMessagesHandler
+        = std::function<void(Result<std::vector<FriendMessages>>)>;
+    static void AsyncGetRecentMessagesWithCache(
+        int uid, int days, int limit, RecentMessagesHandler handler);
+    // @brief: 为已写入消息表的一批聊天帧建立全文索引（收发双方各一份文档）
+    static Result<void> IndexMessagesForSearch(const std::vector<std::string>& messages);
+    // @brief: 在 uid 的聊天记录中检索 keyword，结果在 MySQL 工作线程上回调
+    using SearchHandler = std::function<void(Result<SearchPage>)>;
+    static void AsyncSearchMessages(
+        int uid, const std::string& keyword, int64_t before_ts, int64_t before_id,
+        int limit, SearchHandler handler);
+    // @brief: 会话 (uid, peer_uid) 中早于游标的一页历史，首页 before_ts 传 0；
+    //         先查消息表，不足一页时由冷存储（MessageArchive）接着往前翻，
+    //         结果在 MySQL 工作线程上回调
+    using ConversationHandler = std::function<void(Result<ConversationPage>)>;
+    static void AsyncGetConversationHistory(
+        int uid, int peer_uid, int64_t before_ts, int64_t before_id, int limit,
+        ConversationHandler handler);
     static Result<void> CacheFriendMessages(int uid, int friend_uid, const std::vector<std::string>& messages);
     static Result<std::vector<std::string>> GetCachedFriendMessages(int uid, int friend_uid);
 
 private:
+    static std::vector<std::string> recentTables(int days);
+    // @brief: 好友列表 + 各会话的 Redis 缓存，未命中的好友放入 cache_miss_friends
+    static Result<std::vector<FriendMessages>> collectCachedRecent(
+        int uid, std::vector<int>& cache_miss_friends);
+    // @brief: 合并数据库结果（并回填缓存）与 BOT 会话；db_res 为空表示没有查库
+    static Result<std::vector<FriendMessages>> finishRecent(
+        int uid, int days, int limit,
+        const Result<std::vector<FriendMessages>>& cached_res,
+        const std::vector<int>&                    cache_miss_friends,
+        const Result<std::vector<FriendMessages>>* db_res);
+    // @brief: 时间窗早于归档分界时，用冷存储把会话补齐到 limit 条
+    //         messages 为消息表中的结果（从新到旧），只补比其中最旧一条更早的
+    static void appendArchived(
+        int uid, int friend_uid, int64_t window_start, int limit,
+        std::vector<std::string>& messages);
+    // @brief: 消息表的一页（limit + 1 条）与冷存储合并成最终的一页
+    static Result<ConversationPage> mergeArchived(
+        int64_t peer_key, int64_t before_ts, int64_t before_id, int limit,
+        std::vector<ArchiveRow> rows);
+
     static const std::string CHAT_MSG_PREFIX;
     static const std::string CHAT_META_PREFIX;
     static const std::string RECENT_MSG_PREFIX;
+    static const std::string CHAT_SEQ_PREFIX;
     static const int CACHE_TTL_SECONDS; 
+    // 启用归档时消息表中还可能留有分界前未来得及归档的消息，多查这段时间
+    static const int64_t HOT_TABLE_SLACK_SEC;
+    // 未启用归档且按月分区时，会话翻页最多回看这么久的月份表
+    static const int64_t HOT_LOOKBACK_SEC;
 };
 
 
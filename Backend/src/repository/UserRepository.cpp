@@ -1,28 +1,152 @@
 #include "UserRepository.h"
+#include "common/UserCodec.h"
 #include "common/UserMessage.h"
 #include "common/const.h"
 #include "dao/UserDAO.h"
+#include "infra/ConfigManager.h"
 #include "infra/LogManager.h"
+#include "infra/NearCache.h"
 #include "infra/RedisManager.h"
+#include "infra/RedisScripts.h"
 #include <json/json.h>
 #include <memory>
 
+namespace {
+
+// 近端缓存按对象实际占用估算内存
+std::size_t EstimateBytes(const UserInfo& info) {
+    return sizeof(UserInfo) + info.name.capacity() + info.nick.capacity()
+           + info.email.capacity() + info.desc.capacity()
+           + info.back.capacity() + info.icon.capacity()
+           + info.pwd.capacity();
+}
+
+std::size_t EstimateBytes(const ApplyInfo& info) {
+    return sizeof(ApplyInfo) + info._name.capacity() + info._desc.capacity()
+           + info._icon.capacity() + info._nick.capacity();
+}
+
+template <typename T>
+std::size_t EstimateBytes(const std::vector<T>& list) {
+    std::size_t bytes = sizeof(list) + (list.capacity() - list.size()) * sizeof(T);
+    for (const auto& item : list) {
+        bytes += EstimateBytes(item);
+    }
+    return bytes;
+}
+
+// [UserCache] encoding = binary | json，回滚时可切回 JSON 写入；读取两种格式都支持
+bool UseBinaryEncoding() {
+    static const bool binary
+        = (*ConfigManager::getInstance())["UserCache"]["encoding"] != "json";
+    return binary;
+}
+
+std::string EncodeForCache(const UserInfo& info) {
+    if (UseBinaryEncoding()) return UserCodec::Encode(info);
+    Json::FastWriter writer;
+    return writer.write(UserJsonMapper::ToJson(info));
+}
+
+std::string EncodeForCache(const std::vector<UserInfo>& list) {
+    if (UseBinaryEncoding()) return UserCodec::Encode(list);
+    Json::Value root(Json::arrayValue);
+    for (const auto& item : list) {
+        root.append(UserJsonMapper::ToJson(item));
+    }
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+std::string EncodeForCache(const std::vector<ApplyInfo>& list) {
+    if (UseBinaryEncoding()) return UserCodec::Encode(list);
+    Json::Value root(Json::arrayValue);
+    for (const auto& item : list) {
+        root.append(ApplyInfoJsonMapper::ToJson(item));
+    }
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+// 旧格式（JSON）解析
+bool DecodeJson(const Json::Value& root, UserInfo& info) {
+    if (!root.isObject()) return false;
+    info = UserJsonMapper::FromJson(root);
+    return true;
+}
+
+bool DecodeJson(const Json::Value& root, std::vector<UserInfo>& list) {
+    if (!root.isArray()) return false;
+    list.clear();
+    list.reserve(root.size());
+    for (const auto& item : root) {
+        list.push_back(UserJsonMapper::FromJson(item));
+    }
+    return true;
+}
+
+bool DecodeJson(const Json::Value& root, std::vector<ApplyInfo>& list) {
+    if (!root.isArray()) return false;
+    list.clear();
+    list.reserve(root.size());
+    for (const auto& item : root) {
+        list.push_back(ApplyInfoJsonMapper::FromJson(item));
+    }
+    return true;
+}
+
+// @brief: 解码缓存值，二进制与旧 JSON 格式都能识别；
+//         读到旧格式且当前写二进制时，原值未变则原地改写为二进制（惰性迁移）
+template <typename T>
+bool DecodeCached(const std::string& key, const std::string& raw, T& out) {
+    if (UserCodec::IsBinary(raw)) {
+        return UserCodec::Decode(raw, out);
+    }
+
+    Json::Reader reader;
+    Json::Value  root;
+    if (!reader.parse(raw, root) || !DecodeJson(root, out)) {
+        return false;
+    }
+
+    if (UseBinaryEncoding()) {
+        long long replaced = 0;
+        RedisManager::getInstance()->EvalScript(
+            RedisScripts::REPLACE_IF_EQUAL,
+            {key},
+            {raw, UserCodec::Encode(out)},
+            replaced);
+        LOG_DEBUG("[Cache] Migrated {} to binary encoding: {}", key, replaced);
+    }
+    return true;
+}
+
+}   // namespace
+
 // Read operations with caching
 Result<UserInfo> UserRepository::getUserById(int uid) {
     auto redisManager = RedisManager::getInstance();
+    auto nearCache    = NearCache::getInstance();
 
-    // 1. 从Redis缓存中获取用户信息
+    // 0. 进程内近端缓存
     std::string key = USER_BASE_PREFIX + std::to_string(uid);
+    if (auto cached = nearCache->Get<UserInfo>(key)) {
+        return Result<UserInfo>::OK(*cached);
+    }
+    auto epoch = nearCache->Epoch();
+
+    // 1. 从Redis缓存中获取用户信息
     std::string user_info;
     auto        res = redisManager->Get(key, user_info);
 
     if (res) {
         // 缓存命中
-        Json::Reader reader;
-        Json::Value  value;
-        if (reader.parse(user_info, value)) {
-            UserInfo userInfo = UserJsonMapper::FromJson(value);
+        UserInfo userInfo;
+        if (DecodeCached(key, user_info, userInfo)) {
             LOG_INFO("[Cache] Hit cache for user ID: {}", uid);
+            nearCache->Put(
+                key, std::make_shared<const UserInfo>(userInfo),
+                EstimateBytes(userInfo), epoch);
             return Result<UserInfo>::OK(userInfo);
         }
     }
@@ -34,11 +158,10 @@ Result<UserInfo> UserRepository::getUserById(int uid) {
         UserInfo userInfo = dbRes.Value();
 
         // 3. 将用户信息存入Redis缓存
-        Json::Value      jsonUser = UserJsonMapper::ToJson(userInfo);
-        Json::FastWriter writer;
-        std::string      jsonStr = writer.write(jsonUser);
-
-        redisManager->Set(key, jsonStr);
+        redisManager->Set(key, EncodeForCache(userInfo));
+        nearCache->Put(
+            key, std::make_shared<const UserInfo>(userInfo),
+            EstimateBytes(userInfo), epoch);
         LOG_INFO("[Cache] Set cache for user ID: {}", uid);
         return Result<UserInfo>::OK(userInfo);
     }
@@ -102,6 +225,7 @@ Result<void> UserRepository::AddFriendApply(const int& from, const int& to) {
         auto        redisManager = RedisManager::getInstance();
         std::string key          = FRIEND_APPLY_PREFIX + std::to_string(to);
         redisManager->Del(key);
+        NearCache::getInstance()->Invalidate(key);
     }
     return res;
 }
@@ -115,6 +239,8 @@ Result<void> UserRepository::AddFriend(
         std::string key2         = FRIEND_LIST_PREFIX + std::to_string(to);
         redisManager->Del(key1);
         redisManager->Del(key2);
+        NearCache::getInstance()->Invalidate(key1);
+        NearCache::getInstance()->Invalidate(key2);
     }
     return res;
 }
@@ -125,40 +251,40 @@ Result<void> UserRepository::AuthFriendApply(const int& from, const int& to) {
         auto        redisManager = RedisManager::getInstance();
         std::string key          = FRIEND_APPLY_PREFIX + std::to_string(to);
         redisManager->Del(key);
+        NearCache::getInstance()->Invalidate(key);
     }
     return res;
 }
 
-Result<std::vector<std::shared_ptr<ApplyInfo>>> UserRepository::GetApplyList(
-    int uid) {
+Result<std::vector<ApplyInfo>> UserRepository::GetApplyList(int uid) {
+    using ApplyList   = std::vector<ApplyInfo>;
     auto        redisManager = RedisManager::getInstance();
+    auto        nearCache    = NearCache::getInstance();
     std::string key          = FRIEND_APPLY_PREFIX + std::to_string(uid);
+    if (auto cached = nearCache->Get<ApplyList>(key)) {
+        return Result<ApplyList>::OK(*cached);
+    }
+    auto epoch = nearCache->Epoch();
+
     std::string list_str;
     auto        res = redisManager->Get(key, list_str);
     if (res) {
-        Json::Reader reader;
-        Json::Value  root;
-        if (reader.parse(list_str, root) && root.isArray()) {
-            std::vector<std::shared_ptr<ApplyInfo>> applyList;
-            for (const auto& item : root) {
-                applyList.push_back(
-                    std::make_shared<ApplyInfo>(
-                        ApplyInfoJsonMapper::FromJson(item)));
-            }
+        ApplyList applyList;
+        if (DecodeCached(key, list_str, applyList)) {
             LOG_INFO("[Cache] Hit cache for apply list: {}", uid);
-            return Result<std::vector<std::shared_ptr<ApplyInfo>>>::OK(
-                applyList);
+            nearCache->Put(
+                key, std::make_shared<const ApplyList>(applyList),
+                EstimateBytes(applyList), epoch);
+            return Result<ApplyList>::OK(applyList);
         }
     }
 
     auto dbRes = UserDAO::getInstance()->GetApplyList(uid, 0, 10);
     if (dbRes.IsOK()) {
-        Json::Value root(Json::arrayValue);
-        for (const auto& item : dbRes.Value()) {
-            root.append(ApplyInfoJsonMapper::ToJson(*item));
-        }
-        Json::FastWriter writer;
-        redisManager->Set(key, writer.write(root));
+        redisManager->Set(key, EncodeForCache(dbRes.Value()));
+        nearCache->Put(
+            key, std::make_shared<const ApplyList>(dbRes.Value()),
+            EstimateBytes(dbRes.Value()), epoch);
     }
     return dbRes;
 }
@@ -175,34 +301,35 @@ Result<std::string> UserRepository::FindUserIpServerByUid(const int& uid) {
     }
 }
 
-using ArrayUserInfo = std::vector<std::shared_ptr<UserInfo>>;
+using ArrayUserInfo = std::vector<UserInfo>;
 Result<ArrayUserInfo> UserRepository::GetFriendList(int uid) {
     auto        redisManager = RedisManager::getInstance();
+    auto        nearCache    = NearCache::getInstance();
     std::string key          = FRIEND_LIST_PREFIX + std::to_string(uid);
+    if (auto cached = nearCache->Get<ArrayUserInfo>(key)) {
+        return Result<ArrayUserInfo>::OK(*cached);
+    }
+    auto epoch = nearCache->Epoch();
+
     std::string list_str;
     auto        res = redisManager->Get(key, list_str);
     if (res) {
-        Json::Reader reader;
-        Json::Value  root;
-        if (reader.parse(list_str, root) && root.isArray()) {
-            ArrayUserInfo friendList;
-            for (const auto& item : root) {
-                friendList.push_back(
-                    std::make_shared<UserInfo>(UserJsonMapper::FromJson(item)));
-            }
+        ArrayUserInfo friendList;
+        if (DecodeCached(key, list_str, friendList)) {
             LOG_INFO("[Cache] Hit cache for friend list: {}", uid);
+            nearCache->Put(
+                key, std::make_shared<const ArrayUserInfo>(friendList),
+                EstimateBytes(friendList), epoch);
             return Result<ArrayUserInfo>::OK(friendList);
         }
     }
 
     auto dbRes = UserDAO::getInstance()->GetFriendList(uid);
     if (dbRes.IsOK()) {
-        Json::Value root(Json::arrayValue);
-        for (const auto& item : dbRes.Value()) {
-            root.append(UserJsonMapper::ToJson(*item));
-        }
-        Json::FastWriter writer;
-        redisManager->Set(key, writer.write(root));
+        redisManager->Set(key, EncodeForCache(dbRes.Value()));
+        nearCache->Put(
+            key, std::make_shared<const ArrayUserInfo>(dbRes.Value()),
+            EstimateBytes(dbRes.Value()), epoch);
     }
     return dbRes;
 }
@@ -213,6 +340,7 @@ void UserRepository::clearUserCache(int uid) {
     auto        redisManager = RedisManager::getInstance();
     std::string key          = USER_BASE_PREFIX + std::to_string(uid);
     redisManager->Del(key);
+    NearCache::getInstance()->Invalidate(key);
     LOG_INFO("[Cache] Cleared cache for user ID: {}", uid);
 }
 
@@ -246,8 +374,8 @@ Result<std::vector<std::string>> UserRepository::GetOfflineMessages(int uid) {
     auto                     redisManager = RedisManager::getInstance();
     std::string              key = OFFLINE_MSG_PREFIX + std::to_string(uid);
     std::vector<std::string> values;
-    if (redisManager->LRange(key, 0, -1, values)) {
-        redisManager->Del(key);
+    // LRANGE + DEL 原子完成，避免两步之间新写入的离线消息被一并删除
+    if (redisManager->EvalScript(RedisScripts::LIST_DRAIN, {key}, {}, values)) {
         return Result<std::vector<std::string>>::OK(values);
     }
     return Result<std::vector<std::string>>::Error(ErrorCodes::REDIS_ERROR);
@@ -258,13 +386,16 @@ Result<void> UserRepository::UpdateUserIcon(int uid, const std::string& icon) {
     auto res = UserDAO::getInstance()->UpdateUserIcon(uid, icon);
     if (!res.IsOK()) return res;
 
-    auto redis = RedisManager::getInstance();
+    auto redis     = RedisManager::getInstance();
+    auto nearCache = NearCache::getInstance();
     redis->Del(USER_BASE_PREFIX + std::to_string(uid));
+    nearCache->Invalidate(USER_BASE_PREFIX + std::to_string(uid));
 
     auto ownersRes = UserDAO::getInstance()->FindFriendOwnersByFriendId(uid);
     if (ownersRes.IsOK()) {
         for (int ownerUid : ownersRes.Value()) {
             redis->Del(FRIEND_LIST_PREFIX + std::to_string(ownerUid));
+            nearCache->Invalidate(FRIEND_LIST_PREFIX + std::to_string(ownerUid));
         }
     }
     return Result<void>::OK();
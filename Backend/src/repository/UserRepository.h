@@ -35,9 +35,9 @@ public:
         const int& uid, const std::string& server_name);
     static void                UnBindUserIpWithServer(const int& uid);
     static Result<std::string> FindUserIpServerByUid(const int& uid);
-    static Result<std::vector<std::shared_ptr<ApplyInfo>>> GetApplyList(
-        int uid);
-    using ArrayUserInfo = std::vector<std::shared_ptr<UserInfo>>;
+    // 列表以值数组返回，缓存命中时直接从二进制编码解码，不再逐条分配
+    static Result<std::vector<ApplyInfo>> GetApplyList(int uid);
+    using ArrayUserInfo = std::vector<UserInfo>;
     static Result<ArrayUserInfo> GetFriendList(
         int uid);
 
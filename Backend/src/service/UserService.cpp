@@ -84,7 +84,7 @@ Result<void> UserService::AddFriendApply(const int &from, const int &to) {
     return res;
 }
 
-Result<std::vector<std::shared_ptr<ApplyInfo>>> UserService::GetApplyList(
+Result<std::vector<ApplyInfo>> UserService::GetApplyList(
     int uid) {
     auto res = UserRepository::GetApplyList(uid);
     return res;
@@ -100,7 +100,7 @@ Result<void> UserService::AddFriend(const int &from, const int &to, const std::s
     return res;
 }
 
-Result<std::vector<std::shared_ptr<UserInfo>>> UserService::GetFriendList(int uid) {
+Result<std::vector<UserInfo>> UserService::GetFriendList(int uid) {
     auto res = UserRepository::GetFriendList(uid);
     return res;
 }
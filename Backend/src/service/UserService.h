@@ -25,8 +25,8 @@ public:
     static Result<void> AddFriendApply(const int& from, const int& to);
     static Result<void> AuthFriendApply(const int& from, const int& to);
     static Result<void> AddFriend(const int& from, const int& to, const std::string& back_name);
-    static Result<std::vector<std::shared_ptr<ApplyInfo>>> GetApplyList(int uid);
-    static Result<std::vector<std::shared_ptr<UserInfo>>> GetFriendList(int uid);
+    static Result<std::vector<ApplyInfo>> GetApplyList(int uid);
+    static Result<std::vector<UserInfo>> GetFriendList(int uid);
 };
 
 
@@ -0,0 +1,216 @@
+// 消息冷存储归档工具
+// 把 msg_ts 早于 [MessageArchive] age_days 的消息从消息表移到段文件：
+// 按主键顺序分批读出，攒够 segment_rows 条后按消息月份各写一个段文件
+// （fsync 后原子改名），段文件落盘后再分块删除消息表中的对应行
+//
+// 中断后可直接重跑：已写段但未删除的行会再次写入新段，
+// 读取时按 (msg_ts, id) 去重
+// 在线重分片期间不运行（迁移工具仍在按 id 复制、校验旧表）
+// 按月分区的布局下，整月早于分界的月份表归档后为空表，可在低峰期手动 DROP
+//
+// 用法: MsgArchive [--table NAME] [--batch 1000] [--sleep-ms 100]
+//                  [--delete-chunk 500] [--dry-run]
+//       不指定 --table 时处理当前布局（[MessageShard]）下的全部消息表
+#include "common/ArchiveSegment.h"
+#include "dao/MsgDAO.h"
+#include "infra/LogManager.h"
+#include "infra/MessageArchive.h"
+#include "infra/MessageShardMap.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string table;   // 为空表示全部消息表
+    int  batch        = 1000;
+    int  sleep_ms     = 100;
+    int  delete_chunk = 500;
+    bool dry_run      = false;
+};
+
+struct Totals {
+    long long rows     = 0;
+    long long deleted  = 0;
+    int       segments = 0;
+};
+
+bool ParseOptions(int argc, char* argv[], Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dry-run") {
+            opts.dry_run = true;
+        } else if (i + 1 < argc && arg == "--table") {
+            opts.table = argv[++i];
+        } else if (i + 1 < argc && arg == "--batch") {
+            opts.batch = std::atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--sleep-ms") {
+            opts.sleep_ms = std::atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--delete-chunk") {
+            opts.delete_chunk = std::atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return opts.batch > 0 && opts.sleep_ms >= 0 && opts.delete_chunk > 0;
+}
+
+// 一个段的行写成按月份划分的段文件，名字带表名与 id 区间，重跑同一区间时覆盖
+bool WriteSegments(
+    const std::string& table, std::vector<ArchiveRow> rows, const Options& opts,
+    Totals& totals) {
+    std::map<std::string, std::vector<ArchiveRow>> by_month;
+    for (auto& row : rows) {
+        by_month[ArchiveSegment::MonthOf(row.record.msg_ts)].push_back(
+            std::move(row));
+    }
+
+    for (auto& [month, month_rows] : by_month) {
+        std::string name = table + "_" + std::to_string(month_rows.front().id)
+                           + "_" + std::to_string(month_rows.back().id);
+        if (opts.dry_run) {
+            LOG_INFO(
+                "[MsgArchive] Would write {}/{} ({} rows)",
+                month,
+                name,
+                month_rows.size());
+            continue;
+        }
+        auto res = MessageArchive::getInstance()->WriteSegment(
+            month, name, std::move(month_rows));
+        if (!res.IsOK()) return false;
+        totals.segments++;
+    }
+    return true;
+}
+
+bool ArchiveTable(
+    const std::string& table, int64_t cutoff, const Options& opts,
+    Totals& totals) {
+    auto       dao     = MsgDAO::getInstance();
+    const auto max_len = MessageArchive::getInstance()->SegmentRows();
+    int64_t    after   = 0;
+    auto       start   = std::chrono::steady_clock::now();
+    long long  rows    = 0;
+
+    while (true) {
+        // 攒一个段：id 区间 (after, last_id] 内所有早于分界的行
+        std::vector<ArchiveRow> segment;
+        int64_t                 last_id = after;
+        while (segment.size() < max_len) {
+            auto res = dao->readArchivable(table, last_id, cutoff, opts.batch);
+            if (!res.IsOK()) {
+                LOG_ERROR(
+                    "[MsgArchive] {} read failed after id {}", table, last_id);
+                return false;
+            }
+            if (res.Value().empty()) break;
+            last_id = res.Value().back().id;
+            segment.insert(
+                segment.end(), res.Value().begin(), res.Value().end());
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(opts.sleep_ms));
+        }
+        if (segment.empty()) break;
+
+        std::size_t count = segment.size();
+        if (!WriteSegments(table, std::move(segment), opts, totals)) {
+            LOG_ERROR(
+                "[MsgArchive] {} failed to write segment up to id {}",
+                table,
+                last_id);
+            return false;
+        }
+
+        // 段文件已落盘，删除消息表中的原行
+        if (!opts.dry_run) {
+            auto del_res = dao->deleteArchived(
+                table, after, last_id, cutoff, opts.delete_chunk);
+            if (!del_res.IsOK()) {
+                LOG_ERROR(
+                    "[MsgArchive] {} archived up to id {} but delete failed, "
+                    "rerun to retry",
+                    table,
+                    last_id);
+                return false;
+            }
+            totals.deleted += del_res.Value();
+        }
+
+        after = last_id;
+        rows += static_cast<long long>(count);
+        LOG_INFO(
+            "[MsgArchive] {}: up to id {}, archived {}", table, after, rows);
+    }
+
+    totals.rows += rows;
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    LOG_INFO("[MsgArchive] {} done: {} rows in {:.1f}s", table, rows, elapsed);
+    return true;
+}
+
+}   // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        std::fprintf(
+            stderr,
+            "usage: %s [--table NAME] [--batch 1000] [--sleep-ms 100] "
+            "[--delete-chunk 500] [--dry-run]\n",
+            argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto archive = MessageArchive::getInstance();
+    if (!archive->Enabled()) {
+        LOG_ERROR("[MsgArchive] [MessageArchive] age_days is not set");
+        return EXIT_FAILURE;
+    }
+    auto map = MessageShardMap::getInstance();
+    if (map->Phase(true) != ReshardPhase::NONE) {
+        LOG_ERROR(
+            "[MsgArchive] Reshard in progress ({}), try again later",
+            MessageShardMap::PhaseName(map->Phase()));
+        return EXIT_FAILURE;
+    }
+
+    int64_t cutoff = archive->Cutoff(static_cast<int64_t>(std::time(nullptr)));
+    LOG_INFO("[MsgArchive] Archiving messages before {}", cutoff);
+
+    std::vector<std::string> tables;
+    if (!opts.table.empty()) {
+        tables.push_back(opts.table);
+    } else {
+        const auto& layout = map->Active();
+        auto        res    = MsgDAO::getInstance()->listTables(layout.prefix);
+        if (!res.IsOK()) {
+            LOG_ERROR(
+                "[MsgArchive] Failed to list tables of {}", layout.prefix);
+            return EXIT_FAILURE;
+        }
+        for (const auto& table : res.Value()) {
+            if (layout.Owns(table)) tables.push_back(table);
+        }
+    }
+
+    Totals totals;
+    bool   ok = true;
+    for (const auto& table : tables) {
+        ok = ArchiveTable(table, cutoff, opts, totals) && ok;
+    }
+    LOG_INFO(
+        "[MsgArchive] {} rows archived into {} segments, {} rows deleted",
+        totals.rows,
+        totals.segments,
+        totals.deleted);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,119 @@
+// 消息分表类型化列回填工具
+// 分批读取 payload 为空的历史行，解析一次原始帧后写入 peer_key / msg_type /
+// msg_ts / payload；每批一个事务，批间休眠限速，可随时中断后重跑（幂等）
+//
+// 用法: MsgBackfill [--table NAME] [--batch 500] [--sleep-ms 200] [--drop-content]
+//       不指定 --table 时处理当前布局（config.ini [MessageShard]）下的全部消息表
+#include "dao/MsgDAO.h"
+#include "infra/LogManager.h"
+#include "infra/MessageShardMap.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string table;   // 为空表示全部消息表
+    int  batch        = 500;
+    int  sleep_ms     = 200;
+    bool drop_content = false;
+};
+
+bool ParseOptions(int argc, char* argv[], Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--drop-content") {
+            opts.drop_content = true;
+        } else if (i + 1 < argc && arg == "--table") {
+            opts.table = argv[++i];
+        } else if (i + 1 < argc && arg == "--batch") {
+            opts.batch = std::atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--sleep-ms") {
+            opts.sleep_ms = std::atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return opts.batch > 0 && opts.sleep_ms >= 0;
+}
+
+bool BackfillTable(const std::string& table, const Options& opts) {
+    int64_t     after   = 0;
+    long long   scanned = 0;
+    long long   updated = 0;
+    auto        start   = std::chrono::steady_clock::now();
+
+    while (true) {
+        auto res = MsgDAO::getInstance()->backfillTypedColumns(
+            table, after, opts.batch, opts.drop_content);
+        if (!res.IsOK()) {
+            LOG_ERROR("[MsgBackfill] {} failed after id {}", table, after);
+            return false;
+        }
+
+        const auto& progress = res.Value();
+        if (progress.scanned == 0) break;
+
+        after = progress.last_id;
+        scanned += progress.scanned;
+        updated += progress.updated;
+        LOG_INFO(
+            "[MsgBackfill] {}: up to id {}, scanned {}, updated {}",
+            table,
+            after,
+            scanned,
+            updated);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(opts.sleep_ms));
+    }
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    LOG_INFO(
+        "[MsgBackfill] {} done: scanned {}, updated {} in {:.1f}s",
+        table,
+        scanned,
+        updated,
+        elapsed);
+    return true;
+}
+
+}   // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        std::fprintf(
+            stderr,
+            "usage: %s [--table NAME] [--batch 500] [--sleep-ms 200] "
+            "[--drop-content]\n",
+            argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> tables;
+    if (!opts.table.empty()) {
+        tables.push_back(opts.table);
+    } else {
+        const auto& layout = MessageShardMap::getInstance()->Active();
+        auto        res    = MsgDAO::getInstance()->listTables(layout.prefix);
+        if (!res.IsOK()) {
+            LOG_ERROR("[MsgBackfill] Failed to list tables of {}", layout.prefix);
+            return EXIT_FAILURE;
+        }
+        for (const auto& table : res.Value()) {
+            if (layout.Owns(table)) tables.push_back(table);
+        }
+    }
+
+    bool ok = true;
+    for (const auto& table : tables) {
+        ok = BackfillTable(table, opts) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
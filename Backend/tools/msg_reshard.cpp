@@ -0,0 +1,469 @@
+// 消息表在线重分片工具
+// 把消息从当前布局（config.ini [MessageShard]）迁移到新的分表数 / 按月分区布局，
+// 迁移期间 ChatServer 正常收发，阶段保存在 Redis msg:reshard，所有实例共享
+//
+// 流程:
+//   start    记录各源表水位（MAX(id)）并进入双写；水位以下的行由 copy 复制，
+//            之后的行由持久化服务同时写入新旧两套表
+//   copy     按 id 分批复制水位以下的历史行，进度记在 cursor:<table>，可中断重跑
+//   verify   按会话比较新旧两套表的行数与校验和，不一致或双写失败的会话
+//            在持久化锁内整段重新复制
+//   cutover  读切到新布局（仍双写，可 rollback）
+//   finish   停止写旧表；之后把 config.ini 改成新布局并滚动重启，再执行 clear
+//
+// 阶段切换都在持久化锁（lock:msg:persistence）内进行，持久化服务每轮开始时
+// 强制刷新阶段，因此同一轮写入不会跨阶段
+//
+// 用法: MsgReshard <command> [options]
+//   start --prefix P --shards N [--partition none|monthly]
+//   copy [--batch 500] [--sleep-ms 100]
+//   verify [--batch 200]
+//   cutover | rollback | finish | abort | clear | status
+#include "common/MessageRecord.h"
+#include "dao/MsgDAO.h"
+#include "dao/MsgReshardDAO.h"
+#include "infra/DistLock.h"
+#include "infra/LogManager.h"
+#include "infra/MessageShardMap.h"
+#include "infra/RedisManager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+const char* PERSISTENCE_LOCK = "lock:msg:persistence";
+
+struct Options {
+    std::string command;
+    std::string prefix;
+    int         shards    = 0;
+    std::string partition = "none";
+    int         batch     = 0;
+    int         sleep_ms  = 100;
+};
+
+bool ParseOptions(int argc, char* argv[], Options& opts) {
+    if (argc < 2) return false;
+    opts.command = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        if (arg == "--prefix") {
+            opts.prefix = argv[++i];
+        } else if (arg == "--shards") {
+            opts.shards = std::atoi(argv[++i]);
+        } else if (arg == "--partition") {
+            opts.partition = argv[++i];
+        } else if (arg == "--batch") {
+            opts.batch = std::atoi(argv[++i]);
+        } else if (arg == "--sleep-ms") {
+            opts.sleep_ms = std::atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return opts.batch >= 0 && opts.sleep_ms >= 0;
+}
+
+// 持久化锁：阶段切换与会话重新复制期间阻止持久化服务写入
+class PersistenceLock {
+public:
+    PersistenceLock() : _lock(PERSISTENCE_LOCK, 60, 120, true) {}
+    bool isLocked() const { return _lock.isLocked(); }
+
+private:
+    DistLock _lock;
+};
+
+std::map<std::string, std::string> LoadState() {
+    return RedisManager::getInstance()->HGetAll(MessageShardMap::RESHARD_KEY);
+}
+
+bool SetState(const std::map<std::string, std::string>& fields) {
+    return RedisManager::getInstance()->HMSet(MessageShardMap::RESHARD_KEY, fields);
+}
+
+// @brief: 列出属于布局的全部表，按分表号分组
+bool TablesByShard(
+    const MessageShardLayout& layout, std::map<int, std::vector<std::string>>& out) {
+    auto res = MsgDAO::getInstance()->listTables(layout.prefix);
+    if (!res.IsOK()) {
+        LOG_ERROR("[MsgReshard] Failed to list tables of {}", layout.prefix);
+        return false;
+    }
+    for (const auto& table : res.Value()) {
+        int shard = layout.TableShard(table);
+        if (shard >= 0) out[shard].push_back(table);
+    }
+    return true;
+}
+
+// @brief: 会话键拆回两端 uid（与 MessageCodec::PeerKey 对应）
+std::pair<int, int> PeerUids(int64_t peer_key) {
+    auto key = static_cast<uint64_t>(peer_key);
+    return {
+        static_cast<int>(static_cast<uint32_t>(key >> 32)),
+        static_cast<int>(static_cast<uint32_t>(key & 0xffffffffu))};
+}
+
+bool RequirePhase(ReshardPhase expected) {
+    ReshardPhase phase = MessageShardMap::getInstance()->Phase(true);
+    if (phase != expected) {
+        std::fprintf(
+            stderr,
+            "current phase is %s, expected %s\n",
+            MessageShardMap::PhaseName(phase),
+            MessageShardMap::PhaseName(expected));
+        return false;
+    }
+    return true;
+}
+
+int CmdStart(const Options& opts) {
+    auto map = MessageShardMap::getInstance();
+    if (!RequirePhase(ReshardPhase::NONE)) return EXIT_FAILURE;
+
+    MessageShardLayout target;
+    target.prefix  = opts.prefix;
+    target.shards  = opts.shards;
+    target.monthly = opts.partition == "monthly";
+    if (target.prefix.empty() || target.shards <= 0
+        || (opts.partition != "none" && opts.partition != "monthly")) {
+        std::fprintf(stderr, "start requires --prefix, --shards and a valid --partition\n");
+        return EXIT_FAILURE;
+    }
+    if (target == map->Active()) {
+        std::fprintf(stderr, "target layout equals the active layout\n");
+        return EXIT_FAILURE;
+    }
+
+    std::map<int, std::vector<std::string>> sources;
+    if (!TablesByShard(map->Active(), sources)) return EXIT_FAILURE;
+
+    // 校验与重新复制都依赖 peer_key，旧行必须先由 MsgBackfill 回填
+    for (const auto& [shard, tables] : sources) {
+        for (const auto& table : tables) {
+            auto pending = MsgReshardDAO::getInstance()->countUnbackfilled(table);
+            if (!pending.IsOK() || pending.Value() > 0) {
+                std::fprintf(
+                    stderr,
+                    "%s has rows without typed columns, run MsgBackfill first\n",
+                    table.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    PersistenceLock lock;
+    if (!lock.isLocked()) {
+        std::fprintf(stderr, "failed to acquire %s\n", PERSISTENCE_LOCK);
+        return EXIT_FAILURE;
+    }
+
+    // 持锁期间没有写入：水位之前的行只在旧表，之后的行都会被双写
+    std::map<std::string, std::string> fields{
+        {"phase", MessageShardMap::PhaseName(ReshardPhase::DUAL_WRITE)},
+        {"prefix", target.prefix},
+        {"shards", std::to_string(target.shards)},
+        {"partition", MessageShardMap::PartitionName(target.monthly)},
+    };
+    for (const auto& [shard, tables] : sources) {
+        for (const auto& table : tables) {
+            auto max_id = MsgReshardDAO::getInstance()->maxId(table);
+            if (!max_id.IsOK()) return EXIT_FAILURE;
+            fields["watermark:" + table] = std::to_string(max_id.Value());
+            fields["cursor:" + table]    = "0";
+        }
+    }
+    RedisManager::getInstance()->Del(MessageShardMap::RESHARD_DIRTY_KEY);
+    if (!SetState(fields)) return EXIT_FAILURE;
+
+    LOG_INFO(
+        "[MsgReshard] Dual write started: {} -> prefix={}, shards={}, partition={}",
+        map->Active().prefix,
+        target.prefix,
+        target.shards,
+        opts.partition);
+    return EXIT_SUCCESS;
+}
+
+int CmdCopy(const Options& opts) {
+    auto map = MessageShardMap::getInstance();
+    if (!RequirePhase(ReshardPhase::DUAL_WRITE)) return EXIT_FAILURE;
+
+    MessageShardLayout target;
+    map->Target(target, true);
+    int batch = opts.batch > 0 ? opts.batch : 500;
+
+    auto state = LoadState();
+    for (const auto& [field, value] : state) {
+        if (field.compare(0, 10, "watermark:") != 0) continue;
+        std::string table     = field.substr(10);
+        int64_t     watermark = std::stoll(value);
+        int64_t     cursor    = std::stoll(state["cursor:" + table]);
+        long long   copied    = 0;
+
+        while (cursor < watermark) {
+            auto res = MsgReshardDAO::getInstance()->copyBatch(
+                table, cursor, watermark, batch, target);
+            if (!res.IsOK()) {
+                LOG_ERROR("[MsgReshard] Copy of {} failed after id {}", table, cursor);
+                return EXIT_FAILURE;
+            }
+            const auto& progress = res.Value();
+            cursor = progress.copied == 0 ? watermark : progress.last_id;
+            copied += progress.copied;
+            RedisManager::getInstance()->HSet(
+                MessageShardMap::RESHARD_KEY, "cursor:" + table, std::to_string(cursor));
+
+            LOG_INFO(
+                "[MsgReshard] {}: up to id {}/{}, copied {}",
+                table,
+                cursor,
+                watermark,
+                copied);
+            std::this_thread::sleep_for(std::chrono::milliseconds(opts.sleep_ms));
+        }
+    }
+
+    LOG_INFO("[MsgReshard] Copy finished");
+    return EXIT_SUCCESS;
+}
+
+int CmdVerify(const Options& opts) {
+    auto map   = MessageShardMap::getInstance();
+    auto dao   = MsgReshardDAO::getInstance();
+    auto redis = RedisManager::getInstance();
+    if (!RequirePhase(ReshardPhase::DUAL_WRITE)) return EXIT_FAILURE;
+
+    auto state = LoadState();
+    for (const auto& [field, value] : state) {
+        if (field.compare(0, 10, "watermark:") != 0) continue;
+        std::string table = field.substr(10);
+        if (std::stoll(state["cursor:" + table]) < std::stoll(value)) {
+            std::fprintf(stderr, "%s is not fully copied, run copy first\n", table.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    MessageShardLayout target;
+    map->Target(target, true);
+    const MessageShardLayout&               active = map->Active();
+    std::map<int, std::vector<std::string>> sources;
+    std::map<int, std::vector<std::string>> targets;
+    if (!TablesByShard(active, sources) || !TablesByShard(target, targets)) {
+        return EXIT_FAILURE;
+    }
+
+    auto tables_of = [&](const MessageShardLayout&                      layout,
+                         const std::map<int, std::vector<std::string>>& by_shard,
+                         int64_t peer_key) -> std::vector<std::string> {
+        auto [a, b] = PeerUids(peer_key);
+        auto it     = by_shard.find(layout.ShardOf(a, b));
+        return it == by_shard.end() ? std::vector<std::string>{} : it->second;
+    };
+
+    // 持锁后重新比较，仍不一致则整段重新复制
+    auto repair = [&](int64_t peer_key) -> bool {
+        PersistenceLock lock;
+        if (!lock.isLocked()) return false;
+        // 双写可能刚创建了新的月份表，重新列出目标表
+        std::map<int, std::vector<std::string>> fresh;
+        if (!TablesByShard(target, fresh)) return false;
+
+        auto src = tables_of(active, sources, peer_key);
+        auto dst = tables_of(target, fresh, peer_key);
+        auto lhs = dao->digest(src, peer_key);
+        auto rhs = dao->digest(dst, peer_key);
+        if (lhs.IsOK() && rhs.IsOK() && lhs.Value() == rhs.Value()) return true;
+
+        auto res = dao->recopyConversation(src, dst, peer_key, target);
+        if (!res.IsOK()) return false;
+        LOG_INFO("[MsgReshard] Recopied conversation {} ({} rows)", peer_key, res.Value());
+        return true;
+    };
+
+    int batch      = opts.batch > 0 ? opts.batch : 200;
+    int mismatched = 0;
+    int failed     = 0;
+
+    // 1. 双写失败的会话
+    for (const auto& [peer, flag] : redis->HGetAll(MessageShardMap::RESHARD_DIRTY_KEY)) {
+        if (repair(std::stoll(peer))) {
+            redis->HDel(MessageShardMap::RESHARD_DIRTY_KEY, peer);
+        } else {
+            failed++;
+        }
+    }
+
+    // 2. 逐会话比较；按月分区时一个会话分布在多张表，只比较一次
+    std::unordered_set<int64_t> checked;
+    for (const auto& [shard, tables] : sources) {
+        for (const auto& table : tables) {
+            int64_t after = -1;
+            while (true) {
+                auto peers = dao->listConversations(table, after, batch);
+                if (!peers.IsOK()) return EXIT_FAILURE;
+                if (peers.Value().empty()) break;
+
+                for (int64_t peer_key : peers.Value()) {
+                    after = peer_key;
+                    if (!checked.insert(peer_key).second) continue;
+
+                    auto lhs = dao->digest(tables_of(active, sources, peer_key), peer_key);
+                    auto rhs = dao->digest(tables_of(target, targets, peer_key), peer_key);
+                    if (lhs.IsOK() && rhs.IsOK() && lhs.Value() == rhs.Value()) {
+                        continue;
+                    }
+                    mismatched++;
+                    if (!repair(peer_key)) failed++;
+                }
+            }
+            LOG_INFO("[MsgReshard] Verified {} ({} conversations so far)", table, checked.size());
+        }
+    }
+
+    LOG_INFO(
+        "[MsgReshard] Verify finished: {} conversations, {} mismatched, {} failed",
+        checked.size(),
+        mismatched,
+        failed);
+    if (failed > 0) return EXIT_FAILURE;
+    redis->HSet(MessageShardMap::RESHARD_KEY, "verified", "1");
+    return EXIT_SUCCESS;
+}
+
+int SwitchPhase(ReshardPhase from, ReshardPhase to) {
+    if (!RequirePhase(from)) return EXIT_FAILURE;
+
+    PersistenceLock lock;
+    if (!lock.isLocked()) {
+        std::fprintf(stderr, "failed to acquire %s\n", PERSISTENCE_LOCK);
+        return EXIT_FAILURE;
+    }
+    if (!SetState({{"phase", MessageShardMap::PhaseName(to)}})) return EXIT_FAILURE;
+
+    LOG_INFO(
+        "[MsgReshard] Phase {} -> {}",
+        MessageShardMap::PhaseName(from),
+        MessageShardMap::PhaseName(to));
+    return EXIT_SUCCESS;
+}
+
+int CmdCutover() {
+    auto state = LoadState();
+    if (state["verified"] != "1"
+        || RedisManager::getInstance()->HLen(MessageShardMap::RESHARD_DIRTY_KEY) > 0) {
+        std::fprintf(stderr, "run verify until it succeeds before cutover\n");
+        return EXIT_FAILURE;
+    }
+    return SwitchPhase(ReshardPhase::DUAL_WRITE, ReshardPhase::CUTOVER);
+}
+
+int CmdRollback() {
+    int rc = SwitchPhase(ReshardPhase::CUTOVER, ReshardPhase::DUAL_WRITE);
+    if (rc == EXIT_SUCCESS) {
+        RedisManager::getInstance()->HDel(MessageShardMap::RESHARD_KEY, "verified");
+    }
+    return rc;
+}
+
+int CmdFinish() {
+    int rc = SwitchPhase(ReshardPhase::CUTOVER, ReshardPhase::DONE);
+    if (rc == EXIT_SUCCESS) {
+        MessageShardLayout target;
+        MessageShardMap::getInstance()->Target(target, true);
+        std::printf(
+            "set [MessageShard] prefix = %s, shards = %d, partition = %s in config.ini,\n"
+            "restart every ChatServer, then run: MsgReshard clear\n",
+            target.prefix.c_str(),
+            target.shards,
+            MessageShardMap::PartitionName(target.monthly).c_str());
+    }
+    return rc;
+}
+
+// @brief: 双写阶段放弃迁移，已复制到新表的数据保留，需手工清理
+int CmdAbort() {
+    if (!RequirePhase(ReshardPhase::DUAL_WRITE)) return EXIT_FAILURE;
+
+    PersistenceLock lock;
+    if (!lock.isLocked()) return EXIT_FAILURE;
+    RedisManager::getInstance()->Del(
+        {MessageShardMap::RESHARD_KEY, MessageShardMap::RESHARD_DIRTY_KEY});
+    LOG_INFO("[MsgReshard] Reshard aborted, target tables are left in place");
+    return EXIT_SUCCESS;
+}
+
+// @brief: 清除迁移状态；只能在本机 config.ini 已切换到新布局后执行
+int CmdClear() {
+    auto               map = MessageShardMap::getInstance();
+    MessageShardLayout target;
+    if (!RequirePhase(ReshardPhase::DONE) || !map->Target(target, true)) {
+        return EXIT_FAILURE;
+    }
+    if (!(map->Active() == target)) {
+        std::fprintf(stderr, "config.ini [MessageShard] still has the old layout\n");
+        return EXIT_FAILURE;
+    }
+
+    RedisManager::getInstance()->Del(
+        {MessageShardMap::RESHARD_KEY, MessageShardMap::RESHARD_DIRTY_KEY});
+    LOG_INFO("[MsgReshard] Reshard state cleared");
+    return EXIT_SUCCESS;
+}
+
+int CmdStatus() {
+    const auto& active = MessageShardMap::getInstance()->Active();
+    std::printf(
+        "active: prefix=%s shards=%d partition=%s\n",
+        active.prefix.c_str(),
+        active.shards,
+        MessageShardMap::PartitionName(active.monthly).c_str());
+    for (const auto& [field, value] : LoadState()) {
+        std::printf("%s = %s\n", field.c_str(), value.c_str());
+    }
+    std::printf(
+        "dirty conversations = %lld\n",
+        RedisManager::getInstance()->HLen(MessageShardMap::RESHARD_DIRTY_KEY));
+    return EXIT_SUCCESS;
+}
+
+}   // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        std::fprintf(
+            stderr,
+            "usage: %s start --prefix P --shards N [--partition none|monthly]\n"
+            "       %s copy [--batch 500] [--sleep-ms 100]\n"
+            "       %s verify [--batch 200]\n"
+            "       %s cutover | rollback | finish | abort | clear | status\n",
+            argv[0],
+            argv[0],
+            argv[0],
+            argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::string& cmd = opts.command;
+    if (cmd == "start") return CmdStart(opts);
+    if (cmd == "copy") return CmdCopy(opts);
+    if (cmd == "verify") return CmdVerify(opts);
+    if (cmd == "cutover") return CmdCutover();
+    if (cmd == "rollback") return CmdRollback();
+    if (cmd == "finish") return CmdFinish();
+    if (cmd == "abort") return CmdAbort();
+    if (cmd == "clear") return CmdClear();
+    if (cmd == "status") return CmdStatus();
+
+    std::fprintf(stderr, "unknown command: %s\n", cmd.c_str());
+    return EXIT_FAILURE;
+}
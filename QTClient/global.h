@@ -45,6 +45,10 @@ enum ReqId{
     ID_PULL_HISTORY_MSG_REQ = 123, // 消息拉取请求
     ID_PULL_HISTORY_MSG_RSP = 124, // 消息拉取回复
     ID_NOTIFY_USER_ICON_REQ = 125, // 广播头像更新
+    ID_SEARCH_MSG_REQ = 126, // 聊天记录检索请求
+    ID_SEARCH_MSG_RSP = 127, // 聊天记录检索回复
+    ID_PULL_CONV_HISTORY_REQ = 128, // 会话历史翻页请求
+    ID_PULL_CONV_HISTORY_RSP = 129, // 会话历史翻页回复
     ID_UPDATE_ICON = 10050, // 头像上传
 };
 